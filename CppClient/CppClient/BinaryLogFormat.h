@@ -0,0 +1,123 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Binary log file format written by Logger if logBinary is set and read by the LogDecoder tool.
+// The file is a sequence of records, each starting with a BinaryLogRecord byte. Integers are little endian, varints are
+// LEB128 and signed values are zigzag encoded. Every write of the logger is one Batch record followed by the site and
+// message records of that batch, so that several processes can append to the same file.
+//
+// Batch:	magic[8], u32 version, u32 process id, u32 size of the records that follow, u64 counter frequency,
+//			u64 counter, u64 FILETIME (UTC)
+// Site:	u32 site id, u32 message id, u8 BinaryLogLevel, varint line, varint length + file, varint length + format
+// Message:	u32 site id, u64 counter, varint thread id, u8 argument count, arguments
+// Dropped:	varint number of messages that were dropped because the queue was full
+//
+// An argument is a BinaryLogArgument byte followed by the value: Int zigzag varint, UInt varint, Double 8 bytes,
+// False and True nothing, String varint length + UTF-8, Char 1 byte.
+// A site is defined once per file handle before its first message. An empty format means that the arguments are the
+// message. Counters are QueryPerformanceCounter values, the batch relates them to the wall clock.
+
+constexpr char BINARY_LOG_MAGIC[] = "PILOGBIN";
+constexpr size_t BINARY_LOG_MAGIC_SIZE = sizeof(BINARY_LOG_MAGIC) - 1;
+constexpr uint32_t BINARY_LOG_VERSION = 1;
+
+enum class BinaryLogRecord : uint8_t
+{
+	Batch = 1,
+	Site = 2,
+	Message = 3,
+	Dropped = 4
+};
+
+enum class BinaryLogArgument : uint8_t
+{
+	Int = 1,
+	UInt = 2,
+	Double = 3,
+	False = 4,
+	True = 5,
+	String = 6,
+	Char = 7
+};
+
+enum class BinaryLogLevel : uint8_t
+{
+	Error = 0,
+	Debug = 1
+};
+
+// FNV-1a, used for the message id of a format string
+constexpr uint32_t BinaryLogHash(const char* text, uint32_t hash = 2166136261u)
+{
+	while (*text != '\0')
+	{
+		hash = (hash ^ static_cast<uint8_t>(*text++)) * 16777619u;
+	}
+	return hash;
+}
+
+// Id of a call site, computed at compile time from __FILE__ and __LINE__
+constexpr uint32_t BinaryLogSiteId(const char* file, int line)
+{
+	uint32_t hash = BinaryLogHash(file);
+	for (int i = 0; i < 4; i++)
+	{
+		hash = (hash ^ static_cast<uint8_t>(static_cast<uint32_t>(line) >> (i * 8))) * 16777619u;
+	}
+	return hash;
+}
+
+inline void BinaryLogAppendFixed(std::string& out, uint64_t value, size_t bytes)
+{
+	for (size_t i = 0; i < bytes; i++)
+	{
+		out.push_back(static_cast<char>((value >> (i * 8)) & 0xFF));
+	}
+}
+
+inline void BinaryLogAppendVarint(std::string& out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+inline uint64_t BinaryLogZigZag(int64_t value)
+{
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t BinaryLogUnZigZag(uint64_t value)
+{
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+inline void BinaryLogAppendString(std::string& out, const char* text, size_t size)
+{
+	BinaryLogAppendVarint(out, size);
+	out.append(text, size);
+}
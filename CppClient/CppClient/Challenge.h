@@ -18,6 +18,7 @@
 ** * * * * * * * * * * * * * * * * * * */
 #pragma once
 #include "WebAuthnSignRequest.h"
+#include <memory>
 #include <string>
 
 class Challenge
@@ -27,7 +28,40 @@ public:
 	std::string transactionId;
 	std::string serial;
 	std::string type;
-	std::string image;
+	/// <summary>
+	/// The image as sent by the server ("data:image/png;base64,..."). It can be large, so it is held in a shared buffer
+	/// that is not duplicated when the challenge or the response containing it is copied.
+	/// </summary>
+	std::shared_ptr<const std::string> image;
 	std::string clientMode;
 	WebAuthnSignRequest webAuthnSignRequest;
+
+	bool HasImage() const noexcept
+	{
+		return image && !image->empty();
+	}
+
+	/// <summary>
+	/// Get a pointer to the base64 payload of the image, without the leading "data:...;base64," part. The pointer is valid
+	/// as long as this challenge (or a copy of it) exists.
+	/// </summary>
+	/// <param name="size">Receives the length of the payload.</param>
+	/// <returns>Pointer into the image buffer or nullptr if there is no image.</returns>
+	const char* GetImageBase64(size_t& size) const noexcept
+	{
+		size = 0;
+		if (!HasImage())
+		{
+			return nullptr;
+		}
+
+		size_t offset = 0;
+		if (image->compare(0, 5, "data:") == 0)
+		{
+			const auto comma = image->find(',');
+			offset = comma == std::string::npos ? image->size() : comma + 1;
+		}
+		size = image->size() - offset;
+		return image->data() + offset;
+	}
 };
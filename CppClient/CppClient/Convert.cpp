@@ -19,27 +19,50 @@
 
 #include "Convert.h"
 #include "Logger.h"
-#include <codecvt>
-#include <sstream>
+#include "Utf.h"
 #include <algorithm>
-#include <iomanip>
-#include <iostream>
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <cwctype>
+#include <locale.h>
+#endif
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 std::wstring Convert::ToWString(const std::string& s)
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
-
-	return converterX.from_bytes(s);
+	// A UTF-8 byte never results in more than one UTF-16 unit
+	std::wstring ws(s.size(), L'\0');
+	ws.resize(Utf::Utf8ToUtf16(s.data(), s.size(), &ws[0], ws.size()));
+	return ws;
 }
 
 std::string Convert::ToString(const std::wstring& ws)
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
+	// A UTF-16 unit never results in more than three bytes, a UTF-32 unit in more than four
+	std::string s(ws.size() * (sizeof(wchar_t) == 2 ? 3 : 4), '\0');
+	s.resize(Utf::Utf16ToUtf8(ws.data(), ws.size(), &s[0], s.size()));
+	return s;
+}
 
-	return converterX.to_bytes(ws);
+SecureWString Convert::ToWString(const SecureString& s)
+{
+	SecureWString ws;
+	ws.resize(Utf::Utf8ToUtf16(s.c_str(), s.size(), nullptr, 0));
+	Utf::Utf8ToUtf16(s.c_str(), s.size(), ws.data(), ws.size());
+	return ws;
+}
+
+SecureString Convert::ToString(const SecureWString& ws)
+{
+	SecureString s;
+	s.resize(Utf::Utf16ToUtf8(ws.c_str(), ws.size(), nullptr, 0));
+	Utf::Utf16ToUtf8(ws.c_str(), ws.size(), s.data(), s.size());
+	return s;
 }
 
 std::string Convert::ToString(const bool b)
@@ -47,171 +70,239 @@ std::string Convert::ToString(const bool b)
 	return b ? std::string("true") : std::string("false");
 }
 
-std::wstring Convert::ToUpperCase(std::wstring s)
+Convert::FilePath Convert::ToFilePath(const std::wstring& path)
 {
-	std::transform(s.begin(), s.end(), s.begin(), [](wchar_t c) { return static_cast<wchar_t>(std::toupper(c)); });
-	return s;
+#ifdef _WIN32
+	return path;
+#else
+	return ToString(path);
+#endif
 }
 
-std::string Convert::ToUpperCase(std::string s)
+std::wstring Convert::ToUpperCase(std::wstring s)
 {
-	std::transform(s.begin(), s.end(), s.begin(), [](char c) { return static_cast<char>(std::toupper(c)); });
+	if (!s.empty())
+	{
+		ToUpperCase(&s[0], s.size());
+	}
 	return s;
 }
 
-std::string Convert::LongToHexString(long in)
+std::string Convert::ToUpperCase(std::string s)
 {
-	std::stringstream ss;
-	ss << std::hex << in;
-	return "0x" + ss.str();
+	bool ascii = true;
+	for (auto& c : s)
+	{
+		if (c >= 'a' && c <= 'z') c = static_cast<char>(c - ('a' - 'A'));
+		else if (static_cast<unsigned char>(c) >= 0x80) ascii = false;
+	}
+	return ascii ? s : ToString(ToUpperCase(ToWString(s)));
 }
 
-std::wstring Convert::JoinW(const std::vector<std::wstring>& elements, const wchar_t* separator)
+void Convert::ToUpperCase(wchar_t* s, size_t size) noexcept
 {
-	std::wstringstream os;
-	for (std::vector<std::wstring>::const_iterator iter = elements.begin(); iter != elements.end(); ++iter)
+	bool ascii = true;
+	for (size_t i = 0; i < size; i++)
 	{
-		os << *iter;
-		if (iter + 1 != elements.end())
-		{
-			os << separator;
-		}
+		if (s[i] >= L'a' && s[i] <= L'z') s[i] = static_cast<wchar_t>(s[i] - (L'a' - L'A'));
+		else if (s[i] >= 0x80) ascii = false;
 	}
-	return os.str();
-}
 
-std::vector<unsigned char> Convert::Base64Decode(const std::string& base64String)
-{
-	static const std::string base64_chars =
-		"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-		"abcdefghijklmnopqrstuvwxyz"
-		"0123456789+/";
-
-	std::vector<unsigned char> decoded_data;
-	size_t in_len = base64String.size();
-	int i = 0;
-	int j = 0;
-	int in_ = 0;
-	unsigned char char_array_4[4]{};
-	unsigned char char_array_3[3]{};
-
-	while (in_len-- && (base64String[in_] != '=') && (isalnum(base64String[in_]) 
-		|| (base64String[in_] == '+') || (base64String[in_] == '/')))
+	if (!ascii)
 	{
-		char_array_4[i++] = base64String[in_];
-		in_++;
-		if (i == 4)
+		// Simple uppercase mapping of each unit in place, like the case insensitive comparison of account names
+#ifdef _WIN32
+		LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_UPPERCASE, s, static_cast<int>(size), s, static_cast<int>(size), nullptr, nullptr, 0);
+#else
+		// The Unicode mapping of the C.UTF-8 locale is the closest to the invariant locale. Surrogates are left as they are.
+		static const locale_t invariant = newlocale(LC_CTYPE_MASK, "C.UTF-8", static_cast<locale_t>(0));
+		for (size_t i = 0; i < size; i++)
 		{
-			for (i = 0; i < 4; i++)
+			if (s[i] >= 0x80 && (s[i] < 0xD800 || s[i] > 0xDFFF))
 			{
-				char_array_4[i] = base64_chars.find(char_array_4[i]);
+				const wint_t upper = invariant ? towupper_l(static_cast<wint_t>(s[i]), invariant) : towupper(static_cast<wint_t>(s[i]));
+				// Keep the length, a unit is never mapped to a supplementary character
+				if (upper <= 0xFFFF)
+				{
+					s[i] = static_cast<wchar_t>(upper);
+				}
 			}
-				
-			char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-			char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-			char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-
-			for (i = 0; i < 3; i++)
-			{
-				decoded_data.push_back(char_array_3[i]);
-			}
-				
-			i = 0;
 		}
+#endif
 	}
+}
 
-	if (i)
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+std::string Convert::LongToHexString(long in)
+{
+	// Negative values are shown as their two's complement, like HRESULTs and NTSTATUS codes
+	unsigned long value = static_cast<unsigned long>(in);
+	char buffer[2 + sizeof(value) * 2];
+	char* end = buffer + sizeof(buffer);
+	char* p = end;
+	do
 	{
-		for (j = i; j < 4; j++)
-		{
-			char_array_4[j] = 0;
-		}
+		*--p = HEX_DIGITS[value & 0xF];
+		value >>= 4;
+	} while (value != 0);
+	*--p = 'x';
+	*--p = '0';
+	return std::string(p, end);
+}
 
-		for (j = 0; j < 4; j++)
-		{
-			char_array_4[j] = base64_chars.find(char_array_4[j]);
-		}
+bool Convert::ToInt(const std::string& s, int& out) noexcept
+{
+	const char* begin = s.c_str();
+	char* end = nullptr;
+	errno = 0;
+	const long value = strtol(begin, &end, 10);
+	if (end == begin || errno == ERANGE || value < INT_MIN || value > INT_MAX)
+	{
+		return false;
+	}
+	out = static_cast<int>(value);
+	return true;
+}
 
-		char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-		char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-		char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
+std::wstring Convert::JoinW(const std::vector<std::wstring>& elements, const wchar_t* separator)
+{
+	if (elements.empty()) return std::wstring();
 
-		for (j = 0; j < i - 1; j++)
-		{
-			decoded_data.push_back(char_array_3[j]);
-		}
+	const size_t separatorLength = separator != nullptr ? wcslen(separator) : 0;
+	size_t length = separatorLength * (elements.size() - 1);
+	for (const auto& element : elements)
+	{
+		length += element.size();
 	}
 
-	return decoded_data;
+	std::wstring ret;
+	ret.reserve(length);
+	for (size_t i = 0; i < elements.size(); i++)
+	{
+		if (i > 0) ret.append(separator, separatorLength);
+		ret.append(elements[i]);
+	}
+	return ret;
 }
 
-std::vector<unsigned char> Convert::Base64URLDecode(const std::string& base64String)
-{
-	std::string base64 = base64String;
-	Convert::Base64URLToBase64(base64);
-	return Base64Decode(base64);
-}
+// Alphabets without the padding character. ab64 is the adapted base64 of passlib, which uses '.' instead of '+'.
+static const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+static const char BASE64URL_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+static const char ABASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789./";
 
-std::string Convert::Base64Encode(const unsigned char* data, const size_t size, bool padded)
-{
-	static const std::string base64_chars =
-		"ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-		"abcdefghijklmnopqrstuvwxyz"
-		"0123456789+/";
+constexpr unsigned char BASE64_INVALID = 0xFF;
 
-	size_t count = size;
-	std::string encoded_string;
-	int i = 0;
-	int j = 0;
-	unsigned char char_array_3[3]{};
-	unsigned char char_array_4[4]{};
+struct Base64DecodeTable
+{
+	unsigned char values[256];
 
-	while (count--)
+	explicit Base64DecodeTable(const char* alphabet)
 	{
-		char_array_3[i++] = *(data++);
-		if (i == 3)
-		{
-			char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-			char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-			char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-			char_array_4[3] = char_array_3[2] & 0x3f;
+		for (auto& value : values) value = BASE64_INVALID;
+		for (unsigned char i = 0; i < 64; i++) values[(unsigned char)alphabet[i]] = i;
+	}
+};
 
-			for (i = 0; i < 4; i++)
-			{
-				encoded_string += base64_chars[char_array_4[i]];
-			}
-				
-			i = 0;
-		}
+// Decodes until the first character that is not part of the alphabet, which includes the padding.
+// A trailing group of n < 4 characters results in n - 1 bytes.
+static std::vector<unsigned char> DecodeBase64(const char* data, const size_t size, const Base64DecodeTable& table)
+{
+	const unsigned char* in = reinterpret_cast<const unsigned char*>(data);
+	const unsigned char* t = table.values;
+	std::vector<unsigned char> decoded(size / 4 * 3 + 3);
+	unsigned char* out = decoded.data();
+
+	size_t i = 0;
+	// Groups of 4 characters, the validity of all 4 is checked with a single branch
+	for (; i + 4 <= size; i += 4)
+	{
+		const unsigned char a = t[in[i]], b = t[in[i + 1]], c = t[in[i + 2]], d = t[in[i + 3]];
+		if ((a | b | c | d) & 0x80) break;
+
+		const uint32_t group = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6 | d;
+		out[0] = (unsigned char)(group >> 16);
+		out[1] = (unsigned char)(group >> 8);
+		out[2] = (unsigned char)group;
+		out += 3;
 	}
 
-	if (i)
+	// The rest, up to the end or the first invalid character
+	uint32_t group = 0;
+	int count = 0;
+	for (; i < size && t[in[i]] != BASE64_INVALID && count < 4; i++, count++)
 	{
-		for (j = i; j < 3; j++)
-		{
-			char_array_3[j] = '\0';
-		}
+		group |= (uint32_t)t[in[i]] << (18 - 6 * count);
+	}
+	for (int j = 0; j < count - 1; j++)
+	{
+		*out++ = (unsigned char)(group >> (16 - 8 * j));
+	}
 
-		char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-		char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-		char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-		char_array_4[3] = char_array_3[2] & 0x3f;
+	decoded.resize(out - decoded.data());
+	return decoded;
+}
 
-		for (j = 0; j < i + 1; j++)
-		{
-			encoded_string += base64_chars[char_array_4[j]];
-		}
-			
+static std::string EncodeBase64(const unsigned char* data, const size_t size, bool padded, const char* alphabet)
+{
+	const size_t remainder = size % 3;
+	const size_t length = size / 3 * 4 + (remainder == 0 ? 0 : (padded ? 4 : remainder + 1));
+	std::string encoded(length, '\0');
+	char* out = &encoded[0];
+
+	size_t i = 0;
+	for (; i + 3 <= size; i += 3)
+	{
+		const uint32_t group = (uint32_t)data[i] << 16 | (uint32_t)data[i + 1] << 8 | data[i + 2];
+		out[0] = alphabet[group >> 18];
+		out[1] = alphabet[(group >> 12) & 0x3F];
+		out[2] = alphabet[(group >> 6) & 0x3F];
+		out[3] = alphabet[group & 0x3F];
+		out += 4;
+	}
+
+	if (remainder != 0)
+	{
+		const uint32_t group = (uint32_t)data[i] << 16 | (remainder == 2 ? (uint32_t)data[i + 1] << 8 : 0);
+		out[0] = alphabet[group >> 18];
+		out[1] = alphabet[(group >> 12) & 0x3F];
+		if (remainder == 2) out[2] = alphabet[(group >> 6) & 0x3F];
 		if (padded)
 		{
-			while (i++ < 3)
-			{
-				encoded_string += '=';
-			}
+			if (remainder == 1) out[2] = '=';
+			out[3] = '=';
 		}
 	}
 
-	return encoded_string;
+	return encoded;
+}
+
+std::vector<unsigned char> Convert::Base64Decode(const std::string& base64String)
+{
+	return Base64Decode(base64String.data(), base64String.size());
+}
+
+std::vector<unsigned char> Convert::Base64Decode(const char* data, const size_t size)
+{
+	static const Base64DecodeTable table(BASE64_ALPHABET);
+	return DecodeBase64(data, size, table);
+}
+
+std::vector<unsigned char> Convert::Base64URLDecode(const std::string& base64String)
+{
+	static const Base64DecodeTable table(BASE64URL_ALPHABET);
+	return DecodeBase64(base64String.data(), base64String.size(), table);
+}
+
+std::vector<unsigned char> Convert::ABase64Decode(const std::string& abase64String)
+{
+	static const Base64DecodeTable table(ABASE64_ALPHABET);
+	return DecodeBase64(abase64String.data(), abase64String.size(), table);
+}
+
+std::string Convert::Base64Encode(const unsigned char* data, const size_t size, bool padded)
+{
+	return EncodeBase64(data, size, padded, BASE64_ALPHABET);
 }
 
 std::string Convert::Base64Encode(const std::vector<unsigned char>& data, bool padded)
@@ -221,9 +312,7 @@ std::string Convert::Base64Encode(const std::vector<unsigned char>& data, bool p
 
 std::string Convert::Base64URLEncode(const unsigned char* data, const size_t size, bool padded)
 {
-	std::string base64 = Base64Encode(data, size, padded);
-	Convert::Base64ToBase64URL(base64);
-	return base64;
+	return EncodeBase64(data, size, padded, BASE64URL_ALPHABET);
 }
 
 std::string Convert::Base64URLEncode(const std::vector<unsigned char>& data, bool padded)
@@ -231,6 +320,7 @@ std::string Convert::Base64URLEncode(const std::vector<unsigned char>& data, boo
 	return Base64URLEncode(data.data(), data.size(), padded);
 }
 
+#ifdef _WIN32
 char* Convert::UnicodeToCodePage(int codePage, const wchar_t* src)
 {
 	if (!src) return 0;
@@ -265,6 +355,7 @@ char* Convert::UnicodeToCodePage(int codePage, const wchar_t* src)
 
 	return x;
 }
+#endif
 
 void Convert::Base64ToBase64URL(std::string& base64)
 {
@@ -283,42 +374,87 @@ void Convert::Base64ToABase64(std::string& base64)
 	std::replace(base64.begin(), base64.end(), '.', '+');
 }
 
-std::string Convert::BytesToHex(std::vector<unsigned char> bytes)
+std::string Convert::BytesToHex(const std::vector<unsigned char>& bytes)
 {
 	return BytesToHex(bytes.data(), bytes.size());
 }
 
 std::string Convert::BytesToHex(const unsigned char* data, const size_t dataSize)
 {
-	std::stringstream ss;
-	for (unsigned char c : std::vector<unsigned char>(data, data + dataSize))
+	std::string hex(dataSize * 2, '\0');
+	BytesToHex(data, dataSize, &hex[0]);
+	return hex;
+}
+
+void Convert::BytesToHex(const unsigned char* data, const size_t dataSize, char* out) noexcept
+{
+	for (size_t i = 0; i < dataSize; i++)
+	{
+		out[2 * i] = HEX_DIGITS[data[i] >> 4];
+		out[2 * i + 1] = HEX_DIGITS[data[i] & 0xF];
+	}
+}
+
+constexpr unsigned char HEX_INVALID = 0xFF;
+
+struct HexDecodeTable
+{
+	unsigned char values[256];
+
+	HexDecodeTable()
+	{
+		for (auto& value : values) value = HEX_INVALID;
+		for (unsigned char i = 0; i < 10; i++) values['0' + i] = i;
+		for (unsigned char i = 0; i < 6; i++)
+		{
+			values['a' + i] = 10 + i;
+			values['A' + i] = 10 + i;
+		}
+	}
+};
+
+bool Convert::HexToBytes(const char* hex, const size_t size, unsigned char* out) noexcept
+{
+	static const HexDecodeTable table;
+	if (size % 2 != 0) return false;
+
+	const unsigned char* in = reinterpret_cast<const unsigned char*>(hex);
+	for (size_t i = 0; i < size / 2; i++)
 	{
-		ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
+		const unsigned char high = table.values[in[2 * i]];
+		const unsigned char low = table.values[in[2 * i + 1]];
+		if (((high | low) & 0xF0) != 0) return false;
+		out[i] = static_cast<unsigned char>(high << 4 | low);
 	}
-	return ss.str();
+	return true;
 }
 
 std::vector<unsigned char> Convert::HexToBytes(const std::string& hexString)
 {
-	std::vector<unsigned char> binaryData;
-	for (size_t i = 0; i < hexString.length(); i += 2)
+	std::vector<unsigned char> binaryData(hexString.size() / 2);
+	if (!HexToBytes(hexString.data(), hexString.size(), binaryData.data()))
 	{
-		std::string byteString = hexString.substr(i, 2);
-		unsigned char byte = static_cast<unsigned char>(std::stoi(byteString, nullptr, 16));
-		binaryData.push_back(byte);
+		PIDebug("Invalid hex string");
+		return std::vector<unsigned char>();
 	}
 	return binaryData;
 }
 
 std::string Convert::ReplaceAll(const std::string& input, const std::string& target, const std::string& replacement)
 {
-	// Replace all occurences of target in input with replacement
-	std::string result = input;
+	// Replace all occurences of target in input with replacement, building the result in a single pass
+	if (target.empty()) return input;
+
+	std::string result;
+	result.reserve(input.size());
+	size_t start = 0;
 	size_t pos = 0;
-	while ((pos = result.find(target, pos)) != std::string::npos)
+	while ((pos = input.find(target, start)) != std::string::npos)
 	{
-		result.replace(pos, target.length(), replacement);
-		pos += replacement.length();
+		result.append(input, start, pos - start);
+		result.append(replacement);
+		start = pos + target.length();
 	}
+	result.append(input, start, std::string::npos);
 	return result;
 }
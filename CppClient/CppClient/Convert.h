@@ -20,26 +20,51 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "SecureString.h"
 
 class Convert
 {
 public:
+	// UTF-8 to UTF-16 and back with Utf, invalid sequences are replaced by U+FFFD
 	static std::wstring ToWString(const std::string& s);
 	static std::string ToString(const std::wstring& ws);
+	// Transcode secrets without leaving a copy in unprotected memory
+	static SecureWString ToWString(const SecureString& s);
+	static SecureString ToString(const SecureWString& ws);
+
 	static std::string ToString(const bool b);
+
+#ifdef _WIN32
+	typedef std::wstring FilePath;
+#else
+	typedef std::string FilePath;
+#endif
+	// Path in the form that the file streams and the file functions of the system take, UTF-8 outside of Windows
+	static FilePath ToFilePath(const std::wstring& path);
+
+	// Uppercase with the invariant casing of Windows, independent of the current locale. Works for UTF-8 and UTF-16.
 	static std::wstring ToUpperCase(std::wstring s);
 	static std::string ToUpperCase(std::string s);
+	// Uppercase each UTF-16 unit in place, without changing the length. ASCII is mapped directly.
+	static void ToUpperCase(wchar_t* s, size_t size) noexcept;
 	static std::string LongToHexString(long in);
+	// Like std::stoi, but returns false instead of throwing if s does not start with a number or it is out of range
+	static bool ToInt(const std::string& s, int& out) noexcept;
 	static std::wstring JoinW(const std::vector<std::wstring>& elements, const wchar_t* separator);
 	
 	static std::vector<unsigned char> Base64Decode(const std::string& base64String);
+	static std::vector<unsigned char> Base64Decode(const char* data, const size_t size);
 	static std::vector<unsigned char> Base64URLDecode(const std::string& base64String);
+	// Decode the adapted base64 of passlib (ab64), which uses '.' instead of '+'
+	static std::vector<unsigned char> ABase64Decode(const std::string& abase64String);
 	static std::string Base64Encode(const unsigned char* data, const size_t size, bool padded = false);
 	static std::string Base64Encode(const std::vector<unsigned char>& data, bool padded = false);
 	static std::string Base64URLEncode(const unsigned char* data, const size_t size, bool padded = false);
 	static std::string Base64URLEncode(const std::vector<unsigned char>& data, bool padded = false);
 
+#ifdef _WIN32
 	static char* UnicodeToCodePage(int codePage, const wchar_t* src);
+#endif
 	// replace '+' with '-' and '/' with '_'
 	static void Base64ToBase64URL(std::string& base64);
 	// replace '-' with '+' and '_' with '/'
@@ -49,9 +74,14 @@ public:
 	static void Base64ToABase64(std::string& base64);
 
 	static std::string BytesToHex(const unsigned char* data, const size_t dataSize);
-	static std::string BytesToHex(std::vector<unsigned char> bytes);
+	static std::string BytesToHex(const std::vector<unsigned char>& bytes);
+	// Write 2 * dataSize lowercase hex characters to out
+	static void BytesToHex(const unsigned char* data, const size_t dataSize, char* out) noexcept;
 
+	// Returns an empty vector if the input is not valid hex
 	static std::vector<unsigned char> HexToBytes(const std::string& hexString);
+	// Decode size hex characters into size / 2 bytes in out. Returns false if size is odd or a character is not hex.
+	static bool HexToBytes(const char* hex, const size_t size, unsigned char* out) noexcept;
 
 	static std::string ReplaceAll(const std::string& input, const std::string& target, const std::string& replacement);
 };
@@ -0,0 +1,155 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "CryptoProvider.h"
+#include "Logger.h"
+#include <atomic>
+#include <climits>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <bcrypt.h>
+#pragma comment (lib, "bcrypt.lib")
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+class BCryptProvider : public CryptoProvider
+{
+public:
+	bool PBKDF2SHA512(
+		const unsigned char* password,
+		size_t passwordSize,
+		const unsigned char* salt,
+		size_t saltSize,
+		unsigned long long iterations,
+		unsigned char* out,
+		size_t outSize) override
+	{
+		const ULONG dwFlags = 0; // RESERVED, MUST BE ZERO
+		const NTSTATUS status = BCryptDeriveKeyPBKDF2(
+			BCRYPT_HMAC_SHA512_ALG_HANDLE,
+			const_cast<PUCHAR>(password),
+			(ULONG)passwordSize,
+			const_cast<PUCHAR>(salt),
+			(ULONG)saltSize,
+			iterations,
+			out,
+			(ULONG)outSize,
+			dwFlags);
+
+		if (status != 0) // STATUS_SUCCESS
+		{
+			PIDebugF("BCryptDeriveKeyPBKDF2 failed with error: {}", status);
+			return false;
+		}
+		return true;
+	}
+
+	bool GenerateRandom(unsigned char* buffer, size_t size) override
+	{
+		const NTSTATUS status = BCryptGenRandom(BCRYPT_RNG_ALG_HANDLE, buffer, (ULONG)size, 0);
+		if (status != 0)
+		{
+			PIErrorF("BCryptGenRandom failed with error: {}", status);
+			return false;
+		}
+		return true;
+	}
+
+	std::string GetName() const override { return CRYPTO_PROVIDER_BCRYPT; }
+};
+#endif
+
+class OpenSSLProvider : public CryptoProvider
+{
+public:
+	bool PBKDF2SHA512(
+		const unsigned char* password,
+		size_t passwordSize,
+		const unsigned char* salt,
+		size_t saltSize,
+		unsigned long long iterations,
+		unsigned char* out,
+		size_t outSize) override
+	{
+		if (passwordSize > INT_MAX || saltSize > INT_MAX || iterations > INT_MAX || outSize > INT_MAX)
+		{
+			PIError("PBKDF2 parameters exceed the range supported by OpenSSL");
+			return false;
+		}
+
+		if (PKCS5_PBKDF2_HMAC(reinterpret_cast<const char*>(password), (int)passwordSize, salt, (int)saltSize,
+			(int)iterations, EVP_sha512(), (int)outSize, out) != 1)
+		{
+			PIDebug("PKCS5_PBKDF2_HMAC failed");
+			return false;
+		}
+		return true;
+	}
+
+	bool GenerateRandom(unsigned char* buffer, size_t size) override
+	{
+		if (size > INT_MAX || RAND_bytes(buffer, (int)size) != 1)
+		{
+			PIError("RAND_bytes failed");
+			return false;
+		}
+		return true;
+	}
+
+	std::string GetName() const override { return CRYPTO_PROVIDER_OPENSSL; }
+};
+
+static OpenSSLProvider openSSLProvider;
+#ifdef _WIN32
+static BCryptProvider bcryptProvider;
+#endif
+
+#if defined(_WIN32) && !defined(PI_CRYPTO_OPENSSL)
+static atomic<CryptoProvider*> selectedProvider{ &bcryptProvider };
+#else
+static atomic<CryptoProvider*> selectedProvider{ &openSSLProvider };
+#endif
+
+CryptoProvider& CryptoProvider::Get()
+{
+	return *selectedProvider.load();
+}
+
+bool CryptoProvider::Select(const std::string& name)
+{
+	if (name == CRYPTO_PROVIDER_OPENSSL)
+	{
+		selectedProvider.store(&openSSLProvider);
+		return true;
+	}
+#ifdef _WIN32
+	if (name == CRYPTO_PROVIDER_BCRYPT)
+	{
+		selectedProvider.store(&bcryptProvider);
+		return true;
+	}
+#endif
+	PIErrorF("Crypto provider {} is not available", name);
+	return false;
+}
@@ -0,0 +1,67 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <string>
+
+constexpr auto CRYPTO_PROVIDER_BCRYPT = "bcrypt";
+constexpr auto CRYPTO_PROVIDER_OPENSSL = "openssl";
+
+/// <summary>
+/// Interface for the cryptographic primitives used by the offline and WebAuthn verification.
+/// On Windows, BCrypt is used by default. Defining PI_CRYPTO_OPENSSL at build time makes OpenSSL the default,
+/// which is the only implementation available on other platforms. The provider can also be changed at runtime with Select.
+/// </summary>
+class CryptoProvider
+{
+public:
+	virtual ~CryptoProvider() = default;
+
+	/// <summary>
+	/// Derive outSize bytes with PBKDF2 using HMAC-SHA512.
+	/// </summary>
+	/// <returns>true on success</returns>
+	virtual bool PBKDF2SHA512(
+		const unsigned char* password,
+		size_t passwordSize,
+		const unsigned char* salt,
+		size_t saltSize,
+		unsigned long long iterations,
+		unsigned char* out,
+		size_t outSize) = 0;
+
+	/// <summary>
+	/// Fill the buffer with cryptographically secure random bytes.
+	/// </summary>
+	/// <returns>true on success</returns>
+	virtual bool GenerateRandom(unsigned char* buffer, size_t size) = 0;
+
+	virtual std::string GetName() const = 0;
+
+	/// <summary>
+	/// Get the provider that is currently selected.
+	/// </summary>
+	static CryptoProvider& Get();
+
+	/// <summary>
+	/// Select the provider to use by name (CRYPTO_PROVIDER_BCRYPT, CRYPTO_PROVIDER_OPENSSL).
+	/// </summary>
+	/// <returns>false if the provider is not available in this build. The selection is unchanged then.</returns>
+	static bool Select(const std::string& name);
+};
@@ -21,8 +21,9 @@
 #include "Endpoint.h"
 #include "Logger.h"
 #include "Convert.h"
-#include <winhttp.h>
 #include <atlutil.h>
+#include <thread>
+#include <atomic>
 
 #pragma comment(lib, "winhttp.lib")
 
@@ -31,64 +32,69 @@
 using namespace std;
 
 vector<std::string> _excludedEndpoints = { PI_ENDPOINT_POLLTRANSACTION };
+// The responses of these endpoints are logged by JsonParser::ParseResponse, so that they are only parsed once
+vector<std::string> _parsedEndpoints = { PI_ENDPOINT_VALIDATE_CHECK };
 
 HRESULT Endpoint::GetLastErrorCode()
 {
 	return _lastErrorCode;
 }
 
-std::string Endpoint::URLEncode(const std::string& in)
+bool Endpoint::URLEncode(const char* in, size_t size, SecureString& out)
 {
-	if (in.empty())
+	if (size == 0)
 	{
-		return in;
+		return true;
 	}
-	const size_t maxLen = (in.size() * 3);
-	DWORD* pdwWritten = nullptr;
-	LPSTR buf = (char*)malloc(sizeof(char) * maxLen);
-	if (buf == nullptr)
+
+	// Escape directly into the body, so that there is no intermediate copy of the value
+	const size_t start = out.size();
+	const size_t maxLen = size * 3 + 1;
+	out.resize(start + maxLen);
+	DWORD written = 0;
+	if (!AtlEscapeUrl(in, out.data() + start, &written, (DWORD)maxLen, ATL_URL_ENCODE_PERCENT))
 	{
-		PIDebug("malloc fail");
-		return "";
+		PIErrorF("AtlEscapeUrl Failure {}", GetLastError());
+		out.resize(start);
+		return false;
+	}
+	out.resize(start + strnlen(out.c_str() + start, maxLen));
+	return true;
+}
+
+void Endpoint::AppendParameter(SecureString& body, const std::string& name, const char* value, size_t size)
+{
+	if (!body.empty())
+	{
+		body.push_back('&');
 	}
-	std::string ret;
+	body.append(name.c_str(), name.size());
+	body.push_back('=');
+	const size_t start = body.size();
+	URLEncode(value, size, body);
 
-	if (AtlEscapeUrl(in.c_str(), buf, pdwWritten, (DWORD)maxLen, ATL_URL_ENCODE_PERCENT))
+	if (name != "pass" || _config.logPasswords)
 	{
-		ret = std::string(buf);
+		PIDebugF("{}={}", name, string(body.c_str() + start, body.size() - start));
 	}
 	else
 	{
-		PIError("AtlEscapeUrl Failure " + to_string(GetLastError()));
+		PIDebug("pass parameter is not logged");
 	}
-
-	SecureZeroMemory(buf, (sizeof(char) * maxLen));
-	free(buf);
-	return ret;
 }
 
-std::string Endpoint::EncodeRequestParameters(const std::map<std::string, std::string>& parameters)
+SecureString Endpoint::EncodeRequestParameters(const std::map<std::string, std::string>& parameters, const SecureString* pass)
 {
 	PIDebug("Request parameters:");
-	string ret;
+	SecureString ret;
 	for (auto& entry : parameters)
 	{
-		auto encoded = URLEncode(entry.second);
-		ret += entry.first + "=" + encoded + "&";
-		if (entry.first != "pass" || _config.logPasswords)
-		{
-			PIDebug(entry.first + "=" + encoded);
-		}
-		else
-		{
-			PIDebug("pass parameter is not logged");
-		}
+		AppendParameter(ret, entry.first, entry.second.c_str(), entry.second.size());
 	}
 
-	// Cut trailing &
-	if (ret.size() > 1)
+	if (pass)
 	{
-		ret = ret.substr(0, ret.size() - 1);
+		AppendParameter(ret, "pass", pass->c_str(), pass->size());
 	}
 	return ret;
 }
@@ -96,6 +102,7 @@ std::string Endpoint::EncodeRequestParameters(const std::map<std::string, std::s
 wstring Endpoint::EncodeUTF16(const std::string& str, int codepage)
 {
 	if (str.empty()) return wstring();
+	if (codepage == CP_UTF8) return Convert::ToWString(str);
 	int sz = MultiByteToWideChar(codepage, 0, &str[0], (int)str.size(), 0, 0);
 	wstring res(sz, 0);
 	MultiByteToWideChar(codepage, 0, &str[0], (int)str.size(), &res[0], sz);
@@ -154,32 +161,14 @@ void CALLBACK WinHttpStatusCallback(
 						break;
 				}
 
-				PIError("SECURE_FAILURE with status info: " + strDetail);
+				PIErrorF("SECURE_FAILURE with status info: {}", strDetail);
 			}
 			break;
 	}
 }
 
-string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::string, std::string>& parameters, const std::map<std::string, std::string>& headers, const RequestMethod& method)
+HINTERNET Endpoint::OpenSession()
 {
-	PIDebug(string(__FUNCTION__) + " to " + endpoint);
-	// Prepare the parameters
-	wstring wHostname = EncodeUTF16(Convert::ToString(_config.hostname), CP_UTF8);
-	// the api endpoint needs to be appended to the path then converted, because the "full path" is set separately in winhttp
-	wstring fullPath = EncodeUTF16((Convert::ToString(_config.path) + endpoint), CP_UTF8);
-
-	string strData = EncodeRequestParameters(parameters);
-
-	LPSTR data = _strdup(strData.c_str());
-	const DWORD data_len = (DWORD)strnlen_s(strData.c_str(), MAXDWORD32);
-	LPCWSTR requestMethod = (method == RequestMethod::GET ? L"GET" : L"POST");
-
-	DWORD dwSize = 0;
-	DWORD dwDownloaded = 0;
-	LPSTR pszOutBuffer = nullptr;
-	BOOL  bResults = FALSE;
-	HINTERNET  hSession = nullptr, hConnect = nullptr, hRequest = nullptr;
-
 	// Check the windows version to decide which access type flag to set
 	DWORD dwAccessType = WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY;
 	OSVERSIONINFOEX info;
@@ -194,54 +183,200 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 	}
 
 	// Use WinHttpOpen to obtain a session handle.
-	hSession = WinHttpOpen(_config.userAgent.c_str(),
+	HINTERNET hSession = WinHttpOpen(_config.userAgent.c_str(),
 		dwAccessType,
 		WINHTTP_NO_PROXY_NAME,
 		WINHTTP_NO_PROXY_BYPASS, 0);
 
-	// Specify an HTTP server.
 	if (hSession)
 	{
-		// Set the callback and optionally a port other than default https
+		// Set the callback
 		WinHttpSetStatusCallback(
 			hSession,
 			(WINHTTP_STATUS_CALLBACK)WinHttpStatusCallback,
 			WINHTTP_CALLBACK_FLAG_ALL_NOTIFICATIONS,
 			NULL);
-
-		int port = (_config.customPort != 0) ? _config.customPort : INTERNET_DEFAULT_HTTPS_PORT;
-		hConnect = WinHttpConnect(hSession, wHostname.c_str(), (INTERNET_PORT)port, 0);
 	}
 	else
 	{
-		PIError("WinHttpOpen failure: " + to_string(GetLastError()));
+		PIErrorF("WinHttpOpen failure: {}", GetLastError());
+	}
+
+	return hSession;
+}
+
+HINTERNET Endpoint::OpenConnection(HINTERNET hSession)
+{
+	const wstring& wHostname = _config.hostname;
+	// Optionally use a port other than default https
+	int port = (_config.customPort != 0) ? _config.customPort : INTERNET_DEFAULT_HTTPS_PORT;
+	HINTERNET hConnect = WinHttpConnect(hSession, wHostname.c_str(), (INTERNET_PORT)port, 0);
+	if (!hConnect)
+	{
+		PIErrorF("WinHttpConnect failure: {}", GetLastError());
+	}
+	return hConnect;
+}
+
+string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::string, std::string>& parameters, const std::map<std::string, std::string>& headers, const RequestMethod& method)
+{
+	return SendRequest(endpoint, parameters, nullptr, headers, method);
+}
+
+string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::string, std::string>& parameters, const SecureString& pass, const std::map<std::string, std::string>& headers, const RequestMethod& method)
+{
+	return SendRequest(endpoint, parameters, &pass, headers, method);
+}
+
+string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::string, std::string>& parameters, const SecureString* pass, const std::map<std::string, std::string>& headers, const RequestMethod& method)
+{
+	PIDebugF("{} to {}", __FUNCTION__, endpoint);
+
+	HINTERNET hSession = OpenSession();
+	if (!hSession)
+	{
 		_lastErrorCode = PI_ERROR_ENDPOINT_SETUP;
 		return "";
 	}
-	// Create an HTTPS request handle. SSL indicated by WINHTTP_FLAG_SECURE
-	if (hConnect)
+
+	HINTERNET hConnect = OpenConnection(hSession);
+	if (!hConnect)
 	{
-		hRequest = WinHttpOpenRequest(hConnect, requestMethod, fullPath.c_str(),
-			NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
+		WinHttpCloseHandle(hSession);
+		_lastErrorCode = PI_ERROR_ENDPOINT_SETUP;
+		return "";
 	}
-	else
+
+	string response;
+	const HRESULT res = SendOnConnection(hConnect, endpoint, parameters, pass, headers, method, response);
+
+	WinHttpCloseHandle(hConnect);
+	WinHttpCloseHandle(hSession);
+
+	if (res != S_OK)
+	{
+		_lastErrorCode = res;
+	}
+
+	return response;
+}
+
+std::vector<EndpointResponse> Endpoint::SendRequests(
+	const std::string& endpoint,
+	const std::vector<std::map<std::string, std::string>>& parameterSets,
+	const RequestMethod& method,
+	size_t maxConcurrency)
+{
+	return SendRequests(endpoint, parameterSets, std::vector<const SecureString*>(parameterSets.size(), nullptr), method, maxConcurrency);
+}
+
+std::vector<EndpointResponse> Endpoint::SendRequests(
+	const std::string& endpoint,
+	const std::vector<std::map<std::string, std::string>>& parameterSets,
+	const std::vector<const SecureString*>& passes,
+	const RequestMethod& method,
+	size_t maxConcurrency)
+{
+	PIDebugF("{} to {} ({} requests)", __FUNCTION__, endpoint, parameterSets.size());
+	std::vector<EndpointResponse> responses(parameterSets.size());
+	if (parameterSets.empty())
 	{
-		PIError("WinHttpOpenRequest failure: " + to_string(GetLastError()));
+		return responses;
+	}
+
+	HINTERNET hSession = OpenSession();
+	HINTERNET hConnect = hSession ? OpenConnection(hSession) : nullptr;
+	if (!hConnect)
+	{
+		if (hSession) WinHttpCloseHandle(hSession);
+		for (auto& response : responses)
+		{
+			response.result = PI_ERROR_ENDPOINT_SETUP;
+		}
 		_lastErrorCode = PI_ERROR_ENDPOINT_SETUP;
-		return "";
+		return responses;
 	}
 
-	// Set Option Security Flags to start TLS
+	// All requests share the connection handle so that WinHttp can reuse the connection (keep-alive) for them.
+	// A bounded number of workers takes the next request until all are done.
+	std::atomic<size_t> next = 0;
+	auto worker = [&]()
+	{
+		size_t i;
+		while ((i = next.fetch_add(1)) < parameterSets.size())
+		{
+			const SecureString* pass = i < passes.size() ? passes[i] : nullptr;
+			responses[i].result = SendOnConnection(hConnect, endpoint, parameterSets[i], pass, std::map<std::string, std::string>(), method, responses[i].body);
+		}
+	};
+
+	size_t workerCount = maxConcurrency < parameterSets.size() ? maxConcurrency : parameterSets.size();
+	if (workerCount == 0)
+	{
+		workerCount = 1;
+	}
+	std::vector<std::thread> workers;
+	for (size_t i = 1; i < workerCount; i++)
+	{
+		workers.emplace_back(worker);
+	}
+	worker();
+	for (auto& t : workers)
+	{
+		t.join();
+	}
+
+	WinHttpCloseHandle(hConnect);
+	WinHttpCloseHandle(hSession);
+
+	return responses;
+}
+
+HRESULT Endpoint::SendOnConnection(
+	HINTERNET hConnect,
+	const std::string& endpoint,
+	const std::map<std::string, std::string>& parameters,
+	const SecureString* pass,
+	const std::map<std::string, std::string>& headers,
+	const RequestMethod& method,
+	std::string& response)
+{
+	// the api endpoint needs to be appended to the path then converted, because the "full path" is set separately in winhttp
+	wstring fullPath = _config.path + Convert::ToWString(endpoint);
+
+	// The body is wiped when it goes out of scope
+	SecureString body = EncodeRequestParameters(parameters, pass);
+	LPSTR data = body.data();
+	const DWORD data_len = (DWORD)body.size();
+	LPCWSTR requestMethod = (method == RequestMethod::GET ? L"GET" : L"POST");
+
+	DWORD dwSize = 0;
+	DWORD dwDownloaded = 0;
+	LPSTR pszOutBuffer = nullptr;
+	BOOL  bResults = FALSE;
+	HRESULT hr = S_OK;
 	DWORD dwReqOpts = 0;
+	DWORD dwSSLFlags = 0;
+
+	// Create an HTTPS request handle. SSL indicated by WINHTTP_FLAG_SECURE
+	HINTERNET hRequest = WinHttpOpenRequest(hConnect, requestMethod, fullPath.c_str(),
+		NULL, WINHTTP_NO_REFERER, WINHTTP_DEFAULT_ACCEPT_TYPES, WINHTTP_FLAG_SECURE);
+	if (!hRequest)
+	{
+		PIErrorF("WinHttpOpenRequest failure: {}", GetLastError());
+		hr = PI_ERROR_ENDPOINT_SETUP;
+		goto Exit;
+	}
+
+	// Set Option Security Flags to start TLS
 	if (!WinHttpSetOption(hRequest, WINHTTP_OPTION_SECURITY_FLAGS, &dwReqOpts, sizeof(DWORD)))
 	{
-		PIError("WinHttpSetOption to set TLS flag failure: " + to_string(GetLastError()));
-		_lastErrorCode = PI_ERROR_ENDPOINT_SETUP;
-		return "";
+		PIErrorF("WinHttpSetOption to set TLS flag failure: {}", GetLastError());
+		hr = PI_ERROR_ENDPOINT_SETUP;
+		goto Exit;
 	}
 
 	/////////// SET THE FLAGS TO IGNORE SSL ERRORS, IF SPECIFIED /////////////////
-	DWORD dwSSLFlags = 0;
 	if (_config.ignoreUnknownCA)
 	{
 		dwSSLFlags = SECURITY_FLAG_IGNORE_UNKNOWN_CA;
@@ -262,9 +397,9 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 		}
 		else
 		{
-			PIError("WinHttpSetOption for SSL flags failure: " + to_string(GetLastError()));
-			_lastErrorCode = PI_ERROR_ENDPOINT_SETUP;
-			return "";
+			PIErrorF("WinHttpSetOption for SSL flags failure: {}", GetLastError());
+			hr = PI_ERROR_ENDPOINT_SETUP;
+			goto Exit;
 		}
 	}
 	///////////////////////////////////////////////////////////////////////////////
@@ -272,7 +407,7 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 	// Set timeouts on the request handle
 	if (!WinHttpSetTimeouts(hRequest, _config.resolveTimeout, _config.connectTimeout, _config.sendTimeout, _config.receiveTimeout))
 	{
-		PIError("Failed to set timeouts on hRequest: " + to_string(GetLastError()));
+		PIErrorF("Failed to set timeouts on hRequest: {}", GetLastError());
 		// Continue with defaults
 	}
 
@@ -281,48 +416,56 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 	{
 		if (!WinHttpAddRequestHeaders(hRequest, Convert::ToWString(entry.first + ": " + entry.second).c_str(), (DWORD)-1L, WINHTTP_ADDREQ_FLAG_ADD))
 		{
-			PIError("Failed to add header " + entry.first + ": " + entry.second + " to request: " + to_string(GetLastError()));
+			PIErrorF("Failed to add header {}: {} to request: {}", entry.first, entry.second, GetLastError());
 		}
 	}
 
-	// Send the request
-	if (hRequest)
+	// Only the blocking calls from here on can be interrupted by Cancel. It is checked before each of them, because a
+	// handle that Cancel has closed must not be used anymore.
+	if (!TrackRequest(hRequest))
 	{
-		bResults = WinHttpSendRequest(
-			hRequest,
-			L"Content-Type: application/x-www-form-urlencoded\r\n",
-			(DWORD)-1,
-			(LPVOID)data,
-			data_len,
-			data_len,
-			0);
+		WinHttpCloseHandle(hRequest);
+		hRequest = nullptr;
+		hr = PI_ERROR_REQUEST_CANCELLED;
+		goto Exit;
 	}
 
+	// Send the request
+	bResults = WinHttpSendRequest(
+		hRequest,
+		L"Content-Type: application/x-www-form-urlencoded\r\n",
+		(DWORD)-1,
+		(LPVOID)data,
+		data_len,
+		data_len,
+		0);
+
 	if (!bResults)
 	{
 		// This happens in case of timeout using offline OTP vvv will be 120002
-		PIError("WinHttpSendRequest failure: " + to_string(GetLastError()));
-		_lastErrorCode = PI_ERROR_SERVER_UNAVAILABLE;
-		return "";
+		PIErrorF("WinHttpSendRequest failure: {}", GetLastError());
+		hr = PI_ERROR_SERVER_UNAVAILABLE;
+		goto Exit;
 	}
 
 	// End the request.
-	if (bResults)
-	{
-		bResults = WinHttpReceiveResponse(hRequest, NULL);
-	}
+	bResults = IsRequestOpen(hRequest) && WinHttpReceiveResponse(hRequest, NULL);
 
 	// Keep checking for data until there is nothing left.
-	string response;
 	if (bResults)
 	{
 		do
 		{
 			// Check for available data.
 			dwSize = 0;
+			if (!IsRequestOpen(hRequest))
+			{
+				response = "";
+				break;
+			}
 			if (!WinHttpQueryDataAvailable(hRequest, &dwSize))
 			{
-				PIError("WinHttpQueryDataAvailable failure: " + to_string(GetLastError()));
+				PIErrorF("WinHttpQueryDataAvailable failure: {}", GetLastError());
 				response = ""; //ENDPOINT_ERROR_RESPONSE_ERROR;
 			}
 
@@ -330,7 +473,7 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 			pszOutBuffer = new char[ULONGLONG(dwSize) + 1];
 			if (!pszOutBuffer)
 			{
-				PIError("WinHttpReadData out of memory: " + to_string(GetLastError()));
+				PIErrorF("WinHttpReadData out of memory: {}", GetLastError());
 				response = ""; // ENDPOINT_ERROR_RESPONSE_ERROR;
 				dwSize = 0;
 			}
@@ -338,10 +481,12 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 			{
 				// Read the data.
 				ZeroMemory(pszOutBuffer, (ULONGLONG)dwSize + 1);
-				if (!WinHttpReadData(hRequest, (LPVOID)pszOutBuffer, dwSize, &dwDownloaded))
+				if (!IsRequestOpen(hRequest) || !WinHttpReadData(hRequest, (LPVOID)pszOutBuffer, dwSize, &dwDownloaded))
 				{
-					PIError("WinHttpReadData error: " + to_string(GetLastError()));
+					PIErrorF("WinHttpReadData error: {}", GetLastError());
 					response = "";// ENDPOINT_ERROR_RESPONSE_ERROR;
+					// Reading on would use a handle that might be closed
+					dwSize = 0;
 				}
 				else
 				{
@@ -355,21 +500,18 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 	// Report any errors.
 	if (!bResults)
 	{
-		PIError("WinHttp Result error: " + to_string(GetLastError()));
+		PIErrorF("WinHttp Result error: {}", GetLastError());
 		response = "";// ENDPOINT_ERROR_RESPONSE_ERROR;
 	}
-	// Close any open handles.
-	if (hRequest) WinHttpCloseHandle(hRequest);
-	if (hConnect) WinHttpCloseHandle(hConnect);
-	if (hSession) WinHttpCloseHandle(hSession);
 
-	SecureZeroMemory(data, data_len);
-
-	if (std::find(_excludedEndpoints.begin(), _excludedEndpoints.end(), endpoint) == _excludedEndpoints.end())
+	if (Logger::Get().logDebug && std::find(_excludedEndpoints.begin(), _excludedEndpoints.end(), endpoint) == _excludedEndpoints.end())
 	{
 		if (!response.empty())
 		{
-			PIDebug(JsonParser::PrettyFormatJson(response));
+			if (std::find(_parsedEndpoints.begin(), _parsedEndpoints.end(), endpoint) == _parsedEndpoints.end())
+			{
+				PIDebug(JsonParser::PrettyFormatJson(response));
+			}
 		}
 		else
 		{
@@ -379,8 +521,65 @@ string Endpoint::SendRequest(const std::string& endpoint, const std::map<std::st
 
 	if (response.empty())
 	{
-		_lastErrorCode = PI_ERROR_SERVER_UNAVAILABLE;
+		hr = PI_ERROR_SERVER_UNAVAILABLE;
 	}
 
-	return response;
+Exit:
+	// Close any open handles. If the request was cancelled, Cancel has closed it and the calls above failed because of that.
+	if (hRequest)
+	{
+		if (UntrackRequest(hRequest))
+		{
+			WinHttpCloseHandle(hRequest);
+		}
+		else
+		{
+			PIDebugF("Request to {} was cancelled", endpoint);
+			response.clear();
+			hr = PI_ERROR_REQUEST_CANCELLED;
+		}
+	}
+
+	return hr;
+}
+
+void Endpoint::Cancel()
+{
+	lock_guard<mutex> lock(_requestsMutex);
+	_cancelled = true;
+	// Closing the handle makes the WinHttp call that is waiting for it return with ERROR_WINHTTP_OPERATION_CANCELLED
+	for (HINTERNET hRequest : _requests)
+	{
+		WinHttpCloseHandle(hRequest);
+	}
+	_requests.clear();
+}
+
+bool Endpoint::TrackRequest(HINTERNET hRequest)
+{
+	lock_guard<mutex> lock(_requestsMutex);
+	if (_cancelled)
+	{
+		return false;
+	}
+	_requests.push_back(hRequest);
+	return true;
+}
+
+bool Endpoint::IsRequestOpen(HINTERNET hRequest)
+{
+	lock_guard<mutex> lock(_requestsMutex);
+	return std::find(_requests.begin(), _requests.end(), hRequest) != _requests.end();
+}
+
+bool Endpoint::UntrackRequest(HINTERNET hRequest)
+{
+	lock_guard<mutex> lock(_requestsMutex);
+	auto it = std::find(_requests.begin(), _requests.end(), hRequest);
+	if (it == _requests.end())
+	{
+		return false;
+	}
+	_requests.erase(it);
+	return true;
 }
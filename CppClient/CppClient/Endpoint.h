@@ -21,11 +21,16 @@
 
 #include "Challenge.h"
 #include "PIConfig.h"
+#include "SecureString.h"
 #include <map>
+#include <mutex>
+#include <vector>
 #include <Windows.h>
+#include <winhttp.h>
 
 #define PI_ERROR_SERVER_UNAVAILABLE					((HRESULT)0x88809014)
 #define PI_ERROR_ENDPOINT_SETUP						((HRESULT)0x88809015)
+#define PI_ERROR_REQUEST_CANCELLED					((HRESULT)0x88809016)
 
 enum class RequestMethod
 {
@@ -33,6 +38,12 @@ enum class RequestMethod
 	POST
 };
 
+struct EndpointResponse
+{
+	HRESULT result = S_OK;
+	std::string body;
+};
+
 class Endpoint
 { 
 public:
@@ -44,18 +55,92 @@ public:
 		const std::map<std::string, std::string>& headers = std::map<std::string, std::string>(),
 		const RequestMethod& method = RequestMethod::POST);
 
+	/// <summary>
+	/// Send a request with the "pass" parameter taken from a SecureString. The password or OTP is only encoded into the
+	/// request body, which is also a SecureString.
+	/// </summary>
+	std::string SendRequest(
+		const std::string& endpoint,
+		const std::map<std::string, std::string>& parameters,
+		const SecureString& pass,
+		const std::map<std::string, std::string>& headers = std::map<std::string, std::string>(),
+		const RequestMethod& method = RequestMethod::POST);
+
+	/// <summary>
+	/// Send multiple requests to the same endpoint over one connection, with at most maxConcurrency requests in flight.
+	/// </summary>
+	/// <returns>The responses in the order of the parameter sets. Each has its own result code.</returns>
+	std::vector<EndpointResponse> SendRequests(
+		const std::string& endpoint,
+		const std::vector<std::map<std::string, std::string>>& parameterSets,
+		const RequestMethod& method = RequestMethod::POST,
+		size_t maxConcurrency = 4);
+
+	/// <summary>
+	/// Like SendRequests, with the "pass" parameter of each request taken from a SecureString like with SendRequest.
+	/// </summary>
+	/// <param name="passes">One per parameter set, null for a request without "pass"</param>
+	std::vector<EndpointResponse> SendRequests(
+		const std::string& endpoint,
+		const std::vector<std::map<std::string, std::string>>& parameterSets,
+		const std::vector<const SecureString*>& passes,
+		const RequestMethod& method = RequestMethod::POST,
+		size_t maxConcurrency = 4);
+
 	HRESULT GetLastErrorCode();
 
+	/// <summary>
+	/// Abort the requests that are in progress and fail all following requests with PI_ERROR_REQUEST_CANCELLED.
+	/// Can be called from any thread, e.g. to stop a background thread that is waiting for the server.
+	/// </summary>
+	void Cancel();
+
 private:
+	HINTERNET OpenSession();
 
-	std::string EncodeRequestParameters(const std::map<std::string, std::string>& parameters);
+	HINTERNET OpenConnection(HINTERNET hSession);
+
+	std::string SendRequest(
+		const std::string& endpoint,
+		const std::map<std::string, std::string>& parameters,
+		const SecureString* pass,
+		const std::map<std::string, std::string>& headers,
+		const RequestMethod& method);
+
+	HRESULT SendOnConnection(
+		HINTERNET hConnect,
+		const std::string& endpoint,
+		const std::map<std::string, std::string>& parameters,
+		const SecureString* pass,
+		const std::map<std::string, std::string>& headers,
+		const RequestMethod& method,
+		std::string& response);
+
+	// Build the form encoded body, pass is appended if it is not null
+	SecureString EncodeRequestParameters(const std::map<std::string, std::string>& parameters, const SecureString* pass);
+
+	void AppendParameter(SecureString& body, const std::string& name, const char* value, size_t size);
 
 	std::wstring EncodeUTF16(const std::string& str, int codepage);
 
-	std::string URLEncode(const std::string& in);
+	// Append the percent encoded input to out
+	bool URLEncode(const char* in, size_t size, SecureString& out);
+
+	// Remember the request so that Cancel can close it. Returns false if the endpoint is already cancelled.
+	bool TrackRequest(HINTERNET hRequest);
+
+	// False if Cancel has closed the request, the handle must not be used anymore then
+	bool IsRequestOpen(HINTERNET hRequest);
+
+	// Returns false if Cancel has closed the request already
+	bool UntrackRequest(HINTERNET hRequest);
 
 	HRESULT _lastErrorCode = 0;
 
+	std::mutex _requestsMutex;
+	std::vector<HINTERNET> _requests;
+	bool _cancelled = false;
+
 	PIConfig _config;
 };
 
@@ -17,16 +17,15 @@
 **
 ** * * * * * * * * * * * * * * * * * * */
 #include "Convert.h"
+#include "CryptoProvider.h"
 #include "FIDO2Device.h"
 #include "Logger.h"
 #include "PrivacyIDEA.h"
-#include <cbor.h>
-#include <fido/es256.h>
 
 std::vector<FIDO2Device> FIDO2Device::GetDevices()
 {
 	PIDebug("Searching for connected FIDO2 devices");
-	PIDebug("Filtering Windows Hello: " + std::to_string(filterWinHello));
+	PIDebugF("Filtering Windows Hello: {}", std::to_string(filterWinHello));
 	fido_init(fidoFlags);
 	std::vector<FIDO2Device> ret;
 	size_t ndevs;
@@ -41,7 +40,7 @@ std::vector<FIDO2Device> FIDO2Device::GetDevices()
 	if ((res = fido_dev_info_manifest(deviceList, 64, &ndevs)) != FIDO_OK)
 	{
 		std::string fidoStrerr = fido_strerr(res);
-		PIError("fido_dev_info_manifest: " + fidoStrerr + " " + std::to_string(res));
+		PIErrorF("fido_dev_info_manifest: {} {}", fidoStrerr, res);
 		return ret;
 	}
 
@@ -70,7 +69,7 @@ FIDO2Device::FIDO2Device(const fido_dev_info_t* devinfo)
 	int res = fido_dev_open_with_info(dev);
 	if (res != FIDO_OK)
 	{
-		PIError("fido_dev_open_with_info: " + std::string(fido_strerr(res)) + " " + std::to_string(res));
+		PIErrorF("fido_dev_open_with_info: {} {}", fido_strerr(res), res);
 	}
 	else
 	{
@@ -80,7 +79,7 @@ FIDO2Device::FIDO2Device(const fido_dev_info_t* devinfo)
 		_hasPin = fido_dev_has_pin(dev);
 		_isWinHello = fido_dev_is_winhello(dev);
 		_hasUV = fido_dev_has_uv(dev);
-		PIDebug("New FIDO2 device: " + _manufacturer + " " + _product + " " + _path + " hasPin: " + std::to_string(_hasPin) + " isWinHello: " + std::to_string(_isWinHello));
+		PIDebugF("New FIDO2 device: {} {} {} hasPin: {} isWinHello: {}", _manufacturer, _product, _path, std::to_string(_hasPin), std::to_string(_isWinHello));
 
 		fido_dev_close(dev);
 	}
@@ -89,7 +88,7 @@ FIDO2Device::FIDO2Device(const fido_dev_info_t* devinfo)
 int GetAssert(
 	const WebAuthnSignRequest& signRequest, 
 	const std::string& origin,
-	const std::string& pin,
+	const SecureString& pin,
 	const std::string& devicePath, 
 	fido_assert_t** assert, 
 	std::vector<unsigned char>& clientDataOut)
@@ -116,7 +115,7 @@ int GetAssert(
 		res = fido_assert_allow_cred(*assert, cred.data(), cred.size());
 		if (res != FIDO_OK)
 		{
-			PIDebug("fido_assert_allow_cred: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+			PIDebugF("fido_assert_allow_cred: {} code: {}", fido_strerr(res), res);
 		}
 	}
 
@@ -126,21 +125,21 @@ int GetAssert(
 	res = fido_assert_set_clientdata(*assert, clientDataOut.data(), clientDataOut.size());
 	if (res != FIDO_OK)
 	{
-		PIDebug("fido_assert_set_clientdata: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+		PIDebugF("fido_assert_set_clientdata: {} code: {}", fido_strerr(res), res);
 	}
 
 	// RP
 	res = fido_assert_set_rp(*assert, signRequest.rpId.c_str());
 	if (res != FIDO_OK)
 	{
-		PIDebug("fido_assert_set_rp: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+		PIDebugF("fido_assert_set_rp: {} code: {}", fido_strerr(res), res);
 	}
 
 	// EXT TODO
 	res = fido_assert_set_extensions(*assert, NULL);
 	if (res != FIDO_OK)
 	{
-		PIDebug("fido_assert_set_extensions: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+		PIDebugF("fido_assert_set_extensions: {} code: {}", fido_strerr(res), res);
 	}
 
 	// TODO userhandle?
@@ -161,7 +160,7 @@ int GetAssert(
 	}
 	else
 	{
-		PIDebug("fido_dev_open: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+		PIDebugF("fido_dev_open: {} code: {}", fido_strerr(res), res);
 	}
 	
 	return res;
@@ -170,7 +169,7 @@ int GetAssert(
 int FIDO2Device::Sign(
 	const WebAuthnSignRequest& signRequest, 
 	const std::string& origin,
-	const std::string& pin, 
+	const SecureString& pin, 
 	WebAuthnSignResponse& signResponse) const
 {
 	fido_assert_t* assert = nullptr;
@@ -179,7 +178,7 @@ int FIDO2Device::Sign(
 
 	if (res != FIDO_OK)
 	{
-		PIDebug("fido_dev_get_assert: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+		PIDebugF("fido_dev_get_assert: {} code: {}", fido_strerr(res), res);
 	}
 	else
 	{
@@ -206,131 +205,21 @@ int FIDO2Device::Sign(
 	return res;
 }
 
-constexpr auto COSE_PUB_KEY_ALG = 3;
-constexpr auto COSE_PUB_KEY_X = -2;
-constexpr auto COSE_PUB_KEY_Y = -3;
-constexpr auto COSE_PUB_KEY_E = -2;
-constexpr auto COSE_PUB_KEY_N = -1;
-
-int EcKeyFromCBOR(
-	const std::string& cborPubKey, 
-	EC_KEY** ecKey, 
-	int* algorithm)
-{
-	int res = FIDO_OK;
-	auto pubKeyBytes = Convert::HexToBytes(cborPubKey);
-	struct cbor_load_result result;
-	cbor_item_t* map = cbor_load(pubKeyBytes.data(), pubKeyBytes.size(), &result);
-	
-	if (map == NULL)
-	{
-		PIError("Failed to parse CBOR public key");
-		return FIDO_ERR_INVALID_ARGUMENT;
-	}
-	if (!cbor_isa_map(map))
-	{
-		PIError("CBOR public key is not a map");
-		cbor_decref(&map);
-		return FIDO_ERR_INVALID_ARGUMENT;
-	}
-
-	size_t size = cbor_map_size(map);
-	cbor_pair* pairs = cbor_map_handle(map);
-	
-	// Find the algorithm
-	int alg = 0;
-	for (int i = 0; i < size; i++)
-	{
-		if (cbor_isa_uint(pairs[i].key) && cbor_get_uint8(pairs[i].key) == COSE_PUB_KEY_ALG)
-		{
-			if (cbor_isa_negint(pairs[i].value))
-			{
-				alg = -1 - cbor_get_int(pairs[i].value);
-			}
-		}
-	}
-
-	// Depending on the algorithm, find the values to build the public key	
-	if (alg == COSE_ES256)
-	{
-		*algorithm = alg;
-		std::vector<uint8_t> x, y;
-		for (int i = 0; i < size; i++)
-		{
-			if (cbor_isa_negint(pairs[i].key))
-			{
-				int key = -1 - cbor_get_int(pairs[i].key);
-				if (key == COSE_PUB_KEY_X)
-				{
-					if (cbor_isa_bytestring(pairs[i].value))
-					{
-						x = std::vector<uint8_t>(cbor_bytestring_handle(pairs[i].value), cbor_bytestring_handle(pairs[i].value) + cbor_bytestring_length(pairs[i].value));
-					}
-				}
-				else if (key == COSE_PUB_KEY_Y)
-				{
-					if (cbor_isa_bytestring(pairs[i].value))
-					{
-						y = std::vector<uint8_t>(cbor_bytestring_handle(pairs[i].value), cbor_bytestring_handle(pairs[i].value) + cbor_bytestring_length(pairs[i].value));
-					}
-				}
-			}
-		}
-
-		if (x.size() != 32)
-		{
-			PIError("COSE_PUB_KEY_X has the wrong size. Expected 32, actual: " + std::to_string(x.size()));
-			cbor_decref(&map);
-			return FIDO_ERR_INVALID_ARGUMENT;
-		}
-		if (y.size() != 32)
-		{
-			PIError("COSE_PUB_KEY_Y has the wrong size. Expected 32, actual: " + std::to_string(y.size()));
-			cbor_decref(&map);
-			return FIDO_ERR_INVALID_ARGUMENT;
-		}
-
-		// secp256r1 is called prime256v1 in OpenSSL (RFC 5480, Section 2.1.1.1)
-		*ecKey = EC_KEY_new_by_curve_name(NID_X9_62_prime256v1);
-		BIGNUM* bnx = BN_new();
-		BN_bin2bn(x.data(), x.size(), bnx);
-		BIGNUM* bny = BN_new();
-		BN_bin2bn(y.data(), y.size(), bny);
-		EC_KEY_set_public_key_affine_coordinates(*ecKey, bnx, bny);
-		BN_free(bnx);
-		BN_free(bny);
-	}
-	else
-	{
-		// TODO implement other COSE algorithms if supported by privacyIDEA
-		PIError("Unimplemented alg: " + std::to_string(alg));
-		res = FIDO_ERR_INVALID_ARGUMENT;
-	}
-
-	cbor_decref(&map);
-	return res;
-}
-
 std::string GenerateRandomAsBase64URL(long size)
 {
-	PUCHAR buf = new UCHAR[size];
-	auto status = BCryptGenRandom(BCRYPT_RNG_ALG_HANDLE, buf, size, 0);
-	if (status != 0)
+	std::vector<unsigned char> buf(size);
+	if (!CryptoProvider::Get().GenerateRandom(buf.data(), buf.size()))
 	{
-		PIError("BCryptGenRandom failed with error: " + std::to_string(status));
-		delete[] buf;
 		return "";
 	}
 
-	std::string ret = Convert::Base64URLEncode(buf, size);
-	delete[] buf;
-	return ret;
+	return Convert::Base64URLEncode(buf);
 }
 
 int FIDO2Device::SignAndVerifyAssertion(
 	const std::vector<OfflineData>& offlineData, 
 	const std::string& origin,
-	const std::string& pin,
+	const SecureString& pin,
 	std::string& serialUsed) const
 {
 	// Make a signRequest from the offlineData
@@ -341,7 +230,7 @@ int FIDO2Device::SignAndVerifyAssertion(
 	{
 		if (item.rpId != signRequest.rpId)
 		{
-			PIError("Offline data for ID " + item.credId + " has different rpId. Expected: " + signRequest.rpId + ", actual: " + item.rpId);
+			PIErrorF("Offline data for ID {} has different rpId. Expected: {}, actual: {}", item.credId, signRequest.rpId, item.rpId);
 			PIError("The data will not be used for offline authentication");
 		}
 		else
@@ -356,78 +245,61 @@ int FIDO2Device::SignAndVerifyAssertion(
 	std::vector<unsigned char> cDataBytes;
 	int res = GetAssert(signRequest, origin, pin, _path, &assert, cDataBytes);
 
-	EC_KEY* ecKey = nullptr;
-	es256_pk_t* pk = es256_pk_new();
-	int algorithm;
-
 	if (res == FIDO_OK)
 	{
 		// Find the credential which signed the assert and use it's public key to verify the signature
 		auto pbId = fido_assert_id_ptr(assert, 0);
 		auto cbId = fido_assert_id_len(assert, 0);
 		auto idUsed = Convert::Base64URLEncode(pbId, cbId);
-		std::string pubKey;
+		const OfflineData* used = nullptr;
 		for (auto& item : offlineData)
 		{
 			if (item.credId == idUsed)
 			{
-				pubKey = item.pubKey;
+				used = &item;
 				serialUsed = item.serial;
 				break;
 			}
 		}
 
-		if (pubKey.empty())
+		// The key is decoded when the data is added to the OfflineHandler, decode it here only for data from elsewhere
+		OfflineData decoded;
+		if (used != nullptr && !used->publicKey)
 		{
-			PIError("No public key provided");
-			return FIDO_ERR_INVALID_ARGUMENT;
+			decoded = *used;
+			decoded.DecodePublicKey();
+			used = &decoded;
 		}
 
-		res = EcKeyFromCBOR(pubKey, &ecKey, &algorithm);
-		if (ecKey == nullptr)
+		if (used == nullptr || !used->publicKey)
 		{
-			PIError("Failed to create EC_KEY");
-			return FIDO_ERR_INTERNAL;
+			PIError("No public key provided");
+			res = FIDO_ERR_INVALID_ARGUMENT;
 		}
-		
 		// TODO other algorithms if privacyidea supports them
-		if (algorithm != COSE_ES256)
+		else if (used->publicKeyAlgorithm != COSE_ES256)
 		{
-			PIError("Unsupported algorithm: " + std::to_string(algorithm));
-			return FIDO_ERR_UNSUPPORTED_OPTION;
+			PIErrorF("Unsupported algorithm: {}", used->publicKeyAlgorithm);
+			res = FIDO_ERR_UNSUPPORTED_OPTION;
 		}
-
-		res = es256_pk_from_EC_KEY(pk, ecKey);
-		if (res == FIDO_OK)
+		else
 		{
-			res = fido_assert_verify(assert, 0, algorithm, pk);
+			res = fido_assert_verify(assert, 0, used->publicKeyAlgorithm, used->publicKey.get());
 			if (res == FIDO_OK)
 			{
 				PIDebug("Assertion verified successfully!");
 			}
 			else
 			{
-				PIError("fido_assert_verify: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+				PIErrorF("fido_assert_verify: {} code: {}", fido_strerr(res), res);
 			}
 		}
-		else
-		{
-			PIError("es256_pk_from_EC_KEY: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
-		}
 	}
 	else
 	{
-		PIError("fido_dev_get_assert: " + std::string(fido_strerr(res)) + " code: " + std::to_string(res));
+		PIErrorF("fido_dev_get_assert: {} code: {}", fido_strerr(res), res);
 	}
 
-	if (pk)
-	{
-		es256_pk_free(&pk);
-	}
-	if (ecKey)
-	{
-		EC_KEY_free(ecKey);
-	}
 	if (assert)
 	{
 		fido_assert_free(&assert);
@@ -21,6 +21,7 @@
 #include "WebAuthnSignRequest.h"
 #include "WebAuthnSignResponse.h"
 #include "OfflineData.h"
+#include "SecureString.h"
 #include <string>
 #include <fido.h>
 #include <vector>
@@ -40,9 +41,9 @@ public:
 	FIDO2Device(const fido_dev_info_t* devinfo);
 	FIDO2Device() = default;
 
-	int Sign(const WebAuthnSignRequest& signRequest, const std::string& origin, const std::string& pin, WebAuthnSignResponse& signResponse) const;
+	int Sign(const WebAuthnSignRequest& signRequest, const std::string& origin, const SecureString& pin, WebAuthnSignResponse& signResponse) const;
 	
-	int SignAndVerifyAssertion(const std::vector<OfflineData>& offlineData, const std::string& origin, const std::string& pin, std::string& serialUsed) const;
+	int SignAndVerifyAssertion(const std::vector<OfflineData>& offlineData, const std::string& origin, const SecureString& pin, std::string& serialUsed) const;
 
 	std::string GetPath() const { return _path; }
 	std::string GetManufacturer() const { return _manufacturer; }
@@ -0,0 +1,83 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "IdentityKey.h"
+#include "Convert.h"
+#include "Utf.h"
+#include <cstdint>
+#include <cwchar>
+
+using namespace std;
+
+// Names up to this length are compared in a buffer on the stack, which covers user names (UNLEN) and domains
+constexpr size_t IDENTITY_STACK_BUFFER_SIZE = 512;
+
+IdentityKey::IdentityKey()
+	: _hash(ComputeHash(nullptr, 0))
+{
+}
+
+IdentityKey::IdentityKey(const std::wstring& name)
+	: _folded(Convert::ToUpperCase(name)), _hash(ComputeHash(_folded.data(), _folded.size()))
+{
+}
+
+IdentityKey::IdentityKey(const std::string& name)
+	: _folded(Convert::ToUpperCase(Convert::ToWString(name))), _hash(ComputeHash(_folded.data(), _folded.size()))
+{
+}
+
+bool IdentityKey::Matches(const std::wstring& name) const
+{
+	if (name.size() != _folded.size()) return false;
+	if (name.size() > IDENTITY_STACK_BUFFER_SIZE) return *this == IdentityKey(name);
+
+	wchar_t buffer[IDENTITY_STACK_BUFFER_SIZE];
+	wmemcpy(buffer, name.data(), name.size());
+	return Matches(buffer, name.size());
+}
+
+bool IdentityKey::Matches(const std::string& name) const
+{
+	wchar_t buffer[IDENTITY_STACK_BUFFER_SIZE];
+	const size_t size = Utf::Utf8ToUtf16(name.data(), name.size(), buffer, IDENTITY_STACK_BUFFER_SIZE);
+	if (size != _folded.size()) return false;
+	if (size > IDENTITY_STACK_BUFFER_SIZE) return *this == IdentityKey(name);
+
+	return Matches(buffer, size);
+}
+
+bool IdentityKey::Matches(wchar_t* name, size_t size) const noexcept
+{
+	// Uppercasing does not change the length, so the size has already been compared
+	Convert::ToUpperCase(name, size);
+	return wmemcmp(name, _folded.data(), size) == 0;
+}
+
+// FNV-1a over the UTF-16 units
+size_t IdentityKey::ComputeHash(const wchar_t* name, size_t size) noexcept
+{
+	uint64_t hash = 14695981039346656037ULL;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= static_cast<uint16_t>(name[i]);
+		hash *= 1099511628211ULL;
+	}
+	return static_cast<size_t>(hash);
+}
@@ -0,0 +1,78 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <string>
+
+/// <summary>
+/// Case insensitive identity of a user name, domain or account. The name is uppercased (see Convert::ToUpperCase) and
+/// hashed once when the key is created. Comparing keys, or a key with a name, does not allocate.
+/// </summary>
+class IdentityKey
+{
+public:
+	// The key of the empty name
+	IdentityKey();
+
+	explicit IdentityKey(const std::wstring& name);
+
+	// From UTF-8
+	explicit IdentityKey(const std::string& name);
+
+	/// <summary>
+	/// Check if the name is the same identity as this key, without creating a key for it.
+	/// </summary>
+	bool Matches(const std::wstring& name) const;
+
+	bool Matches(const std::string& name) const;
+
+	bool operator==(const IdentityKey& other) const noexcept
+	{
+		return _hash == other._hash && _folded == other._folded;
+	}
+
+	bool operator!=(const IdentityKey& other) const noexcept
+	{
+		return !(*this == other);
+	}
+
+	// Ordering for use in std::map
+	bool operator<(const IdentityKey& other) const noexcept
+	{
+		return _folded < other._folded;
+	}
+
+	size_t GetHash() const noexcept { return _hash; }
+
+	// The uppercased name
+	const std::wstring& GetFolded() const noexcept { return _folded; }
+
+	struct Hash
+	{
+		size_t operator()(const IdentityKey& key) const noexcept { return key.GetHash(); }
+	};
+
+private:
+	std::wstring _folded;
+	size_t _hash;
+
+	bool Matches(wchar_t* name, size_t size) const noexcept;
+
+	static size_t ComputeHash(const wchar_t* name, size_t size) noexcept;
+};
@@ -0,0 +1,60 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "PIResponse.h"
+#include "OfflineData.h"
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+/// <summary>
+/// Parser for the large inputs of the client: the responses of /validate/check and the offline file.
+/// The implementation with nlohmann::json is used by default. Defining PI_JSON_SIMDJSON at build time selects the
+/// implementation with simdjson, which requires the simdjson library.
+/// </summary>
+class JsonBackend
+{
+public:
+	virtual ~JsonBackend() = default;
+
+	/// <summary>
+	/// Get the PIResponse and the offline data from auth_items of a response.
+	/// </summary>
+	/// <returns>S_OK or PI_JSON_PARSE_ERROR if the input is malformed or 'result' is missing. The offline data is set in that case, too.</returns>
+	virtual HRESULT ParseResponse(const std::string& input, PIResponse& response, std::vector<OfflineData>& offlineData) = 0;
+
+	/// <summary>
+	/// Get the datasets of the offline file.
+	/// </summary>
+	virtual std::vector<OfflineData> ParseOfflineFile(const std::string& input) = 0;
+
+	virtual std::string GetName() const = 0;
+
+	/// <summary>
+	/// Get the backend that was selected at build time.
+	/// </summary>
+	static JsonBackend& Get();
+
+	/// <summary>
+	/// Get a backend by name ("nlohmann", "simdjson"), for example to compare them.
+	/// </summary>
+	/// <returns>nullptr if the backend is not part of this build</returns>
+	static JsonBackend* Get(const std::string& name);
+};
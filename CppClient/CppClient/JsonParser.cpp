@@ -18,401 +18,550 @@
 ** * * * * * * * * * * * * * * * * * * */
 
 #include "Convert.h"
+#include "JsonBackend.h"
 #include "JsonParser.h"
+#include "JsonSchema.h"
 #include "Logger.h"
+#include "ResponseStreamParser.h"
+#include "SimdJsonBackend.h"
 #include "nlohmann/json.hpp"
 #include "WebAuthnSignRequest.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
 
 using json = nlohmann::json;
 using namespace std;
 
-int GetIntOrZero(json& input, string fieldName)
+int GetIntOrZero(const json& input, const char* fieldName)
 {
-	auto& t = input[fieldName];
-	if (t.is_number_integer())
+	if (input.is_object())
 	{
-		return t.get<int>();
-	}
-	else
-	{
-		PIDebug(fieldName + " was expected to be int, but was not.");
+		const auto t = input.find(fieldName);
+		if (t != input.end() && t->is_number_integer())
+		{
+			return t->get<int>();
+		}
 	}
+	PIDebugF("{} was expected to be int, but was not.", fieldName);
 	return 0;
 }
 
-string GetStringOrEmpty(json& input, string fieldName)
+string GetStringOrEmpty(const json& input, const char* fieldName)
 {
-	auto& t = input[fieldName];
-	if (t.is_string())
-	{
-		return t.get<string>();
-	}
-	else
+	if (input.is_object())
 	{
-		PIDebug(fieldName + " was expected to be string, but was not.");
+		const auto t = input.find(fieldName);
+		if (t != input.end() && t->is_string())
+		{
+			return t->get<string>();
+		}
 	}
+	PIDebugF("{} was expected to be string, but was not.", fieldName);
 	return "";
 }
 
-bool GetBoolOrFalse(json& input, string fieldName)
+bool GetBoolOrFalse(const json& input, const char* fieldName)
 {
-	auto& t = input[fieldName];
-	if (t.is_boolean())
+	if (input.is_object())
 	{
-		return t.get<bool>();
-	}
-	else
-	{
-		PIDebug(fieldName + " was expected to be bool, but was not.");
+		const auto t = input.find(fieldName);
+		if (t != input.end() && t->is_boolean())
+		{
+			return t->get<bool>();
+		}
 	}
+	PIDebugF("{} was expected to be bool, but was not.", fieldName);
 	return false;
 }
 
-json ParseJson(std::string input)
+// Parse without exceptions. Returns null if the input is not valid json.
+json ParseJson(const std::string& input)
 {
-	json jRoot;
-	try
-	{
-		jRoot = json::parse(input);
-	}
-	catch (const json::parse_error& e)
+	json jRoot = json::parse(input, nullptr, false);
+	if (jRoot.is_discarded())
 	{
-		PIDebug(e.what());
+		PIDebug("Input is not valid json");
 		return nullptr;
 	}
 	return jRoot;
 }
 
+// Dump without exceptions, invalid UTF-8 is replaced
+static std::string DumpJson(const json& j, int indentation)
+{
+	return j.dump(indentation, ' ', false, json::error_handler_t::replace);
+}
+
 HRESULT JsonParser::ParseResponse(std::string serverResponse, PIResponse& response)
 {
 	PIDebug(__FUNCTION__);
-	json jRoot;
-	try
-	{
-		jRoot = json::parse(serverResponse);
-	}
-	catch (const json::parse_error& e)
+	vector<OfflineData> offlineData;
+	return JsonBackend::Get().ParseResponse(serverResponse, response, offlineData);
+}
+
+std::string JsonParser::PrettyFormatJson(std::string input)
+{
+	auto jRoot = ParseJson(input);
+	if (jRoot == nullptr) return input;
+	return DumpJson(jRoot, JSON_DUMP_INDENTATION);
+}
+
+bool JsonParser::IsStillActiveOfflineToken(const std::string& input)
+{
+	return GetErrorCode(input) != 905;
+}
+
+int JsonParser::GetErrorCode(const std::string& input)
+{
+	const auto jRoot = ParseJson(input);
+	if (jRoot == nullptr) return 0;
+
+	const auto jResult = jRoot.find("result");
+	if (jResult != jRoot.end() && jResult->is_object())
 	{
-		PIDebug(e.what());
-		return PI_JSON_PARSE_ERROR;
+		const auto jError = jResult->find("error");
+		if (jError != jResult->end() && jError->is_object())
+		{
+			const auto jCode = jError->find("code");
+			if (jCode != jError->end() && jCode->is_number_integer())
+			{
+				return jCode->get<int>();
+			}
+			// An error without a code is still an error
+			return -1;
+		}
 	}
 
-	if (jRoot.contains("result"))
+	return 0;
+}
+
+// Set the members of the object from the fields of the json object that are part of the table
+template<class T, size_t N>
+static void ReadFields(const json& jObject, const JsonField<T>(&fields)[N], T& object)
+{
+	if (!jObject.is_object()) return;
+
+	for (const auto& item : jObject.items())
 	{
-		auto& jResult = jRoot["result"];
+		const auto& key = item.key();
+		const auto field = JsonFindField(fields, key.data(), key.size());
+		if (field == nullptr) continue;
 
-		response.value = GetBoolOrFalse(jResult, "value");
-		response.status = GetBoolOrFalse(jResult, "status");
+		const auto& value = item.value();
+		bool set = false;
+		if (value.is_string()) set = JsonSetString(*field, object, value.get<string>());
+		else if (value.is_boolean()) set = JsonSetBool(*field, object, value.get<bool>());
+		else if (value.is_number_integer()) set = JsonSetInteger(*field, object, value.get<long long>());
+		else if (value.is_number_float()) set = JsonSetDouble(*field, object, value.get<double>());
+		else if (field->type == JsonFieldType::Object) set = true;
 
-		if (jResult.contains("error"))
+		if (!set)
 		{
-			auto& jError = jResult["error"];
-			response.errorCode = jError["code"].get<int>();
-			response.errorMessage = GetStringOrEmpty(jError, "message");
+			PIDebugF("{} does not have the expected type.", key);
 		}
 	}
-	else
+}
+
+HRESULT ParseOfflineDataItem(const json& jRoot, OfflineData& data)
+{
+	// General info and, if the data is coming from the save file, the serial and usage
+	ReadFields(jRoot, OFFLINE_DATA_FIELDS, data);
+
+	// Token type specific info
+	if (!jRoot.is_object() || !jRoot.contains("response") || !jRoot["response"].is_object())
 	{
-		PIDebug("Reponse did not contain 'result'");
+		PIDebug("Offline data item did not contain 'response'");
 		return PI_JSON_PARSE_ERROR;
 	}
+	const auto& response = jRoot["response"];
 
-	auto& jDetail = jRoot["detail"];
-
-	response.message = GetStringOrEmpty(jDetail, "message");
-
-	auto& multiChallenge = jDetail["multi_challenge"];
-	if (!multiChallenge.empty())
+	const bool isWebAuthn = response.contains("credentialId") && response.contains("rpId") && response.contains("pubKey");
+	for (const auto& item : response.items())
 	{
-		response.transactionId = GetStringOrEmpty(jDetail, "transaction_id");
-		response.preferredMode = GetStringOrEmpty(jDetail, "preferred_client_mode");
-
-		for (auto& item : multiChallenge.items())
+		if (!item.value().is_string()) continue;
+		if (isWebAuthn)
 		{
-			json jChallenge = item.value();
-			string type = GetStringOrEmpty(jChallenge, "type");
-			Challenge c;
-			c.type = type;
-			c.message = GetStringOrEmpty(jChallenge, "message");
-			c.serial = GetStringOrEmpty(jChallenge, "serial");
-			c.transactionId = GetStringOrEmpty(jChallenge, "transaction_id");
-			c.image = GetStringOrEmpty(jChallenge, "image");
-
-			if (type == "webauthn")
-			{
-				auto& jSignRequest = jChallenge["attributes"]["webAuthnSignRequest"];
-				vector<AllowCredential> allowCredentials;
-				for (auto& tmp : jSignRequest["allowCredentials"])
-				{
-					AllowCredential ac;
-					ac.id = GetStringOrEmpty(tmp, "id");
-					ac.type = GetStringOrEmpty(tmp, "type");
-					for (auto& transport : tmp["transports"])
-					{
-						ac.transports.push_back(transport.get<string>());
-					}
-					allowCredentials.push_back(ac);
-				}
-				WebAuthnSignRequest signRequest;
-				signRequest.challenge = GetStringOrEmpty(jSignRequest, "challenge");
-				signRequest.rpId = GetStringOrEmpty(jSignRequest, "rpId");
-				signRequest.userVerification = GetStringOrEmpty(jSignRequest, "userVerification");
-				signRequest.timeout = GetIntOrZero(jSignRequest, "timeout");
-				signRequest.allowCredentials = allowCredentials;
-				signRequest.type = allowCredentials[0].type; // TODO does this matter? Currently not
-				c.webAuthnSignRequest = signRequest;
-			}
-
-			response.challenges.push_back(c);
+			if (item.key() == "pubKey") data.pubKey = item.value().get<string>();
+			else if (item.key() == "credentialId") data.credId = item.value().get<string>();
+			else if (item.key() == "rpId") data.rpId = item.value().get<string>();
+		}
+		else // HOTP
+		{
+			data.offlineOTPs.emplace(item.key(), item.value().get<string>());
 		}
 	}
-
 	return S_OK;
 }
 
-std::string JsonParser::PrettyFormatJson(std::string input)
+HRESULT JsonParser::ParseOfflineDataItemFromString(std::string input, OfflineData& data)
 {
-	json jRoot;
-	try
-	{
-		jRoot = json::parse(input);
-	}
-	catch (const json::parse_error& e)
+	auto j = ParseJson(input);
+	return ParseOfflineDataItem(j, data);
+}
+
+// Write the string with the escaping of nlohmann::json. Runs of characters that need no escaping are written at once.
+static void WriteJsonString(std::ostream& out, const std::string& value)
+{
+	static const char* hex = "0123456789abcdef";
+	out.put('"');
+	size_t runStart = 0;
+	for (size_t i = 0; i < value.size(); i++)
 	{
-		PIDebug(e.what());
-		return input;
+		const unsigned char c = (unsigned char)value[i];
+		if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+		out.write(value.data() + runStart, i - runStart);
+		runStart = i + 1;
+		switch (c)
+		{
+			case '"': out.write("\\\"", 2); break;
+			case '\\': out.write("\\\\", 2); break;
+			case '\b': out.write("\\b", 2); break;
+			case '\f': out.write("\\f", 2); break;
+			case '\n': out.write("\\n", 2); break;
+			case '\r': out.write("\\r", 2); break;
+			case '\t': out.write("\\t", 2); break;
+			default:
+			{
+				const char escaped[] = { '\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF] };
+				out.write(escaped, sizeof(escaped));
+			}
+		}
 	}
-	return jRoot.dump(JSON_DUMP_INDENTATION);
+	out.write(value.data() + runStart, value.size() - runStart);
+	out.put('"');
 }
 
-bool JsonParser::IsStillActiveOfflineToken(const std::string& input)
+// Writes json in the layout of nlohmann's dump, either indented by JSON_DUMP_INDENTATION or compact
+class JsonStreamWriter
 {
-	json jRoot;
-	try
+public:
+	JsonStreamWriter(std::ostream& out, bool compact) : _out(out), _compact(compact) {}
+
+	void BeginObject() { Begin('{'); }
+
+	void EndObject() { End('}'); }
+
+	void BeginArray() { Begin('['); }
+
+	void EndArray() { End(']'); }
+
+	void Key(const std::string& key)
 	{
-		jRoot = json::parse(input);
+		if (!_first) _out.put(',');
+		_first = false;
+		NewLine();
+		WriteJsonString(_out, key);
+		if (_compact) _out.put(':');
+		else _out.write(": ", 2);
 	}
-	catch (const json::parse_error& e)
+
+	// For array elements
+	void Element()
 	{
-		PIDebug(e.what());
-		return true;
+		if (!_first) _out.put(',');
+		_first = false;
+		NewLine();
 	}
 
-	if (jRoot.contains("result"))
+	void Value(const std::string& value) { WriteJsonString(_out, value); }
+
+	void Value(long long value) { _out << value; }
+
+	void Value(bool value) { _out << (value ? "true" : "false"); }
+
+	void Value(double value)
 	{
-		auto& jResult = jRoot["result"];
-		if (jResult.contains("error"))
+		// JSON has no nan or infinity, nlohmann writes null for them, too
+		if (!std::isfinite(value))
 		{
-			auto& jError = jResult["error"];
-			if (jError.contains("code"))
-			{
-				return jError["code"].get<int>() != 905;
-			}
+			_out.write("null", 4);
+			return;
+		}
+
+		// Use the shortest representation that reads back to the same value
+		char buffer[32];
+		for (int precision = 15; precision <= 17; precision++)
+		{
+			snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+			if (strtod(buffer, nullptr) == value) break;
 		}
+		_out << buffer;
+		// Like nlohmann, keep the number a float when it is read again
+		if (strpbrk(buffer, ".eEn") == nullptr) _out.write(".0", 2);
 	}
 
-	return true;
-}
+private:
+	std::ostream& _out;
+	bool _compact;
+	int _level = 0;
+	bool _first = true;
 
-HRESULT ParseOfflineDataItem(json jRoot, OfflineData& data)
-{
-	// General info independent of token type
-	data.refilltoken = GetStringOrEmpty(jRoot, "refilltoken");
-	data.username = GetStringOrEmpty(jRoot, "username");
+	void Begin(char c)
+	{
+		_out.put(c);
+		_level++;
+		_first = true;
+	}
 
-	// Token type specific info
-	auto& response = jRoot["response"];
-	if (response == nullptr)
+	void End(char c)
 	{
-		PIDebug("Offline data item did not contain 'response'");
-		return PI_JSON_PARSE_ERROR;
+		_level--;
+		// Empty containers are written as {} or []
+		if (!_first) NewLine();
+		_out.put(c);
+		_first = false;
 	}
-	
-	const bool isWebAuthn = response.contains("credentialId") && response.contains("rpId") && response.contains("pubKey");
-	if (isWebAuthn)
+
+	void NewLine()
 	{
-		data.pubKey = GetStringOrEmpty(response, "pubKey");
-		data.credId = GetStringOrEmpty(response, "credentialId");
-		data.rpId = GetStringOrEmpty(response, "rpId");
+		if (_compact) return;
+		_out.put('\n');
+		for (int i = 0; i < _level * JSON_DUMP_INDENTATION; i++) _out.put(' ');
 	}
-	else // HOTP
+};
+
+// Write the members of the object in the order of the table. Fields of type Object and IntString are passed to writeCustom.
+template<class T, size_t N, class F>
+static void WriteFields(JsonStreamWriter& writer, const JsonField<T>(&fields)[N], const T& object, F&& writeCustom)
+{
+	for (const auto& field : fields)
 	{
-		for (const auto& item : response.items())
+		switch (field.type)
 		{
-			string key = item.key();
-			string value = item.value();
-			data.offlineOTPs.try_emplace(key, value);
+			case JsonFieldType::String:
+				writer.Key(field.key);
+				writer.Value(object.*field.stringMember);
+				break;
+			case JsonFieldType::SharedString:
+				if (object.*field.sharedStringMember)
+				{
+					writer.Key(field.key);
+					writer.Value(*(object.*field.sharedStringMember));
+				}
+				break;
+			case JsonFieldType::Int:
+				writer.Key(field.key);
+				writer.Value((long long)(object.*field.intMember));
+				break;
+			case JsonFieldType::Time:
+				writer.Key(field.key);
+				writer.Value((long long)(object.*field.timeMember));
+				break;
+			case JsonFieldType::Double:
+				writer.Key(field.key);
+				writer.Value(object.*field.doubleMember);
+				break;
+			case JsonFieldType::Bool:
+				writer.Key(field.key);
+				writer.Value(object.*field.boolMember);
+				break;
+			default:
+				writeCustom(field);
 		}
-		// count (max stored otps)
-		try
-		{
-			if (jRoot["count"].is_string())
+	}
+}
+
+void JsonParser::WriteOfflineData(std::ostream& out, const std::vector<OfflineData>& data, bool compact)
+{
+	constexpr uint32_t countHash = JsonKeyHash("count");
+	constexpr uint32_t responseHash = JsonKeyHash("response");
+
+	// The keys are written in alphabetical order, like nlohmann::json does
+	JsonStreamWriter writer(out, compact);
+	writer.BeginObject();
+	writer.Key("offline");
+	writer.BeginArray();
+
+	for (const auto& item : data)
+	{
+		const bool isWebAuthn = item.isWebAuthn();
+
+		writer.Element();
+		writer.BeginObject();
+		WriteFields(writer, OFFLINE_DATA_FIELDS, item, [&](const JsonField<OfflineData>& field)
 			{
-				try
+				if (field.hash == countHash)
 				{
-					data.count = stoi(jRoot["count"].get<std::string>());
+					// The number of stored OTPs, as a string like the server sends it
+					if (!isWebAuthn)
+					{
+						writer.Key(field.key);
+						writer.Value(to_string(item.offlineOTPs.size()));
+					}
 				}
-				catch (const std::invalid_argument& e)
+				else if (field.hash == responseHash)
 				{
-					PIDebug(e.what());
+					// token type specific offline data is listed in the "response" object
+					writer.Key(field.key);
+					writer.BeginObject();
+					if (isWebAuthn)
+					{
+						writer.Key("credentialId");
+						writer.Value(item.credId);
+						writer.Key("pubKey");
+						writer.Value(item.pubKey);
+						writer.Key("rpId");
+						writer.Value(item.rpId);
+					}
+					else // HOTP
+					{
+						for (const auto& otpEntry : item.offlineOTPs)
+						{
+							writer.Key(otpEntry.first);
+							writer.Value(otpEntry.second);
+						}
+					}
+					writer.EndObject();
 				}
-			}
-		}
-		catch (const json::type_error& e)
-		{
-			PIDebug(e.what());
-
-		}
+			});
+		writer.EndObject();
 	}
 
-	// Try to get the serial - if the data is coming from the save file, the serial will be set
-	data.serial = GetStringOrEmpty(jRoot, "serial");
-	return S_OK;
+	writer.EndArray();
+	writer.EndObject();
 }
 
-HRESULT JsonParser::ParseOfflineDataItemFromString(std::string input, OfflineData& data)
+std::string JsonParser::OfflineDataToString(std::vector<OfflineData> data)
 {
-	auto j = ParseJson(input);
-	return ParseOfflineDataItem(j, data);
+	ostringstream out;
+	WriteOfflineData(out, data);
+	return out.str();
 }
 
-std::string JsonParser::OfflineDataToString(std::vector<OfflineData> data)
+// Default JsonBackend: the responses are parsed with the SAX interface and the offline file with the DOM
+class NlohmannJsonBackend : public JsonBackend
 {
-	json::array_t jArray;
+public:
+	HRESULT ParseResponse(const std::string& input, PIResponse& response, std::vector<OfflineData>& offlineData) override
+	{
+		ResponseStreamParser parser;
+		parser.Feed(input);
+		return parser.Finish(response, offlineData);
+	}
 
-	for (auto& item : data)
+	std::vector<OfflineData> ParseOfflineFile(const std::string& input) override
 	{
-		// General information not specific to token type
-		json jElement;
-		jElement["refilltoken"] = item.refilltoken;
-		jElement["serial"] = item.serial;
-		jElement["username"] = item.username;
+		const auto j = ParseJson(input);
 
-		const bool isWebAuthn = !item.pubKey.empty() && !item.credId.empty() && !item.rpId.empty();
-		json jResponse; // token type specific offline data is listed in the "response" object
+		std::vector<OfflineData> ret;
 
-		if (isWebAuthn)
-		{
-			jResponse["pubKey"] = item.pubKey;
-			jResponse["credentialId"] = item.credId;
-			jResponse["rpId"] = item.rpId;
-		}
-		else // HOTP
+		const auto jOffline = j.find("offline");
+		if (jOffline != j.end() && jOffline->is_array())
 		{
-			jElement["count"] = to_string(item.offlineOTPs.size());
-			for (auto& otpEntry : item.offlineOTPs)
+			for (auto const& item : *jOffline)
 			{
-				jResponse[otpEntry.first] = otpEntry.second;
+				OfflineData d;
+				ParseOfflineDataItem(item, d);
+				ret.push_back(d);
 			}
 		}
-
-		jElement["response"] = jResponse;
-		jArray.push_back(jElement);
+		return ret;
 	}
 
-	json jRoot;
-	jRoot["offline"] = jArray;
+	std::string GetName() const override { return "nlohmann"; }
+};
+
+static NlohmannJsonBackend nlohmannBackend;
+#ifdef PI_JSON_SIMDJSON
+static SimdJsonBackend simdJsonBackend;
+#endif
 
-	return jRoot.dump(4);
+JsonBackend& JsonBackend::Get()
+{
+#ifdef PI_JSON_SIMDJSON
+	return simdJsonBackend;
+#else
+	return nlohmannBackend;
+#endif
+}
+
+JsonBackend* JsonBackend::Get(const std::string& name)
+{
+	if (name == nlohmannBackend.GetName()) return &nlohmannBackend;
+#ifdef PI_JSON_SIMDJSON
+	if (name == simdJsonBackend.GetName()) return &simdJsonBackend;
+#endif
+	return nullptr;
 }
 
 std::vector<OfflineData> JsonParser::ParseFileContentsForOfflineData(std::string input)
 {
 	PIDebug(__FUNCTION__);
-	auto j = ParseJson(input);
-
-	std::vector<OfflineData> ret;
-
-	auto& jOffline = j["offline"];
-
-	if (jOffline.is_array())
-	{
-		for (auto const& item : jOffline)
-		{
-			OfflineData d;
-			ParseOfflineDataItem(item, d);
-			ret.push_back(d);
-		}
-	}
-	return ret;
+	return JsonBackend::Get().ParseOfflineFile(input);
 }
 
 std::vector<OfflineData> JsonParser::ParseResponseForOfflineData(std::string serverResponse)
 {
 	PIDebug(__FUNCTION__);
-	std::vector<OfflineData> ret;
-	auto jRoot = ParseJson(serverResponse);
-	if (jRoot == nullptr) return ret;
+	vector<OfflineData> ret;
+	PIResponse response;
+	JsonBackend::Get().ParseResponse(serverResponse, response, ret);
+	return ret;
+}
 
-	auto& jAuthItems = jRoot["auth_items"];
-	if (jAuthItems == nullptr) return ret;
+HRESULT JsonParser::ParseResponse(const std::string& serverResponse, PIResponse& response, std::vector<OfflineData>& offlineData)
+{
+	PIDebug(__FUNCTION__);
+	// The body as received, pretty printing would parse it a second time
+	PIDebug(serverResponse);
 
-	// Get the serial to add to the data
-	string serial = GetStringOrEmpty(jRoot["detail"], "serial");
+	return JsonBackend::Get().ParseResponse(serverResponse, response, offlineData);
+}
 
-	auto& jOffline = jAuthItems["offline"];
+// Get auth_items -> offline -> [0] or nullptr if it does not exist
+static const json* GetFirstOfflineItem(const json& jRoot)
+{
+	const auto jAuthItems = jRoot.find("auth_items");
+	if (jAuthItems == jRoot.end() || !jAuthItems->is_object()) return nullptr;
 
-	if (!jOffline.is_array() || jOffline.size() < 1)
-	{
-		return ret;
-	}
+	const auto jOffline = jAuthItems->find("offline");
+	if (jOffline == jAuthItems->end() || !jOffline->is_array() || jOffline->empty()) return nullptr;
 
-	for (const auto& jItem : jOffline)
-	{
-		OfflineData newData;
-		if (ParseOfflineDataItem(jItem, newData) == S_OK)
-		{
-			// Add the serial explicitly because it is not part of the 'offline' section of the response, but required for refill later
-			newData.serial = serial;
-			ret.push_back(newData);
-			PIDebug("Received offline data for user '" + newData.username + "'");
-		}
-	}
-	return ret;
+	const json& jItem = jOffline->front();
+	return jItem.is_object() ? &jItem : nullptr;
 }
 
 std::string JsonParser::GetRefilltoken(std::string input)
 {
-	auto jRoot = ParseJson(input);
+	const auto jRoot = ParseJson(input);
 	if (jRoot == nullptr) return "";
-	try
-	{
-		json jOffline = jRoot["auth_items"]["offline"].at(0);
-		return GetStringOrEmpty(jOffline, "refilltoken");
-	}
-	catch (const std::exception& e)
+
+	const json* jOffline = GetFirstOfflineItem(jRoot);
+	if (jOffline == nullptr)
 	{
-		PIError(e.what());
+		PIError("Response does not contain offline data");
 		return "";
 	}
+	return GetStringOrEmpty(*jOffline, "refilltoken");
 }
 
 HRESULT JsonParser::ParseRefillResponse(const std::string& in, const std::string& username, OfflineData& data)
 {
 	PIDebug(__FUNCTION__);
-	auto jRoot = ParseJson(in);
+	const auto jRoot = ParseJson(in);
 	if (jRoot == nullptr) return PI_JSON_PARSE_ERROR;
-	json jOffline;
-	try
-	{
-		jOffline = jRoot["auth_items"]["offline"].at(0);
-	}
-	catch (const std::exception& e)
+
+	const json* jOfflinePtr = GetFirstOfflineItem(jRoot);
+	if (jOfflinePtr == nullptr)
 	{
-		PIDebug(e.what());
+		PIDebug("Response does not contain offline data");
 		return PI_JSON_PARSE_ERROR;
 	}
+	const json& jOffline = *jOfflinePtr;
 
-	if (jOffline == nullptr) return PI_JSON_PARSE_ERROR;
-
-	if (jOffline.contains("response"))
+	const auto jResponse = jOffline.find("response");
+	if (jResponse != jOffline.end() && jResponse->is_object())
 	{
-		auto& jResponse = jOffline["response"];
-		for (const auto& jItem : jResponse.items())
+		for (const auto& jItem : jResponse->items())
 		{
-			string key = jItem.key();
-			string value = jItem.value();
-			data.offlineOTPs.try_emplace(key, value);
+			if (jItem.value().is_string())
+			{
+				data.offlineOTPs.emplace(jItem.key(), jItem.value().get<string>());
+			}
 		}
 	}
 	else
@@ -434,14 +583,70 @@ HRESULT JsonParser::ParseRefillResponse(const std::string& in, const std::string
 	return S_OK;
 }
 
+std::string JsonParser::OfflineRefillJobsToString(const std::vector<OfflineRefillJob>& jobs, const std::vector<std::string>& protectedOTPs)
+{
+	json::array_t jArray;
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		const auto& job = jobs[i];
+		json jJob;
+		jJob["username"] = job.username;
+		jJob["serial"] = job.serial;
+		jJob["pass"] = i < protectedOTPs.size() ? protectedOTPs[i] : string();
+		jJob["webauthn"] = job.isWebAuthn;
+		jJob["attempts"] = job.attempts;
+		jJob["next_attempt"] = (long long)job.nextAttempt;
+		jArray.push_back(jJob);
+	}
+
+	json jRoot;
+	jRoot["refill"] = jArray;
+	return DumpJson(jRoot, JSON_DUMP_INDENTATION);
+}
+
+std::vector<OfflineRefillJob> JsonParser::ParseOfflineRefillJobs(const std::string& input, std::vector<std::string>& protectedOTPs)
+{
+	std::vector<OfflineRefillJob> ret;
+	protectedOTPs.clear();
+	auto jRoot = ParseJson(input);
+	if (jRoot == nullptr) return ret;
+
+	const auto jRefill = jRoot.find("refill");
+	if (jRefill == jRoot.end() || !jRefill->is_array()) return ret;
+
+	for (const auto& jJob : *jRefill)
+	{
+		if (!jJob.is_object()) continue;
+
+		OfflineRefillJob job;
+		job.username = GetStringOrEmpty(jJob, "username");
+		job.serial = GetStringOrEmpty(jJob, "serial");
+		job.isWebAuthn = GetBoolOrFalse(jJob, "webauthn");
+		job.attempts = GetIntOrZero(jJob, "attempts");
+		const auto jNextAttempt = jJob.find("next_attempt");
+		if (jNextAttempt != jJob.end() && jNextAttempt->is_number_integer())
+		{
+			job.nextAttempt = (std::time_t)jNextAttempt->get<long long>();
+		}
+
+		if (!job.username.empty() && !job.serial.empty())
+		{
+			ret.push_back(std::move(job));
+			protectedOTPs.push_back(GetStringOrEmpty(jJob, "pass"));
+		}
+	}
+	return ret;
+}
+
 bool JsonParser::ParsePollTransaction(std::string input)
 {
 	auto jRoot = ParseJson(input);
 	if (jRoot == nullptr) return false;
 
-	if (jRoot.contains("result"))
+	const auto jResult = jRoot.find("result");
+	if (jResult != jRoot.end())
 	{
-		return GetBoolOrFalse(jRoot["result"], "value");
+		return GetBoolOrFalse(*jResult, "value");
 	}
 	else
 	{
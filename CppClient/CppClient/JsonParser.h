@@ -20,8 +20,10 @@
 #pragma once
 #include "PIResponse.h"
 #include "OfflineData.h"
+#include "OfflineRefillQueue.h"
 #include <string>
 #include <vector>
+#include <ostream>
 #include <winerror.h>
 
 #define PI_JSON_PARSE_ERROR							((HRESULT)0x88809031)
@@ -41,6 +43,14 @@ public:
 	/// </returns>
 	HRESULT ParseResponse(std::string serverResponse, PIResponse &response);
 
+	/// <summary>
+	/// Parse the response once and get both the response object and the offline data from the auth_items.
+	/// The response is parsed with the JsonBackend, without building a json document.
+	/// If debug logging is enabled, the response is logged.
+	/// </summary>
+	/// <returns>Same as ParseResponse</returns>
+	HRESULT ParseResponse(const std::string& serverResponse, PIResponse& response, std::vector<OfflineData>& offlineData);
+
 	/// <summary>
 	/// 
 	/// </summary>
@@ -59,12 +69,24 @@ public:
 
 	std::string OfflineDataToString(std::vector<OfflineData> data);
 
+	/// <summary>
+	/// Write the offline data in the format of the offline file directly to the stream, without building a json document or string first.
+	/// The output is indented like OfflineDataToString, unless compact is set.
+	/// </summary>
+	void WriteOfflineData(std::ostream& out, const std::vector<OfflineData>& data, bool compact = false);
+
 	bool ParsePollTransaction(std::string input);
 
 	HRESULT ParseRefillResponse(const std::string& in, const std::string& username, OfflineData& data);
 
 	std::string GetRefilltoken(std::string input);
 
+	// The OTPs of the jobs are not written, only their protected form, one per job
+	std::string OfflineRefillJobsToString(const std::vector<OfflineRefillJob>& jobs, const std::vector<std::string>& protectedOTPs);
+
+	// The jobs without their OTPs, the protected form of each is returned in protectedOTPs
+	std::vector<OfflineRefillJob> ParseOfflineRefillJobs(const std::string& input, std::vector<std::string>& protectedOTPs);
+
 
 	// Return the input json with indentation of 4. If the input is not a valid json it is returned as is.
 	static std::string PrettyFormatJson(std::string input);
@@ -77,5 +99,11 @@ public:
 	/// <param name="input"></param>
 	/// <returns>true if still marked for offline or error, false if not</returns>
 	bool IsStillActiveOfflineToken(const std::string& input);
+
+	/// <summary>
+	/// Get result->error->code of a server response.
+	/// </summary>
+	/// <returns>The code, -1 if there is an error without a code, 0 if there is no error or the input is not valid json</returns>
+	int GetErrorCode(const std::string& input);
 };
 
@@ -0,0 +1,276 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "Convert.h"
+#include "OfflineData.h"
+#include "PIResponse.h"
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+/// <summary>
+/// Describes which members of the client objects are read from and written to json. Every parser and the writer
+/// dispatch on these tables instead of comparing the keys one after another.
+/// The key hashes of the tables are computed at compile time and checked to be unique within each table. A lookup
+/// hashes the key once and scans the table comparing integers, only the field with the same hash is compared with
+/// memcmp. The tables have at most eight entries, so there is no index beyond that.
+/// </summary>
+
+enum class JsonFieldType
+{
+	String,
+	// std::shared_ptr<const std::string>, for large values that are shared between copies
+	SharedString,
+	Int,
+	// Number that is sent as a string, like the offline "count"
+	IntString,
+	Bool,
+	Double,
+	Time,
+	// Nested object or array that is handled by the caller
+	Object
+};
+
+// FNV-1a
+constexpr uint32_t JsonKeyHash(const char* key, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+	{
+		hash ^= (unsigned char)key[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+constexpr size_t JsonKeyLength(const char* key)
+{
+	size_t length = 0;
+	while (key[length] != '\0') length++;
+	return length;
+}
+
+constexpr uint32_t JsonKeyHash(const char* key)
+{
+	return JsonKeyHash(key, JsonKeyLength(key));
+}
+
+template<class T>
+struct JsonField
+{
+	constexpr JsonField(const char* key, std::string T::* member)
+		: key(key), length(JsonKeyLength(key)), hash(JsonKeyHash(key)), type(JsonFieldType::String), stringMember(member) {}
+
+	constexpr JsonField(const char* key, std::shared_ptr<const std::string> T::* member)
+		: key(key), length(JsonKeyLength(key)), hash(JsonKeyHash(key)), type(JsonFieldType::SharedString), sharedStringMember(member) {}
+
+	constexpr JsonField(const char* key, int T::* member, JsonFieldType type = JsonFieldType::Int)
+		: key(key), length(JsonKeyLength(key)), hash(JsonKeyHash(key)), type(type), intMember(member) {}
+
+	constexpr JsonField(const char* key, bool T::* member)
+		: key(key), length(JsonKeyLength(key)), hash(JsonKeyHash(key)), type(JsonFieldType::Bool), boolMember(member) {}
+
+	constexpr JsonField(const char* key, double T::* member)
+		: key(key), length(JsonKeyLength(key)), hash(JsonKeyHash(key)), type(JsonFieldType::Double), doubleMember(member) {}
+
+	constexpr JsonField(const char* key, std::time_t T::* member)
+		: key(key), length(JsonKeyLength(key)), hash(JsonKeyHash(key)), type(JsonFieldType::Time), timeMember(member) {}
+
+	explicit constexpr JsonField(const char* key)
+		: key(key), length(JsonKeyLength(key)), hash(JsonKeyHash(key)), type(JsonFieldType::Object) {}
+
+	const char* key;
+	size_t length;
+	uint32_t hash;
+	JsonFieldType type;
+
+	// Only the member matching the type is set
+	std::string T::* stringMember = nullptr;
+	std::shared_ptr<const std::string> T::* sharedStringMember = nullptr;
+	int T::* intMember = nullptr;
+	bool T::* boolMember = nullptr;
+	double T::* doubleMember = nullptr;
+	std::time_t T::* timeMember = nullptr;
+};
+
+template<class T, size_t N>
+constexpr bool JsonHashesAreUnique(const JsonField<T>(&fields)[N])
+{
+	for (size_t i = 0; i < N; i++)
+	{
+		for (size_t j = i + 1; j < N; j++)
+		{
+			if (fields[i].hash == fields[j].hash) return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// Find the field for the key in the table. The key is hashed at runtime, the table is scanned linearly.
+/// </summary>
+/// <returns>The field or nullptr if the key is not part of the table</returns>
+template<class T, size_t N>
+const JsonField<T>* JsonFindField(const JsonField<T>(&fields)[N], const char* key, size_t length)
+{
+	const uint32_t hash = JsonKeyHash(key, length);
+	for (const auto& field : fields)
+	{
+		if (field.hash == hash && field.length == length && memcmp(field.key, key, length) == 0)
+		{
+			return &field;
+		}
+	}
+	return nullptr;
+}
+
+// The setters return false if the value does not have the type of the field
+
+template<class T>
+bool JsonSetString(const JsonField<T>& field, T& object, std::string&& value)
+{
+	switch (field.type)
+	{
+		case JsonFieldType::String:
+			object.*field.stringMember = std::move(value);
+			return true;
+		case JsonFieldType::SharedString:
+			object.*field.sharedStringMember = std::make_shared<const std::string>(std::move(value));
+			return true;
+		case JsonFieldType::IntString:
+			return Convert::ToInt(value, object.*field.intMember);
+		default:
+			return false;
+	}
+}
+
+template<class T>
+bool JsonSetInteger(const JsonField<T>& field, T& object, long long value)
+{
+	switch (field.type)
+	{
+		case JsonFieldType::Int:
+			object.*field.intMember = (int)value;
+			return true;
+		case JsonFieldType::Time:
+			object.*field.timeMember = (std::time_t)value;
+			return true;
+		case JsonFieldType::Double:
+			object.*field.doubleMember = (double)value;
+			return true;
+		default:
+			return false;
+	}
+}
+
+template<class T>
+bool JsonSetDouble(const JsonField<T>& field, T& object, double value)
+{
+	if (field.type != JsonFieldType::Double) return false;
+	object.*field.doubleMember = value;
+	return true;
+}
+
+template<class T>
+bool JsonSetBool(const JsonField<T>& field, T& object, bool value)
+{
+	if (field.type != JsonFieldType::Bool) return false;
+	object.*field.boolMember = value;
+	return true;
+}
+
+// The tables are sorted by key, which is also the order in which the writer writes them
+
+// "result"
+constexpr JsonField<PIResponse> PIRESPONSE_RESULT_FIELDS[] =
+{
+	JsonField<PIResponse>("error"),
+	JsonField<PIResponse>("status", &PIResponse::status),
+	JsonField<PIResponse>("value", &PIResponse::value)
+};
+
+// "result" -> "error"
+constexpr JsonField<PIResponse> PIRESPONSE_ERROR_FIELDS[] =
+{
+	JsonField<PIResponse>("code", &PIResponse::errorCode),
+	JsonField<PIResponse>("message", &PIResponse::errorMessage)
+};
+
+// "detail". transaction_id and preferred_client_mode are only kept if there are challenges.
+// The serial is not part of the response object, the parsers set it for the offline data.
+constexpr JsonField<PIResponse> PIRESPONSE_DETAIL_FIELDS[] =
+{
+	JsonField<PIResponse>("message", &PIResponse::message),
+	JsonField<PIResponse>("multi_challenge"),
+	JsonField<PIResponse>("preferred_client_mode", &PIResponse::preferredMode),
+	JsonField<PIResponse>("transaction_id", &PIResponse::transactionId)
+};
+
+// "detail" -> "multi_challenge" -> []
+constexpr JsonField<Challenge> CHALLENGE_FIELDS[] =
+{
+	JsonField<Challenge>("attributes"),
+	JsonField<Challenge>("image", &Challenge::image),
+	JsonField<Challenge>("message", &Challenge::message),
+	JsonField<Challenge>("serial", &Challenge::serial),
+	JsonField<Challenge>("transaction_id", &Challenge::transactionId),
+	JsonField<Challenge>("type", &Challenge::type)
+};
+
+// "detail" -> "multi_challenge" -> [] -> "attributes" -> "webAuthnSignRequest"
+constexpr JsonField<WebAuthnSignRequest> WEBAUTHN_SIGN_REQUEST_FIELDS[] =
+{
+	JsonField<WebAuthnSignRequest>("allowCredentials"),
+	JsonField<WebAuthnSignRequest>("challenge", &WebAuthnSignRequest::challenge),
+	JsonField<WebAuthnSignRequest>("rpId", &WebAuthnSignRequest::rpId),
+	JsonField<WebAuthnSignRequest>("timeout", &WebAuthnSignRequest::timeout),
+	JsonField<WebAuthnSignRequest>("userVerification", &WebAuthnSignRequest::userVerification)
+};
+
+// "detail" -> "multi_challenge" -> [] -> "attributes" -> "webAuthnSignRequest" -> "allowCredentials" -> []
+constexpr JsonField<AllowCredential> ALLOW_CREDENTIAL_FIELDS[] =
+{
+	JsonField<AllowCredential>("id", &AllowCredential::id),
+	JsonField<AllowCredential>("transports"),
+	JsonField<AllowCredential>("type", &AllowCredential::type)
+};
+
+// "auth_items" -> "offline" -> [] in the response and "offline" -> [] in the offline file.
+// The values in "response" depend on the token type.
+constexpr JsonField<OfflineData> OFFLINE_DATA_FIELDS[] =
+{
+	JsonField<OfflineData>("consumption_rate", &OfflineData::consumptionRate),
+	JsonField<OfflineData>("count", &OfflineData::count, JsonFieldType::IntString),
+	JsonField<OfflineData>("last_consumption", &OfflineData::lastConsumption),
+	JsonField<OfflineData>("last_used", &OfflineData::lastUsed),
+	JsonField<OfflineData>("refilltoken", &OfflineData::refilltoken),
+	JsonField<OfflineData>("response"),
+	JsonField<OfflineData>("serial", &OfflineData::serial),
+	JsonField<OfflineData>("username", &OfflineData::username)
+};
+
+static_assert(JsonHashesAreUnique(PIRESPONSE_RESULT_FIELDS), "Duplicate key hash");
+static_assert(JsonHashesAreUnique(PIRESPONSE_ERROR_FIELDS), "Duplicate key hash");
+static_assert(JsonHashesAreUnique(PIRESPONSE_DETAIL_FIELDS), "Duplicate key hash");
+static_assert(JsonHashesAreUnique(CHALLENGE_FIELDS), "Duplicate key hash");
+static_assert(JsonHashesAreUnique(WEBAUTHN_SIGN_REQUEST_FIELDS), "Duplicate key hash");
+static_assert(JsonHashesAreUnique(ALLOW_CREDENTIAL_FIELDS), "Duplicate key hash");
+static_assert(JsonHashesAreUnique(OFFLINE_DATA_FIELDS), "Duplicate key hash");
@@ -18,94 +18,621 @@
 ** * * * * * * * * * * * * * * * * * * */
 
 #include "Logger.h"
-#include <Windows.h>
+#include "Convert.h"
 #include <chrono>
-#include <fstream>
-#include <iostream>
-#include <codecvt>
+#include <ctime>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
 
 using namespace std;
 
-void Logger::LogS(const string& message, const char* file, int line, bool isDebugMessage)
+namespace
+{
+	uint64_t GetCounter() noexcept
+	{
+#ifdef _WIN32
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return static_cast<uint64_t>(counter.QuadPart);
+#else
+		return static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(
+			chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+	}
+
+	uint64_t GetCounterFrequency() noexcept
+	{
+#ifdef _WIN32
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		return static_cast<uint64_t>(frequency.QuadPart);
+#else
+		return 1000000000ULL;
+#endif
+	}
+
+	// 100ns intervals since 1601-01-01, like FILETIME
+	uint64_t GetSystemFileTime() noexcept
+	{
+#ifdef _WIN32
+		FILETIME now;
+		GetSystemTimeAsFileTime(&now);
+		return (static_cast<uint64_t>(now.dwHighDateTime) << 32) | now.dwLowDateTime;
+#else
+		const auto sinceUnixEpoch = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch());
+		return static_cast<uint64_t>(sinceUnixEpoch.count() / 100) + 116444736000000000ULL;
+#endif
+	}
+
+	uint64_t CurrentProcessId() noexcept
+	{
+#ifdef _WIN32
+		return GetCurrentProcessId();
+#else
+		return static_cast<uint64_t>(getpid());
+#endif
+	}
+
+	uint64_t CurrentThreadId() noexcept
+	{
+#ifdef _WIN32
+		return GetCurrentThreadId();
+#elif defined(SYS_gettid)
+		return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+		return static_cast<uint64_t>(hash<thread::id>()(this_thread::get_id()));
+#endif
+	}
+
+	bool LocalTime(time_t rawtime, tm& timeinfo) noexcept
+	{
+#ifdef _WIN32
+		return localtime_s(&timeinfo, &rawtime) == 0;
+#else
+		return localtime_r(&rawtime, &timeinfo) != nullptr;
+#endif
+	}
+}
+
+Logger::Logger() : _slots(new Slot[LOGGER_QUEUE_CAPACITY])
+{
+	for (size_t i = 0; i < LOGGER_QUEUE_CAPACITY; i++)
+	{
+		_slots[i].sequence.store(i, memory_order_relaxed);
+	}
+}
+
+Logger::~Logger()
+{
+	// This runs in DLL_PROCESS_DETACH, where threads must not be waited for. The writer holds a reference to the module,
+	// so it has either exited already or this is the process exit, where it has been terminated, possibly while it held
+	// the consumer lock.
+	_stopWriter = true;
+#ifdef _WIN32
+	if (_writer != nullptr)
+	{
+		CloseHandle(_writer);
+		_writer = nullptr;
+	}
+#else
+	if (_writer.joinable())
+	{
+		_writer.detach();
+	}
+#endif
+
+	if (_consumerMutex.try_lock())
+	{
+		_consumerMutex.unlock();
+		WriteQueued();
+	}
+
+	CloseBinaryFile();
+}
+
+void Logger::LogS(const LogSite& site, const string& message)
 {
 	// Do not log debug messages if it is not enabled
-	if (!logDebug && isDebugMessage)
+	if (!logDebug && site.isDebug)
+	{
+		return;
+	}
+
+	if (logBinary)
 	{
+		string record = BeginBinaryRecord(site, 1);
+		AppendBinaryArgument(record, message);
+		Enqueue(std::move(record), &site);
 		return;
 	}
 
 	// Format: [Time] [file:line]  message
-	time_t rawtime = NULL;
-	struct tm* timeinfo = (tm*)CoTaskMemAlloc(sizeof(tm));
-	char buffer[80];
-	SecureZeroMemory(buffer, sizeof(buffer));
-	if (timeinfo == nullptr)
+	// The caller formats the message, so the time is the time of the event and not the time of writing
+	char buffer[80] = {};
+	time_t rawtime = time(nullptr);
+	tm timeinfo;
+	if (!LocalTime(rawtime, timeinfo))
+	{
+		return;
+	}
+	strftime(buffer, sizeof(buffer), "%d-%m-%Y %H:%M:%S", &timeinfo);
+
+	string fullMessage;
+	fullMessage.reserve(message.size() + 64);
+	fullMessage.append("[").append(buffer).append("] [").append(site.file).append(":").append(to_string(site.line)).append("] ")
+		.append(message);
+
+	Enqueue(std::move(fullMessage));
+}
+
+void Logger::Enqueue(std::string&& message, const LogSite* site)
+{
+	size_t position = _enqueuePosition.load(memory_order_relaxed);
+	Slot* slot = nullptr;
+	while (true)
+	{
+		slot = &_slots[position & (LOGGER_QUEUE_CAPACITY - 1)];
+		const size_t sequence = slot->sequence.load(memory_order_acquire);
+		const ptrdiff_t diff = static_cast<ptrdiff_t>(sequence) - static_cast<ptrdiff_t>(position);
+		if (diff == 0)
+		{
+			if (_enqueuePosition.compare_exchange_weak(position, position + 1, memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (diff < 0)
+		{
+			// The writer is a whole queue behind, do not block the caller
+			_dropped.fetch_add(1, memory_order_relaxed);
+			StartWriter();
+			return;
+		}
+		else
+		{
+			position = _enqueuePosition.load(memory_order_relaxed);
+		}
+	}
+
+	slot->message = std::move(message);
+	slot->binary = site != nullptr;
+	if (site != nullptr)
+	{
+		slot->site = *site;
+	}
+	slot->sequence.store(position + 1, memory_order_release);
+	// Pairs with the fence in ExitIfIdle: either the writer sees this message or this thread sees that it has stopped
+	atomic_thread_fence(memory_order_seq_cst);
+
+	StartWriter();
+	_wake.notify_one();
+}
+
+void Logger::StartWriter()
+{
+	if (_writerRunning.load(memory_order_acquire))
 	{
 		return;
 	}
-	time(&rawtime);
-	const errno_t err = localtime_s(timeinfo, &rawtime);
-	if (err != 0)
+
+	lock_guard<mutex> lock(_writerMutex);
+	if (_writerRunning.load(memory_order_relaxed))
 	{
 		return;
 	}
-	strftime(buffer, sizeof(buffer), "%d-%m-%Y %H:%M:%S", timeinfo);
-	CoTaskMemFree(timeinfo);
-	string fullMessage = "[" + string(buffer) + "] [" + string(file) + ":" + to_string(line) + "] " + message;
 
-	ofstream os;
-	os.open(logfilePath.c_str(), std::ios_base::app);
-	os << fullMessage << endl;
+	// The previous writer has been stopped or is exiting after being idle
+	JoinWriter();
+	_stopWriter = false;
+#ifdef _WIN32
+	// COM unloads the module once DllCanUnloadNow returns S_OK, which can be while the writer still runs, for example
+	// after the destructor of a credential logged a message. The reference is released by FreeLibraryAndExitThread.
+	HMODULE module = nullptr;
+	if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(&Logger::Get), &module))
+	{
+		return;
+	}
+	HANDLE writer = CreateThread(nullptr, 0, [](LPVOID parameter) -> DWORD
+		{
+			Logger::Get().WriterThread();
+			FreeLibraryAndExitThread(static_cast<HMODULE>(parameter), 0);
+		}, module, 0, nullptr);
+	if (writer == nullptr)
+	{
+		FreeLibrary(module);
+		return;
+	}
+	_writer = writer;
+#else
+	_writer = thread(&Logger::WriterThread, this);
+#endif
+	_writerRunning.store(true, memory_order_release);
+}
 
-#ifndef _OUTPUT_TO_COUT
-	OutputDebugStringA(fullMessage.c_str());
-	OutputDebugStringA("\n");
+void Logger::JoinWriter()
+{
+#ifdef _WIN32
+	if (_writer != nullptr)
+	{
+		WaitForSingleObject(_writer, INFINITE);
+		CloseHandle(_writer);
+		_writer = nullptr;
+	}
 #else
-	//std::cout << fullMessage << std::endl;
-#endif // !_OUTPUT_TO_COUT
+	if (_writer.joinable())
+	{
+		_writer.join();
+	}
+#endif
 }
 
-void Logger::LogW(const wstring& message, const char* file, int line, bool isDebugMessage)
+void Logger::WriterThread()
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
+	const int idleExitIntervals = LOGGER_IDLE_EXIT_MS / LOGGER_WRITE_INTERVAL_MS;
+	int idleIntervals = 0;
+	while (!_stopWriter.load())
+	{
+		bool queued;
+		{
+			// Producers notify without the lock, a missed notification only delays the write until the timeout
+			unique_lock<mutex> lock(_wakeMutex);
+			queued = _wake.wait_for(lock, chrono::milliseconds(LOGGER_WRITE_INTERVAL_MS),
+				[this]() { return _stopWriter.load() || HasQueued(); });
+		}
 
-	string conv = converterX.to_bytes(message);
-	LogS(conv, file, line, isDebugMessage);
+		if (queued)
+		{
+			idleIntervals = 0;
+		}
+		else if (++idleIntervals >= idleExitIntervals && ExitIfIdle())
+		{
+			// Do not keep the file open while nothing is logged
+			CloseFiles();
+			return;
+		}
+		WriteQueued();
+	}
 }
 
-void Logger::Log(const char* message, const char* file, int line, bool isDebugMessage)
+bool Logger::ExitIfIdle()
+{
+	// Flush holds the lock while it waits for this thread, which then exits because of _stopWriter
+	unique_lock<mutex> lock(_writerMutex, try_to_lock);
+	if (!lock.owns_lock())
+	{
+		return false;
+	}
+
+	_writerRunning.store(false);
+	// Pairs with the fence in Enqueue, a message that was queued before the producer saw the writer running is seen here
+	atomic_thread_fence(memory_order_seq_cst);
+	if (HasQueued())
+	{
+		_writerRunning.store(true);
+		return false;
+	}
+	return true;
+}
+
+bool Logger::HasQueued() const noexcept
+{
+	const Slot& slot = _slots[_dequeuePosition & (LOGGER_QUEUE_CAPACITY - 1)];
+	return slot.sequence.load(memory_order_acquire) == _dequeuePosition + 1;
+}
+
+void Logger::WriteQueued()
+{
+	lock_guard<mutex> lock(_consumerMutex);
+
+	string batch;
+	string binaryBatch;
+	while (HasQueued())
+	{
+		Slot& slot = _slots[_dequeuePosition & (LOGGER_QUEUE_CAPACITY - 1)];
+		if (slot.binary)
+		{
+			// The format and file of a site are only written before its first message
+			if (_definedSites.insert(slot.site.id).second)
+			{
+				const LogSite& site = slot.site;
+				binaryBatch.push_back(static_cast<char>(BinaryLogRecord::Site));
+				BinaryLogAppendFixed(binaryBatch, site.id, 4);
+				BinaryLogAppendFixed(binaryBatch, site.messageId, 4);
+				binaryBatch.push_back(static_cast<char>(site.isDebug ? BinaryLogLevel::Debug : BinaryLogLevel::Error));
+				BinaryLogAppendVarint(binaryBatch, static_cast<uint64_t>(site.line));
+				BinaryLogAppendString(binaryBatch, site.file, strlen(site.file));
+				BinaryLogAppendString(binaryBatch, site.format, strlen(site.format));
+			}
+			binaryBatch.append(slot.message);
+		}
+		else
+		{
+#if defined(_WIN32) && !defined(_OUTPUT_TO_COUT)
+			OutputDebugStringA(slot.message.c_str());
+			OutputDebugStringA("\n");
+#endif // _WIN32 && !_OUTPUT_TO_COUT
+			batch.append(slot.message).append("\n");
+		}
+		// Release the memory of the message, so the queue does not keep the capacity of the largest messages
+		string().swap(slot.message);
+		slot.sequence.store(_dequeuePosition + LOGGER_QUEUE_CAPACITY, memory_order_release);
+		_dequeuePosition++;
+	}
+
+	const size_t dropped = _dropped.load(memory_order_relaxed);
+	if (dropped != _droppedReported)
+	{
+		if (logBinary)
+		{
+			binaryBatch.push_back(static_cast<char>(BinaryLogRecord::Dropped));
+			BinaryLogAppendVarint(binaryBatch, dropped - _droppedReported);
+		}
+		else
+		{
+			batch.append("[Logger] ").append(to_string(dropped - _droppedReported))
+				.append(" messages were dropped because the log queue was full\n");
+		}
+		_droppedReported = dropped;
+	}
+
+	if (!binaryBatch.empty())
+	{
+		WriteBinary(binaryBatch);
+	}
+
+	if (batch.empty())
+	{
+		return;
+	}
+
+	if (!_file.is_open())
+	{
+		_file.open(logfilePath.c_str(), std::ios_base::app);
+	}
+	_file << batch;
+	_file.flush();
+}
+
+void Logger::WriteBinary(const string& batch)
+{
+	if (!OpenBinaryFile())
+	{
+		return;
+	}
+
+	// The batch header relates the counter of this process to the wall clock
+	string data;
+	data.reserve(batch.size() + 48);
+	data.push_back(static_cast<char>(BinaryLogRecord::Batch));
+	data.append(BINARY_LOG_MAGIC, BINARY_LOG_MAGIC_SIZE);
+	BinaryLogAppendFixed(data, BINARY_LOG_VERSION, 4);
+	BinaryLogAppendFixed(data, CurrentProcessId(), 4);
+	BinaryLogAppendFixed(data, batch.size(), 4);
+	BinaryLogAppendFixed(data, GetCounterFrequency(), 8);
+	BinaryLogAppendFixed(data, GetCounter(), 8);
+	BinaryLogAppendFixed(data, GetSystemFileTime(), 8);
+	data.append(batch);
+
+#ifdef _WIN32
+	DWORD written = 0;
+	WriteFile(_binaryFile, data.data(), static_cast<DWORD>(data.size()), &written, NULL);
+#else
+	// O_APPEND makes the offset and the write one step, like FILE_APPEND_DATA
+	const ssize_t written = write(_binaryFile, data.data(), data.size());
+	(void)written;
+#endif
+}
+
+bool Logger::OpenBinaryFile()
+{
+#ifdef _WIN32
+	if (_binaryFile == nullptr)
+	{
+		HANDLE hFile = CreateFileA(binaryLogfilePath.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+			OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		_binaryFile = hFile;
+	}
+#else
+	if (_binaryFile < 0)
+	{
+		_binaryFile = open(binaryLogfilePath.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+		if (_binaryFile < 0)
+		{
+			return false;
+		}
+	}
+#endif
+	return true;
+}
+
+void Logger::CloseBinaryFile()
+{
+#ifdef _WIN32
+	if (_binaryFile != nullptr)
+	{
+		CloseHandle(_binaryFile);
+		_binaryFile = nullptr;
+	}
+#else
+	if (_binaryFile >= 0)
+	{
+		close(_binaryFile);
+		_binaryFile = -1;
+	}
+#endif
+	_definedSites.clear();
+}
+
+void Logger::Flush()
+{
+	{
+		lock_guard<mutex> lock(_writerMutex);
+		_stopWriter = true;
+		_wake.notify_one();
+		JoinWriter();
+		_writerRunning.store(false, memory_order_release);
+	}
+
+	WriteQueued();
+	CloseFiles();
+}
+
+void Logger::CloseFiles()
+{
+	lock_guard<mutex> lock(_consumerMutex);
+	_file.close();
+	CloseBinaryFile();
+}
+
+void Logger::LogW(const LogSite& site, const wstring& message)
+{
+	LogS(site, Convert::ToString(message));
+}
+
+void Logger::AppendArgument(std::string& message, const std::string& argument)
+{
+	message.append(argument);
+}
+
+void Logger::AppendArgument(std::string& message, const char* argument)
+{
+	if (argument != nullptr)
+	{
+		message.append(argument);
+	}
+}
+
+void Logger::AppendArgument(std::string& message, const std::wstring& argument)
+{
+	message.append(Convert::ToString(argument));
+}
+
+void Logger::AppendArgument(std::string& message, const wchar_t* argument)
+{
+	if (argument != nullptr)
+	{
+		message.append(Convert::ToString(wstring(argument)));
+	}
+}
+
+void Logger::AppendArgument(std::string& message, char argument)
+{
+	message.push_back(argument);
+}
+
+void Logger::AppendArgument(std::string& message, bool argument)
+{
+	message.append(argument ? "true" : "false");
+}
+
+string Logger::BeginBinaryRecord(const LogSite& site, size_t argumentCount)
+{
+	string record;
+	record.reserve(32 + 16 * argumentCount);
+	record.push_back(static_cast<char>(BinaryLogRecord::Message));
+	BinaryLogAppendFixed(record, site.id, 4);
+	BinaryLogAppendFixed(record, GetCounter(), 8);
+	BinaryLogAppendVarint(record, CurrentThreadId());
+	record.push_back(static_cast<char>(argumentCount));
+	return record;
+}
+
+void Logger::AppendBinaryArgument(std::string& record, const std::string& argument)
+{
+	record.push_back(static_cast<char>(BinaryLogArgument::String));
+	BinaryLogAppendString(record, argument.data(), argument.size());
+}
+
+void Logger::AppendBinaryArgument(std::string& record, const char* argument)
+{
+	record.push_back(static_cast<char>(BinaryLogArgument::String));
+	if (argument != nullptr)
+	{
+		BinaryLogAppendString(record, argument, strlen(argument));
+	}
+	else
+	{
+		BinaryLogAppendVarint(record, 0);
+	}
+}
+
+void Logger::AppendBinaryArgument(std::string& record, const std::wstring& argument)
+{
+	AppendBinaryArgument(record, Convert::ToString(argument));
+}
+
+void Logger::AppendBinaryArgument(std::string& record, const wchar_t* argument)
+{
+	AppendBinaryArgument(record, argument != nullptr ? Convert::ToString(wstring(argument)) : string());
+}
+
+void Logger::AppendBinaryArgument(std::string& record, char argument)
+{
+	record.push_back(static_cast<char>(BinaryLogArgument::Char));
+	record.push_back(argument);
+}
+
+void Logger::AppendBinaryArgument(std::string& record, bool argument)
+{
+	record.push_back(static_cast<char>(argument ? BinaryLogArgument::True : BinaryLogArgument::False));
+}
+
+void Logger::AppendBinaryArgument(std::string& record, double argument)
+{
+	uint64_t bits = 0;
+	memcpy(&bits, &argument, sizeof(bits));
+	record.push_back(static_cast<char>(BinaryLogArgument::Double));
+	BinaryLogAppendFixed(record, bits, 8);
+}
+
+void Logger::Log(const LogSite& site, const char* message)
 {
 	string msg = "";
-	if (message != nullptr && message[0] != NULL)
+	if (message != nullptr && message[0] != '\0')
 	{
 		msg = string(message);
 	}
-	LogS(msg, file, line, isDebugMessage);
+	LogS(site, msg);
 }
 
-void Logger::Log(const wchar_t* message, const char* file, int line, bool isDebugMessage)
+void Logger::Log(const LogSite& site, const wchar_t* message)
 {
 	wstring msg = L"";
-	if (message != nullptr && message[0] != NULL)
+	if (message != nullptr && message[0] != L'\0')
 	{
 		msg = wstring(message);
 	}
-	LogW(msg, file, line, isDebugMessage);
+	LogW(site, msg);
 }
 
-void Logger::Log(const long message, const char* file, int line, bool isDebugMessage)
+void Logger::Log(const LogSite& site, const long message)
 {
+	if (logBinary && (logDebug || !site.isDebug))
+	{
+		string record = BeginBinaryRecord(site, 1);
+		AppendBinaryArgument(record, message);
+		Enqueue(std::move(record), &site);
+		return;
+	}
 	string i = "(long) " + to_string(message);
-	LogS(i, file, line, isDebugMessage);
+	LogS(site, i);
 }
 
-void Logger::Log(const std::string& message, const char* file, int line, bool isDebugMessage)
+void Logger::Log(const LogSite& site, const std::string& message)
 {
-	LogS(message, file, line, isDebugMessage);
+	LogS(site, message);
 }
 
-void Logger::Log(const std::wstring& message, const char* file, int line, bool isDebugMessage)
+void Logger::Log(const LogSite& site, const std::wstring& message)
 {
-	LogW(message, file, line, isDebugMessage);
+	LogW(site, message);
 }
@@ -19,17 +19,60 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <cstring>
+#include <type_traits>
+#include <unordered_set>
+#include "BinaryLogFormat.h"
 
 #define __FILENAME__ (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)
 
-#define PIError(message)				Logger::Get().Log(message, __FILENAME__, __LINE__, false)
-#define PIDebug(message)				Logger::Get().Log(message, __FILENAME__, __LINE__, true)
+// Call site of a log statement. The ids are constants, so the binary log only has to write them.
+#define PI_LOG_SITE(isDebug, format)	LogSite{ std::integral_constant<uint32_t, BinaryLogSiteId(__FILE__, __LINE__)>::value, \
+	std::integral_constant<uint32_t, BinaryLogHash(format)>::value, __FILENAME__, __LINE__, isDebug, format }
 
-// Singleton logger class that writes to a file on C: and to OutputDebugString
+// The message of PIDebug is only evaluated if debug logging is enabled, so it can be built with concatenations
+#define PIError(message)				Logger::Get().Log(PI_LOG_SITE(false, ""), message)
+#define PIDebug(message)				do { if (Logger::Get().logDebug) Logger::Get().Log(PI_LOG_SITE(true, ""), message); } while (0)
+
+// Format string with {} placeholders that are replaced by the arguments in order. The arguments are only evaluated and
+// formatted if the message is logged. The format must be a string literal.
+#define PIErrorF(format, ...)			Logger::Get().LogFormat(PI_LOG_SITE(false, format), __VA_ARGS__)
+#define PIDebugF(format, ...)			do { if (Logger::Get().logDebug) Logger::Get().LogFormat(PI_LOG_SITE(true, format), __VA_ARGS__); } while (0)
+
+// Number of messages that can wait for the writer thread, must be a power of two. Messages are dropped if it is full.
+constexpr size_t LOGGER_QUEUE_CAPACITY = 4096;
+// The writer thread wakes up at least this often to write what has been queued
+constexpr auto LOGGER_WRITE_INTERVAL_MS = 100;
+// The writer thread exits and closes the file when nothing has been logged for this long. The next message starts it again.
+constexpr auto LOGGER_IDLE_EXIT_MS = 1000;
+
+struct LogSite
+{
+	uint32_t id;
+	uint32_t messageId;
+	const char* file;
+	int line;
+	bool isDebug;
+	// Empty if the message is passed as a whole
+	const char* format;
+};
+
+// Singleton logger class that writes to a file on C: and to OutputDebugString.
+// Messages are formatted by the caller and put into a bounded lock-free queue. A background thread keeps the file open
+// and writes the messages in batches, so that logging does not block the logon.
+// If logBinary is set, the caller only encodes the site id, a timestamp and the arguments (see BinaryLogFormat.h) and
+// the file has to be read with the LogDecoder tool.
 class Logger
 {
 public:
 	std::string logfilePath = "C:\\PICredentialProviderLog.txt";
+	std::string binaryLogfilePath = "C:\\PICredentialProviderLog.bin";
 
 	Logger(Logger const&) = delete;
 	void operator=(Logger const&) = delete;
@@ -39,22 +82,191 @@ public:
 		return instance;
 	}
 
-	void Log(const char* message, const char* file, int line, bool isDebugMessage);
+	void Log(const LogSite& site, const char* message);
+
+	void Log(const LogSite& site, const wchar_t* message);
+
+	void Log(const LogSite& site, const long message);
+
+	void Log(const LogSite& site, const std::string& message);
+
+	void Log(const LogSite& site, const std::wstring& message);
 
-	void Log(const wchar_t* message, const char* file, int line, bool isDebugMessage);
+	template<typename... Args>
+	void LogFormat(const LogSite& site, const Args&... args)
+	{
+		if (!logDebug && site.isDebug)
+		{
+			return;
+		}
 
-	void Log(const long message, const char* file, int line, bool isDebugMessage);
+		if (logBinary)
+		{
+			std::string record = BeginBinaryRecord(site, sizeof...(args));
+			int expand[] = { 0, (AppendBinaryArgument(record, args), 0)... };
+			(void)expand;
+			Enqueue(std::move(record), &site);
+			return;
+		}
 
-	void Log(const std::string& message, const char* file, int line, bool isDebugMessage);
+		std::string message;
+		message.reserve(strlen(site.format) + 16 * sizeof...(args));
+		const char* rest = site.format;
+		int expand[] = { 0, (AppendFormatted(message, rest, args), 0)... };
+		(void)expand;
+		message.append(rest);
+		LogS(site, message);
+	}
+
+	/// <summary>
+	/// Write all queued messages, close the file and stop the writer thread. The next message starts it again.
+	/// Not from DllMain. The writer also stops by itself when it is idle and keeps the module loaded until then.
+	/// </summary>
+	void Flush();
+
+	// Number of messages that were dropped because the queue was full
+	size_t GetDroppedCount() const noexcept { return _dropped.load(std::memory_order_relaxed); }
 
-	void Log(const std::wstring& message, const char* file, int line, bool isDebugMessage);
+	// If the writer thread is running, for diagnostics
+	bool IsWriterRunning() const noexcept { return _writerRunning.load(); }
 
 	bool logDebug = false;
 
+	// Write the binary format to binaryLogfilePath instead of text
+	bool logBinary = false;
+
 private:
-	Logger() = default;
+	Logger();
+
+	~Logger();
+
+	void LogS(const LogSite& site, const std::string& message);
+
+	void LogW(const LogSite& site, const std::wstring& message);
+
+	// site is only set for binary records
+	void Enqueue(std::string&& message, const LogSite* site = nullptr);
+
+	// Append the format up to the next placeholder, then the argument
+	template<typename T>
+	static void AppendFormatted(std::string& message, const char*& rest, const T& argument)
+	{
+		const char* placeholder = strstr(rest, "{}");
+		if (placeholder == nullptr)
+		{
+			// More arguments than placeholders, append them at the end
+			message.append(rest).append(" ");
+			rest = "";
+		}
+		else
+		{
+			message.append(rest, placeholder - rest);
+			rest = placeholder + 2;
+		}
+		AppendArgument(message, argument);
+	}
+
+	static void AppendArgument(std::string& message, const std::string& argument);
+	static void AppendArgument(std::string& message, const char* argument);
+	static void AppendArgument(std::string& message, const std::wstring& argument);
+	static void AppendArgument(std::string& message, const wchar_t* argument);
+	static void AppendArgument(std::string& message, char argument);
+	static void AppendArgument(std::string& message, bool argument);
+
+	template<typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+	static void AppendArgument(std::string& message, T argument)
+	{
+		message.append(std::to_string(argument));
+	}
+
+	// Message record up to the arguments
+	static std::string BeginBinaryRecord(const LogSite& site, size_t argumentCount);
+
+	static void AppendBinaryArgument(std::string& record, const std::string& argument);
+	static void AppendBinaryArgument(std::string& record, const char* argument);
+	static void AppendBinaryArgument(std::string& record, const std::wstring& argument);
+	static void AppendBinaryArgument(std::string& record, const wchar_t* argument);
+	static void AppendBinaryArgument(std::string& record, char argument);
+	static void AppendBinaryArgument(std::string& record, bool argument);
+	static void AppendBinaryArgument(std::string& record, double argument);
+
+	template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+	static void AppendBinaryArgument(std::string& record, T argument)
+	{
+		if (std::is_signed<T>::value)
+		{
+			record.push_back(static_cast<char>(BinaryLogArgument::Int));
+			BinaryLogAppendVarint(record, BinaryLogZigZag(static_cast<int64_t>(argument)));
+		}
+		else
+		{
+			record.push_back(static_cast<char>(BinaryLogArgument::UInt));
+			BinaryLogAppendVarint(record, static_cast<uint64_t>(argument));
+		}
+	}
+
+	void StartWriter();
+
+	void WriterThread();
+
+	// Called by the writer thread when nothing has been queued for LOGGER_IDLE_EXIT_MS. Returns true if the thread
+	// can exit, false if a message arrived in the meantime or Flush is stopping it.
+	bool ExitIfIdle();
+
+	// Wait for the writer thread that has been told to stop or has exited by itself. Needs _writerMutex.
+	void JoinWriter();
+
+	void CloseFiles();
+
+	// Take the queued messages and write them with one call. Only one thread can consume at a time (_consumerMutex).
+	void WriteQueued();
+
+	// Append the batch with a single write, so that it is not interleaved with the writes of other processes
+	void WriteBinary(const std::string& batch);
+
+	bool OpenBinaryFile();
+
+	// Close the binary log, the sites have to be defined again in the next one
+	void CloseBinaryFile();
+
+	bool HasQueued() const noexcept;
+
+	// Bounded MPSC queue: a slot can be written when its sequence equals the enqueue position, and read when it is one
+	// more than the dequeue position
+	struct Slot
+	{
+		std::atomic<size_t> sequence;
+		std::string message;
+		bool binary;
+		LogSite site;
+	};
+
+	std::unique_ptr<Slot[]> _slots;
+	std::atomic<size_t> _enqueuePosition{ 0 };
+	size_t _dequeuePosition = 0;
+	std::atomic<size_t> _dropped{ 0 };
+	size_t _droppedReported = 0;
 
-	void LogS(const std::string& message, const char* file, int line, bool isDebugMessage);
+	std::mutex _consumerMutex;
+	std::ofstream _file;
+	// HANDLE (file descriptor outside of Windows) of the binary log and the sites that have been defined in it
+#ifdef _WIN32
+	void* _binaryFile = nullptr;
+#else
+	int _binaryFile = -1;
+#endif
+	std::unordered_set<uint32_t> _definedSites;
 
-	void LogW(const std::wstring& message, const char* file, int line, bool isDebugMessage);
+	std::mutex _writerMutex;
+#ifdef _WIN32
+	// HANDLE of the writer thread. The thread holds a reference to the module, so that it is not unloaded while the
+	// thread still runs its code.
+	void* _writer = nullptr;
+#else
+	std::thread _writer;
+#endif
+	std::atomic<bool> _writerRunning{ false };
+	std::atomic<bool> _stopWriter{ false };
+	std::mutex _wakeMutex;
+	std::condition_variable _wake;
 };
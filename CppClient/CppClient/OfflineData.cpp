@@ -19,7 +19,15 @@
 
 #include "OfflineData.h"
 #include "Logger.h"
+#include "Convert.h"
 #include <iostream>
+#include <climits>
+#include <cmath>
+#ifndef PI_NO_FIDO2
+#include <cbor.h>
+#include <fido.h>
+#include <fido/es256.h>
+#endif
 
 using namespace std;
 
@@ -29,16 +37,170 @@ int OfflineData::GetLowestKey()
 
 	for (auto& item : offlineOTPs)
 	{
-		try
+		int key = 0;
+		if (Convert::ToInt(item.first, key))
 		{
-			const int key = stoi(item.first);
 			lowestKey = (lowestKey > key ? key : lowestKey);
 		}
-		catch (const std::invalid_argument & e)
+		else
 		{
-			PIDebug(e.what());
+			PIDebugF("Offline OTP key is not a number: {}", item.first);
 		}
 	}
 
 	return lowestKey;
 }
+
+size_t OfflineData::GetSize() const
+{
+	size_t size = sizeof(OfflineData) + username.capacity() + serial.capacity() + refilltoken.capacity()
+		+ pubKey.capacity() + credId.capacity() + rpId.capacity();
+
+	for (const auto& item : offlineOTPs)
+	{
+		// Each map entry is a tree node (3 pointers and the color) holding the pair
+		size += sizeof(std::pair<const std::string, std::string>) + 4 * sizeof(void*) + item.first.capacity() + item.second.capacity();
+	}
+
+	return size;
+}
+
+// Time constant of the moving average, older consumption fades out with e^(-t/tau)
+constexpr double CONSUMPTION_RATE_TAU_DAYS = 7.0;
+// Several logons in a short time should not result in a huge rate
+constexpr double CONSUMPTION_MIN_INTERVAL_DAYS = 1.0 / 24.0;
+constexpr double SECONDS_PER_DAY = 86400.0;
+
+void OfflineData::RecordConsumption(size_t count, std::time_t now)
+{
+	if (lastConsumption == 0 || now <= lastConsumption)
+	{
+		// Nothing to compare with yet
+		lastConsumption = now > lastConsumption ? now : lastConsumption;
+		return;
+	}
+
+	double intervalDays = (double)(now - lastConsumption) / SECONDS_PER_DAY;
+	if (intervalDays < CONSUMPTION_MIN_INTERVAL_DAYS)
+	{
+		intervalDays = CONSUMPTION_MIN_INTERVAL_DAYS;
+	}
+
+	const double rate = (double)count / intervalDays;
+	if (consumptionRate <= 0.0)
+	{
+		consumptionRate = rate;
+	}
+	else
+	{
+		// The weight of the new sample grows with the time that passed since the last one
+		const double weight = 1.0 - exp(-intervalDays / CONSUMPTION_RATE_TAU_DAYS);
+		consumptionRate = weight * rate + (1.0 - weight) * consumptionRate;
+	}
+	lastConsumption = now;
+}
+
+constexpr auto COSE_PUB_KEY_ALG = 3;
+constexpr auto COSE_PUB_KEY_X = -2;
+constexpr auto COSE_PUB_KEY_Y = -3;
+constexpr auto ES256_COORDINATE_SIZE = 32;
+
+bool OfflineData::DecodePublicKey()
+{
+	publicKey.reset();
+	publicKeyAlgorithm = 0;
+	if (pubKey.empty())
+	{
+		return false;
+	}
+#ifdef PI_NO_FIDO2
+	// Built without libfido2 (portable build of the tests), offline WebAuthn can not be verified
+	return false;
+#else
+
+	const auto pubKeyBytes = Convert::HexToBytes(pubKey);
+	struct cbor_load_result result;
+	cbor_item_t* map = cbor_load(pubKeyBytes.data(), pubKeyBytes.size(), &result);
+
+	if (map == NULL)
+	{
+		PIError("Failed to parse CBOR public key");
+		return false;
+	}
+	if (!cbor_isa_map(map))
+	{
+		PIError("CBOR public key is not a map");
+		cbor_decref(&map);
+		return false;
+	}
+
+	const size_t size = cbor_map_size(map);
+	cbor_pair* pairs = cbor_map_handle(map);
+
+	int alg = 0;
+	vector<unsigned char> x, y;
+	for (size_t i = 0; i < size; i++)
+	{
+		if (cbor_isa_uint(pairs[i].key) && cbor_get_uint8(pairs[i].key) == COSE_PUB_KEY_ALG)
+		{
+			if (cbor_isa_negint(pairs[i].value))
+			{
+				alg = -1 - (int)cbor_get_int(pairs[i].value);
+			}
+		}
+		else if (cbor_isa_negint(pairs[i].key) && cbor_isa_bytestring(pairs[i].value))
+		{
+			const int key = -1 - (int)cbor_get_int(pairs[i].key);
+			const unsigned char* value = cbor_bytestring_handle(pairs[i].value);
+			const size_t length = cbor_bytestring_length(pairs[i].value);
+			if (key == COSE_PUB_KEY_X)
+			{
+				x.assign(value, value + length);
+			}
+			else if (key == COSE_PUB_KEY_Y)
+			{
+				y.assign(value, value + length);
+			}
+		}
+	}
+	cbor_decref(&map);
+
+	// TODO implement other COSE algorithms if supported by privacyIDEA
+	if (alg != COSE_ES256)
+	{
+		PIErrorF("Unimplemented alg: {}", alg);
+		return false;
+	}
+	if (x.size() != ES256_COORDINATE_SIZE || y.size() != ES256_COORDINATE_SIZE)
+	{
+		PIError("COSE public key has the wrong size. Expected 32 bytes for x and y, actual: " + to_string(x.size())
+			+ " and " + to_string(y.size()));
+		return false;
+	}
+
+	// The uncompressed point x|y, libfido2 checks that it is on the curve
+	x.insert(x.end(), y.begin(), y.end());
+	es256_pk_t* pk = es256_pk_new();
+	if (pk == nullptr)
+	{
+		PIError("Failed to allocate public key");
+		return false;
+	}
+
+	const int res = es256_pk_from_ptr(pk, x.data(), x.size());
+	if (res != FIDO_OK)
+	{
+		PIErrorF("es256_pk_from_ptr: {} code: {}", fido_strerr(res), res);
+		es256_pk_free(&pk);
+		return false;
+	}
+
+	publicKey = shared_ptr<const es256_pk>(pk, [](const es256_pk* p)
+		{
+			es256_pk_t* key = const_cast<es256_pk_t*>(p);
+			es256_pk_free(&key);
+		});
+	publicKeyAlgorithm = alg;
+	return true;
+#endif
+}
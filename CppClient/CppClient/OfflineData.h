@@ -20,12 +20,26 @@
 
 #include "Logger.h"
 #include <map>
+#include <ctime>
+#include <memory>
+
+// libfido2 public key type, see fido/es256.h
+struct es256_pk;
 
 class OfflineData
 {
 public:
 	int GetLowestKey();
 
+	// Approximate memory used by this dataset in bytes
+	size_t GetSize() const;
+
+	// Update the consumption rate with count OTPs used at time now, O(1)
+	void RecordConsumption(size_t count, std::time_t now);
+
+	// Decode the COSE public key (pubKey) into publicKey, so that it does not have to be parsed again for each verification
+	bool DecodePublicKey();
+
 	bool operator==(const OfflineData& other) const
 	{
 		return username == other.username && serial == other.serial && refilltoken == other.refilltoken;
@@ -34,6 +48,11 @@ public:
 	std::string username = "";
 	std::string serial = "";
 	std::string refilltoken = "";
+	// Last successful use or when the data was received, used for eviction
+	std::time_t lastUsed = 0;
+	// Exponentially weighted moving average of the OTPs used per day, 0 if unknown
+	double consumptionRate = 0.0;
+	std::time_t lastConsumption = 0;
 
 	// HOTP
 	std::map<std::string, std::string> offlineOTPs;
@@ -44,6 +63,9 @@ public:
 	std::string pubKey;
 	std::string credId;
 	std::string rpId;
+	// Decoded from pubKey, not persisted
+	std::shared_ptr<const es256_pk> publicKey;
+	int publicKeyAlgorithm = 0;
 
 	bool isWebAuthn() const { return !pubKey.empty() && !credId.empty() && !rpId.empty(); }
 };
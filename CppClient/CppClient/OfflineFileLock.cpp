@@ -0,0 +1,136 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "OfflineFileLock.h"
+#include "Convert.h"
+#include "Logger.h"
+#include <chrono>
+#include <thread>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// Another process holds the lock, so it is worth trying again
+static bool IsContended(unsigned long error)
+{
+#ifdef _WIN32
+	return error == ERROR_LOCK_VIOLATION;
+#else
+	return error == EAGAIN || error == EACCES;
+#endif
+}
+
+OfflineFileLock::OfflineFileLock(const std::wstring& offlineFilePath, bool enabled, bool exclusive)
+{
+	_enabled = enabled;
+	if (!_enabled)
+	{
+		_locked = true;
+		return;
+	}
+
+	// A separate lock file is used so that the lock does not interfere with reading and writing the offline file itself
+	const wstring lockFilePath = offlineFilePath + OFFLINE_LOCK_FILE_SUFFIX;
+#ifdef _WIN32
+	_hFile = CreateFileW(lockFilePath.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+		NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_HIDDEN, NULL);
+	if (_hFile == INVALID_HANDLE_VALUE)
+	{
+		PIErrorF("Unable to open offline lock file: {}", GetLastError());
+		return;
+	}
+#else
+	_fd = open(Convert::ToFilePath(lockFilePath).c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if (_fd < 0)
+	{
+		PIErrorF("Unable to open offline lock file: {}", errno);
+		return;
+	}
+#endif
+
+	// Try to get the lock until the timeout is reached, so that a hanging process can not block the logon forever
+	const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(OFFLINE_LOCK_TIMEOUT_MS);
+	while (true)
+	{
+		const unsigned long error = TryLock(exclusive);
+		if (error == 0)
+		{
+			_locked = true;
+			break;
+		}
+
+		if (!IsContended(error) || chrono::steady_clock::now() > deadline)
+		{
+			PIErrorF("Unable to lock offline file: {}", error);
+			break;
+		}
+		this_thread::sleep_for(chrono::milliseconds(10));
+	}
+}
+
+unsigned long OfflineFileLock::TryLock(bool exclusive)
+{
+#ifdef _WIN32
+	const DWORD dwFlags = (exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0) | LOCKFILE_FAIL_IMMEDIATELY;
+	return LockFileEx(_hFile, dwFlags, 0, 1, 0, &_overlapped) ? 0 : GetLastError();
+#else
+	struct flock lock = {};
+	lock.l_type = exclusive ? F_WRLCK : F_RDLCK;
+	lock.l_whence = SEEK_SET;
+	lock.l_start = 0;
+	lock.l_len = 1;
+#ifdef F_OFD_SETLK
+	// Locks of the open file description conflict between threads of the same process, like LockFileEx
+	return fcntl(_fd, F_OFD_SETLK, &lock) == 0 ? 0 : errno;
+#else
+	// Process wide lock, only coordinates between processes
+	return fcntl(_fd, F_SETLK, &lock) == 0 ? 0 : errno;
+#endif
+#endif
+}
+
+OfflineFileLock::~OfflineFileLock()
+{
+	if (!_enabled)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	if (_locked)
+	{
+		UnlockFileEx(_hFile, 0, 1, 0, &_overlapped);
+	}
+
+	if (_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(_hFile);
+	}
+#else
+	// Closing the descriptor releases the lock
+	if (_fd >= 0)
+	{
+		close(_fd);
+	}
+#endif
+}
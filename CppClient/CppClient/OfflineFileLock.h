@@ -0,0 +1,61 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <string>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+constexpr auto OFFLINE_LOCK_FILE_SUFFIX = L".lock";
+constexpr unsigned int OFFLINE_LOCK_TIMEOUT_MS = 5000;
+
+/// <summary>
+/// Scoped byte-range lock on the lock file next to the offline file. Used to coordinate access to the offline file
+/// between multiple processes (LogonUI, CredUI host) that each have their own OfflineHandler.
+/// A disabled lock does nothing and is always considered locked. If the lock can not be taken before the timeout, IsLocked
+/// is false and the offline file must not be changed.
+/// On Windows LockFileEx is used, elsewhere an open file description lock (fcntl), which also belongs to the handle and
+/// not to the process.
+/// </summary>
+class OfflineFileLock
+{
+public:
+	OfflineFileLock(const std::wstring& offlineFilePath, bool enabled, bool exclusive);
+
+	~OfflineFileLock();
+
+	OfflineFileLock(const OfflineFileLock&) = delete;
+	OfflineFileLock& operator=(const OfflineFileLock&) = delete;
+
+	bool IsLocked() const noexcept { return _locked; }
+
+private:
+	// Returns 0 if the lock was taken, otherwise the error code of the system
+	unsigned long TryLock(bool exclusive);
+
+#ifdef _WIN32
+	HANDLE _hFile = INVALID_HANDLE_VALUE;
+	OVERLAPPED _overlapped{};
+#else
+	int _fd = -1;
+#endif
+	bool _enabled = false;
+	bool _locked = false;
+};
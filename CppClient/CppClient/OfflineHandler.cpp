@@ -18,19 +18,29 @@
 ** * * * * * * * * * * * * * * * * * * */
 
 #include "OfflineHandler.h"
+#include "OfflineFileLock.h"
 #include "JsonParser.h"
 #include "Convert.h"
+#include "CryptoProvider.h"
+#include "IdentityKey.h"
 #include <iostream>
 #include <fstream>
-#include <atlenc.h>
+#include <sstream>
 #include <algorithm>
-
-#pragma comment (lib, "bcrypt.lib")
+#include <cmath>
+#include <cstring>
+#ifndef _WIN32
+#include <sys/stat.h>
+#include <time.h>
+#endif
 
 using namespace std;
 
 std::wstring getErrorText(DWORD err)
 {
+#ifndef _WIN32
+	return Convert::ToWString(strerror(static_cast<int>(err)));
+#else
 	LPWSTR msgBuf = nullptr;
 	FormatMessage(
 		FORMAT_MESSAGE_ALLOCATE_BUFFER |
@@ -42,17 +52,79 @@ std::wstring getErrorText(DWORD err)
 		(LPTSTR)&msgBuf,
 		0, NULL);
 	return (msgBuf == nullptr) ? wstring() : wstring(msgBuf);
+#endif
+}
+
+#ifdef _WIN32
+constexpr long long FILE_TIME_TICKS_PER_SECOND = 10000000; // FILETIME
+#else
+constexpr long long FILE_TIME_TICKS_PER_SECOND = 1000000000;
+#endif
+// Writes within this time can have the same time stamp on file systems with a coarse resolution (FAT has 2 seconds)
+constexpr long long FILE_TIME_RESOLUTION = 2 * FILE_TIME_TICKS_PER_SECOND;
+
+// Size and last write time of the file and the current time in the same unit. Returns false if the file does not exist.
+static bool GetFileState(const wstring& path, long long& size, long long& time, long long& now)
+{
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExW(path.c_str(), GetFileExInfoStandard, &attributes)) return false;
+	size = ((long long)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	time = ((long long)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	FILETIME current;
+	GetSystemTimeAsFileTime(&current);
+	now = ((long long)current.dwHighDateTime << 32) | current.dwLowDateTime;
+#else
+	struct stat info;
+	if (stat(Convert::ToFilePath(path).c_str(), &info) != 0) return false;
+	size = (long long)info.st_size;
+#ifdef __APPLE__
+	time = (long long)info.st_mtimespec.tv_sec * FILE_TIME_TICKS_PER_SECOND + info.st_mtimespec.tv_nsec;
+#else
+	time = (long long)info.st_mtim.tv_sec * FILE_TIME_TICKS_PER_SECOND + info.st_mtim.tv_nsec;
+#endif
+	struct timespec current;
+	clock_gettime(CLOCK_REALTIME, &current);
+	now = (long long)current.tv_sec * FILE_TIME_TICKS_PER_SECOND + current.tv_nsec;
+#endif
+	return true;
 }
 
-OfflineHandler::OfflineHandler(const wstring& filePath, int tryWindow)
+OfflineHandler::OfflineHandler(const wstring& filePath, int tryWindow, bool sharedStore, size_t maxUsers, size_t maxBytes, bool compactFile)
 {
 	// Load the offline file on startup
 	_filePath = filePath.empty() ? _filePath : filePath;
 	_tryWindow = tryWindow == 0 ? _tryWindow : tryWindow;
+	_sharedStore = sharedStore;
+	_maxUsers = maxUsers;
+	_maxBytes = maxBytes;
+	_compactFile = compactFile;
+	OfflineFileLock lock(_filePath, _sharedStore, true);
+	if (!lock.IsLocked())
+	{
+		// Reading without the lock could see a partially written file. The next access tries again.
+		PIError("Offline: The shared store is locked, it is not loaded now");
+		return;
+	}
+
 	const HRESULT res = LoadFromFile();
+	if (_sharedStore)
+	{
+		RememberFile();
+	}
 	if (res == S_OK)
 	{
-		PIDebug("Offline data loaded successfully!");
+		PIDebugF("Offline data loaded successfully! Store size: {} bytes", GetStoreSize());
+		// The limits might have been lowered since the file was written
+		if (EnforceCapacity())
+		{
+			Publish();
+			const HRESULT saved = SaveToFile();
+			if (saved != S_OK)
+			{
+				PIErrorF("Offline: Unable to save the store after enforcing the limits: {}", Convert::LongToHexString(saved));
+			}
+		}
 	}
 	else if (res == ERROR_FILE_NOT_FOUND)
 	{
@@ -66,7 +138,9 @@ OfflineHandler::OfflineHandler(const wstring& filePath, int tryWindow)
 
 OfflineHandler::~OfflineHandler()
 {
-	if (!_dataSets.empty())
+	lock_guard<mutex> guard(_writeMutex);
+	// In shared mode every change has already been written. Writing again would overwrite changes of other processes.
+	if (!_dataSets.empty() && !_sharedStore)
 	{
 		const HRESULT res = SaveToFile();
 		if (res != S_OK)
@@ -80,14 +154,25 @@ OfflineHandler::~OfflineHandler()
 	}
 }
 
-HRESULT OfflineHandler::VerifyOfflineOTP(const std::wstring& otp, const std::string& username, std::string& serialUsed)
+HRESULT OfflineHandler::VerifyOfflineOTP(const SecureWString& otp, const std::string& username, std::string& serialUsed)
 {
+	const IdentityKey user(username);
+	// The OTP is hashed as UTF-8, convert it once for all stored values
+	const SecureString utf8OTP = Convert::ToString(otp);
+	lock_guard<mutex> guard(_writeMutex);
+	OfflineFileLock lock(_filePath, _sharedStore, true);
+	const HRESULT res = BeginUpdate(lock);
+	if (res != S_OK)
+	{
+		return res;
+	}
+
 	HRESULT success = E_FAIL;
 	for (auto& item : _dataSets)
 	{
-		if (Convert::ToUpperCase(item.username) == Convert::ToUpperCase(username))
+		if (user.Matches(item.username))
 		{
-			PIDebug("Trying token " + item.serial);
+			PIDebugF("Trying token {}", item.serial);
 			const int lowestKey = item.GetLowestKey();
 			int matchingKey = lowestKey;
 
@@ -97,7 +182,7 @@ HRESULT OfflineHandler::VerifyOfflineOTP(const std::wstring& otp, const std::str
 				try
 				{
 					string storedValue = item.offlineOTPs.at(to_string(i));
-					if (PBKDF2SHA512Verify(otp, storedValue))
+					if (PBKDF2SHA512Verify(utf8OTP, storedValue))
 					{
 						matchingKey = i;
 						success = S_OK;
@@ -123,22 +208,43 @@ HRESULT OfflineHandler::VerifyOfflineOTP(const std::wstring& otp, const std::str
 						count++;
 					}
 				}
-				PIDebug("Offline authentication success with token " + item.serial + ", removing " + to_string(count) + " offline OTPs.");
+				PIDebugF("Offline authentication success with token {}, removing {} offline OTPs.", item.serial, count);
 				serialUsed = item.serial;
+				item.lastUsed = time(nullptr);
+				item.RecordConsumption(count, item.lastUsed);
 				// If success, stop trying other dataSets
 				break;
 			}
 		}
 	}
 
+	if (success == S_OK)
+	{
+		Publish();
+		if (_sharedStore)
+		{
+			// Other processes read the file, an OTP that is still in it could be used again
+			const HRESULT saved = SaveToFile();
+			if (saved != S_OK)
+			{
+				PIErrorF("Offline: The used OTPs could not be saved, rejecting the OTP: {}", Convert::LongToHexString(saved));
+				serialUsed.clear();
+				return saved;
+			}
+		}
+	}
+
 	return success;
 }
 
 HRESULT OfflineHandler::GetRefillToken(const std::string& username, const std::string& serial, std::string& refilltoken)
 {
-	for (const auto& item : _dataSets)
+	const IdentityKey user(username);
+	const auto snapshot = GetSnapshot();
+
+	for (const auto& item : *snapshot)
 	{
-		if (Convert::ToUpperCase(item.username) == Convert::ToUpperCase(username) && item.serial == serial)
+		if (item.serial == serial && user.Matches(item.username))
 		{
 			if (item.refilltoken.empty()) return PI_OFFLINE_NO_OFFLINE_DATA;
 			refilltoken = string(item.refilltoken);
@@ -151,18 +257,42 @@ HRESULT OfflineHandler::GetRefillToken(const std::string& username, const std::s
 
 HRESULT OfflineHandler::AddOfflineData(const OfflineData& data)
 {
+	lock_guard<mutex> guard(_writeMutex);
+	OfflineFileLock lock(_filePath, _sharedStore, true);
+	const HRESULT res = BeginUpdate(lock);
+	if (res != S_OK)
+	{
+		return res;
+	}
+
+	MergeOfflineData(data);
+	const bool evicted = EnforceCapacity();
+	Publish();
+
+	// Evictions are persisted right away, so that evicted data does not come back if the process ends unexpectedly
+	if (evicted || _sharedStore)
+	{
+		return SaveToFile();
+	}
+
+	return S_OK;
+}
+
+void OfflineHandler::MergeOfflineData(const OfflineData& data)
+{
+	const IdentityKey user(data.username);
 	// Check if the user already has data first, then add
 	bool done = false;
 	for (auto& existing : _dataSets)
 	{
-		if (Convert::ToUpperCase(existing.username) == Convert::ToUpperCase(data.username) && existing.serial == data.serial)
+		if (existing.serial == data.serial && user.Matches(existing.username))
 		{
-			PIDebug("Offline: Updating exsisting user data for " + data.username + " and token " + data.serial);
+			PIDebugF("Offline: Updating exsisting user data for {} and token {}", data.username, data.serial);
 			existing.refilltoken = data.refilltoken;
 
 			for (const auto& newOTP : data.offlineOTPs)
 			{
-				existing.offlineOTPs.try_emplace(newOTP.first, newOTP.second);
+				existing.offlineOTPs.emplace(newOTP.first, newOTP.second);
 			}
 			done = true;
 		}
@@ -171,17 +301,136 @@ HRESULT OfflineHandler::AddOfflineData(const OfflineData& data)
 	if (!done)
 	{
 		_dataSets.push_back(data);
-		PIDebug("Offline: Adding new data for " + data.username + " and token " + data.serial);
+		auto& added = _dataSets.back();
+		if (added.lastUsed == 0)
+		{
+			added.lastUsed = time(nullptr);
+		}
+		if (added.isWebAuthn() && !added.publicKey)
+		{
+			added.DecodePublicKey();
+		}
+		PIDebugF("Offline: Adding new data for {} and token {}", data.username, data.serial);
 	}
+}
 
-	return S_OK;
+bool OfflineHandler::EnforceCapacity()
+{
+	if (_maxUsers == 0 && _maxBytes == 0)
+	{
+		return false;
+	}
+
+	// Group by user once, the last use of a user is the last use of any of its token
+	struct UserUsage
+	{
+		IdentityKey user;
+		time_t lastUsed;
+		size_t size;
+		bool evict;
+	};
+	map<IdentityKey, size_t> userIndex;
+	vector<UserUsage> users;
+	size_t storeSize = 0;
+	for (const auto& item : _dataSets)
+	{
+		IdentityKey user(item.username);
+		auto it = userIndex.find(user);
+		if (it == userIndex.end())
+		{
+			it = userIndex.emplace(user, users.size()).first;
+			users.push_back({ std::move(user), item.lastUsed, 0, false });
+		}
+		auto& usage = users[it->second];
+		if (usage.lastUsed < item.lastUsed)
+		{
+			usage.lastUsed = item.lastUsed;
+		}
+		const size_t size = item.GetSize();
+		usage.size += size;
+		storeSize += size;
+	}
+
+	// Least recently used first, users that were used at the same time in the order of their key
+	vector<UserUsage*> byLastUse;
+	byLastUse.reserve(users.size());
+	for (const auto& entry : userIndex)
+	{
+		byLastUse.push_back(&users[entry.second]);
+	}
+	stable_sort(byLastUse.begin(), byLastUse.end(), [](const UserUsage* a, const UserUsage* b) { return a->lastUsed < b->lastUsed; });
+
+	size_t userCount = users.size();
+	bool evicted = false;
+	for (UserUsage* usage : byLastUse)
+	{
+		const bool tooManyUsers = _maxUsers > 0 && userCount > _maxUsers;
+		const bool tooLarge = _maxBytes > 0 && storeSize > _maxBytes;
+		// Never evict the last remaining user, even if its data alone exceeds the size limit
+		if ((!tooManyUsers && !tooLarge) || userCount < 2)
+		{
+			break;
+		}
+
+		PIDebug("Offline: Evicting data of least recently used user " + Convert::ToString(usage->user.GetFolded())
+			+ " (users: " + to_string(userCount) + ", size: " + to_string(storeSize) + " bytes)");
+		usage->evict = true;
+		userCount--;
+		storeSize -= usage->size;
+		evicted = true;
+	}
+
+	if (evicted)
+	{
+		_dataSets.erase(std::remove_if(_dataSets.begin(), _dataSets.end(),
+			[&](const OfflineData& item) { return users[userIndex.at(IdentityKey(item.username))].evict; }), _dataSets.end());
+	}
+
+	return evicted;
 }
 
-size_t OfflineHandler::GetOfflineOTPCount(const std::string& username, const std::string& serial)
+HRESULT OfflineHandler::MarkUsed(const std::string& username, const std::string& serial)
 {
+	const IdentityKey user(username);
+	lock_guard<mutex> guard(_writeMutex);
+	OfflineFileLock lock(_filePath, _sharedStore, true);
+	const HRESULT res = BeginUpdate(lock);
+	if (res != S_OK)
+	{
+		return res;
+	}
+
 	for (auto& item : _dataSets)
 	{
-		if (Convert::ToUpperCase(item.username) == Convert::ToUpperCase(username) && item.serial == serial)
+		if (item.serial == serial && user.Matches(item.username))
+		{
+			item.lastUsed = time(nullptr);
+			Publish();
+			return _sharedStore ? SaveToFile() : S_OK;
+		}
+	}
+	return PI_OFFLINE_NO_OFFLINE_DATA;
+}
+
+size_t OfflineHandler::GetStoreSize()
+{
+	const auto snapshot = atomic_load(&_snapshot);
+	size_t size = 0;
+	for (const auto& item : *snapshot)
+	{
+		size += item.GetSize();
+	}
+	return size;
+}
+
+size_t OfflineHandler::GetOfflineOTPCount(const std::string& username, const std::string& serial)
+{
+	const IdentityKey user(username);
+	const auto snapshot = GetSnapshot();
+
+	for (const auto& item : *snapshot)
+	{
+		if (item.serial == serial && user.Matches(item.username))
 		{
 			return item.offlineOTPs.size();
 		}
@@ -190,12 +439,41 @@ size_t OfflineHandler::GetOfflineOTPCount(const std::string& username, const std
 	return 0;
 }
 
+bool OfflineHandler::ShouldRefill(const std::string& username, const std::string& serial, size_t threshold, double autonomyDays)
+{
+	const IdentityKey user(username);
+	const auto snapshot = GetSnapshot();
+
+	for (const auto& item : *snapshot)
+	{
+		if (item.serial == serial && user.Matches(item.username))
+		{
+			const size_t remaining = item.offlineOTPs.size();
+			if (autonomyDays > 0.0 && item.consumptionRate > 0.0)
+			{
+				const size_t required = (size_t)ceil(item.consumptionRate * autonomyDays);
+				PIDebug("Offline: Token " + serial + " uses " + to_string(item.consumptionRate) + " OTPs per day, "
+					+ to_string(remaining) + " left, " + to_string(required) + " needed for " + to_string(autonomyDays) + " days");
+				return remaining < required;
+			}
+
+			// Without a known rate, use the fixed threshold. 0 means refill after every authentication
+			return threshold == 0 || remaining < threshold;
+		}
+	}
+
+	return false;
+}
+
 std::vector<std::pair<std::string, size_t>> OfflineHandler::GetTokenInfo(const std::string& username)
 {
+	const IdentityKey user(username);
+	const auto snapshot = GetSnapshot();
+
 	std::vector<std::pair<std::string, size_t>> ret;
-	for (auto& item : _dataSets)
+	for (const auto& item : *snapshot)
 	{
-		if (Convert::ToUpperCase(item.username) == Convert::ToUpperCase(username))
+		if (user.Matches(item.username))
 		{
 			ret.push_back(make_pair(item.serial, item.offlineOTPs.size()));
 		}
@@ -205,10 +483,13 @@ std::vector<std::pair<std::string, size_t>> OfflineHandler::GetTokenInfo(const s
 
 std::vector<OfflineData> OfflineHandler::GetWebAuthnOfflineData(const std::string& username)
 {
+	const IdentityKey user(username);
+	const auto snapshot = GetSnapshot();
+
 	std::vector<OfflineData> ret;
-	for (auto& item : _dataSets)
+	for (const auto& item : *snapshot)
 	{
-		if (Convert::ToUpperCase(item.username) == Convert::ToUpperCase(username) && item.isWebAuthn())
+		if (user.Matches(item.username) && item.isWebAuthn())
 		{
 			ret.push_back(item);
 		}
@@ -218,77 +499,255 @@ std::vector<OfflineData> OfflineHandler::GetWebAuthnOfflineData(const std::strin
 
 bool OfflineHandler::RemoveOfflineData(const std::string& username, const std::string& serial)
 {
-	bool found = false;
-	for (auto& item : _dataSets)
+	lock_guard<mutex> guard(_writeMutex);
+	OfflineFileLock lock(_filePath, _sharedStore, true);
+	if (BeginUpdate(lock) != S_OK)
 	{
-		if (Convert::ToUpperCase(item.username) == Convert::ToUpperCase(username) && item.serial == serial)
-		{
-			_dataSets.erase(std::remove(_dataSets.begin(), _dataSets.end(), item), _dataSets.end());
-			found = true;
-			break;
-		}
+		return false;
 	}
 
+	const bool found = RemoveDataSet(username, serial);
 	if (!found)
 	{
-		PIDebug("Offline: No data to remove for " + username + " and token " + serial);
+		PIDebugF("Offline: No data to remove for {} and token {}", username, serial);
+	}
+	else
+	{
+		Publish();
+		if (_sharedStore && SaveToFile() != S_OK)
+		{
+			return false;
+		}
 	}
 	
 	return found;
 }
 
+HRESULT OfflineHandler::UpdateOfflineData(const std::vector<OfflineData>& updates, const std::vector<std::pair<std::string, std::string>>& removals)
+{
+	lock_guard<mutex> guard(_writeMutex);
+	OfflineFileLock lock(_filePath, _sharedStore, true);
+	const HRESULT res = BeginUpdate(lock);
+	if (res != S_OK)
+	{
+		return res;
+	}
+
+	for (const auto& data : updates)
+	{
+		MergeOfflineData(data);
+	}
+
+	for (const auto& removal : removals)
+	{
+		if (!RemoveDataSet(removal.first, removal.second))
+		{
+			PIDebugF("Offline: No data to remove for {} and token {}", removal.first, removal.second);
+		}
+	}
+
+	const bool evicted = EnforceCapacity();
+	Publish();
+	if (evicted || _sharedStore)
+	{
+		return SaveToFile();
+	}
+
+	return S_OK;
+}
+
+bool OfflineHandler::RemoveDataSet(const std::string& username, const std::string& serial)
+{
+	const IdentityKey user(username);
+	for (auto& item : _dataSets)
+	{
+		if (item.serial == serial && user.Matches(item.username))
+		{
+			_dataSets.erase(std::remove(_dataSets.begin(), _dataSets.end(), item), _dataSets.end());
+			return true;
+		}
+	}
+	return false;
+}
+
 bool OfflineHandler::UpdateRefilltoken(std::string serial, std::string refilltoken)
 {
+	lock_guard<mutex> guard(_writeMutex);
+	OfflineFileLock lock(_filePath, _sharedStore, true);
+	if (BeginUpdate(lock) != S_OK)
+	{
+		return false;
+	}
+
 	for (auto& item : _dataSets)
 	{
 		if (item.serial == serial)
 		{
 			item.refilltoken = refilltoken;
-			return true;
+			Publish();
+			return !_sharedStore || SaveToFile() == S_OK;
 		}
 	}
 	return false;
 }
 
+HRESULT OfflineHandler::BeginUpdate(const OfflineFileLock& lock)
+{
+	if (!lock.IsLocked())
+	{
+		PIError("Offline: Unable to lock the shared store, the change is not made");
+		return PI_OFFLINE_FILE_LOCKED;
+	}
+
+	const HRESULT res = ReloadFromFile();
+	if (res != S_OK && res != PI_OFFLINE_FILE_EMPTY && res != ERROR_FILE_NOT_FOUND)
+	{
+		// Writing now would replace the file with outdated data
+		return res;
+	}
+
+	return S_OK;
+}
+
+void OfflineHandler::Publish()
+{
+	atomic_store(&_snapshot, make_shared<const vector<OfflineData>>(_dataSets));
+}
+
+std::shared_ptr<const std::vector<OfflineData>> OfflineHandler::GetSnapshot()
+{
+	// Readers only take the locks if another process changed the file
+	if (_sharedStore && FileChanged())
+	{
+		// Other processes might have changed the file, reloading it changes the data of the writers
+		lock_guard<mutex> guard(_writeMutex);
+		OfflineFileLock lock(_filePath, _sharedStore, false);
+		// Without the lock the file might be written right now, the last snapshot is used then
+		if (lock.IsLocked())
+		{
+			ReloadFromFile();
+		}
+	}
+
+	return atomic_load(&_snapshot);
+}
+
 HRESULT OfflineHandler::SaveToFile()
 {
 	ofstream o;
-	o.open(_filePath, ios_base::out); // Destroy contents | create new
+	o.open(Convert::ToFilePath(_filePath), ios_base::out); // Destroy contents | create new
 
 	if (!o.is_open()) return GetLastError();
 	JsonParser parser;
-	string s = parser.OfflineDataToString(_dataSets);
-	o << s;
+	parser.WriteOfflineData(o, _dataSets, _compactFile);
 	o.close();
+	// A full disk or another I/O error only shows in the state of the stream, close() flushes the rest
+	if (o.fail())
+	{
+		PIError("Offline: Writing the offline file failed");
+		return PI_OFFLINE_FILE_WRITE_FAILED;
+	}
+	if (_sharedStore)
+	{
+		RememberFile();
+	}
 	return S_OK;
 }
 
 HRESULT OfflineHandler::LoadFromFile()
 {
-	string fileContent;
-	string line;
-	ifstream ifs(_filePath);
+	vector<OfflineData> data;
+	const HRESULT res = ReadOfflineFile(data);
+	if (res != S_OK) return res;
 
-	if (!ifs.good()) return GetLastError();
+	for (auto& item : data)
+	{
+		MergeOfflineData(item);
+	}
+	Publish();
 
-	if (ifs.is_open())
+	return S_OK;
+}
+
+HRESULT OfflineHandler::ReloadFromFile()
+{
+	if (!_sharedStore || !FileChanged()) return S_OK;
+
+	// Consumed OTPs must not be merged back in, so the data from the file replaces the data in memory
+	vector<OfflineData> data;
+	const HRESULT res = ReadOfflineFile(data);
+	if (res == S_OK || res == PI_OFFLINE_FILE_EMPTY || res == ERROR_FILE_NOT_FOUND)
 	{
-		while (getline(ifs, line))
+		// Keep the public keys that are already decoded
+		for (auto& item : data)
 		{
-			fileContent += line;
+			if (!item.isWebAuthn()) continue;
+
+			for (const auto& existing : _dataSets)
+			{
+				if (existing.publicKey && existing.pubKey == item.pubKey)
+				{
+					item.publicKey = existing.publicKey;
+					item.publicKeyAlgorithm = existing.publicKeyAlgorithm;
+					break;
+				}
+			}
+			if (!item.publicKey)
+			{
+				item.DecodePublicKey();
+			}
 		}
-		ifs.close();
+		_dataSets = data;
+		Publish();
+		RememberFile();
+	}
+	else
+	{
+		PIDebug(L"Unable to reload offline file: " + to_wstring(res) + L": " + getErrorText(res));
 	}
 
-	if (fileContent.empty()) return PI_OFFLINE_FILE_EMPTY;
+	return res;
+}
 
-	JsonParser parser;
-	auto vec = parser.ParseFileContentsForOfflineData(fileContent);
+bool OfflineHandler::FileChanged() const
+{
+	long long size = 0, time = 0, now = 0;
+	if (!GetFileState(_filePath, size, time, now)) return true;
+	const long long knownSize = _fileSize.load();
+	return knownSize < 0 || knownSize != size || _fileTime.load() != time;
+}
 
-	for (auto& item : vec)
+void OfflineHandler::RememberFile()
+{
+	long long size = 0, time = 0, now = 0;
+	// A missing file is always checked again. Also a recent write, the next one could get the same time stamp.
+	if (!GetFileState(_filePath, size, time, now) || now - time < FILE_TIME_RESOLUTION)
 	{
-		AddOfflineData(item);
+		_fileSize.store(-1);
+		return;
 	}
+	// Published before, so readers that see the new state also get the new snapshot
+	_fileSize.store(-1);
+	_fileTime.store(time);
+	_fileSize.store(size);
+}
+
+HRESULT OfflineHandler::ReadOfflineFile(std::vector<OfflineData>& data)
+{
+	ifstream ifs(Convert::ToFilePath(_filePath));
+
+	if (!ifs.good()) return GetLastError();
+
+	// Read the whole file at once instead of line by line
+	stringstream buffer;
+	buffer << ifs.rdbuf();
+	ifs.close();
+	const string fileContent = buffer.str();
+
+	if (fileContent.empty()) return PI_OFFLINE_FILE_EMPTY;
+
+	JsonParser parser;
+	data = parser.ParseFileContentsForOfflineData(fileContent);
 
 	return S_OK;
 }
@@ -301,7 +760,7 @@ std::string OfflineHandler::GetNextValue(std::string& in)
 	return tmp;
 }
 
-bool OfflineHandler::PBKDF2SHA512Verify(std::wstring password, std::string storedValue)
+bool OfflineHandler::PBKDF2SHA512Verify(const SecureString& password, std::string storedValue)
 {
 	bool isValid = false;
 	// Format of stored values (passlib):
@@ -311,97 +770,41 @@ bool OfflineHandler::PBKDF2SHA512Verify(std::wstring password, std::string store
 	string salt = GetNextValue(storedValue);
 	// $algorithm$iteratons
 	int iterations = 10000;
-	try
-	{
-		iterations = stoi(GetNextValue(storedValue));
-	}
-	catch (const invalid_argument& e)
+	const string iterationsValue = GetNextValue(storedValue);
+	if (!Convert::ToInt(iterationsValue, iterations))
 	{
-		PIDebug(e.what());
+		PIDebugF("Invalid iterations: {}", iterationsValue);
+		iterations = 10000;
 	}
 	// $algorithm
 	string algorithm = GetNextValue(storedValue);
 
-	// Salt is in adapted abase64 encoding of passlib where [./+] is substituted
-	Convert::Base64ToABase64(salt);
-
-	int cbSalt = Base64DecodeGetRequiredLength((int)(salt.size() + 1));
-	BYTE* pbSalt = (BYTE*)CoTaskMemAlloc(cbSalt);
-	if (pbSalt == nullptr)
-	{
-		return false;
-	}
-	Base64Decode(salt.c_str(), (int)(salt.size() + 1), pbSalt, &cbSalt);
-
-	// The password is encoded into UTF-8 from Unicode
-	char* pszPassword = Convert::UnicodeToCodePage(65001, password.c_str());
-	const int cbPassword = (int)strnlen_s(pszPassword, INT_MAX);
-	BYTE* pbPassword = reinterpret_cast<unsigned char*>(pszPassword);
-
-	// Get the size of the output from the stored value, which is also in abase64 encoding
-	Convert::Base64ToABase64(storedOTP);
-
-	int cbStoredOTP = Base64DecodeGetRequiredLength((int)(storedOTP.size() + 1));
-	BYTE* pbStoredOTP = (BYTE*)CoTaskMemAlloc(cbStoredOTP);
-	if (pbStoredOTP == nullptr)
+	// Salt and checksum are in adapted abase64 encoding of passlib where [./+] is substituted
+	const auto saltBytes = Convert::ABase64Decode(salt);
+	const auto storedBytes = Convert::ABase64Decode(storedOTP);
+	if (storedBytes.empty())
 	{
+		PIDebug("Stored value has no checksum");
 		return false;
 	}
-	Base64Decode(storedOTP.c_str(), (int)(storedOTP.size() + 1), pbStoredOTP, &cbStoredOTP);
 
-	// Do PBKDF2
-	const ULONGLONG ullIterations = iterations;
-	ULONG cbDerivedKey = (ULONG)cbStoredOTP;
-	PUCHAR pbDerivedKey = (unsigned char*)CoTaskMemAlloc(sizeof(unsigned char) * cbDerivedKey);
-	if (pbDerivedKey == nullptr)
+	// The size of the output is taken from the stored value
+	vector<unsigned char> derivedKey(storedBytes.size());
+	if (CryptoProvider::Get().PBKDF2SHA512(
+		reinterpret_cast<const unsigned char*>(password.c_str()), password.size(),
+		saltBytes.data(), saltBytes.size(), (unsigned long long)iterations,
+		derivedKey.data(), derivedKey.size()))
 	{
-		PIError("Could not allocate memory for derived key.");
-		return false;
-	}
-
-	const ULONG dwFlags = 0; // RESERVED, MUST BE ZERO
-	BCRYPT_ALG_HANDLE hPrf = BCRYPT_HMAC_SHA512_ALG_HANDLE;
-
-	const NTSTATUS status =
-		BCryptDeriveKeyPBKDF2(
-			hPrf,
-			pbPassword,
-			cbPassword,
-			pbSalt,
-			cbSalt,
-			ullIterations,
-			pbDerivedKey,
-			cbDerivedKey,
-			dwFlags);
-
-	CoTaskMemFree(pbSalt);
-
-	if (status == 0) // STATUS_SUCCESS
-	{
-		// Compare the bytes
-		if (cbDerivedKey == (ULONG)cbStoredOTP)
+		// Compare the bytes without exiting early
+		unsigned char diff = 0;
+		for (size_t i = 0; i < derivedKey.size(); i++)
 		{
-			while (cbDerivedKey--)
-			{
-				if (pbDerivedKey[cbDerivedKey] != pbStoredOTP[cbDerivedKey])
-				{
-					goto Exit;
-				}
-			}
-			isValid = true;
+			diff |= derivedKey[i] ^ storedBytes[i];
 		}
-	}
-	else
-	{
-		PIDebug("PBKDF2 Error: " + to_string(status));
-		isValid = false;
+		isValid = diff == 0;
 	}
 
-Exit:
-	SecureZeroMemory(pszPassword, sizeof(pszPassword));
-	SecureZeroMemory(pbPassword, sizeof(pbPassword));
-	CoTaskMemFree(pbDerivedKey);
-	CoTaskMemFree(pbStoredOTP);
+	SecureZeroMemory(derivedKey.data(), derivedKey.size());
 
 	return isValid;
 }
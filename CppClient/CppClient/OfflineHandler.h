@@ -19,9 +19,13 @@
 ** * * * * * * * * * * * * * * * * * * */
 
 #include "OfflineData.h"
+#include "SecureString.h"
+#include <atomic>
 #include <map>
 #include <Windows.h>
 #include <vector>
+#include <memory>
+#include <mutex>
 
 // 888090-2X OFFLINE
 #define PI_OFFLINE_DATA_NO_OTPS_LEFT				((HRESULT)0x88809020)
@@ -29,11 +33,28 @@
 #define PI_OFFLINE_FILE_DOES_NOT_EXIST				((HRESULT)0x88809023)
 #define PI_OFFLINE_FILE_EMPTY						((HRESULT)0x88809024)
 #define PI_OFFLINE_WRONG_OTP						((HRESULT)0x88809025)
+#define PI_OFFLINE_FILE_LOCKED						((HRESULT)0x88809026)
+#define PI_OFFLINE_FILE_WRITE_FAILED				((HRESULT)0x88809028)
 
+class OfflineFileLock;
+
+/// <summary>
+/// The OfflineHandler can be used from multiple threads. Changes are made to a working copy under a mutex and then published
+/// as an immutable snapshot. Reading methods use the latest snapshot without locking.
+/// </summary>
 class OfflineHandler
 {
 public:
-	OfflineHandler(const std::wstring& filePath, int tryWindow = 10);
+	/// <summary>
+	/// If sharedStore is enabled, the offline file is the single source of truth for all processes using it.
+	/// Every access checks if the file was changed and reloads it under a lock then. Every change is written back immediately. If the lock can not be
+	/// taken, changes fail with PI_OFFLINE_FILE_LOCKED and reading methods use the data of the last access.
+	/// maxUsers and maxBytes limit the size of the store, 0 means unlimited. If a limit is exceeded, the data of the least
+	/// recently used users is evicted.
+	/// If compactFile is enabled, the offline file is written without indentation.
+	/// </summary>
+	OfflineHandler(const std::wstring& filePath, int tryWindow = 10, bool sharedStore = false, size_t maxUsers = 0, size_t maxBytes = 0,
+		bool compactFile = false);
 
 	~OfflineHandler();
 
@@ -45,7 +66,7 @@ public:
 	/// <param name="username"></param>
 	/// <param name="serialUsed"></param>
 	/// <returns></returns>
-	HRESULT VerifyOfflineOTP(const std::wstring& otp, const std::string& username, std::string& serialUsed);
+	HRESULT VerifyOfflineOTP(const SecureWString& otp, const std::string& username, std::string& serialUsed);
 
 	HRESULT GetRefillToken(const std::string& username, const std::string& serial, std::string& refilltoken);
 
@@ -58,27 +79,106 @@ public:
 	/// <returns>The number of remaining offline OTP values or 0 if no data is found</returns>
 	size_t GetOfflineOTPCount(const std::string& username, const std::string& serial);
 
+	/// <summary>
+	/// Check if the offline OTPs of the token should be refilled.
+	/// If autonomyDays is set and the consumption rate of the token is known, a refill is done when the remaining OTPs are
+	/// predicted to last less than autonomyDays. Otherwise, a refill is done when less than threshold OTPs remain.
+	/// A threshold of 0 means that a refill is always done.
+	/// </summary>
+	bool ShouldRefill(const std::string& username, const std::string& serial, size_t threshold, double autonomyDays);
+
 	std::vector<std::pair<std::string, size_t>> GetTokenInfo(const std::string& username);
 
 	std::vector<OfflineData> GetWebAuthnOfflineData(const std::string& username);
 
+	// False if there is no such data or, in shared mode, the change could not be saved
 	bool RemoveOfflineData(const std::string& username, const std::string& serial);
 
+	/// <summary>
+	/// Merge and remove multiple datasets in one update of the store, e.g. with the results of a batch refill.
+	/// </summary>
+	/// <param name="updates">Data to merge like with AddOfflineData</param>
+	/// <param name="removals">Pairs of username and serial to remove</param>
+	HRESULT UpdateOfflineData(const std::vector<OfflineData>& updates, const std::vector<std::pair<std::string, std::string>>& removals);
+
+	// False if the token is not found or, in shared mode, the change could not be saved
 	bool UpdateRefilltoken(std::string serial, std::string refilltoken);
 
+	std::wstring GetFilePath() const { return _filePath; }
+
+	/// <summary>
+	/// Set the time of the last use of the token to now. VerifyOfflineOTP does this itself, this is for offline WebAuthn.
+	/// </summary>
+	HRESULT MarkUsed(const std::string& username, const std::string& serial);
+
+	/// <summary>
+	/// Get the approximate memory used by the store in bytes.
+	/// </summary>
+	size_t GetStoreSize();
+
 private:
+	// Working copy, only used while holding _writeMutex
 	std::vector<OfflineData> _dataSets = std::vector<OfflineData>();
 
+	// Copy of _dataSets for the readers, replaced atomically by Publish
+	std::shared_ptr<const std::vector<OfflineData>> _snapshot = std::make_shared<const std::vector<OfflineData>>();
+
+	std::mutex _writeMutex;
+
 	std::wstring _filePath = L"C:\\offlineFile.json";
 
 	int _tryWindow = 10;
 
-	bool PBKDF2SHA512Verify(std::wstring password, std::string storedValue);
+	bool _sharedStore = false;
+
+	size_t _maxUsers = 0;
+
+	size_t _maxBytes = 0;
+
+	bool _compactFile = false;
+
+	// Size and last write time of the offline file when it was last read or written in shared mode.
+	// -1 if the file has to be read again, also while the last write is too recent to tell later writes apart by time.
+	std::atomic<long long> _fileSize{ -1 };
+
+	std::atomic<long long> _fileTime{ 0 };
+
+	// The password is expected in UTF-8
+	bool PBKDF2SHA512Verify(const SecureString& password, std::string storedValue);
 
 	std::string GetNextValue(std::string& in);
 
+	// Called with _writeMutex held before a change. In shared mode, the lock must be held and _dataSets is reloaded from
+	// the file. The change must not be made if this fails.
+	HRESULT BeginUpdate(const OfflineFileLock& lock);
+
+	// Make the current state of _dataSets visible to the readers
+	void Publish();
+
+	// Get the latest snapshot. In shared mode, the file is reloaded first if it was changed.
+	std::shared_ptr<const std::vector<OfflineData>> GetSnapshot();
+
 	HRESULT SaveToFile();
 
 	HRESULT LoadFromFile();
+
+	// Replace the data in memory with the contents of the file if it was changed. Used in shared mode.
+	HRESULT ReloadFromFile();
+
+	// Compare the file with the state of the last read or write, without locking
+	bool FileChanged() const;
+
+	// Remember the state of the file after reading or writing it, the lock must be held
+	void RememberFile();
+
+	HRESULT ReadOfflineFile(std::vector<OfflineData>& data);
+
+	void MergeOfflineData(const OfflineData& data);
+
+	bool RemoveDataSet(const std::string& username, const std::string& serial);
+
+	// Evict the least recently used users until the limits are met.
+	// Returns true if something was evicted, the caller has to persist the change then.
+	bool EnforceCapacity();
 };
 
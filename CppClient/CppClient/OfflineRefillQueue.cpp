@@ -0,0 +1,337 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "OfflineRefillQueue.h"
+#include "OfflineFileLock.h"
+#include "OfflineHandler.h"
+#include "JsonParser.h"
+#include "Convert.h"
+#include "IdentityKey.h"
+#include "Logger.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <limits>
+#ifdef _WIN32
+#include <dpapi.h>
+
+#pragma comment (lib, "crypt32.lib")
+#else
+#include <cstdio>
+#endif
+
+using namespace std;
+
+// Encrypt the input with DPAPI for the local machine and return it base64 encoded. DPAPI reads the OTP from the buffer
+// of the SecureString, so that no other copy of it is made.
+// Without DPAPI (the portable build of the tests) it is only base64 encoded.
+static string ProtectString(const SecureString& plain)
+{
+	if (plain.empty()) return "";
+#ifndef _WIN32
+	return Convert::Base64Encode(reinterpret_cast<const unsigned char*>(plain.c_str()), plain.size(), true);
+#else
+
+	DATA_BLOB in{ (DWORD)plain.size(), (BYTE*)plain.c_str() };
+	DATA_BLOB out{};
+	if (!CryptProtectData(&in, NULL, NULL, NULL, NULL, CRYPTPROTECT_LOCAL_MACHINE | CRYPTPROTECT_UI_FORBIDDEN, &out))
+	{
+		PIErrorF("CryptProtectData failed: {}", GetLastError());
+		return "";
+	}
+
+	string ret = Convert::Base64Encode(out.pbData, out.cbData, true);
+	LocalFree(out.pbData);
+	return ret;
+#endif
+}
+
+// The decrypted OTP goes directly into a SecureString, the buffer of DPAPI is wiped
+static SecureString UnprotectString(const string& protectedBase64)
+{
+	if (protectedBase64.empty()) return SecureString();
+
+	auto bytes = Convert::Base64Decode(protectedBase64);
+#ifndef _WIN32
+	SecureString ret(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+	SecureZeroMemory(bytes.data(), bytes.size());
+	return ret;
+#else
+	DATA_BLOB in{ (DWORD)bytes.size(), bytes.data() };
+	DATA_BLOB out{};
+	if (!CryptUnprotectData(&in, NULL, NULL, NULL, NULL, CRYPTPROTECT_UI_FORBIDDEN, &out))
+	{
+		PIErrorF("CryptUnprotectData failed: {}", GetLastError());
+		return SecureString();
+	}
+
+	SecureString ret(reinterpret_cast<const char*>(out.pbData), out.cbData);
+	SecureZeroMemory(out.pbData, out.cbData);
+	LocalFree(out.pbData);
+	return ret;
+#endif
+}
+
+OfflineRefillQueue::OfflineRefillQueue(const std::wstring& filePath)
+{
+	_filePath = filePath;
+	OfflineFileLock lock(_filePath, true, false);
+	if (!lock.IsLocked())
+	{
+		// Every access reloads the file, so the jobs are loaded with the next one
+		return;
+	}
+
+	const HRESULT res = LoadFromFile();
+	if (res == S_OK && !_jobs.empty())
+	{
+		PIDebugF("Loaded {} pending offline refill(s)", _jobs.size());
+	}
+}
+
+void OfflineRefillQueue::Enqueue(const OfflineRefillJob& job)
+{
+	lock_guard<mutex> guard(_mutex);
+	OfflineFileLock lock(_filePath, true, true);
+	if (BeginUpdate(lock) != S_OK)
+	{
+		PIErrorF("Unable to queue the offline refill for token {}", job.serial);
+		return;
+	}
+
+	auto it = Find(job.username, job.serial);
+	if (it != _jobs.end())
+	{
+		*it = job.Copy();
+	}
+	else
+	{
+		_jobs.push_back(job.Copy());
+	}
+	PIDebugF("Queued offline refill for {} and token {}", job.username, job.serial);
+	SaveToFile();
+}
+
+std::vector<OfflineRefillJob> OfflineRefillQueue::GetDueJobs()
+{
+	lock_guard<mutex> guard(_mutex);
+	Refresh();
+	vector<OfflineRefillJob> ret;
+	const time_t now = time(nullptr);
+	for (const auto& item : _jobs)
+	{
+		if (item.nextAttempt <= now)
+		{
+			ret.push_back(item.Copy());
+		}
+	}
+	return ret;
+}
+
+void OfflineRefillQueue::Complete(const OfflineRefillJob& job)
+{
+	lock_guard<mutex> guard(_mutex);
+	OfflineFileLock lock(_filePath, true, true);
+	if (BeginUpdate(lock) != S_OK) return;
+
+	auto it = Find(job.username, job.serial);
+	// Only remove the job if it was not replaced by a newer one in the meantime
+	if (it != _jobs.end() && it->lastOTP == job.lastOTP)
+	{
+		_jobs.erase(it);
+		SaveToFile();
+	}
+}
+
+void OfflineRefillQueue::Drop(const OfflineRefillJob& job)
+{
+	lock_guard<mutex> guard(_mutex);
+	OfflineFileLock lock(_filePath, true, true);
+	if (BeginUpdate(lock) != S_OK) return;
+
+	auto it = Find(job.username, job.serial);
+	if (it != _jobs.end() && it->lastOTP == job.lastOTP)
+	{
+		PIErrorF("Offline refill for token {} was rejected, dropping it", job.serial);
+		_jobs.erase(it);
+		SaveToFile();
+	}
+}
+
+void OfflineRefillQueue::Reschedule(const OfflineRefillJob& job)
+{
+	lock_guard<mutex> guard(_mutex);
+	OfflineFileLock lock(_filePath, true, true);
+	if (BeginUpdate(lock) != S_OK) return;
+
+	auto it = Find(job.username, job.serial);
+	if (it == _jobs.end() || it->lastOTP != job.lastOTP)
+	{
+		return;
+	}
+
+	it->attempts++;
+	if (it->attempts >= OFFLINE_REFILL_MAX_ATTEMPTS)
+	{
+		PIErrorF("Offline refill for token {} failed {} times, dropping it", job.serial, it->attempts);
+		_jobs.erase(it);
+	}
+	else
+	{
+		long long backoff = (long long)OFFLINE_REFILL_BACKOFF_BASE_SECONDS << (it->attempts - 1);
+		if (backoff > OFFLINE_REFILL_BACKOFF_MAX_SECONDS)
+		{
+			backoff = OFFLINE_REFILL_BACKOFF_MAX_SECONDS;
+		}
+		it->nextAttempt = time(nullptr) + backoff;
+		PIDebugF("Offline refill for token {} rescheduled in {}s", job.serial, backoff);
+	}
+	SaveToFile();
+}
+
+bool OfflineRefillQueue::IsEmpty()
+{
+	lock_guard<mutex> guard(_mutex);
+	Refresh();
+	return _jobs.empty();
+}
+
+std::time_t OfflineRefillQueue::GetNextAttemptTime()
+{
+	lock_guard<mutex> guard(_mutex);
+	Refresh();
+	// New jobs have 0, which must not be mistaken for "no job". The parentheses keep the max macro of Windows.h out.
+	time_t next = (numeric_limits<time_t>::max)();
+	for (const auto& item : _jobs)
+	{
+		if (item.nextAttempt < next)
+		{
+			next = item.nextAttempt;
+		}
+	}
+	return next;
+}
+
+std::vector<OfflineRefillJob>::iterator OfflineRefillQueue::Find(const std::string& username, const std::string& serial)
+{
+	const IdentityKey user(username);
+	return find_if(_jobs.begin(), _jobs.end(), [&](const OfflineRefillJob& item)
+		{
+			return item.serial == serial && user.Matches(item.username);
+		});
+}
+
+HRESULT OfflineRefillQueue::BeginUpdate(const OfflineFileLock& lock)
+{
+	if (!lock.IsLocked())
+	{
+		PIError("Unable to lock the offline refill queue, the change is not made");
+		return PI_OFFLINE_FILE_LOCKED;
+	}
+
+	// Other processes change the same file, writing without their jobs would lose them
+	const HRESULT res = LoadFromFile();
+	if (res != S_OK)
+	{
+		PIErrorF("Unable to reload the offline refill queue: {}", Convert::LongToHexString(res));
+	}
+	return res;
+}
+
+void OfflineRefillQueue::Refresh()
+{
+	OfflineFileLock lock(_filePath, true, false);
+	// Without the lock the file might be written right now, the jobs that are known are used then
+	if (lock.IsLocked())
+	{
+		LoadFromFile();
+	}
+}
+
+HRESULT OfflineRefillQueue::SaveToFile()
+{
+	if (_jobs.empty())
+	{
+		// Nothing pending, do not leave a file behind
+#ifdef _WIN32
+		if (!DeleteFileW(_filePath.c_str()) && GetLastError() != ERROR_FILE_NOT_FOUND)
+#else
+		if (remove(Convert::ToFilePath(_filePath).c_str()) != 0 && GetLastError() != ERROR_FILE_NOT_FOUND)
+#endif
+		{
+			return GetLastError();
+		}
+		return S_OK;
+	}
+
+	vector<string> protectedOTPs;
+	protectedOTPs.reserve(_jobs.size());
+	for (const auto& job : _jobs)
+	{
+		protectedOTPs.push_back(ProtectString(job.lastOTP));
+	}
+
+	ofstream o;
+	o.open(Convert::ToFilePath(_filePath), ios_base::out); // Destroy contents | create new
+	if (!o.is_open()) return GetLastError();
+
+	JsonParser parser;
+	o << parser.OfflineRefillJobsToString(_jobs, protectedOTPs);
+	o.close();
+	if (o.fail())
+	{
+		PIError("Writing the offline refill queue failed");
+		return PI_OFFLINE_FILE_WRITE_FAILED;
+	}
+	return S_OK;
+}
+
+HRESULT OfflineRefillQueue::LoadFromFile()
+{
+	ifstream ifs(Convert::ToFilePath(_filePath));
+	if (!ifs.good())
+	{
+		const HRESULT res = GetLastError();
+		// The file is removed when the last job is done
+		if (res != ERROR_FILE_NOT_FOUND) return res;
+		_jobs.clear();
+		return S_OK;
+	}
+
+	stringstream buffer;
+	buffer << ifs.rdbuf();
+	ifs.close();
+
+	const string fileContent = buffer.str();
+	if (fileContent.empty())
+	{
+		_jobs.clear();
+		return S_OK;
+	}
+
+	JsonParser parser;
+	vector<string> protectedOTPs;
+	_jobs = parser.ParseOfflineRefillJobs(fileContent, protectedOTPs);
+	for (size_t i = 0; i < _jobs.size(); i++)
+	{
+		_jobs[i].lastOTP = UnprotectString(protectedOTPs[i]);
+	}
+
+	return S_OK;
+}
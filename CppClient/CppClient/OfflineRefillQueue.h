@@ -0,0 +1,122 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "SecureString.h"
+#include <string>
+#include <vector>
+#include <mutex>
+#include <ctime>
+#include <Windows.h>
+
+class OfflineFileLock;
+
+constexpr auto OFFLINE_REFILL_QUEUE_FILE_SUFFIX = L".refill";
+constexpr auto OFFLINE_REFILL_MAX_ATTEMPTS = 10;
+constexpr auto OFFLINE_REFILL_BACKOFF_BASE_SECONDS = 30;
+constexpr auto OFFLINE_REFILL_BACKOFF_MAX_SECONDS = 3600;
+
+// The refill can not succeed by trying again: the token has no offline data here anymore or the server answered with an error
+#define PI_OFFLINE_REFILL_REJECTED					((HRESULT)0x88809027)
+
+struct OfflineRefillJob
+{
+	std::string username;
+	std::string serial;
+	// The last OTP that was used offline. Empty for WebAuthn.
+	SecureString lastOTP;
+	bool isWebAuthn = false;
+	int attempts = 0;
+	std::time_t nextAttempt = 0;
+
+	// The job is move-only because of the OTP, copies are made explicitly like with SecureString
+	OfflineRefillJob Copy() const
+	{
+		OfflineRefillJob job;
+		job.username = username;
+		job.serial = serial;
+		job.lastOTP = lastOTP.Copy();
+		job.isWebAuthn = isWebAuthn;
+		job.attempts = attempts;
+		job.nextAttempt = nextAttempt;
+		return job;
+	}
+};
+
+/// <summary>
+/// Queue for offline refills that are done in the background after the logon is complete.
+/// The jobs are persisted next to the offline file, so that they survive the exit of the process.
+/// The last OTP is encrypted with DPAPI (machine scope) before it is written to the file.
+/// Every process that does offline refills has its own queue on the same file. Like the shared offline store, each access
+/// takes the lock file next to it and reloads the file, so that the jobs of the other processes are neither lost nor done twice.
+/// This class is thread safe.
+/// </summary>
+class OfflineRefillQueue
+{
+public:
+	OfflineRefillQueue(const std::wstring& filePath);
+
+	/// <summary>
+	/// Add a job to the queue. An existing job for the same user and serial is replaced, because only the latest OTP is relevant for the refill.
+	/// </summary>
+	void Enqueue(const OfflineRefillJob& job);
+
+	/// <summary>
+	/// Get a copy of all jobs that are due. The jobs stay in the queue until Complete or Reschedule is called.
+	/// </summary>
+	std::vector<OfflineRefillJob> GetDueJobs();
+
+	void Complete(const OfflineRefillJob& job);
+
+	/// <summary>
+	/// Remove a job that failed permanently (PI_OFFLINE_REFILL_REJECTED), without retrying it. Like Complete, a job that was
+	/// replaced by a newer one in the meantime is kept.
+	/// </summary>
+	void Drop(const OfflineRefillJob& job);
+
+	/// <summary>
+	/// Schedule the job again with exponential backoff, for failures that might go away (server not reachable). If the maximum number of attempts is reached, the job is dropped.
+	/// </summary>
+	void Reschedule(const OfflineRefillJob& job);
+
+	bool IsEmpty();
+
+	// The earliest point in time at which a job is due, in the past if a job is due now. The maximum of time_t if the
+	// queue is empty.
+	std::time_t GetNextAttemptTime();
+
+private:
+	std::vector<OfflineRefillJob>::iterator Find(const std::string& username, const std::string& serial);
+
+	// Take the jobs of the file, which might have been changed by another process. Fails if the lock is not held.
+	HRESULT BeginUpdate(const OfflineFileLock& lock);
+
+	// Reload the file for reading, keeps the known jobs if it is locked by a writer
+	void Refresh();
+
+	HRESULT SaveToFile();
+
+	HRESULT LoadFromFile();
+
+	std::vector<OfflineRefillJob> _jobs;
+
+	std::wstring _filePath;
+
+	std::mutex _mutex;
+};
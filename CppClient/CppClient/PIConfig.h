@@ -37,6 +37,10 @@ struct PIConfig
 	bool logPasswords = false;
 	std::wstring offlineFilePath = L"C:\\offlineFile.json";
 	int offlineTryWindow = 10;
+	bool offlineSharedStore = false;
+	int offlineMaxUsers = 0; // 0 = unlimited
+	int offlineMaxSizeKB = 0; // 0 = unlimited
+	bool offlineCompactFile = false;
 	bool sendUPN = false;
 
 	// optionals
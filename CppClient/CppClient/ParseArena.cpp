@@ -0,0 +1,77 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "ParseArena.h"
+#include <new>
+#include <Windows.h>
+
+using namespace std;
+
+ParseArena::~ParseArena()
+{
+	Release();
+}
+
+void* ParseArena::Allocate(size_t size, size_t alignment)
+{
+	if (size == 0) size = 1;
+
+	if (!_blocks.empty())
+	{
+		Block& block = _blocks.back();
+		const size_t offset = (block.used + alignment - 1) & ~(alignment - 1);
+		if (offset <= block.size && size <= block.size - offset)
+		{
+			block.used = offset + size;
+			_allocations++;
+			return block.data + offset;
+		}
+	}
+
+	// Large allocations, like the buffer of the whole response, get a block of their own.
+	// operator new returns memory that is aligned for any fundamental type.
+	const size_t blockSize = size > _blockSize ? size : _blockSize;
+	_blocks.reserve(_blocks.size() + 1);
+	Block block{ static_cast<unsigned char*>(::operator new(blockSize)), blockSize, size };
+	_blocks.push_back(block);
+	_allocations++;
+	return block.data;
+}
+
+void ParseArena::Release() noexcept
+{
+	for (auto& block : _blocks)
+	{
+		// Only the used part of a block has been written
+		SecureZeroMemory(block.data, block.used);
+		::operator delete(block.data);
+	}
+	_blocks.clear();
+	_allocations = 0;
+}
+
+size_t ParseArena::GetCapacity() const noexcept
+{
+	size_t capacity = 0;
+	for (const auto& block : _blocks)
+	{
+		capacity += block.size;
+	}
+	return capacity;
+}
@@ -0,0 +1,109 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <cstddef>
+#include <new>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Monotonic arena for the memory that is used while a single response is parsed. Allocations are taken from blocks
+/// that are only released together by Release(). Before that, the blocks are wiped because the response can contain
+/// secrets like transaction ids, refill tokens and OTP hashes.
+/// Objects that use the arena must be destroyed before it is released. Not thread safe.
+/// </summary>
+class ParseArena
+{
+public:
+	explicit ParseArena(size_t blockSize = 4096) noexcept : _blockSize(blockSize) {}
+
+	~ParseArena();
+
+	ParseArena(const ParseArena&) = delete;
+	ParseArena& operator=(const ParseArena&) = delete;
+
+	void* Allocate(size_t size, size_t alignment);
+
+	/// <summary>
+	/// Wipe the used memory and free all blocks at once.
+	/// </summary>
+	void Release() noexcept;
+
+	// Number of allocations served since the last release
+	size_t GetAllocationCount() const noexcept { return _allocations; }
+
+	// Bytes held in blocks
+	size_t GetCapacity() const noexcept;
+
+private:
+	struct Block
+	{
+		unsigned char* data;
+		size_t size;
+		size_t used;
+	};
+
+	std::vector<Block> _blocks;
+	size_t _blockSize;
+	size_t _allocations = 0;
+};
+
+/// <summary>
+/// Allocator for standard containers that takes its memory from a ParseArena. Deallocation does nothing, the memory is
+/// returned when the arena is released. Without an arena, the memory is taken from the heap like with std::allocator.
+/// </summary>
+template<class T>
+class ArenaAllocator
+{
+public:
+	using value_type = T;
+
+	explicit ArenaAllocator(ParseArena& arena) noexcept : _arena(&arena) {}
+
+	explicit ArenaAllocator(ParseArena* arena) noexcept : _arena(arena) {}
+
+	template<class U>
+	ArenaAllocator(const ArenaAllocator<U>& other) noexcept : _arena(other._arena) {}
+
+	T* allocate(size_t n)
+	{
+		if (_arena == nullptr) return static_cast<T*>(::operator new(n * sizeof(T)));
+		return static_cast<T*>(_arena->Allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, size_t) noexcept
+	{
+		if (_arena == nullptr) ::operator delete(p);
+	}
+
+	template<class U>
+	bool operator==(const ArenaAllocator<U>& other) const noexcept { return _arena == other._arena; }
+
+	template<class U>
+	bool operator!=(const ArenaAllocator<U>& other) const noexcept { return _arena != other._arena; }
+
+private:
+	template<class U>
+	friend class ArenaAllocator;
+
+	ParseArena* _arena;
+};
+
+using ArenaString = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
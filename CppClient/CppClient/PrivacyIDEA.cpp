@@ -25,22 +25,41 @@
 
 using namespace std;
 
-// Check if there is a mapping for the given domain or - if not - a default realm is set
-HRESULT PrivacyIDEA::AppendRealm(std::wstring domain, std::map<std::string, std::string>& parameters)
+PrivacyIDEA::~PrivacyIDEA()
 {
-	wstring realm = L"";
-	try
-	{
-		realm = _realmMap.at(Convert::ToUpperCase(domain));
-	}
-	catch (const std::out_of_range& e)
+	if (_refillThread.joinable())
 	{
-		UNREFERENCED_PARAMETER(e);
-		// no mapping - if default domain exists use that
-		if (!_defaultRealm.empty())
 		{
-			realm = _defaultRealm;
+			lock_guard<mutex> lock(_refillMutex);
+			_runRefill.store(false);
 		}
+		// Do not wait for the server, pending jobs stay in the queue file and are done after the next logon
+		_refillEndpoint.Cancel();
+		_refillCondition.notify_all();
+		_refillThread.join();
+	}
+}
+
+std::unordered_map<IdentityKey, std::wstring, IdentityKey::Hash> PrivacyIDEA::MakeRealmMap(
+	const std::map<std::wstring, std::wstring>& realmMap)
+{
+	unordered_map<IdentityKey, wstring, IdentityKey::Hash> ret;
+	ret.reserve(realmMap.size());
+	for (const auto& item : realmMap)
+	{
+		ret.emplace(IdentityKey(item.first), item.second);
+	}
+	return ret;
+}
+
+// Check if there is a mapping for the given domain or - if not - a default realm is set
+HRESULT PrivacyIDEA::AppendRealm(std::wstring domain, std::map<std::string, std::string>& parameters)
+{
+	wstring realm = _defaultRealm;
+	const auto it = _realmMap.find(IdentityKey(domain));
+	if (it != _realmMap.end())
+	{
+		realm = it->second;
 	}
 
 	if (!realm.empty())
@@ -53,15 +72,17 @@ HRESULT PrivacyIDEA::AppendRealm(std::wstring domain, std::map<std::string, std:
 
 HRESULT PrivacyIDEA::ProcessResponse(std::string response, _Inout_ PIResponse& responseObj)
 {
-	auto offlineData = _parser.ParseResponseForOfflineData(response);
+	vector<OfflineData> offlineData;
+	HRESULT res = _parser.ParseResponse(response, responseObj, offlineData);
 	if (!offlineData.empty())
 	{
-		for (auto& item : offlineData)
+		// The server has accepted the authentication, so it does not fail because of this. The OTPs are missing offline until the token is enrolled for offline use again.
+		const HRESULT merged = offlineHandler.UpdateOfflineData(offlineData, {});
+		if (merged != S_OK)
 		{
-			offlineHandler.AddOfflineData(item);
+			PIErrorF("Unable to save the offline data of the response: {}", Convert::LongToHexString(merged));
 		}
 	}
-	HRESULT res = _parser.ParseResponse(response, responseObj);
 	return res;
 }
 
@@ -93,10 +114,10 @@ void PrivacyIDEA::PollThread(
 	{
 		PIDebug("Finalizing transaction...");
 		PIResponse pir;
-		HRESULT res = ValidateCheck(username, domain, L"", pir, transactionId, upn);
+		HRESULT res = ValidateCheck(username, domain, SecureWString(), pir, transactionId, upn);
 		if (FAILED(res))
 		{
-			PIDebug("/validate/check failed with " + to_string(res));
+			PIDebugF("/validate/check failed with {}", res);
 			callback(false);
 		}
 		else
@@ -109,25 +130,20 @@ void PrivacyIDEA::PollThread(
 HRESULT PrivacyIDEA::ValidateCheck(
 	const std::wstring& username,
 	const std::wstring& domain,
-	const std::wstring& otp,
+	const SecureWString& otp,
 	PIResponse& responseObj,
 	const std::string& transactionId,
 	const std::wstring& upn,
 	const std::map<std::string, std::string>& headers)
 {
 	PIDebug(__FUNCTION__);
-	string strOTP = Convert::ToString(otp);
-
-	map<string, string> parameters =
-	{
-		{ "pass", strOTP }
-	};
+	map<string, string> parameters;
 
 	// Username+Domain/Realm or just UPN
 	if (_sendUPN && !upn.empty())
 	{
 		string strUPN = Convert::ToString(upn);
-		PIDebug("Sending UPN " + strUPN);
+		PIDebugF("Sending UPN {}", strUPN);
 		parameters.try_emplace("user", strUPN);
 	}
 	else
@@ -142,12 +158,12 @@ HRESULT PrivacyIDEA::ValidateCheck(
 		parameters.try_emplace("transaction_id", transactionId);
 	}
 
-	string response = _endpoint.SendRequest(PI_ENDPOINT_VALIDATE_CHECK, parameters, headers, RequestMethod::POST);
+	string response = _endpoint.SendRequest(PI_ENDPOINT_VALIDATE_CHECK, parameters, Convert::ToString(otp), headers, RequestMethod::POST);
 
 	// If the response is empty, there was an error in the endpoint
 	if (response.empty())
 	{
-		PIDebug("Response was empty. Endpoint error: " + Convert::LongToHexString(_endpoint.GetLastErrorCode()));
+		PIDebugF("Response was empty. Endpoint error: {}", Convert::LongToHexString(_endpoint.GetLastErrorCode()));
 		return _endpoint.GetLastErrorCode();
 	}
 
@@ -169,7 +185,7 @@ HRESULT PrivacyIDEA::ValidateCheckWebAuthn(
 	if (_sendUPN && !upn.empty())
 	{
 		string strUPN = Convert::ToString(upn);
-		PIDebug("Sending UPN " + strUPN);
+		PIDebugF("Sending UPN {}", strUPN);
 		parameters.try_emplace("user", strUPN);
 	}
 	else
@@ -204,7 +220,7 @@ HRESULT PrivacyIDEA::ValidateCheckWebAuthn(
 	// If the response is empty, there was an error in the endpoint
 	if (response.empty())
 	{
-		PIDebug("Response was empty. Endpoint error: " + Convert::LongToHexString(_endpoint.GetLastErrorCode()));
+		PIDebugF("Response was empty. Endpoint error: {}", Convert::LongToHexString(_endpoint.GetLastErrorCode()));
 		return _endpoint.GetLastErrorCode();
 	}
 
@@ -215,22 +231,21 @@ HRESULT PrivacyIDEA::ValidateCheckWebAuthn(
 
 @return PI_OFFLINE_NO_OFFLINE_DATA, PI_OFFLINE_DATA_NO_OTPS_LEFT, S_OK, E_FAIL
 */
-HRESULT PrivacyIDEA::OfflineCheck(const std::wstring& username, const std::wstring& otp, __out std::string& serialUsed)
+HRESULT PrivacyIDEA::OfflineCheck(const std::wstring& username, const SecureWString& otp, __out std::string& serialUsed)
 {
 	PIDebug(__FUNCTION__);
 	string szUsername = Convert::ToString(username);
 
 	HRESULT res = offlineHandler.VerifyOfflineOTP(otp, szUsername, serialUsed);
-	PIDebug("Offline verification result: " + Convert::LongToHexString(res));
+	PIDebugF("Offline verification result: {}", Convert::LongToHexString(res));
 	return res;
 }
 
-HRESULT PrivacyIDEA::OfflineRefill(const std::wstring& username, const std::wstring& lastOTP, const std::string& serial)
+HRESULT PrivacyIDEA::OfflineRefill(const std::wstring& username, const SecureWString& lastOTP, const std::string& serial)
 {
 	PIDebug(__FUNCTION__);
 	string refilltoken;
 	string szUsername = Convert::ToString(username);
-	string szLastOTP = Convert::ToString(lastOTP);
 
 	HRESULT hr = offlineHandler.GetRefillToken(szUsername, serial, refilltoken);
 	if (hr != S_OK)
@@ -240,12 +255,11 @@ HRESULT PrivacyIDEA::OfflineRefill(const std::wstring& username, const std::wstr
 	}
 
 	map<string, string> parameters = {
-		{"pass", szLastOTP},
 		{"refilltoken", refilltoken},
 		{"serial", serial}
 	};
 
-	string response = _endpoint.SendRequest(PI_ENDPOINT_OFFLINE_REFILL, parameters, map<string, string>(), RequestMethod::POST);
+	string response = _endpoint.SendRequest(PI_ENDPOINT_OFFLINE_REFILL, parameters, Convert::ToString(lastOTP), map<string, string>(), RequestMethod::POST);
 
 	if (response.empty())
 	{
@@ -290,7 +304,7 @@ HRESULT PrivacyIDEA::OfflineRefillWebAuthn(const std::wstring& username, const s
 
 	if (!_parser.IsStillActiveOfflineToken(response))
 	{
-		PIDebug("Token " + serial + " is not marked for offline use anymore, its data is removed from this machine");
+		PIDebugF("Token {} is not marked for offline use anymore, its data is removed from this machine", serial);
 		offlineHandler.RemoveOfflineData(szUsername, serial);
 	}
 	else
@@ -303,7 +317,7 @@ HRESULT PrivacyIDEA::OfflineRefillWebAuthn(const std::wstring& username, const s
 		}
 		if (!offlineHandler.UpdateRefilltoken(serial, refilltoken))
 		{
-            PIDebug("Failed to update refilltoken for serial " + serial);
+            PIDebugF("Failed to update refilltoken for serial {}", serial);
 			return E_FAIL;
 		}
 	}
@@ -311,6 +325,207 @@ HRESULT PrivacyIDEA::OfflineRefillWebAuthn(const std::wstring& username, const s
 	return hr;
 }
 
+std::vector<OfflineRefillResult> PrivacyIDEA::OfflineRefillBatch(const std::vector<OfflineRefillJob>& jobs)
+{
+	PIDebug(__FUNCTION__);
+	vector<OfflineRefillResult> results(jobs.size());
+	vector<map<string, string>> parameterSets;
+	// The last OTP of each parameter set, it is only encoded into the request body
+	vector<const SecureString*> passes;
+	// Index of the job for each parameter set, jobs without refilltoken are not sent
+	vector<size_t> sentJobs;
+
+	for (size_t i = 0; i < jobs.size(); i++)
+	{
+		results[i].username = jobs[i].username;
+		results[i].serial = jobs[i].serial;
+
+		string refilltoken;
+		if (offlineHandler.GetRefillToken(jobs[i].username, jobs[i].serial, refilltoken) != S_OK)
+		{
+			// The data was removed or evicted since the job was queued
+			PIDebugF("Failed to get parameters for offline refill of token {}", jobs[i].serial);
+			results[i].result = PI_OFFLINE_REFILL_REJECTED;
+			continue;
+		}
+
+		parameterSets.push_back({
+			{"refilltoken", refilltoken},
+			{"serial", jobs[i].serial}
+		});
+		passes.push_back(&jobs[i].lastOTP);
+		sentJobs.push_back(i);
+	}
+
+	auto responses = _refillEndpoint.SendRequests(PI_ENDPOINT_OFFLINE_REFILL, parameterSets, passes, RequestMethod::POST, OFFLINE_REFILL_MAX_CONCURRENCY);
+
+	vector<OfflineData> updates;
+	vector<pair<string, string>> removals;
+	// Index of the job for each update and removal, their result depends on saving them
+	vector<size_t> mergedJobs;
+	for (size_t k = 0; k < responses.size(); k++)
+	{
+		const auto& job = jobs[sentJobs[k]];
+		auto& result = results[sentJobs[k]];
+		const auto& response = responses[k];
+
+		if (response.result != S_OK)
+		{
+			PIDebugF("Offline refill for token {} failed: {}", job.serial, Convert::LongToHexString(response.result));
+			result.result = response.result;
+			continue;
+		}
+
+		// An error from the server (e.g. an invalid refilltoken or OTP) does not change by asking again
+		const int errorCode = _parser.GetErrorCode(response.body);
+		if (errorCode != 0 && !(job.isWebAuthn && errorCode == 905))
+		{
+			PIDebugF("Offline refill for token {} was rejected by the server with code {}", job.serial, errorCode);
+			result.result = PI_OFFLINE_REFILL_REJECTED;
+			continue;
+		}
+
+		if (job.isWebAuthn)
+		{
+			if (errorCode == 905)
+			{
+				PIDebugF("Token {} is not marked for offline use anymore, its data is removed from this machine", job.serial);
+				removals.push_back(make_pair(job.username, job.serial));
+				mergedJobs.push_back(sentJobs[k]);
+				result.result = S_OK;
+				continue;
+			}
+
+			OfflineData data;
+			data.username = job.username;
+			data.serial = job.serial;
+			data.refilltoken = _parser.GetRefilltoken(response.body);
+			if (data.refilltoken.empty())
+			{
+				PIDebugF("Refilltoken is empty for token {}", job.serial);
+				result.result = PI_OFFLINE_REFILL_REJECTED;
+				continue;
+			}
+			updates.push_back(data);
+			mergedJobs.push_back(sentJobs[k]);
+			result.result = S_OK;
+		}
+		else
+		{
+			OfflineData data;
+			result.result = _parser.ParseRefillResponse(response.body, job.username, data);
+			if (result.result == S_OK)
+			{
+				// Add the serial off the token used to be able to identify it when adding new data
+				data.serial = job.serial;
+				updates.push_back(data);
+				mergedJobs.push_back(sentJobs[k]);
+			}
+		}
+	}
+
+	if (!updates.empty() || !removals.empty())
+	{
+		// If the store could not be changed, the jobs stay queued instead of being completed without their data
+		const HRESULT merged = offlineHandler.UpdateOfflineData(updates, removals);
+		if (merged != S_OK)
+		{
+			PIErrorF("Unable to save the results of {} offline refill(s): {}", mergedJobs.size(), Convert::LongToHexString(merged));
+			for (const size_t i : mergedJobs)
+			{
+				results[i].result = merged;
+			}
+		}
+	}
+
+	return results;
+}
+
+void PrivacyIDEA::EnqueueOfflineRefill(const std::wstring& username, const SecureWString& lastOTP, const std::string& serial)
+{
+	OfflineRefillJob job;
+	job.username = Convert::ToString(username);
+	job.lastOTP = Convert::ToString(lastOTP);
+	job.serial = serial;
+	_refillQueue.Enqueue(job);
+}
+
+void PrivacyIDEA::EnqueueOfflineRefillWebAuthn(const std::wstring& username, const std::string& serial)
+{
+	OfflineRefillJob job;
+	job.username = Convert::ToString(username);
+	job.serial = serial;
+	job.isWebAuthn = true;
+	_refillQueue.Enqueue(job);
+}
+
+void PrivacyIDEA::ProcessOfflineRefillQueueAsync()
+{
+	if (_refillQueue.IsEmpty())
+	{
+		return;
+	}
+
+	lock_guard<mutex> lock(_refillMutex);
+	if (_runRefill.load())
+	{
+		// Already running, wake it up to pick up new jobs
+		_refillCondition.notify_all();
+		return;
+	}
+
+	if (_refillThread.joinable())
+	{
+		_refillThread.join();
+	}
+	_runRefill.store(true);
+	_refillThread = std::thread(&PrivacyIDEA::RefillThread, this);
+}
+
+void PrivacyIDEA::RefillThread()
+{
+	PIDebug("Starting offline refill thread...");
+	while (_runRefill.load())
+	{
+		auto jobs = _refillQueue.GetDueJobs();
+		if (!jobs.empty())
+		{
+			auto results = OfflineRefillBatch(jobs);
+			for (size_t i = 0; i < jobs.size(); i++)
+			{
+				if (results[i].result == S_OK)
+				{
+					_refillQueue.Complete(jobs[i]);
+				}
+				else if (results[i].result == PI_OFFLINE_REFILL_REJECTED)
+				{
+					_refillQueue.Drop(jobs[i]);
+				}
+				else if (results[i].result != PI_ERROR_REQUEST_CANCELLED)
+				{
+					_refillQueue.Reschedule(jobs[i]);
+				}
+			}
+			continue;
+		}
+
+		unique_lock<mutex> lock(_refillMutex);
+		if (_refillQueue.IsEmpty())
+		{
+			_runRefill.store(false);
+			break;
+		}
+
+		// Sleep until the next job is due, a new job is queued or the thread is stopped
+		const time_t nextAttempt = _refillQueue.GetNextAttemptTime();
+		if (nextAttempt > time(nullptr))
+		{
+			_refillCondition.wait_until(lock, chrono::system_clock::from_time_t(nextAttempt));
+		}
+	}
+	PIDebug("Offline refill thread stopped");
+}
+
 bool PrivacyIDEA::StopPoll()
 {
 	PIDebug("Stopping poll thread...");
@@ -21,14 +21,20 @@
 #include "PIResponse.h"
 #include "JsonParser.h"
 #include "OfflineHandler.h"
+#include "OfflineRefillQueue.h"
 #include "Logger.h"
 #include "Endpoint.h"
 #include "PIConfig.h"
 #include "WebAuthnSignResponse.h"
+#include "IdentityKey.h"
 #include <Windows.h>
 #include <map>
+#include <unordered_map>
 #include <functional>
 #include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 constexpr auto PI_ENDPOINT_VALIDATE_CHECK = "/validate/check";
 constexpr auto PI_ENDPOINT_POLLTRANSACTION = "/validate/polltransaction";
@@ -36,19 +42,33 @@ constexpr auto PI_ENDPOINT_OFFLINE_REFILL = "/validate/offlinerefill";
 
 #define PI_ERROR_WRONG_PARAMETER					((HRESULT)0x88809011)
 
+constexpr auto OFFLINE_REFILL_MAX_CONCURRENCY = 4;
+
+struct OfflineRefillResult
+{
+	std::string username;
+	std::string serial;
+	HRESULT result = E_FAIL;
+};
+
 
 class PrivacyIDEA
 {
 public:
 	PrivacyIDEA(PIConfig conf) :
-		_realmMap(conf.realmMap),
+		_realmMap(MakeRealmMap(conf.realmMap)),
 		_defaultRealm(conf.defaultRealm),
 		_logPasswords(conf.logPasswords),
 		_sendUPN(conf.sendUPN),
 		_endpoint(conf),
-		offlineHandler(conf.offlineFilePath, conf.offlineTryWindow)
+		_refillEndpoint(conf),
+		offlineHandler(conf.offlineFilePath, conf.offlineTryWindow, conf.offlineSharedStore,
+			(size_t)conf.offlineMaxUsers, (size_t)conf.offlineMaxSizeKB * 1024, conf.offlineCompactFile),
+		_refillQueue(offlineHandler.GetFilePath() + OFFLINE_REFILL_QUEUE_FILE_SUFFIX)
 	{};
 
+	~PrivacyIDEA();
+
 	PrivacyIDEA& operator=(const PrivacyIDEA& privacyIDEA) = delete;
 
 	/// <summary>
@@ -64,7 +84,7 @@ public:
 	HRESULT ValidateCheck(
 		const std::wstring& username, 
 		const std::wstring& domain, 
-		const std::wstring& otp,
+		const SecureWString& otp,
 		PIResponse& responseObj,
 		const std::string& transactionId = std::string(),
 		const std::wstring& upn = std::wstring(),
@@ -95,7 +115,7 @@ public:
 	/// <param name="username"></param>
 	/// <param name="otp"></param>
 	/// <returns>S_OK, E_FAIL, PI_OFFLINE_DATA_NO_OTPS_LEFT, PI_OFFLINE_NO_OFFLINE_DATA</returns>
-	HRESULT OfflineCheck(const std::wstring& username, const std::wstring& otp, __out std::string& serialUsed);
+	HRESULT OfflineCheck(const std::wstring& username, const SecureWString& otp, __out std::string& serialUsed);
 
 	/// <summary>
 	/// Try to refill offline OTP values with a request to /validate/offlinerefill.
@@ -103,10 +123,32 @@ public:
 	/// <param name="username"></param>
 	/// <param name="lastOTP"></param>
 	/// <returns>S_OK, E_FAIL, PI_JSON_PARSE_ERROR, PI_ERROR_ENDPOINT_SETUP, PI_ERROR_SERVER_UNAVAILABLE</returns>
-	HRESULT OfflineRefill(const std::wstring& username, const std::wstring& lastOTP, const std::string& serial);
+	HRESULT OfflineRefill(const std::wstring& username, const SecureWString& lastOTP, const std::string& serial);
 
 	HRESULT OfflineRefillWebAuthn(const std::wstring& username, const std::string& serial);
 
+	/// <summary>
+	/// Refill multiple HOTP and WebAuthn offline token at once. The requests share one connection and up to OFFLINE_REFILL_MAX_CONCURRENCY
+	/// are sent in parallel. All results are written to the offline store in a single update.
+	/// </summary>
+	/// <param name="jobs"></param>
+	/// <returns>The outcome for each job, in the order of the input. PI_OFFLINE_REFILL_REJECTED if retrying can not help.</returns>
+	std::vector<OfflineRefillResult> OfflineRefillBatch(const std::vector<OfflineRefillJob>& jobs);
+
+	/// <summary>
+	/// Queue an offline refill to be done in the background by ProcessOfflineRefillQueueAsync instead of blocking the logon.
+	/// The queue keeps the OTP until the refill succeeds, protected with DPAPI in its file.
+	/// </summary>
+	void EnqueueOfflineRefill(const std::wstring& username, const SecureWString& lastOTP, const std::string& serial);
+
+	void EnqueueOfflineRefillWebAuthn(const std::wstring& username, const std::string& serial);
+
+	//
+	// Process the queued offline refills in a background thread. Failed refills are retried with backoff.
+	// The thread ends when the queue is empty. Jobs that are still pending when the process exits are processed on the next call.
+	//
+	void ProcessOfflineRefillQueueAsync();
+
 	bool StopPoll();
 	
 	//
@@ -134,17 +176,32 @@ private:
 
 	void PollThread(const std::wstring& username, const std::wstring& domain, const std::wstring& upn, const std::string& transactionId, std::function<void(bool)> callback);
 
-	std::map<std::wstring, std::wstring> _realmMap;
+	void RefillThread();
+
+	// Domain to realm, looked up case insensitive
+	std::unordered_map<IdentityKey, std::wstring, IdentityKey::Hash> _realmMap;
+
+	static std::unordered_map<IdentityKey, std::wstring, IdentityKey::Hash> MakeRealmMap(
+		const std::map<std::wstring, std::wstring>& realmMap);
 
 	std::wstring _defaultRealm = L"";
 
 	Endpoint _endpoint;
+
+	// Used only by the refill thread, so that it does not share the state of _endpoint with the logon and can be cancelled
+	Endpoint _refillEndpoint;
 	
 	bool _logPasswords = false;
 	bool _sendUPN = false;
 
 	std::atomic<bool> _runPoll = false;
 
+	OfflineRefillQueue _refillQueue;
+	std::thread _refillThread;
+	std::atomic<bool> _runRefill = false;
+	std::mutex _refillMutex;
+	std::condition_variable _refillCondition;
+
 	JsonParser _parser;
 };
 
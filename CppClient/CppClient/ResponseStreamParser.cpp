@@ -0,0 +1,717 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "ResponseStreamParser.h"
+#include "JsonParser.h"
+#include "JsonSchema.h"
+#include "Logger.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <clocale>
+#include <cstdlib>
+#include <initializer_list>
+
+using json = nlohmann::json;
+using namespace std;
+
+constexpr auto ARRAY_ELEMENT = "[]";
+
+// Keeps track of the position in the response and writes the values that are part of the schema to the objects
+class ResponseSaxHandler : public json::json_sax_t
+{
+public:
+	ResponseSaxHandler(PIResponse& response, vector<OfflineData>& offlineData, ParseArena* arena)
+		: _response(response), _offlineData(offlineData), _path(ArenaAllocator<Level>(arena)), _allocator(arena)
+	{
+	}
+
+	bool null() override
+	{
+		return true;
+	}
+
+	bool boolean(bool val) override
+	{
+		if (In({ "result" }))
+		{
+			Set(PIRESPONSE_RESULT_FIELDS, _response, val);
+		}
+		return true;
+	}
+
+	bool number_integer(number_integer_t val) override
+	{
+		Integer((long long)val);
+		return true;
+	}
+
+	bool number_unsigned(number_unsigned_t val) override
+	{
+		Integer((long long)val);
+		return true;
+	}
+
+	bool number_float(number_float_t val, const string_t&) override
+	{
+		if (In({ "auth_items", "offline", ARRAY_ELEMENT }))
+		{
+			Set(OFFLINE_DATA_FIELDS, _offlineData.back(), (double)val);
+		}
+		return true;
+	}
+
+	bool string(string_t& val) override
+	{
+		if (In({ "result", "error" }))
+		{
+			Set(PIRESPONSE_ERROR_FIELDS, _response, std::move(val));
+		}
+		else if (In({ "detail" }))
+		{
+			if (_key == "serial") _serial = std::move(val);
+			else Set(PIRESPONSE_DETAIL_FIELDS, _response, std::move(val));
+		}
+		else if (In({ "detail", "multi_challenge", ARRAY_ELEMENT }))
+		{
+			Set(CHALLENGE_FIELDS, _response.challenges.back(), std::move(val));
+		}
+		else if (In({ "detail", "multi_challenge", ARRAY_ELEMENT, "attributes", "webAuthnSignRequest" }))
+		{
+			Set(WEBAUTHN_SIGN_REQUEST_FIELDS, _signRequest, std::move(val));
+		}
+		else if (In({ "detail", "multi_challenge", ARRAY_ELEMENT, "attributes", "webAuthnSignRequest", "allowCredentials", ARRAY_ELEMENT }))
+		{
+			Set(ALLOW_CREDENTIAL_FIELDS, _signRequest.allowCredentials.back(), std::move(val));
+		}
+		else if (In({ "detail", "multi_challenge", ARRAY_ELEMENT, "attributes", "webAuthnSignRequest", "allowCredentials", ARRAY_ELEMENT, "transports" }))
+		{
+			_signRequest.allowCredentials.back().transports.push_back(std::move(val));
+		}
+		else if (In({ "auth_items", "offline", ARRAY_ELEMENT }))
+		{
+			Set(OFFLINE_DATA_FIELDS, _offlineData.back(), std::move(val));
+		}
+		else if (In({ "auth_items", "offline", ARRAY_ELEMENT, "response" }))
+		{
+			_offlineResponse[_key] = std::move(val);
+		}
+		return true;
+	}
+
+	bool binary(binary_t&) override
+	{
+		return true;
+	}
+
+	bool start_object(std::size_t) override
+	{
+		Push(false);
+		if (In({ "result" }))
+		{
+			_hasResult = true;
+		}
+		else if (In({ "detail", "multi_challenge", ARRAY_ELEMENT }))
+		{
+			_response.challenges.emplace_back();
+			_signRequest = WebAuthnSignRequest();
+		}
+		else if (In({ "detail", "multi_challenge", ARRAY_ELEMENT, "attributes", "webAuthnSignRequest", "allowCredentials", ARRAY_ELEMENT }))
+		{
+			_signRequest.allowCredentials.emplace_back();
+		}
+		else if (In({ "auth_items", "offline", ARRAY_ELEMENT }))
+		{
+			_offlineData.emplace_back();
+			_offlineResponse.clear();
+			_hasOfflineResponse = false;
+		}
+		else if (In({ "auth_items", "offline", ARRAY_ELEMENT, "response" }))
+		{
+			_hasOfflineResponse = true;
+		}
+		return true;
+	}
+
+	bool key(string_t& val) override
+	{
+		// Copy instead of move, so that both buffers keep their capacity for the next key
+		_key.assign(val);
+		return true;
+	}
+
+	bool end_object() override
+	{
+		if (In({ "detail", "multi_challenge", ARRAY_ELEMENT }))
+		{
+			Challenge& c = _response.challenges.back();
+			if (c.type == "webauthn")
+			{
+				if (!_signRequest.allowCredentials.empty())
+				{
+					_signRequest.type = _signRequest.allowCredentials[0].type;
+				}
+				c.webAuthnSignRequest = std::move(_signRequest);
+			}
+		}
+		else if (In({ "auth_items", "offline", ARRAY_ELEMENT }))
+		{
+			FinishOfflineData();
+		}
+		Pop();
+		return true;
+	}
+
+	bool start_array(std::size_t) override
+	{
+		Push(true);
+		return true;
+	}
+
+	bool end_array() override
+	{
+		Pop();
+		return true;
+	}
+
+	bool parse_error(std::size_t position, const std::string&, const nlohmann::detail::exception& ex) override
+	{
+		PIDebugF("Parse error at position {}: {}", position, ex.what());
+		return false;
+	}
+
+	// Values that depend on other parts of the response are set when the complete response is parsed
+	HRESULT Complete()
+	{
+		if (_response.challenges.empty())
+		{
+			_response.transactionId.clear();
+			_response.preferredMode.clear();
+		}
+
+		// The serial is not part of the 'offline' section of the response, but required for refill later
+		for (auto& data : _offlineData)
+		{
+			data.serial = _serial;
+			PIDebugF("Received offline data for user '{}'", data.username);
+		}
+
+		if (!_hasResult)
+		{
+			PIDebug("Reponse did not contain 'result'");
+			return PI_JSON_PARSE_ERROR;
+		}
+		return S_OK;
+	}
+
+private:
+	struct Level
+	{
+		ArenaString name;
+		bool isArray;
+	};
+
+	PIResponse& _response;
+	vector<OfflineData>& _offlineData;
+
+	// Containers from the root to the current position, without the root itself
+	vector<Level, ArenaAllocator<Level>> _path;
+	ArenaAllocator<char> _allocator;
+	int _depth = 0;
+	std::string _key;
+
+	bool _hasResult = false;
+	std::string _serial;
+	WebAuthnSignRequest _signRequest;
+	map<std::string, std::string> _offlineResponse;
+	bool _hasOfflineResponse = false;
+
+	// Check if the current container is at the given path
+	bool In(std::initializer_list<const char*> path) const
+	{
+		if (path.size() != _path.size()) return false;
+
+		size_t i = 0;
+		for (const char* name : path)
+		{
+			if (_path[i++].name != name) return false;
+		}
+		return true;
+	}
+
+	void Push(bool isArray)
+	{
+		// The root container has no name
+		if (_depth++ > 0)
+		{
+			const bool inArray = !_path.empty() && _path.back().isArray;
+			_path.push_back({ inArray ? ArenaString(ARRAY_ELEMENT, _allocator) : ArenaString(_key.data(), _key.size(), _allocator), isArray });
+		}
+	}
+
+	void Pop()
+	{
+		if (--_depth > 0)
+		{
+			_path.pop_back();
+		}
+	}
+
+	// Set the value to the field of the object that matches the current key
+	template<class T, size_t N, class V>
+	void Set(const JsonField<T>(&fields)[N], T& object, V&& value)
+	{
+		const auto field = JsonFindField(fields, _key.data(), _key.size());
+		if (field != nullptr) SetValue(*field, object, std::forward<V>(value));
+	}
+
+	template<class T>
+	static void SetValue(const JsonField<T>& field, T& object, std::string&& value) { JsonSetString(field, object, std::move(value)); }
+
+	template<class T>
+	static void SetValue(const JsonField<T>& field, T& object, long long value) { JsonSetInteger(field, object, value); }
+
+	template<class T>
+	static void SetValue(const JsonField<T>& field, T& object, double value) { JsonSetDouble(field, object, value); }
+
+	template<class T>
+	static void SetValue(const JsonField<T>& field, T& object, bool value) { JsonSetBool(field, object, value); }
+
+	void Integer(long long val)
+	{
+		if (In({ "result", "error" }))
+		{
+			Set(PIRESPONSE_ERROR_FIELDS, _response, val);
+		}
+		else if (In({ "detail", "multi_challenge", ARRAY_ELEMENT, "attributes", "webAuthnSignRequest" }))
+		{
+			Set(WEBAUTHN_SIGN_REQUEST_FIELDS, _signRequest, val);
+		}
+		else if (In({ "auth_items", "offline", ARRAY_ELEMENT }))
+		{
+			Set(OFFLINE_DATA_FIELDS, _offlineData.back(), val);
+		}
+	}
+
+	void FinishOfflineData()
+	{
+		if (!_hasOfflineResponse)
+		{
+			PIDebug("Offline data item did not contain 'response'");
+			_offlineData.pop_back();
+			return;
+		}
+
+		OfflineData& data = _offlineData.back();
+		auto pubKey = _offlineResponse.find("pubKey");
+		auto credId = _offlineResponse.find("credentialId");
+		auto rpId = _offlineResponse.find("rpId");
+		if (pubKey != _offlineResponse.end() && credId != _offlineResponse.end() && rpId != _offlineResponse.end())
+		{
+			data.pubKey = std::move(pubKey->second);
+			data.credId = std::move(credId->second);
+			data.rpId = std::move(rpId->second);
+		}
+		else // HOTP
+		{
+			data.offlineOTPs = std::move(_offlineResponse);
+		}
+		_offlineResponse.clear();
+	}
+};
+
+// -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+static bool IsJsonNumber(const std::string& s)
+{
+	size_t i = 0;
+	const size_t n = s.size();
+	auto digits = [&]()
+	{
+		const size_t start = i;
+		while (i < n && s[i] >= '0' && s[i] <= '9') i++;
+		return i - start;
+	};
+
+	if (i < n && s[i] == '-') i++;
+	if (i < n && s[i] == '0') i++;
+	else if (digits() == 0) return false;
+
+	if (i < n && s[i] == '.')
+	{
+		i++;
+		if (digits() == 0) return false;
+	}
+
+	if (i < n && (s[i] == 'e' || s[i] == 'E'))
+	{
+		i++;
+		if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+		if (digits() == 0) return false;
+	}
+
+	return i == n;
+}
+
+static int HexValue(char c)
+{
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	return -1;
+}
+
+ResponseStreamParser::ResponseStreamParser(bool useArena) : _useArena(useArena)
+{
+}
+
+ResponseStreamParser::~ResponseStreamParser()
+{
+	Reset();
+}
+
+void ResponseStreamParser::Feed(const char* data, size_t size)
+{
+	if (_failed) return;
+
+	if (!_handler)
+	{
+		_handler.reset(new ResponseSaxHandler(_response, _offlineData, _useArena ? &_arena : nullptr));
+	}
+
+	for (size_t i = 0; i < size; i++)
+	{
+		_position++;
+		if (!Process(data[i])) return;
+	}
+}
+
+void ResponseStreamParser::Feed(const std::string& data)
+{
+	Feed(data.data(), data.size());
+}
+
+HRESULT ResponseStreamParser::Finish(PIResponse& response, std::vector<OfflineData>& offlineData)
+{
+	Feed(nullptr, 0);
+	if (!_failed)
+	{
+		// A number or literal at the end of the input has nothing after it that ends it
+		if (_token == Token::Number) EndNumber();
+		else if (_token == Token::Literal) EndLiteral();
+		else if (_token != Token::None) Fail("Unterminated string");
+
+		if (!_failed && _expect != Expect::Nothing) Fail("Unexpected end of input");
+	}
+
+	HRESULT res = _handler->Complete();
+	if (_failed) res = PI_JSON_PARSE_ERROR;
+
+	response = std::move(_response);
+	offlineData = std::move(_offlineData);
+
+	// Nothing uses the arena anymore
+	Reset();
+	return res;
+}
+
+void ResponseStreamParser::Reset()
+{
+	_handler.reset();
+	_response = PIResponse();
+	_offlineData.clear();
+	_containers.clear();
+	_expect = Expect::Value;
+	_token = Token::None;
+	_isKey = false;
+	// A value split between two parts can be a secret
+	if (!_value.empty())
+	{
+		SecureZeroMemory(&_value[0], _value.size());
+	}
+	_value.clear();
+	_codeUnit = 0;
+	_hexDigits = 0;
+	_highSurrogate = 0;
+	_position = 0;
+	_failed = false;
+	_arena.Release();
+}
+
+bool ResponseStreamParser::Process(char c)
+{
+	switch (_token)
+	{
+		case Token::String:
+			if (c == '"') return EndString();
+			if (c == '\\')
+			{
+				_token = Token::Escape;
+				return true;
+			}
+			if (static_cast<unsigned char>(c) < 0x20) return Fail("Control character in string");
+			if (_highSurrogate != 0) return Fail("Unpaired surrogate");
+			_value.push_back(c);
+			return true;
+		case Token::Escape:
+			_token = Token::String;
+			if (c == 'u')
+			{
+				_token = Token::Unicode;
+				_codeUnit = 0;
+				_hexDigits = 0;
+				return true;
+			}
+			if (_highSurrogate != 0) return Fail("Unpaired surrogate");
+			switch (c)
+			{
+				case '"': case '\\': case '/': _value.push_back(c); return true;
+				case 'b': _value.push_back('\b'); return true;
+				case 'f': _value.push_back('\f'); return true;
+				case 'n': _value.push_back('\n'); return true;
+				case 'r': _value.push_back('\r'); return true;
+				case 't': _value.push_back('\t'); return true;
+				default: return Fail("Invalid escape");
+			}
+		case Token::Unicode:
+		{
+			const int digit = HexValue(c);
+			if (digit < 0) return Fail("Invalid unicode escape");
+			_codeUnit = _codeUnit * 16 + static_cast<unsigned int>(digit);
+			if (++_hexDigits < 4) return true;
+			_token = Token::String;
+			return AppendCodeUnit();
+		}
+		case Token::Number:
+			if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E')
+			{
+				_value.push_back(c);
+				return true;
+			}
+			if (!EndNumber()) return false;
+			break;
+		case Token::Literal:
+			if (c >= 'a' && c <= 'z')
+			{
+				_value.push_back(c);
+				return true;
+			}
+			if (!EndLiteral()) return false;
+			break;
+		case Token::None:
+			break;
+	}
+
+	if (c == ' ' || c == '\t' || c == '\n' || c == '\r') return true;
+
+	switch (_expect)
+	{
+		case Expect::Value:
+			return StartValue(c);
+		case Expect::ValueOrEnd:
+			if (c == ']') return EndContainer(false);
+			return StartValue(c);
+		case Expect::KeyOrEnd:
+		case Expect::Key:
+			if (c == '}' && _expect == Expect::KeyOrEnd) return EndContainer(true);
+			if (c != '"') return Fail("Expected a key");
+			_token = Token::String;
+			_isKey = true;
+			_value.clear();
+			return true;
+		case Expect::Colon:
+			if (c != ':') return Fail("Expected ':'");
+			_expect = Expect::Value;
+			return true;
+		case Expect::CommaOrEnd:
+		{
+			const bool inObject = _containers.back();
+			if (c == ',')
+			{
+				_expect = inObject ? Expect::Key : Expect::Value;
+				return true;
+			}
+			if (c == (inObject ? '}' : ']')) return EndContainer(inObject);
+			return Fail("Expected ',' or the end of the container");
+		}
+		case Expect::Nothing:
+			break;
+	}
+
+	return Fail("Unexpected data after the end");
+}
+
+bool ResponseStreamParser::StartValue(char c)
+{
+	if (c == '{')
+	{
+		_containers.push_back(true);
+		_expect = Expect::KeyOrEnd;
+		return _handler->start_object(static_cast<size_t>(-1)) || Fail("Stopped");
+	}
+	if (c == '[')
+	{
+		_containers.push_back(false);
+		_expect = Expect::ValueOrEnd;
+		return _handler->start_array(static_cast<size_t>(-1)) || Fail("Stopped");
+	}
+
+	_value.clear();
+	if (c == '"')
+	{
+		_token = Token::String;
+		_isKey = false;
+	}
+	else if (c == '-' || (c >= '0' && c <= '9'))
+	{
+		_token = Token::Number;
+		_value.push_back(c);
+	}
+	else if (c == 't' || c == 'f' || c == 'n')
+	{
+		_token = Token::Literal;
+		_value.push_back(c);
+	}
+	else
+	{
+		return Fail("Unexpected character");
+	}
+	return true;
+}
+
+bool ResponseStreamParser::EndContainer(bool isObject)
+{
+	_containers.pop_back();
+	ValueDone();
+	return (isObject ? _handler->end_object() : _handler->end_array()) || Fail("Stopped");
+}
+
+bool ResponseStreamParser::EndString()
+{
+	_token = Token::None;
+	if (_highSurrogate != 0) return Fail("Unpaired surrogate");
+
+	if (_isKey)
+	{
+		_expect = Expect::Colon;
+		return _handler->key(_value) || Fail("Stopped");
+	}
+
+	ValueDone();
+	return _handler->string(_value) || Fail("Stopped");
+}
+
+bool ResponseStreamParser::EndNumber()
+{
+	_token = Token::None;
+	if (!IsJsonNumber(_value)) return Fail("Invalid number");
+	ValueDone();
+
+	if (_value.find_first_of(".eE") == string::npos)
+	{
+		errno = 0;
+		if (_value[0] == '-')
+		{
+			const long long value = strtoll(_value.c_str(), nullptr, 10);
+			if (errno != ERANGE) return _handler->number_integer(value) || Fail("Stopped");
+		}
+		else
+		{
+			const unsigned long long value = strtoull(_value.c_str(), nullptr, 10);
+			if (errno != ERANGE) return _handler->number_unsigned(value) || Fail("Stopped");
+		}
+		// Integers out of range are passed as floating point numbers, like nlohmann json does
+	}
+
+	// strtod uses the decimal point of the current locale
+	string number = _value;
+	const char decimalPoint = *localeconv()->decimal_point;
+	if (decimalPoint != '.')
+	{
+		std::replace(number.begin(), number.end(), '.', decimalPoint);
+	}
+	const double value = strtod(number.c_str(), nullptr);
+	return _handler->number_float(value, _value) || Fail("Stopped");
+}
+
+bool ResponseStreamParser::EndLiteral()
+{
+	_token = Token::None;
+	ValueDone();
+	if (_value == "true") return _handler->boolean(true) || Fail("Stopped");
+	if (_value == "false") return _handler->boolean(false) || Fail("Stopped");
+	if (_value == "null") return _handler->null() || Fail("Stopped");
+	return Fail("Invalid literal");
+}
+
+// Append the code unit of a \u escape as UTF-8, surrogate pairs are combined
+bool ResponseStreamParser::AppendCodeUnit()
+{
+	unsigned int codePoint = _codeUnit;
+	if (_highSurrogate != 0)
+	{
+		if (_codeUnit < 0xDC00 || _codeUnit > 0xDFFF) return Fail("Unpaired surrogate");
+		codePoint = 0x10000 + ((_highSurrogate - 0xD800) << 10) + (_codeUnit - 0xDC00);
+		_highSurrogate = 0;
+	}
+	else if (_codeUnit >= 0xD800 && _codeUnit <= 0xDBFF)
+	{
+		_highSurrogate = _codeUnit;
+		return true;
+	}
+	else if (_codeUnit >= 0xDC00 && _codeUnit <= 0xDFFF)
+	{
+		return Fail("Unpaired surrogate");
+	}
+
+	if (codePoint < 0x80)
+	{
+		_value.push_back(static_cast<char>(codePoint));
+	}
+	else if (codePoint < 0x800)
+	{
+		_value.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+		_value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+	else if (codePoint < 0x10000)
+	{
+		_value.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+		_value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		_value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+	else
+	{
+		_value.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+		_value.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+		_value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+		_value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+	}
+	return true;
+}
+
+void ResponseStreamParser::ValueDone()
+{
+	_expect = _containers.empty() ? Expect::Nothing : Expect::CommaOrEnd;
+}
+
+bool ResponseStreamParser::Fail(const char* message)
+{
+	PIDebugF("Parse error at position {}: {}", _position, message);
+	_failed = true;
+	return false;
+}
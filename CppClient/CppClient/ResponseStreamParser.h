@@ -0,0 +1,105 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "PIResponse.h"
+#include "OfflineData.h"
+#include "ParseArena.h"
+#include <memory>
+#include <string>
+#include <vector>
+#include <Windows.h>
+
+class ResponseSaxHandler;
+
+/// <summary>
+/// Event based parser for the responses of /validate/check. The values are written directly to the PIResponse and
+/// the OfflineData of auth_items without building a json document first.
+/// The response can be fed in parts, for example as the chunks are received. Each part is parsed right away, only a
+/// value that is split between two parts is kept until the next part. If a key appears twice in an object, the last
+/// value is used.
+/// The temporary memory of parsing is taken from an arena, that is wiped and released in one step after each response.
+/// </summary>
+class ResponseStreamParser
+{
+public:
+	// Without the arena, the temporary memory is taken from the heap. Only to measure what the arena saves.
+	explicit ResponseStreamParser(bool useArena = true);
+
+	~ResponseStreamParser();
+
+	ResponseStreamParser(const ResponseStreamParser&) = delete;
+	ResponseStreamParser& operator=(const ResponseStreamParser&) = delete;
+
+	void Feed(const char* data, size_t size);
+
+	void Feed(const std::string& data);
+
+	/// <summary>
+	/// Complete the response that has been fed so far. Afterwards, the parser is reset and can be used for the next response.
+	/// </summary>
+	/// <param name="response"></param>
+	/// <param name="offlineData">The offline data from auth_items, with the serial from detail</param>
+	/// <returns>
+	/// S_OK success,
+	/// PI_JSON_PARSE_ERROR if the input is malformed or incomplete or 'result' is missing. The values that were parsed
+	/// before are set in that case, too.
+	/// </returns>
+	HRESULT Finish(PIResponse& response, std::vector<OfflineData>& offlineData);
+
+	/// <summary>
+	/// Discard the current response and wipe and release the memory used for it.
+	/// </summary>
+	void Reset();
+
+private:
+	// What the grammar allows at the current position, apart from whitespace
+	enum class Expect { Value, ValueOrEnd, KeyOrEnd, Key, Colon, CommaOrEnd, Nothing };
+
+	// Token that is not complete yet
+	enum class Token { None, String, Escape, Unicode, Number, Literal };
+
+	bool Process(char c);
+	bool StartValue(char c);
+	bool EndContainer(bool isObject);
+	bool EndString();
+	bool EndNumber();
+	bool EndLiteral();
+	bool AppendCodeUnit();
+	void ValueDone();
+	bool Fail(const char* message);
+
+	ParseArena _arena;
+	bool _useArena = true;
+	PIResponse _response;
+	std::vector<OfflineData> _offlineData;
+	std::unique_ptr<ResponseSaxHandler> _handler;
+
+	// Open containers, true for objects
+	std::vector<bool> _containers;
+	Expect _expect = Expect::Value;
+	Token _token = Token::None;
+	bool _isKey = false;
+	std::string _value;
+	unsigned int _codeUnit = 0;
+	int _hexDigits = 0;
+	unsigned int _highSurrogate = 0;
+	size_t _position = 0;
+	bool _failed = false;
+};
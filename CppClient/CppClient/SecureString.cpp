@@ -0,0 +1,160 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "SecureString.h"
+#include "Logger.h"
+#include <new>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+using namespace std;
+
+// Smallest size class, each following class doubles the size
+constexpr size_t SECURE_POOL_MIN_SLOT_SIZE = 32;
+// One page per chunk, the minimum working set limits how much a process can lock
+constexpr size_t SECURE_POOL_CHUNK_SIZE = 4096;
+
+// Committed pages, or nullptr
+static void* AllocatePages(size_t size) noexcept
+{
+#ifdef _WIN32
+	return VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#else
+	void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+// Keep the pages out of the page file (swap)
+static bool LockPages(void* p, size_t size) noexcept
+{
+#ifdef _WIN32
+	return VirtualLock(p, size) != FALSE;
+#else
+	return mlock(p, size) == 0;
+#endif
+}
+
+static void FreePages(void* p, size_t size) noexcept
+{
+#ifdef _WIN32
+	VirtualUnlock(p, size);
+	VirtualFree(p, 0, MEM_RELEASE);
+#else
+	munlock(p, size);
+	munmap(p, size);
+#endif
+}
+
+SecurePool& SecurePool::Get()
+{
+	// Never destroyed, strings in static objects can still be freed during shutdown
+	static SecurePool* instance = new SecurePool();
+	return *instance;
+}
+
+size_t SecurePool::GetSizeClass(size_t size) noexcept
+{
+	size_t slotSize = SECURE_POOL_MIN_SLOT_SIZE;
+	for (size_t i = 0; i < SIZE_CLASS_COUNT; i++)
+	{
+		if (size <= slotSize)
+		{
+			return i;
+		}
+		slotSize *= 2;
+	}
+	return SIZE_CLASS_COUNT;
+}
+
+void SecurePool::AddChunk(size_t sizeClass)
+{
+	unsigned char* chunk = static_cast<unsigned char*>(AllocatePages(SECURE_POOL_CHUNK_SIZE));
+	if (chunk == nullptr)
+	{
+		throw bad_alloc();
+	}
+
+	if (!LockPages(chunk, SECURE_POOL_CHUNK_SIZE) && !_lockFailureLogged)
+	{
+		// Still usable, the memory is wiped anyway
+		PIDebugF("SecurePool: Locking the pages failed: {}", GetLastError());
+		_lockFailureLogged = true;
+	}
+
+	// Chunks are kept for the lifetime of the process, their slots are put on the free list
+	const size_t slotSize = SECURE_POOL_MIN_SLOT_SIZE << sizeClass;
+	for (size_t offset = 0; offset + slotSize <= SECURE_POOL_CHUNK_SIZE; offset += slotSize)
+	{
+		void* slot = chunk + offset;
+		*static_cast<void**>(slot) = _freeLists[sizeClass];
+		_freeLists[sizeClass] = slot;
+	}
+}
+
+void* SecurePool::Allocate(size_t size)
+{
+	if (size == 0) size = 1;
+	const size_t sizeClass = GetSizeClass(size);
+
+	lock_guard<mutex> lock(_mutex);
+	_allocations++;
+
+	if (sizeClass == SIZE_CLASS_COUNT)
+	{
+		void* p = AllocatePages(size);
+		if (p == nullptr)
+		{
+			throw bad_alloc();
+		}
+		LockPages(p, size);
+		return p;
+	}
+
+	if (_freeLists[sizeClass] == nullptr)
+	{
+		AddChunk(sizeClass);
+	}
+
+	void* slot = _freeLists[sizeClass];
+	_freeLists[sizeClass] = *static_cast<void**>(slot);
+	*static_cast<void**>(slot) = nullptr;
+	return slot;
+}
+
+void SecurePool::Free(void* p, size_t size) noexcept
+{
+	if (p == nullptr) return;
+	if (size == 0) size = 1;
+	const size_t sizeClass = GetSizeClass(size);
+
+	if (sizeClass == SIZE_CLASS_COUNT)
+	{
+		SecureZeroMemory(p, size);
+		FreePages(p, size);
+		return;
+	}
+
+	SecureZeroMemory(p, SECURE_POOL_MIN_SLOT_SIZE << sizeClass);
+
+	lock_guard<mutex> lock(_mutex);
+	*static_cast<void**>(p) = _freeLists[sizeClass];
+	_freeLists[sizeClass] = p;
+}
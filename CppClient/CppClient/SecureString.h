@@ -0,0 +1,289 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <Windows.h>
+
+/// <summary>
+/// Memory for secrets. Small allocations are served from chunks of pages that are locked into memory with VirtualLock,
+/// so that they are not written to the page file, and are reused by size class. Larger allocations get locked pages of
+/// their own. Everything is wiped before it is put back. Thread safe.
+/// </summary>
+class SecurePool
+{
+public:
+	static SecurePool& Get();
+
+	SecurePool(const SecurePool&) = delete;
+	SecurePool& operator=(const SecurePool&) = delete;
+
+	/// <summary>
+	/// Allocate at least size bytes. Throws std::bad_alloc on failure.
+	/// </summary>
+	void* Allocate(size_t size);
+
+	/// <summary>
+	/// Wipe and return memory that was allocated with the same size.
+	/// </summary>
+	void Free(void* p, size_t size) noexcept;
+
+	// Number of Allocate calls, for diagnostics
+	size_t GetAllocationCount() const noexcept { return _allocations; }
+
+private:
+	SecurePool() = default;
+
+	static constexpr size_t SIZE_CLASS_COUNT = 6;
+
+	// Index of the size class for the size, SIZE_CLASS_COUNT if it is too large for the chunks
+	static size_t GetSizeClass(size_t size) noexcept;
+
+	void AddChunk(size_t sizeClass);
+
+	std::mutex _mutex;
+	// Singly linked lists through the free slots of each size class
+	void* _freeLists[SIZE_CLASS_COUNT] = {};
+	size_t _allocations = 0;
+	bool _lockFailureLogged = false;
+};
+
+/// <summary>
+/// String for passwords, OTPs and PINs. The characters live in memory from the SecurePool and are wiped when the string
+/// is cleared, grows or is destroyed. There is no small string buffer, so no part of the secret is left on the stack.
+/// The type is move-only: a copy has to be made explicitly with Copy(), which keeps the number of copies visible.
+/// </summary>
+template<typename CharT>
+class SecureBasicString
+{
+public:
+	SecureBasicString() noexcept = default;
+
+	explicit SecureBasicString(const CharT* str)
+	{
+		assign(str);
+	}
+
+	SecureBasicString(const CharT* str, size_t size)
+	{
+		assign(str, size);
+	}
+
+	SecureBasicString(SecureBasicString&& other) noexcept
+		: _data(other._data), _size(other._size), _capacity(other._capacity)
+	{
+		other._data = nullptr;
+		other._size = 0;
+		other._capacity = 0;
+	}
+
+	SecureBasicString& operator=(SecureBasicString&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Release();
+			std::swap(_data, other._data);
+			std::swap(_size, other._size);
+			std::swap(_capacity, other._capacity);
+		}
+		return *this;
+	}
+
+	SecureBasicString(const SecureBasicString&) = delete;
+	SecureBasicString& operator=(const SecureBasicString&) = delete;
+
+	// From a null terminated buffer, like the field strings of the credential provider
+	SecureBasicString& operator=(const CharT* str)
+	{
+		assign(str);
+		return *this;
+	}
+
+	~SecureBasicString()
+	{
+		Release();
+	}
+
+	SecureBasicString Copy() const
+	{
+		return SecureBasicString(c_str(), _size);
+	}
+
+	void assign(const CharT* str)
+	{
+		assign(str, str ? std::char_traits<CharT>::length(str) : 0);
+	}
+
+	void assign(const CharT* str, size_t size)
+	{
+		if (Contains(str))
+		{
+			// A part of this string, clearing first would wipe it. It moves to the front and the rest is wiped.
+			std::memmove(_data, str, size * sizeof(CharT));
+			SecureZeroMemory(_data + size, (_capacity + 1 - size) * sizeof(CharT));
+			_size = size;
+			return;
+		}
+		clear();
+		append(str, size);
+	}
+
+	void append(const CharT* str, size_t size)
+	{
+		if (size == 0) return;
+		if (Contains(str))
+		{
+			// A part of this string, the buffer might move when it grows
+			const size_t offset = static_cast<size_t>(str - _data);
+			reserve(_size + size);
+			str = _data + offset;
+		}
+		else
+		{
+			reserve(_size + size);
+		}
+		std::memmove(_data + _size, str, size * sizeof(CharT));
+		_size += size;
+		_data[_size] = CharT();
+	}
+
+	// New characters are zero, removed characters are wiped
+	void resize(size_t size)
+	{
+		if (size > _size)
+		{
+			reserve(size);
+			std::memset(_data + _size, 0, (size - _size) * sizeof(CharT));
+		}
+		else if (_data)
+		{
+			SecureZeroMemory(_data + size, (_size - size) * sizeof(CharT));
+		}
+		else
+		{
+			return;
+		}
+		_size = size;
+		_data[_size] = CharT();
+	}
+
+	void push_back(CharT c)
+	{
+		append(&c, 1);
+	}
+
+	void reserve(size_t capacity)
+	{
+		if (capacity <= _capacity) return;
+		if (capacity < _capacity * 2)
+		{
+			capacity = _capacity * 2;
+		}
+
+		CharT* data = static_cast<CharT*>(SecurePool::Get().Allocate((capacity + 1) * sizeof(CharT)));
+		if (_data)
+		{
+			std::memcpy(data, _data, (_size + 1) * sizeof(CharT));
+		}
+		else
+		{
+			data[0] = CharT();
+		}
+		const size_t size = _size;
+		Release();
+		_data = data;
+		_size = size;
+		_capacity = capacity;
+	}
+
+	/// <summary>
+	/// Wipe the content. The memory is kept for reuse.
+	/// </summary>
+	void clear() noexcept
+	{
+		if (_data)
+		{
+			SecureZeroMemory(_data, (_capacity + 1) * sizeof(CharT));
+		}
+		_size = 0;
+	}
+
+	const CharT* c_str() const noexcept
+	{
+		static const CharT empty = CharT();
+		return _data ? _data : &empty;
+	}
+
+	// Writable, for APIs that take a non-const buffer. Null if nothing has been allocated yet.
+	CharT* data() noexcept { return _data; }
+	const CharT* data() const noexcept { return c_str(); }
+
+	size_t size() const noexcept { return _size; }
+
+	bool empty() const noexcept { return _size == 0; }
+
+	// The comparison time does not depend on where the strings differ
+	bool operator==(const SecureBasicString& other) const noexcept
+	{
+		if (_size != other._size) return false;
+		const CharT* a = c_str();
+		const CharT* b = other.c_str();
+		CharT diff = CharT();
+		for (size_t i = 0; i < _size; i++)
+		{
+			diff |= a[i] ^ b[i];
+		}
+		return diff == CharT();
+	}
+
+	bool operator!=(const SecureBasicString& other) const noexcept
+	{
+		return !(*this == other);
+	}
+
+private:
+	// If the pointer is inside the buffer of this string. std::less gives a total order also for unrelated pointers.
+	bool Contains(const CharT* p) const noexcept
+	{
+		return _data != nullptr && !std::less<const CharT*>()(p, _data) && std::less<const CharT*>()(p, _data + _capacity + 1);
+	}
+
+	void Release() noexcept
+	{
+		if (_data)
+		{
+			// The pool wipes the memory
+			SecurePool::Get().Free(_data, (_capacity + 1) * sizeof(CharT));
+			_data = nullptr;
+		}
+		_size = 0;
+		_capacity = 0;
+	}
+
+	CharT* _data = nullptr;
+	size_t _size = 0;
+	size_t _capacity = 0;
+};
+
+using SecureString = SecureBasicString<char>;
+using SecureWString = SecureBasicString<wchar_t>;
@@ -0,0 +1,398 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "SimdJsonBackend.h"
+
+#ifdef PI_JSON_SIMDJSON
+
+// MSVC only reports the language level in __cplusplus with /Zc:__cplusplus
+#if (defined(_MSVC_LANG) ? _MSVC_LANG : __cplusplus) < 201703L
+#error "PI_JSON_SIMDJSON requires C++17 (/std:c++17 or -std=c++17), simdjson uses std::string_view"
+#endif
+
+#include "JsonParser.h"
+#include "JsonSchema.h"
+#include "Logger.h"
+// Only the API that returns error codes, the conversions of simdjson_result that throw do not compile
+#define SIMDJSON_EXCEPTIONS 0
+#include <simdjson.h>
+
+#ifdef _MSC_VER
+#pragma comment (lib, "simdjson.lib")
+#endif
+
+using namespace std;
+namespace ondemand = simdjson::ondemand;
+
+// A value of another type than expected is ignored like with the other backend. Any other error means that the
+// input is malformed.
+static simdjson::error_code InputError(simdjson::error_code error)
+{
+	return error == simdjson::INCORRECT_TYPE ? simdjson::SUCCESS : error;
+}
+
+static bool IsObject(ondemand::value& value)
+{
+	ondemand::json_type type;
+	return value.type().get(type) == simdjson::SUCCESS && type == ondemand::json_type::object;
+}
+
+// Call the function with the value if it is a string
+template<typename F>
+static simdjson::error_code IfString(ondemand::value& value, F&& function)
+{
+	string_view sv;
+	const simdjson::error_code error = value.get_string().get(sv);
+	if (!error) function(string(sv.data(), sv.size()));
+	return InputError(error);
+}
+
+// Set the value to the field of the table that matches the key. field is set to the matching field, so that fields of
+// type Object can be handled by the caller, or nullptr if the key is not part of the table.
+template<class T, size_t N>
+static simdjson::error_code SetField(const JsonField<T>(&fields)[N], T& object, string_view key, ondemand::value& value,
+	const JsonField<T>*& field)
+{
+	field = JsonFindField(fields, key.data(), key.size());
+	if (field == nullptr || field->type == JsonFieldType::Object) return simdjson::SUCCESS;
+
+	ondemand::json_type type;
+	simdjson::error_code error = value.type().get(type);
+	if (error) return error;
+
+	switch (type)
+	{
+		case ondemand::json_type::string:
+			return IfString(value, [&](string&& s) { JsonSetString(*field, object, std::move(s)); });
+		case ondemand::json_type::boolean:
+		{
+			bool b = false;
+			if (!(error = value.get_bool().get(b))) JsonSetBool(*field, object, b);
+			return error;
+		}
+		case ondemand::json_type::number:
+		{
+			// Same conversions as the SAX parser of nlohmann json
+			ondemand::number_type numberType;
+			if ((error = value.get_number_type().get(numberType))) return error;
+			if (numberType == ondemand::number_type::signed_integer)
+			{
+				int64_t i = 0;
+				if (!(error = value.get_int64().get(i))) JsonSetInteger(*field, object, (long long)i);
+			}
+			else if (numberType == ondemand::number_type::unsigned_integer)
+			{
+				uint64_t u = 0;
+				if (!(error = value.get_uint64().get(u))) JsonSetInteger(*field, object, (long long)u);
+			}
+			else
+			{
+				double d = 0.0;
+				if (!(error = value.get_double().get(d))) JsonSetDouble(*field, object, d);
+			}
+			return error;
+		}
+		default:
+			return simdjson::SUCCESS;
+	}
+}
+
+// Call the function with the key and the value of each field of the object. Stops at the first error of the input
+// or of the function.
+template<typename F>
+static simdjson::error_code ForEachField(ondemand::value& value, F&& function)
+{
+	ondemand::object object;
+	simdjson::error_code error = value.get_object().get(object);
+	if (error) return InputError(error);
+
+	for (auto fieldResult : object)
+	{
+		ondemand::field field;
+		string_view key;
+		if ((error = std::move(fieldResult).get(field)) || (error = field.unescaped_key().get(key))) return error;
+		if ((error = function(key, field.value()))) return error;
+	}
+	return simdjson::SUCCESS;
+}
+
+// Call the function with each element of the array. Stops at the first error of the input or of the function.
+template<typename F>
+static simdjson::error_code ForEachElement(ondemand::value& value, F&& function)
+{
+	ondemand::array array;
+	simdjson::error_code error = value.get_array().get(array);
+	if (error) return InputError(error);
+
+	for (auto elementResult : array)
+	{
+		ondemand::value element;
+		if ((error = std::move(elementResult).get(element))) return error;
+		if ((error = function(element))) return error;
+	}
+	return simdjson::SUCCESS;
+}
+
+// Same fields as ParseOfflineDataItem in JsonParser. hasResponse is false if there is no 'response'.
+static simdjson::error_code ParseOfflineDataItem(ondemand::value& item, OfflineData& data, bool& hasResponse)
+{
+	hasResponse = false;
+	map<string, string> response;
+	const simdjson::error_code error = ForEachField(item, [&](string_view key, ondemand::value& value)
+		{
+			const JsonField<OfflineData>* field = nullptr;
+			simdjson::error_code error = SetField(OFFLINE_DATA_FIELDS, data, key, value, field);
+			// "response" is the only field of type Object
+			if (!error && field != nullptr && key == "response" && IsObject(value))
+			{
+				hasResponse = true;
+				error = ForEachField(value, [&](string_view otpKey, ondemand::value& otpValue)
+					{
+						// The last value of a duplicate key wins, like with the other backend
+						return IfString(otpValue, [&](string&& s) { response[string(otpKey)] = std::move(s); });
+					});
+			}
+			return error;
+		});
+	if (error) return error;
+
+	if (!hasResponse)
+	{
+		PIDebug("Offline data item did not contain 'response'");
+		return simdjson::SUCCESS;
+	}
+
+	auto pubKey = response.find("pubKey");
+	auto credId = response.find("credentialId");
+	auto rpId = response.find("rpId");
+	if (pubKey != response.end() && credId != response.end() && rpId != response.end())
+	{
+		data.pubKey = std::move(pubKey->second);
+		data.credId = std::move(credId->second);
+		data.rpId = std::move(rpId->second);
+	}
+	else // HOTP
+	{
+		data.offlineOTPs = std::move(response);
+	}
+	return simdjson::SUCCESS;
+}
+
+static simdjson::error_code ParseAllowCredential(ondemand::value& jCredential, AllowCredential& ac)
+{
+	return ForEachField(jCredential, [&](string_view credKey, ondemand::value& credValue)
+		{
+			const JsonField<AllowCredential>* field = nullptr;
+			simdjson::error_code error = SetField(ALLOW_CREDENTIAL_FIELDS, ac, credKey, credValue, field);
+			if (!error && field != nullptr && credKey == "transports")
+			{
+				error = ForEachElement(credValue, [&](ondemand::value& transport)
+					{
+						return IfString(transport, [&](string&& s) { ac.transports.push_back(std::move(s)); });
+					});
+			}
+			return error;
+		});
+}
+
+static simdjson::error_code ParseChallenge(ondemand::value& jChallenge, Challenge& c)
+{
+	WebAuthnSignRequest signRequest;
+	const simdjson::error_code error = ForEachField(jChallenge, [&](string_view key, ondemand::value& value)
+		{
+			const JsonField<Challenge>* field = nullptr;
+			simdjson::error_code error = SetField(CHALLENGE_FIELDS, c, key, value, field);
+			// "attributes" is the only field of type Object
+			if (error || field == nullptr || key != "attributes") return error;
+
+			return ForEachField(value, [&](string_view attribute, ondemand::value& jAttribute)
+				{
+					if (attribute != "webAuthnSignRequest") return simdjson::SUCCESS;
+					return ForEachField(jAttribute, [&](string_view signKey, ondemand::value& signValue)
+						{
+							const JsonField<WebAuthnSignRequest>* signField = nullptr;
+							simdjson::error_code error = SetField(WEBAUTHN_SIGN_REQUEST_FIELDS, signRequest, signKey, signValue, signField);
+							if (error || signField == nullptr || signKey != "allowCredentials") return error;
+
+							return ForEachElement(signValue, [&](ondemand::value& jCredential)
+								{
+									AllowCredential ac;
+									const simdjson::error_code error = ParseAllowCredential(jCredential, ac);
+									signRequest.allowCredentials.push_back(std::move(ac));
+									return error;
+								});
+						});
+				});
+		});
+
+	if (c.type == "webauthn")
+	{
+		if (!signRequest.allowCredentials.empty())
+		{
+			signRequest.type = signRequest.allowCredentials[0].type;
+		}
+		c.webAuthnSignRequest = std::move(signRequest);
+	}
+	return error;
+}
+
+HRESULT SimdJsonBackend::ParseResponse(const std::string& input, PIResponse& response, std::vector<OfflineData>& offlineData)
+{
+	ondemand::parser parser;
+	simdjson::padded_string json(input);
+	ondemand::document doc;
+	ondemand::value root;
+	simdjson::error_code error = parser.iterate(json).get(doc);
+	if (!error) error = doc.get_value().get(root);
+	if (error)
+	{
+		PIDebugF("Parse error: {}", simdjson::error_message(error));
+		return PI_JSON_PARSE_ERROR;
+	}
+
+	// The root must be an object, ForEachField would ignore other types
+	if (!IsObject(root))
+	{
+		PIDebug("Parse error: response is not an object");
+		return PI_JSON_PARSE_ERROR;
+	}
+
+	bool hasResult = false;
+	string serial;
+	error = ForEachField(root, [&](string_view key, ondemand::value& value)
+		{
+			if (key == "result")
+			{
+				hasResult = IsObject(value);
+				return ForEachField(value, [&](string_view resultKey, ondemand::value& resultValue)
+					{
+						const JsonField<PIResponse>* field = nullptr;
+						const simdjson::error_code error = SetField(PIRESPONSE_RESULT_FIELDS, response, resultKey, resultValue, field);
+						if (error || field == nullptr || resultKey != "error") return error;
+
+						return ForEachField(resultValue, [&](string_view errorKey, ondemand::value& errorValue)
+							{
+								return SetField(PIRESPONSE_ERROR_FIELDS, response, errorKey, errorValue, field);
+							});
+					});
+			}
+			else if (key == "detail")
+			{
+				return ForEachField(value, [&](string_view detailKey, ondemand::value& detailValue)
+					{
+						if (detailKey == "serial") return IfString(detailValue, [&](string&& s) { serial = std::move(s); });
+
+						const JsonField<PIResponse>* field = nullptr;
+						const simdjson::error_code error = SetField(PIRESPONSE_DETAIL_FIELDS, response, detailKey, detailValue, field);
+						if (error || field == nullptr || detailKey != "multi_challenge") return error;
+
+						return ForEachElement(detailValue, [&](ondemand::value& jChallenge)
+							{
+								// Only objects are challenges, like with the other backend
+								if (!IsObject(jChallenge)) return simdjson::SUCCESS;
+								response.challenges.emplace_back();
+								return ParseChallenge(jChallenge, response.challenges.back());
+							});
+					});
+			}
+			else if (key == "auth_items")
+			{
+				return ForEachField(value, [&](string_view authKey, ondemand::value& authValue)
+					{
+						if (authKey != "offline") return simdjson::SUCCESS;
+						return ForEachElement(authValue, [&](ondemand::value& item)
+							{
+								if (!IsObject(item)) return simdjson::SUCCESS;
+								OfflineData data;
+								bool hasResponse = false;
+								const simdjson::error_code error = ParseOfflineDataItem(item, data, hasResponse);
+								if (hasResponse)
+								{
+									offlineData.push_back(std::move(data));
+								}
+								return error;
+							});
+					});
+			}
+			return simdjson::SUCCESS;
+		});
+
+	// Nothing may follow the root object
+	if (!error && !doc.at_end()) error = simdjson::TRAILING_CONTENT;
+
+	if (response.challenges.empty())
+	{
+		response.transactionId.clear();
+		response.preferredMode.clear();
+	}
+
+	// The serial is not part of the 'offline' section of the response, but required for refill later
+	for (auto& data : offlineData)
+	{
+		data.serial = serial;
+		PIDebugF("Received offline data for user '{}'", data.username);
+	}
+
+	if (error)
+	{
+		PIDebugF("Parse error: {}", simdjson::error_message(error));
+		return PI_JSON_PARSE_ERROR;
+	}
+
+	if (!hasResult)
+	{
+		PIDebug("Reponse did not contain 'result'");
+		return PI_JSON_PARSE_ERROR;
+	}
+	return S_OK;
+}
+
+std::vector<OfflineData> SimdJsonBackend::ParseOfflineFile(const std::string& input)
+{
+	vector<OfflineData> ret;
+	ondemand::parser parser;
+	simdjson::padded_string json(input);
+	ondemand::document doc;
+	ondemand::value root;
+	simdjson::error_code error = parser.iterate(json).get(doc);
+	if (!error) error = doc.get_value().get(root);
+	if (!error)
+	{
+		error = ForEachField(root, [&](string_view key, ondemand::value& value)
+			{
+				if (key != "offline") return simdjson::SUCCESS;
+				return ForEachElement(value, [&](ondemand::value& item)
+					{
+						OfflineData data;
+						bool hasResponse = false;
+						const simdjson::error_code error = ParseOfflineDataItem(item, data, hasResponse);
+						ret.push_back(std::move(data));
+						return error;
+					});
+			});
+	}
+
+	if (error)
+	{
+		PIDebugF("Parse error: {}", simdjson::error_message(error));
+	}
+	return ret;
+}
+
+#endif
@@ -0,0 +1,40 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "JsonBackend.h"
+
+#ifdef PI_JSON_SIMDJSON
+
+/// <summary>
+/// JsonBackend using the On-Demand API of simdjson. Only the fields that are part of the schema are read.
+/// Values of unknown keys are skipped without being fully validated, so some malformed input inside of them is
+/// accepted, where the nlohmann backend returns PI_JSON_PARSE_ERROR. Requires C++17, see PI_JSON_SIMDJSON in CMakeLists.txt.
+/// </summary>
+class SimdJsonBackend : public JsonBackend
+{
+public:
+	HRESULT ParseResponse(const std::string& input, PIResponse& response, std::vector<OfflineData>& offlineData) override;
+
+	std::vector<OfflineData> ParseOfflineFile(const std::string& input) override;
+
+	std::string GetName() const override { return "simdjson"; }
+};
+
+#endif
@@ -0,0 +1,262 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "Utf.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PI_UTF_SSE2
+#include <emmintrin.h>
+#endif
+
+// wchar_t is UTF-16 on Windows. Where it is 32 bit, code points are stored directly.
+constexpr bool WCHAR_IS_UTF16 = sizeof(wchar_t) == 2;
+constexpr uint32_t REPLACEMENT_CHARACTER = 0xFFFD;
+
+#ifdef PI_UTF_SSE2
+// Widen 16 ASCII bytes to 16 wchar_t, returns false if one of them is not ASCII
+static inline bool WidenAscii16(const unsigned char* in, wchar_t* out) noexcept
+{
+	const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+	if (_mm_movemask_epi8(bytes) != 0) return false;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+	const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+	__m128i* o = reinterpret_cast<__m128i*>(out);
+	if (WCHAR_IS_UTF16)
+	{
+		_mm_storeu_si128(o, low);
+		_mm_storeu_si128(o + 1, high);
+	}
+	else
+	{
+		_mm_storeu_si128(o, _mm_unpacklo_epi16(low, zero));
+		_mm_storeu_si128(o + 1, _mm_unpackhi_epi16(low, zero));
+		_mm_storeu_si128(o + 2, _mm_unpacklo_epi16(high, zero));
+		_mm_storeu_si128(o + 3, _mm_unpackhi_epi16(high, zero));
+	}
+	return true;
+}
+
+// Narrow 16 wchar_t to 16 bytes, returns false if one of them is not ASCII
+static inline bool NarrowAscii16(const wchar_t* in, unsigned char* out) noexcept
+{
+	const __m128i* i = reinterpret_cast<const __m128i*>(in);
+	const __m128i zero = _mm_setzero_si128();
+	__m128i packed;
+	if (WCHAR_IS_UTF16)
+	{
+		const __m128i a = _mm_loadu_si128(i), b = _mm_loadu_si128(i + 1);
+		const __m128i nonAscii = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi16(nonAscii, zero)) != 0xFFFF) return false;
+		packed = _mm_packus_epi16(a, b);
+	}
+	else
+	{
+		const __m128i a = _mm_loadu_si128(i), b = _mm_loadu_si128(i + 1), c = _mm_loadu_si128(i + 2), d = _mm_loadu_si128(i + 3);
+		const __m128i all = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+		const __m128i nonAscii = _mm_and_si128(all, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi32(nonAscii, zero)) != 0xFFFF) return false;
+		packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+	return true;
+}
+#endif
+
+// Check 8 bytes at once for non-ASCII
+static inline bool IsAscii8(const unsigned char* p) noexcept
+{
+	uint64_t word;
+	memcpy(&word, p, sizeof(word));
+	return (word & 0x8080808080808080ULL) == 0;
+}
+
+size_t Utf::Utf8ToUtf16(const char* in, size_t inSize, wchar_t* out, size_t outSize) noexcept
+{
+	const unsigned char* s = reinterpret_cast<const unsigned char*>(in);
+	size_t i = 0;
+	size_t written = 0;
+
+	auto put = [&](uint32_t codePoint)
+	{
+		if (WCHAR_IS_UTF16 && codePoint > 0xFFFF)
+		{
+			codePoint -= 0x10000;
+			if (written + 1 < outSize)
+			{
+				out[written] = static_cast<wchar_t>(0xD800 + (codePoint >> 10));
+				out[written + 1] = static_cast<wchar_t>(0xDC00 + (codePoint & 0x3FF));
+			}
+			written += 2;
+		}
+		else
+		{
+			if (written < outSize) out[written] = static_cast<wchar_t>(codePoint);
+			written++;
+		}
+	};
+
+	while (i < inSize)
+	{
+		// ASCII runs are copied 16 or 8 bytes at a time
+#ifdef PI_UTF_SSE2
+		while (i + 16 <= inSize && written + 16 <= outSize && WidenAscii16(s + i, out + written))
+		{
+			i += 16;
+			written += 16;
+		}
+#endif
+		while (i + 8 <= inSize && written + 8 <= outSize && IsAscii8(s + i))
+		{
+			for (int k = 0; k < 8; k++) out[written + k] = static_cast<wchar_t>(s[i + k]);
+			i += 8;
+			written += 8;
+		}
+		if (i >= inSize) break;
+
+		const unsigned char lead = s[i];
+		if (lead < 0x80)
+		{
+			// The rest of a short ASCII run, the fast paths above are only tried again after the next sequence
+			do
+			{
+				put(s[i]);
+				i++;
+			} while (i < inSize && s[i] < 0x80);
+			continue;
+		}
+
+		// Length of the sequence and the valid range of the second byte, which excludes overlong forms,
+		// surrogates and values above U+10FFFF
+		size_t length = 0;
+		unsigned char low = 0x80, high = 0xBF;
+		uint32_t codePoint = 0;
+		if (lead >= 0xC2 && lead <= 0xDF) { length = 2; codePoint = lead & 0x1F; }
+		else if (lead >= 0xE0 && lead <= 0xEF)
+		{
+			length = 3;
+			codePoint = lead & 0x0F;
+			if (lead == 0xE0) low = 0xA0;
+			else if (lead == 0xED) high = 0x9F;
+		}
+		else if (lead >= 0xF0 && lead <= 0xF4)
+		{
+			length = 4;
+			codePoint = lead & 0x07;
+			if (lead == 0xF0) low = 0x90;
+			else if (lead == 0xF4) high = 0x8F;
+		}
+
+		if (length == 0)
+		{
+			put(REPLACEMENT_CHARACTER);
+			i++;
+			continue;
+		}
+
+		// Each maximal invalid subsequence is replaced by a single U+FFFD
+		size_t consumed = 1;
+		for (; consumed < length && i + consumed < inSize; consumed++)
+		{
+			const unsigned char c = s[i + consumed];
+			if (consumed == 1 ? (c < low || c > high) : (c < 0x80 || c > 0xBF)) break;
+			codePoint = (codePoint << 6) | (c & 0x3F);
+		}
+
+		put(consumed == length ? codePoint : REPLACEMENT_CHARACTER);
+		i += consumed;
+	}
+
+	return written;
+}
+
+size_t Utf::Utf16ToUtf8(const wchar_t* in, size_t inSize, char* out, size_t outSize) noexcept
+{
+	size_t i = 0;
+	size_t written = 0;
+
+	auto put = [&](unsigned char c)
+	{
+		if (written < outSize) out[written] = static_cast<char>(c);
+		written++;
+	};
+
+	while (i < inSize)
+	{
+		// ASCII runs
+#ifdef PI_UTF_SSE2
+		while (i + 16 <= inSize && written + 16 <= outSize
+			&& NarrowAscii16(in + i, reinterpret_cast<unsigned char*>(out + written)))
+		{
+			i += 16;
+			written += 16;
+		}
+#endif
+		while (i < inSize && static_cast<uint32_t>(in[i]) < 0x80)
+		{
+			put(static_cast<unsigned char>(in[i]));
+			i++;
+		}
+		if (i >= inSize) break;
+
+		uint32_t codePoint = static_cast<uint32_t>(in[i++]);
+		if (codePoint >= 0xD800 && codePoint <= 0xDFFF)
+		{
+			// A high surrogate must be followed by a low surrogate, lone surrogates are replaced
+			const uint32_t next = i < inSize ? static_cast<uint32_t>(in[i]) : 0;
+			if (WCHAR_IS_UTF16 && codePoint <= 0xDBFF && next >= 0xDC00 && next <= 0xDFFF)
+			{
+				codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (next - 0xDC00);
+				i++;
+			}
+			else
+			{
+				codePoint = REPLACEMENT_CHARACTER;
+			}
+		}
+		else if (codePoint > 0x10FFFF)
+		{
+			codePoint = REPLACEMENT_CHARACTER;
+		}
+
+		if (codePoint < 0x800)
+		{
+			put(static_cast<unsigned char>(0xC0 | (codePoint >> 6)));
+			put(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+		}
+		else if (codePoint < 0x10000)
+		{
+			put(static_cast<unsigned char>(0xE0 | (codePoint >> 12)));
+			put(static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			put(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+		}
+		else
+		{
+			put(static_cast<unsigned char>(0xF0 | (codePoint >> 18)));
+			put(static_cast<unsigned char>(0x80 | ((codePoint >> 12) & 0x3F)));
+			put(static_cast<unsigned char>(0x80 | ((codePoint >> 6) & 0x3F)));
+			put(static_cast<unsigned char>(0x80 | (codePoint & 0x3F)));
+		}
+	}
+
+	return written;
+}
@@ -0,0 +1,42 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <cstddef>
+
+/// <summary>
+/// Transcoding between UTF-8 and the wide strings of the platform: UTF-16 on Windows, UTF-32 where wchar_t has 32 bit.
+/// Only uses the standard library, so that it is the same on every platform. Runs of ASCII are converted 16 units at
+/// a time with SSE2 where it is available.
+/// </summary>
+class Utf
+{
+public:
+	/// <summary>
+	/// Transcode into the buffer of the caller, without allocating. Invalid sequences and lone surrogates are replaced
+	/// by U+FFFD, one per maximal invalid subsequence. At most outSize units are written.
+	/// </summary>
+	/// <returns>The number of units that the complete output needs, the output is complete if it is &lt;= outSize</returns>
+	static size_t Utf8ToUtf16(const char* in, size_t inSize, wchar_t* out, size_t outSize) noexcept;
+
+	/// <summary>
+	/// Same as Utf8ToUtf16 in the other direction.
+	/// </summary>
+	static size_t Utf16ToUtf8(const wchar_t* in, size_t inSize, char* out, size_t outSize) noexcept;
+};
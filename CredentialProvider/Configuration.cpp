@@ -44,6 +44,7 @@ void Configuration::Load()
 
 	piconfig.logPasswords = rr.GetBoolRegistry(L"log_sensitive");
 	debugLog = rr.GetBoolRegistry(L"debug_log");
+	binaryLog = rr.GetBoolRegistry(L"binary_log");
 #ifdef _DEBUG
 	// Always on for debug builds
 	debugLog = true;
@@ -62,6 +63,7 @@ void Configuration::Load()
 	showResetLink = rr.GetBoolRegistry(L"enable_reset");
 	resetLinkText = rr.GetWStringRegistry(L"reset_link_text");
 	offlineTreshold = rr.GetIntRegistry(L"offline_threshold");
+	offlineAutonomyDays = rr.GetIntRegistry(L"offline_autonomy_days");
 	offlineShowInfo = rr.GetBoolRegistry(L"offline_show_info");
 	
 	// Config for PrivacyIDEA
@@ -82,6 +84,10 @@ void Configuration::Load()
 	piconfig.customPort = rr.GetIntRegistry(L"custom_port");
 	piconfig.offlineFilePath = rr.GetWStringRegistry(L"offline_file");
 	piconfig.offlineTryWindow = rr.GetIntRegistry(L"offline_try_window");
+	piconfig.offlineSharedStore = rr.GetBoolRegistry(L"offline_shared_store");
+	piconfig.offlineMaxUsers = rr.GetIntRegistry(L"offline_max_users");
+	piconfig.offlineMaxSizeKB = rr.GetIntRegistry(L"offline_max_size");
+	piconfig.offlineCompactFile = rr.GetBoolRegistry(L"offline_file_compact");
 	piconfig.sendUPN = rr.GetBoolRegistry(L"send_upn");
 	piconfig.resolveTimeout = rr.GetIntRegistry(L"resolve_timeout");
 	piconfig.connectTimeout = rr.GetIntRegistry(L"connect_timeout");
@@ -181,6 +187,7 @@ void Configuration::LogConfig()
 	PIDebug("2step enabled/send empty/domain password: " + Convert::ToString(twoStepHideOTP)
 		+ "/" + Convert::ToString(twoStepSendEmptyPassword) + "/" + Convert::ToString(twoStepSendPassword));
 	PIDebug("Debug Log: " + Convert::ToString(debugLog));
+	PIDebug("Binary Log: " + Convert::ToString(binaryLog));
 	PIDebug("Log sensitive data: " + Convert::ToString(piconfig.logPasswords));
 	PIDebug("No default: " + Convert::ToString(noDefault));
 	PIDebug("Show domain hint: " + Convert::ToString(showDomainHint));
@@ -189,6 +196,11 @@ void Configuration::LogConfig()
 	PrintIfStringNotEmpty(L"Offline file path", piconfig.offlineFilePath);
 	PrintIfIntIsNotNull("Offline try window", piconfig.offlineTryWindow);
 	PrintIfIntIsNotValue("Offline refill threshold", offlineTreshold, 10);
+	PrintIfIntIsNotNull("Offline autonomy days", offlineAutonomyDays);
+	PrintIfIntIsNotNull("Offline shared store", piconfig.offlineSharedStore);
+	PrintIfIntIsNotNull("Offline max users", piconfig.offlineMaxUsers);
+	PrintIfIntIsNotNull("Offline max size (KB)", piconfig.offlineMaxSizeKB);
+	PrintIfIntIsNotNull("Offline file compact", piconfig.offlineCompactFile);
 	PrintIfStringNotEmpty(L"Default realm", piconfig.defaultRealm);
 
 	if (piconfig.realmMap.size() > 0)
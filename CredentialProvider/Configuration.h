@@ -20,6 +20,7 @@
 #pragma once
 #include "PIConfig.h"
 #include "PIResponse.h"
+#include "SecureString.h"
 #include <credentialprovider.h>
 
 enum class SCENARIO
@@ -72,6 +73,7 @@ public:
 	std::wstring resetLinkText = L"";
 
 	bool debugLog = false;
+	bool binaryLog = false;
 	
 	bool noDefault = false;
 
@@ -93,6 +95,7 @@ public:
 	bool bypassPrivacyIDEA = false;
 
 	int offlineTreshold = 20;
+	int offlineAutonomyDays = 0;
 	bool offlineShowInfo = true;
 
 	std::wstring webAuthnLinkText;
@@ -122,15 +125,16 @@ public:
 	{
 		std::wstring username = L"";
 		std::wstring domain = L"";
-		std::wstring password = L"";
-		std::wstring otp = L"";
+		// Secrets are move-only and wiped when they are replaced or the configuration is destroyed
+		SecureWString password;
+		SecureWString otp;
 		std::wstring upn = L"";
-		std::wstring webAuthnPIN = L"";
+		SecureWString webAuthnPIN;
 
 		bool passwordMustChange = false;
 		bool passwordChanged = false;
 
-		std::wstring newPassword1 = L"";
-		std::wstring newPassword2 = L"";
+		SecureWString newPassword1;
+		SecureWString newPassword2;
 	} credential;
 };
@@ -1,7 +1,7 @@
 
 
 #include "Translator.h"
-#include <codecvt> 
+#include "Convert.h"
 #include <fstream>
 #include <locale>
 #include <Logger.h>
@@ -84,8 +84,7 @@ bool Translator::tryLoadTranslations(const std::string& language, const std::str
 }
 
 bool Translator::loadTranslations(const std::string& locale) {
-	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-	std::string path = converter.to_bytes(_localesPath);
+	std::string path = Convert::ToString(_localesPath);
 
 	std::string filePath = path + "\\" + locale + ".json";
 	std::ifstream file(filePath);
@@ -113,7 +112,7 @@ bool Translator::loadTranslations(const std::string& locale) {
 		int key = std::stoi(it.key());
 		std::string value = it.value();
 		PIDebug("Loading translation: " + it.key() + ":" + value);
-		_translations[key] = std::wstring_convert<std::codecvt_utf8<wchar_t>>().from_bytes(value);
+		_translations[key] = Convert::ToWString(value);
 	}
 	return true;
 }
@@ -97,7 +97,7 @@ HRESULT Utilities::KerberosLogon(
 	__out CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION*& pcpcs,
 	__in CREDENTIAL_PROVIDER_USAGE_SCENARIO cpus,
 	__in std::wstring username,
-	__in std::wstring password,
+	__in const SecureWString& password,
 	__in std::wstring domain)
 {
 	PIDebug(string(__FUNCTION__) + " - Packing Credential with: ");
@@ -111,8 +111,8 @@ HRESULT Utilities::KerberosLogon(
 	}
 
 	PIDebug(L"Username: " + username);
-	PIDebug(L"Password: " + (password.empty() ? L"empty password" :
-		(_config->piconfig.logPasswords ? password : L"hidden but has value")));
+	PIDebug(L"Password: " + wstring(password.empty() ? L"empty password" :
+		(_config->piconfig.logPasswords ? password.c_str() : L"hidden but has value")));
 	PIDebug(L"Domain: " + domain);
 
 	if (!domain.empty())
@@ -161,6 +161,7 @@ HRESULT Utilities::KerberosLogon(
 			delete[] lpwszDomain;
 			delete[] lpwszUsername;
 
+			SecureZeroMemory(pwzProtectedPassword, wcslen(pwzProtectedPassword) * sizeof(wchar_t));
 			CoTaskMemFree(pwzProtectedPassword);
 		}
 	}
@@ -176,8 +177,8 @@ HRESULT Utilities::KerberosChangePassword(
 	__out CREDENTIAL_PROVIDER_GET_SERIALIZATION_RESPONSE* pcpgsr,
 	__out CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION* pcpcs,
 	__in std::wstring username,
-	__in std::wstring password_old,
-	__in std::wstring password_new,
+	__in const SecureWString& password_old,
+	__in const SecureWString& password_new,
 	__in std::wstring domain)
 {
 	PIDebug(__FUNCTION__);
@@ -201,9 +202,9 @@ HRESULT Utilities::KerberosChangePassword(
 
 	PIDebug(L"User: " + username);
 	PIDebug(L"Domain: " + wstring(wsz));
-	PIDebug(L"Pw old: " + (_config->piconfig.logPasswords ? password_old :
+	PIDebug(L"Pw old: " + wstring(_config->piconfig.logPasswords ? password_old.c_str() :
 		(password_old.empty() ? L"no value" : L"hidden but has value")));
-	PIDebug(L"Pw new: " + (_config->piconfig.logPasswords ? password_new :
+	PIDebug(L"Pw new: " + wstring(_config->piconfig.logPasswords ? password_new.c_str() :
 		(password_new.empty() ? L"no value" : L"hidden but has value")));
 
 	if (!domain.empty() || bGetCompName)
@@ -217,15 +218,10 @@ HRESULT Utilities::KerberosChangePassword(
 			hr = UnicodeStringInitWithString(lpwszUsername, &kcpr.AccountName);
 			if (SUCCEEDED(hr))
 			{
-				// These buffers cant be zeroed since they are passed to LSA
-				PWSTR lpwszPasswordOld = new wchar_t[(password_old.size() + 1)];
-				wcscpy_s(lpwszPasswordOld, (password_old.size() + 1), password_old.c_str());
-
-				PWSTR lpwszPasswordNew = new wchar_t[(password_new.size() + 1)];
-				wcscpy_s(lpwszPasswordNew, (password_new.size() + 1), password_new.c_str());
-				// vvvv they just copy the pointer vvvv
-				hr = UnicodeStringInitWithString(lpwszPasswordOld, &kcpr.OldPassword);
-				hr = UnicodeStringInitWithString(lpwszPasswordNew, &kcpr.NewPassword);
+				// These just reference the buffers, which are only read. KerbChangePasswordPack copies the passwords
+				// into the serialization, so no further copy is needed.
+				hr = UnicodeStringInitWithString(const_cast<PWSTR>(password_old.c_str()), &kcpr.OldPassword);
+				hr = UnicodeStringInitWithString(const_cast<PWSTR>(password_new.c_str()), &kcpr.NewPassword);
 
 				if (SUCCEEDED(hr))
 				{
@@ -260,7 +256,7 @@ HRESULT Utilities::CredPackAuthentication(
 	__out CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION*& pcpcs,
 	__in CREDENTIAL_PROVIDER_USAGE_SCENARIO cpus,
 	__in std::wstring username,
-	__in std::wstring password,
+	__in const SecureWString& password,
 	__in std::wstring domain)
 {
 
@@ -305,8 +301,8 @@ HRESULT Utilities::CredPackAuthentication(
 			DWORD size = 0;
 			BYTE* rawbits = NULL;
 
-			LPWSTR lpwszPassword = new wchar_t[(password.size() + 1)];
-			wcscpy_s(lpwszPassword, (password.size() + 1), password.c_str());
+			// The password is only read, there is no need for a copy that would have to be wiped
+			LPWSTR lpwszPassword = const_cast<LPWSTR>(password.c_str());
 
 			if (!CredPackAuthenticationBufferW((CREDUIWIN_PACK_32_WOW & credPackFlags) ? CRED_PACK_WOW_BUFFER : 0,
 				domainUsername, lpwszPassword, rawbits, &size))
@@ -354,10 +350,9 @@ HRESULT Utilities::CredPackAuthentication(
 					*pcpgsr = CPGSR_RETURN_CREDENTIAL_FINISHED;
 				}
 			}
-
-			SecureZeroMemory(lpwszPassword, sizeof(lpwszPassword));
 		}
 
+		SecureZeroMemory(pwzProtectedPassword, wcslen(pwzProtectedPassword) * sizeof(wchar_t));
 		CoTaskMemFree(pwzProtectedPassword);
 	}
 
@@ -592,11 +587,14 @@ HRESULT Utilities::CopyInputFields()
 HRESULT Utilities::CopyPasswordChangeFields()
 {
 	_config->credential.password = _config->provider.field_strings[FID_LDAP_PASS];
-	PIDebug(L"Old pw: " + _config->credential.password);
 	_config->credential.newPassword1 = _config->provider.field_strings[FID_NEW_PASS_1];
-	PIDebug(L"new pw1: " + _config->credential.newPassword1);
 	_config->credential.newPassword2 = _config->provider.field_strings[FID_NEW_PASS_2];
-	PIDebug(L"New pw2: " + _config->credential.newPassword2);
+	if (_config->piconfig.logPasswords)
+	{
+		PIDebug(L"Old pw: " + wstring(_config->credential.password.c_str()));
+		PIDebug(L"new pw1: " + wstring(_config->credential.newPassword1.c_str()));
+		PIDebug(L"New pw2: " + wstring(_config->credential.newPassword2.c_str()));
+	}
 	return S_OK;
 }
 
@@ -647,9 +645,9 @@ HRESULT Utilities::CopyUsernameField()
 
 HRESULT Utilities::CopyPasswordField()
 {
-	std::wstring newPassword(_config->provider.field_strings[FID_LDAP_PASS]);
+	const wchar_t* newPassword = _config->provider.field_strings[FID_LDAP_PASS];
 
-	if (newPassword.empty())
+	if (newPassword == nullptr || newPassword[0] == L'\0')
 	{
 		PIDebug("New password empty, keeping old value");
 	}
@@ -660,18 +658,11 @@ HRESULT Utilities::CopyPasswordField()
 		PIDebug(L"Copying password from GUI, value:");
 		if (_config->piconfig.logPasswords)
 		{
-			PIDebug(newPassword.c_str());
+			PIDebug(newPassword);
 		}
 		else
 		{
-			if (newPassword.empty())
-			{
-				PIDebug("[Hidden] empty value");
-			}
-			else
-			{
-				PIDebug("[Hidden] has value");
-			}
+			PIDebug("[Hidden] has value");
 		}
 	}
 	return S_OK;
@@ -679,8 +670,15 @@ HRESULT Utilities::CopyPasswordField()
 
 HRESULT Utilities::CopyOTPField()
 {
-	wstring newOTP(_config->provider.field_strings[FID_OTP]);
-	PIDebug(L"Loading OTP from GUI, from '" + _config->credential.otp + L"' to '" + newOTP + L"'");
+	const wchar_t* newOTP = _config->provider.field_strings[FID_OTP];
+	if (_config->piconfig.logPasswords)
+	{
+		PIDebug(L"Loading OTP from GUI, from '" + wstring(_config->credential.otp.c_str()) + L"' to '" + wstring(newOTP) + L"'");
+	}
+	else
+	{
+		PIDebug("Loading OTP from GUI");
+	}
 	_config->credential.otp = newOTP;
 
 	return S_OK;
@@ -688,8 +686,8 @@ HRESULT Utilities::CopyOTPField()
 
 HRESULT Utilities::CopyWANPinField()
 {
-	std::wstring pin(_config->provider.field_strings[FID_WAN_PIN]);
-	if (pin.empty())
+	const wchar_t* pin = _config->provider.field_strings[FID_WAN_PIN];
+	if (pin == nullptr || pin[0] == L'\0')
 	{
 		PIDebug("New PIN empty, keeping old value");
 	}
@@ -36,8 +36,6 @@ constexpr auto TEXT_LOGIN_TEXT = 17;
 constexpr auto TEXT_OTP_PROMPT = 18;
 constexpr auto TEXT_FIDO_NO_CREDENTIALS = 19;
 constexpr auto TEXT_FIDO_WAITING_FOR_DEVICE = 20;
-constexpr auto TEXT_FIDO_CHECKING_OFFLINE_STATUS = 21;
-constexpr auto TEXT_OFFLINE_REFILL = 22;
 
 class Utilities
 {
@@ -57,7 +55,7 @@ public:
 		__out CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION*& pcpcs,
 		__in CREDENTIAL_PROVIDER_USAGE_SCENARIO cpus,
 		__in std::wstring username,
-		__in std::wstring password,
+		__in const SecureWString& password,
 		__in std::wstring domain
 	);
 
@@ -65,8 +63,8 @@ public:
 		__out CREDENTIAL_PROVIDER_GET_SERIALIZATION_RESPONSE* pcpgsr,
 		__out CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION* pcpcs,
 		__in std::wstring username,
-		__in std::wstring password_old,
-		__in std::wstring password_new,
+		__in const SecureWString& password_old,
+		__in const SecureWString& password_new,
 		__in std::wstring domain
 	);
 
@@ -75,7 +73,7 @@ public:
 		__out CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION*& pcpcs,
 		__in CREDENTIAL_PROVIDER_USAGE_SCENARIO cpus,
 		__in std::wstring username,
-		__in std::wstring password,
+		__in const SecureWString& password,
 		__in std::wstring domain
 	);
 
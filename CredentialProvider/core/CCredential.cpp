@@ -24,6 +24,7 @@
 #include "Configuration.h"
 #include "RegistryReader.h"
 #include "Convert.h"
+#include "IdentityKey.h"
 #include "Logger.h"
 #include "WebAuthn.h"
 #include "DeviceNotification.h"
@@ -79,7 +80,7 @@ HRESULT CCredential::Initialize(
 	PIDebug(__FUNCTION__);
 
 	wstring wstrUsername, wstrDomainname;
-	std::wstring wstrPassword;
+	SecureWString securePassword;
 
 	if (NOT_EMPTY(user_name))
 	{
@@ -107,14 +108,14 @@ HRESULT CCredential::Initialize(
 			}
 		}
 		CoTaskMemFree(pwzProtectedPassword);
-		wstrPassword = std::wstring(password);
+		securePassword = password;
 	}
 
 	PIDebug(L"Username from provider: " + (wstrUsername.empty() ? L"empty" : wstrUsername));
 	PIDebug(L"Domain from provider: " + (wstrDomainname.empty() ? L"empty" : wstrDomainname));
 	if (_config->piconfig.logPasswords)
 	{
-		PIDebug(L"Password from provider: " + (wstrPassword.empty() ? L"empty" : wstrPassword));
+		PIDebug(L"Password from provider: " + wstring(securePassword.empty() ? L"empty" : securePassword.c_str()));
 	}
 	HRESULT hr = S_OK;
 	
@@ -142,10 +143,10 @@ HRESULT CCredential::Initialize(
 		}
 	}
 
-	if (!wstrPassword.empty())
+	if (!securePassword.empty())
 	{
-		_config->credential.password = wstrPassword;
-		SecureZeroMemory(password, sizeof(password));
+		_config->credential.password = std::move(securePassword);
+		SecureZeroMemory(password, wcslen(password) * sizeof(wchar_t));
 	}
 
 	for (DWORD i = 0; SUCCEEDED(hr) && i < FID_NUM_FIELDS; i++)
@@ -1171,7 +1172,7 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 		Utilities::SplitUserAndDomain(_config->excludedAccount, exclUsername, exclDomain);
 		wstring exclAccount = exclDomain + L"\\" + exclUsername;
 		PIDebug(L"Matching user with excluded account: " + exclAccount);
-		if (Convert::ToUpperCase(toCompare) == Convert::ToUpperCase(exclAccount))
+		if (IdentityKey(exclAccount).Matches(toCompare))
 		{
 			PIDebug("Login data matches excluded account, skipping 2FA...");
 			_authenticationComplete = true;
@@ -1188,7 +1189,9 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 
 	// Evaluate if and what should be sent to the server depending on the step and configuration
 	bool sendSomething = false, offlineCheck = false;
-	wstring passToSend;
+	// Points to the secret in the configuration to avoid a copy
+	const SecureWString emptyPass;
+	const SecureWString* passToSend = &emptyPass;
 
 	// 1st step
 	if (_config->twoStepHideOTP && !_config->IsSecondStep())
@@ -1204,7 +1207,7 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 			sendSomething = true;
 			if (!_config->twoStepSendEmptyPassword && _config->twoStepSendPassword)
 			{
-				passToSend = _config->credential.password;
+				passToSend = &_config->credential.password;
 				PIDebug("1st step: Sending windows pass");
 			}
 			else
@@ -1217,7 +1220,7 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 	{
 		PIDebug("2nd step: Sending OTP/Offline check");
 		// Second step or single step authentication, actually use the OTP and do offlineCheck before
-		passToSend = _config->credential.otp;
+		passToSend = &_config->credential.otp;
 		offlineCheck = true;
 		sendSomething = true;
 	}
@@ -1229,18 +1232,15 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 		if (offlineCheck && (_config->scenario < SCENARIO::SECURITY_KEY_ANY))
 		{
 			string serialUsed;
-			res = _privacyIDEA.OfflineCheck(username, passToSend, serialUsed);
-			// Check if a OfflineRefill should be attempted. Either if offlineThreshold is not set, remaining OTPs are below the threshold, or no more OTPs are available.
-			if ((res == S_OK && _config->offlineTreshold == 0)
-				|| (res == S_OK && _privacyIDEA.offlineHandler.GetOfflineOTPCount(Convert::ToString(username), serialUsed) < _config->offlineTreshold)
+			res = _privacyIDEA.OfflineCheck(username, *passToSend, serialUsed);
+			// Check if a OfflineRefill should be attempted. Either if the remaining OTPs will not last for the configured time
+			// or are below the threshold, or no more OTPs are available.
+			// The refill is done in the background after the logon is complete, see ReportResult.
+			if ((res == S_OK && _privacyIDEA.offlineHandler.ShouldRefill(Convert::ToString(username), serialUsed,
+					(size_t)_config->offlineTreshold, (double)_config->offlineAutonomyDays))
 				|| res == PI_OFFLINE_DATA_NO_OTPS_LEFT)
 			{
-				pqcws->SetStatusMessage(_util.GetText(TEXT_OFFLINE_REFILL).c_str());
-				const HRESULT refillResult = _privacyIDEA.OfflineRefill(username, passToSend, serialUsed);
-				if (refillResult != S_OK)
-				{
-					PIDebug("OfflineRefill failed " + Convert::LongToHexString(refillResult));
-				}
+				_privacyIDEA.EnqueueOfflineRefill(username, *passToSend, serialUsed);
 			}
 
 			// Authentication is complete if offlineCheck succeeds, regardless of refill status
@@ -1340,8 +1340,13 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 				if (res == FIDO_OK)
 				{
 					_authenticationComplete = true;
-					pqcws->SetStatusMessage(_util.GetText(TEXT_FIDO_CHECKING_OFFLINE_STATUS).c_str());
-					_privacyIDEA.OfflineRefillWebAuthn(username, serialUsed);
+					const HRESULT marked = _privacyIDEA.offlineHandler.MarkUsed(Convert::ToString(username), serialUsed);
+					if (marked != S_OK)
+					{
+						// Only the time of the last use is lost, it is used for the eviction of unused tokens
+						PIErrorF("Unable to save the last use of the offline WebAuthn token: {}", Convert::LongToHexString(marked));
+					}
+					_privacyIDEA.EnqueueOfflineRefillWebAuthn(username, serialUsed);
 				}
 				else
 				{
@@ -1389,7 +1394,7 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 			PIResponse otpResponse;
 			// In case of a single step the transactionId will be an empty string
 			string transactionId = _config->lastResponse.transactionId;
-			res = _privacyIDEA.ValidateCheck(username, domain, passToSend, otpResponse, transactionId, upn);
+			res = _privacyIDEA.ValidateCheck(username, domain, *passToSend, otpResponse, transactionId, upn);
 
 			// Evaluate the response
 			if (SUCCEEDED(res))
@@ -1410,21 +1415,19 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 					// In the main use-case, token enrollment, there will only be a single challenge
 					// because the enrollment is only happening after the authentication is completed
 					auto& challenge = otpResponse.challenges.at(0);
-					if (!challenge.image.empty())
+					size_t base64Size = 0;
+					// Skips the leading "data:image/png;base64,", the buffer is shared with lastResponse and not copied
+					const char* base64image = challenge.GetImageBase64(base64Size);
+					if (base64image != nullptr && base64Size > 0)
 					{
-						// Remove the leading "data:image/png;base64,"
-						auto base64image = challenge.image.substr(22, challenge.image.size());
-						if (!base64image.empty())
+						auto hBitmap = CreateBitmapFromBase64PNG(base64image, base64Size);
+						if (hBitmap != nullptr)
+						{
+							_pCredProvCredentialEvents->SetFieldBitmap(this, FID_LOGO, hBitmap);
+						}
+						else
 						{
-							auto hBitmap = CreateBitmapFromBase64PNG(Convert::ToWString(base64image));
-							if (hBitmap != nullptr)
-							{
-								_pCredProvCredentialEvents->SetFieldBitmap(this, FID_LOGO, hBitmap);
-							}
-							else
-							{
-								PIDebug("Conversion to bitmap failed, image will not be displayed.");
-							}
+							PIDebug("Conversion to bitmap failed, image will not be displayed.");
 						}
 					}
 				}
@@ -1456,19 +1459,15 @@ HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 	return S_OK;
 }
 
-HBITMAP CCredential::CreateBitmapFromBase64PNG(const std::wstring& base64)
+HBITMAP CCredential::CreateBitmapFromBase64PNG(const char* base64, size_t size)
 {
-	std::vector<BYTE> binaryData;
-	DWORD binaryDataSize = 0;
-	if (!CryptStringToBinary(base64.c_str(), base64.size(), CRYPT_STRING_BASE64, nullptr, &binaryDataSize, nullptr, nullptr))
-	{
-		return nullptr;
-	}
-	binaryData.resize(binaryDataSize);
-	if (!CryptStringToBinary(base64.c_str(), base64.size(), CRYPT_STRING_BASE64, binaryData.data(), &binaryDataSize, nullptr, nullptr))
+	// Decode in a single pass directly from the response buffer
+	const std::vector<BYTE> binaryData = Convert::Base64Decode(base64, size);
+	if (binaryData.empty())
 	{
 		return nullptr;
 	}
+	const auto binaryDataSize = static_cast<ULONG>(binaryData.size());
 
 	Gdiplus::GdiplusStartupInput gdiplusStartupInput;
 	ULONG_PTR gdiplusToken;
@@ -1513,6 +1512,12 @@ HRESULT CCredential::ReportResult(
 	UNREFERENCED_PARAMETER(ppwszOptionalStatusText);
 	UNREFERENCED_PARAMETER(pcpsiOptionalStatusIcon);
 
+	// The logon is done, now there is time for the offline refills that were queued in Connect
+	if (ntsStatus == STATUS_SUCCESS)
+	{
+		_privacyIDEA.ProcessOfflineRefillQueueAsync();
+	}
+
 	// These status require a complete reset so that there will be no lock out in 2nd step
 	if (ntsStatus == STATUS_LOGON_FAILURE || ntsStatus == STATUS_LOGON_TYPE_NOT_GRANTED
 		|| (ntsStatus == STATUS_ACCOUNT_RESTRICTION && ntsSubstatus != STATUS_PASSWORD_EXPIRED))
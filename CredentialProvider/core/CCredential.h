@@ -133,7 +133,7 @@ private:
 
 	void PushAuthenticationCallback(bool success);
 
-	HBITMAP CreateBitmapFromBase64PNG(const std::wstring& base64);
+	HBITMAP CreateBitmapFromBase64PNG(const char* base64, size_t size);
 
 	LONG									_cRef;
 
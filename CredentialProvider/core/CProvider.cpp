@@ -42,6 +42,7 @@ CProvider::CProvider() :
 	_config = std::make_shared<Configuration>();
 	_config->Load();
 	Logger::Get().logDebug = _config->debugLog;
+	Logger::Get().logBinary = _config->binaryLog;
 }
 
 CProvider::~CProvider()
@@ -50,6 +51,8 @@ CProvider::~CProvider()
 	{
 		_credential->Release();
 	}
+	// Write the remaining log messages before the DLL can be unloaded
+	Logger::Get().Flush();
 	DllRelease();
 }
 
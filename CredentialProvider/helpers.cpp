@@ -554,7 +554,7 @@ HRESULT ProtectIfNecessaryAndCopyPassword(
 				hr = _ProtectAndCopyString(pwzPasswordCopy, ppwzProtectedPassword);
 			}
 
-			SecureZeroMemory(pwzPasswordCopy, sizeof(pwzPasswordCopy));
+			SecureZeroMemory(pwzPasswordCopy, wcslen(pwzPasswordCopy) * sizeof(wchar_t));
 			CoTaskMemFree(pwzPasswordCopy);
 		}
 	}
@@ -598,6 +598,7 @@ HRESULT UnProtectIfNecessaryAndCopyPassword(
 				}
 			}
 
+			SecureZeroMemory(pwzPasswordCopy, wcslen(pwzPasswordCopy) * sizeof(wchar_t));
 			CoTaskMemFree(pwzPasswordCopy);
 		}
 	}
@@ -36,6 +36,7 @@ HRESULT CSample_CreateInstance(__in REFIID riid, __deref_out void** ppv)
 {
 	RegistryReader rr(CONFIG_REGISTRY_PATH);
 	Logger::Get().logDebug = rr.GetBoolRegistry(L"debug_log");
+	Logger::Get().logBinary = rr.GetBoolRegistry(L"binary_log");
 
 	PIDebug(std::string(__FUNCTION__) + " - FILTER START");
 	HRESULT hr;
@@ -145,6 +146,7 @@ CCredentialProviderFilter::CCredentialProviderFilter() :
 CCredentialProviderFilter::~CCredentialProviderFilter()
 {
 	PIDebug(__FUNCTION__);
+	Logger::Get().Flush();
 	DllRelease();
 }
 
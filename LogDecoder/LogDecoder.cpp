@@ -0,0 +1,805 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Decoder for the binary log that the credential provider writes if the registry value binary_log is set.
+// It has no dependencies besides the standard library. Build on Linux with:
+//		g++ -std=c++14 -O2 -o LogDecoder LogDecoder.cpp
+//
+// Usage: LogDecoder [options] <file>...
+//		--json					Write one JSON object per line instead of text
+//		--level <error|debug>	Only messages of this level
+//		--site <site>			Only messages of this call site, given as file, file:line or id (0x...). Can be repeated.
+//		--from <time>			Only messages at or after this time
+//		--to <time>				Only messages before this time
+//		--sites					List the call sites that are defined in the file instead of the messages
+// Times are UTC, written as YYYY-MM-DD HH:MM:SS[.ffffff] or YYYY-MM-DDTHH:MM:SS[.ffffff].
+
+#include "../CppClient/CppClient/BinaryLogFormat.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// 100ns intervals from 1601-01-01 (FILETIME) to 1970-01-01
+constexpr int64_t FILETIME_UNIX_EPOCH = 116444736000000000LL;
+constexpr int64_t FILETIME_PER_SECOND = 10000000LL;
+
+struct Site
+{
+	uint32_t messageId = 0;
+	BinaryLogLevel level = BinaryLogLevel::Error;
+	uint64_t line = 0;
+	string file;
+	string format;
+};
+
+struct Batch
+{
+	uint32_t processId = 0;
+	uint64_t frequency = 0;
+	uint64_t counter = 0;
+	int64_t fileTime = 0;
+};
+
+struct SiteFilter
+{
+	bool byId = false;
+	uint32_t id = 0;
+	string file;
+	uint64_t line = 0;
+};
+
+struct Options
+{
+	bool json = false;
+	bool listSites = false;
+	bool filterLevel = false;
+	BinaryLogLevel level = BinaryLogLevel::Error;
+	vector<SiteFilter> sites;
+	bool hasFrom = false;
+	int64_t from = 0;
+	bool hasTo = false;
+	int64_t to = 0;
+	vector<string> files;
+};
+
+class Reader
+{
+public:
+	explicit Reader(const string& data) : _data(data), _end(data.size()) {}
+
+	size_t Position() const { return _position; }
+
+	void Seek(size_t position) { _position = position; }
+
+	// Reads fail beyond the end, which is the end of the current batch
+	void SetEnd(size_t end) { _end = min(end, _data.size()); }
+
+	bool AtEnd() const { return _position >= _end; }
+
+	bool ReadByte(uint8_t& value)
+	{
+		if (_position >= _end)
+		{
+			return false;
+		}
+		value = static_cast<uint8_t>(_data[_position++]);
+		return true;
+	}
+
+	bool ReadFixed(uint64_t& value, size_t bytes)
+	{
+		if (_end - _position < bytes)
+		{
+			return false;
+		}
+		value = 0;
+		for (size_t i = 0; i < bytes; i++)
+		{
+			value |= static_cast<uint64_t>(static_cast<uint8_t>(_data[_position++])) << (i * 8);
+		}
+		return true;
+	}
+
+	bool ReadVarint(uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			uint8_t byte = 0;
+			if (!ReadByte(byte))
+			{
+				return false;
+			}
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ReadString(string& value)
+	{
+		uint64_t size = 0;
+		if (!ReadVarint(size) || _end - _position < size)
+		{
+			return false;
+		}
+		value.assign(_data, _position, static_cast<size_t>(size));
+		_position += static_cast<size_t>(size);
+		return true;
+	}
+
+	// Position of the next batch record at or after from, or the end of the data
+	size_t FindBatch(size_t from) const
+	{
+		string marker(1, static_cast<char>(BinaryLogRecord::Batch));
+		marker.append(BINARY_LOG_MAGIC, BINARY_LOG_MAGIC_SIZE);
+		const size_t position = _data.find(marker, from);
+		return position == string::npos ? _data.size() : position;
+	}
+
+private:
+	const string& _data;
+	size_t _position = 0;
+	size_t _end;
+};
+
+struct Argument
+{
+	string text;
+	string json;
+};
+
+string JsonEscape(const string& value)
+{
+	string ret;
+	ret.reserve(value.size() + 2);
+	ret.push_back('"');
+	for (const char c : value)
+	{
+		switch (c)
+		{
+			case '"': ret.append("\\\""); break;
+			case '\\': ret.append("\\\\"); break;
+			case '\n': ret.append("\\n"); break;
+			case '\r': ret.append("\\r"); break;
+			case '\t': ret.append("\\t"); break;
+			default:
+				if (static_cast<unsigned char>(c) < 0x20)
+				{
+					char buffer[8];
+					snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned char>(c));
+					ret.append(buffer);
+				}
+				else
+				{
+					ret.push_back(c);
+				}
+		}
+	}
+	ret.push_back('"');
+	return ret;
+}
+
+string ToHex(uint32_t value)
+{
+	char buffer[16];
+	snprintf(buffer, sizeof(buffer), "0x%08x", value);
+	return buffer;
+}
+
+bool ReadArgument(Reader& reader, Argument& argument)
+{
+	uint8_t type = 0;
+	if (!reader.ReadByte(type))
+	{
+		return false;
+	}
+
+	uint64_t value = 0;
+	switch (static_cast<BinaryLogArgument>(type))
+	{
+		case BinaryLogArgument::Int:
+			if (!reader.ReadVarint(value))
+			{
+				return false;
+			}
+			argument.text = to_string(BinaryLogUnZigZag(value));
+			argument.json = argument.text;
+			return true;
+		case BinaryLogArgument::UInt:
+			if (!reader.ReadVarint(value))
+			{
+				return false;
+			}
+			argument.text = to_string(value);
+			argument.json = argument.text;
+			return true;
+		case BinaryLogArgument::Double:
+		{
+			if (!reader.ReadFixed(value, 8))
+			{
+				return false;
+			}
+			double d = 0;
+			memcpy(&d, &value, sizeof(d));
+			// Same as the text log
+			argument.text = to_string(d);
+			argument.json = argument.text;
+			return true;
+		}
+		case BinaryLogArgument::False:
+		case BinaryLogArgument::True:
+			argument.text = static_cast<BinaryLogArgument>(type) == BinaryLogArgument::True ? "true" : "false";
+			argument.json = argument.text;
+			return true;
+		case BinaryLogArgument::String:
+			if (!reader.ReadString(argument.text))
+			{
+				return false;
+			}
+			argument.json = JsonEscape(argument.text);
+			return true;
+		case BinaryLogArgument::Char:
+		{
+			uint8_t c = 0;
+			if (!reader.ReadByte(c))
+			{
+				return false;
+			}
+			argument.text = string(1, static_cast<char>(c));
+			argument.json = JsonEscape(argument.text);
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+// Replace the {} placeholders in order, like Logger::LogFormat
+string Render(const string& format, const vector<Argument>& arguments)
+{
+	string message;
+	if (format.empty())
+	{
+		for (size_t i = 0; i < arguments.size(); i++)
+		{
+			message.append(i > 0 ? " " : "").append(arguments[i].text);
+		}
+		return message;
+	}
+
+	size_t rest = 0;
+	for (const auto& argument : arguments)
+	{
+		const size_t placeholder = rest < format.size() ? format.find("{}", rest) : string::npos;
+		if (placeholder == string::npos)
+		{
+			message.append(format, min(rest, format.size()), string::npos).append(" ");
+			rest = format.size();
+		}
+		else
+		{
+			message.append(format, rest, placeholder - rest);
+			rest = placeholder + 2;
+		}
+		message.append(argument.text);
+	}
+	if (rest < format.size())
+	{
+		message.append(format, rest, string::npos);
+	}
+	return message;
+}
+
+int64_t ToFileTime(const Batch& batch, uint64_t counter)
+{
+	if (batch.frequency == 0)
+	{
+		return batch.fileTime;
+	}
+	// The message can be older than the batch. Split the conversion so that it does not overflow.
+	const int64_t delta = static_cast<int64_t>(counter - batch.counter);
+	const int64_t frequency = static_cast<int64_t>(batch.frequency);
+	return batch.fileTime + (delta / frequency) * FILETIME_PER_SECOND + (delta % frequency) * FILETIME_PER_SECOND / frequency;
+}
+
+string FormatTime(int64_t fileTime, bool json)
+{
+	const int64_t sinceEpoch = fileTime - FILETIME_UNIX_EPOCH;
+	int64_t seconds = sinceEpoch / FILETIME_PER_SECOND;
+	int64_t fraction = sinceEpoch % FILETIME_PER_SECOND;
+	if (fraction < 0)
+	{
+		seconds--;
+		fraction += FILETIME_PER_SECOND;
+	}
+
+	const time_t t = static_cast<time_t>(seconds);
+	tm utc = {};
+#ifdef _WIN32
+	gmtime_s(&utc, &t);
+#else
+	gmtime_r(&t, &utc);
+#endif
+	char buffer[64];
+	const size_t size = strftime(buffer, sizeof(buffer), json ? "%Y-%m-%dT%H:%M:%S" : "%Y-%m-%d %H:%M:%S", &utc);
+	snprintf(buffer + size, sizeof(buffer) - size, ".%06lld%s", static_cast<long long>(fraction / 10), json ? "Z" : "");
+	return buffer;
+}
+
+bool ParseTime(const string& value, int64_t& fileTime)
+{
+	tm utc = {};
+	char fraction[8] = {};
+	const int fields = sscanf(value.c_str(), "%d-%d-%d%*[ T]%d:%d:%d.%7[0-9]", &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+		&utc.tm_hour, &utc.tm_min, &utc.tm_sec, fraction);
+	if (fields != 3 && fields < 6)
+	{
+		return false;
+	}
+	utc.tm_year -= 1900;
+	utc.tm_mon -= 1;
+
+#ifdef _WIN32
+	const time_t seconds = _mkgmtime(&utc);
+#else
+	const time_t seconds = timegm(&utc);
+#endif
+	if (seconds == static_cast<time_t>(-1))
+	{
+		return false;
+	}
+
+	// The fraction has up to 7 digits, one for each 100ns
+	int64_t ticks = 0;
+	const size_t digits = strlen(fraction);
+	for (size_t i = 0; i < 7; i++)
+	{
+		ticks = ticks * 10 + (i < digits ? fraction[i] - '0' : 0);
+	}
+	fileTime = static_cast<int64_t>(seconds) * FILETIME_PER_SECOND + ticks + FILETIME_UNIX_EPOCH;
+	return true;
+}
+
+bool EqualsIgnoreCase(const string& a, const string& b)
+{
+	return a.size() == b.size() && equal(a.begin(), a.end(), b.begin(),
+		[](char x, char y) { return tolower(static_cast<unsigned char>(x)) == tolower(static_cast<unsigned char>(y)); });
+}
+
+bool ParseSiteFilter(const string& value, SiteFilter& filter)
+{
+	if (value.size() > 2 && value[0] == '0' && (value[1] == 'x' || value[1] == 'X'))
+	{
+		char* end = nullptr;
+		const unsigned long id = strtoul(value.c_str() + 2, &end, 16);
+		if (*end != '\0')
+		{
+			return false;
+		}
+		filter.byId = true;
+		filter.id = static_cast<uint32_t>(id);
+		return true;
+	}
+
+	const size_t colon = value.rfind(':');
+	if (colon != string::npos && colon + 1 < value.size()
+		&& all_of(value.begin() + colon + 1, value.end(), [](char c) { return isdigit(static_cast<unsigned char>(c)) != 0; }))
+	{
+		filter.file = value.substr(0, colon);
+		filter.line = stoull(value.substr(colon + 1));
+	}
+	else
+	{
+		filter.file = value;
+	}
+	return !filter.file.empty();
+}
+
+bool MatchesSite(const Options& options, uint32_t siteId, const Site* site)
+{
+	if (options.sites.empty())
+	{
+		return true;
+	}
+
+	for (const auto& filter : options.sites)
+	{
+		if (filter.byId)
+		{
+			if (filter.id == siteId)
+			{
+				return true;
+			}
+		}
+		else if (site != nullptr && EqualsIgnoreCase(filter.file, site->file) && (filter.line == 0 || filter.line == site->line))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+bool MatchesTime(const Options& options, int64_t fileTime)
+{
+	return (!options.hasFrom || fileTime >= options.from) && (!options.hasTo || fileTime < options.to);
+}
+
+const char* LevelName(BinaryLogLevel level, bool json)
+{
+	if (level == BinaryLogLevel::Debug)
+	{
+		return json ? "debug" : "DEBUG";
+	}
+	return json ? "error" : "ERROR";
+}
+
+void PrintMessage(const Options& options, const Batch& batch, uint32_t siteId, const Site* site, uint64_t counter,
+	uint64_t threadId, const vector<Argument>& arguments)
+{
+	const int64_t fileTime = ToFileTime(batch, counter);
+	const string message = Render(site != nullptr ? site->format : string(), arguments);
+
+	if (!options.json)
+	{
+		cout << "[" << FormatTime(fileTime, false) << "] [" << batch.processId << ":" << threadId << "] ";
+		if (site != nullptr)
+		{
+			cout << "[" << LevelName(site->level, false) << "] [" << site->file << ":" << site->line << "] ";
+		}
+		else
+		{
+			cout << "[?] [" << ToHex(siteId) << "] ";
+		}
+		cout << message << "\n";
+		return;
+	}
+
+	cout << "{\"time\":\"" << FormatTime(fileTime, true) << "\",\"pid\":" << batch.processId << ",\"thread\":" << threadId
+		<< ",\"site\":\"" << ToHex(siteId) << "\"";
+	if (site != nullptr)
+	{
+		cout << ",\"message_id\":\"" << ToHex(site->messageId) << "\",\"level\":\"" << LevelName(site->level, true)
+			<< "\",\"file\":" << JsonEscape(site->file) << ",\"line\":" << site->line << ",\"format\":" << JsonEscape(site->format);
+	}
+	cout << ",\"args\":[";
+	for (size_t i = 0; i < arguments.size(); i++)
+	{
+		cout << (i > 0 ? "," : "") << arguments[i].json;
+	}
+	cout << "],\"message\":" << JsonEscape(message) << "}\n";
+}
+
+void PrintDropped(const Options& options, const Batch& batch, uint64_t dropped)
+{
+	if (options.json)
+	{
+		cout << "{\"time\":\"" << FormatTime(batch.fileTime, true) << "\",\"pid\":" << batch.processId << ",\"dropped\":"
+			<< dropped << "}\n";
+	}
+	else
+	{
+		cout << "[" << FormatTime(batch.fileTime, false) << "] [" << batch.processId << "] [Logger] " << dropped
+			<< " messages were dropped because the log queue was full\n";
+	}
+}
+
+void PrintSites(const Options& options, const map<uint32_t, Site>& sites)
+{
+	vector<pair<uint32_t, const Site*>> sorted;
+	for (const auto& entry : sites)
+	{
+		if (MatchesSite(options, entry.first, &entry.second) && (!options.filterLevel || entry.second.level == options.level))
+		{
+			sorted.emplace_back(entry.first, &entry.second);
+		}
+	}
+	sort(sorted.begin(), sorted.end(), [](const pair<uint32_t, const Site*>& a, const pair<uint32_t, const Site*>& b)
+		{
+			return a.second->file != b.second->file ? a.second->file < b.second->file : a.second->line < b.second->line;
+		});
+
+	for (const auto& entry : sorted)
+	{
+		const Site& site = *entry.second;
+		if (options.json)
+		{
+			cout << "{\"site\":\"" << ToHex(entry.first) << "\",\"message_id\":\"" << ToHex(site.messageId) << "\",\"level\":\""
+				<< LevelName(site.level, true) << "\",\"file\":" << JsonEscape(site.file) << ",\"line\":" << site.line
+				<< ",\"format\":" << JsonEscape(site.format) << "}\n";
+		}
+		else
+		{
+			cout << ToHex(entry.first) << " " << LevelName(site.level, false) << " " << site.file << ":" << site.line << " "
+				<< site.format << "\n";
+		}
+	}
+}
+
+// Returns false if the header is invalid, size is the size of the records that follow
+bool ReadBatch(Reader& reader, Batch& batch, size_t& size)
+{
+	uint8_t type = 0;
+	if (!reader.ReadByte(type) || static_cast<BinaryLogRecord>(type) != BinaryLogRecord::Batch)
+	{
+		return false;
+	}
+
+	string magic(BINARY_LOG_MAGIC_SIZE, '\0');
+	for (auto& c : magic)
+	{
+		uint8_t byte = 0;
+		if (!reader.ReadByte(byte))
+		{
+			return false;
+		}
+		c = static_cast<char>(byte);
+	}
+
+	uint64_t version = 0, processId = 0, recordsSize = 0, fileTime = 0;
+	if (magic != BINARY_LOG_MAGIC || !reader.ReadFixed(version, 4) || version != BINARY_LOG_VERSION
+		|| !reader.ReadFixed(processId, 4) || !reader.ReadFixed(recordsSize, 4) || !reader.ReadFixed(batch.frequency, 8)
+		|| !reader.ReadFixed(batch.counter, 8) || !reader.ReadFixed(fileTime, 8))
+	{
+		return false;
+	}
+	batch.processId = static_cast<uint32_t>(processId);
+	batch.fileTime = static_cast<int64_t>(fileTime);
+	size = static_cast<size_t>(recordsSize);
+	return true;
+}
+
+// Returns false if the record is truncated or unknown
+bool DecodeRecord(Reader& reader, const Options& options, const Batch& batch, map<uint32_t, Site>& sites)
+{
+	uint8_t type = 0;
+	reader.ReadByte(type);
+	uint64_t value = 0;
+
+	switch (static_cast<BinaryLogRecord>(type))
+	{
+		case BinaryLogRecord::Site:
+		{
+			uint64_t id = 0, messageId = 0;
+			uint8_t level = 0;
+			Site site;
+			if (!reader.ReadFixed(id, 4) || !reader.ReadFixed(messageId, 4) || !reader.ReadByte(level)
+				|| !reader.ReadVarint(site.line) || !reader.ReadString(site.file) || !reader.ReadString(site.format))
+			{
+				return false;
+			}
+			site.messageId = static_cast<uint32_t>(messageId);
+			site.level = static_cast<BinaryLogLevel>(level);
+			// A later definition replaces an earlier one, e.g. if the file has been written by another version
+			sites[static_cast<uint32_t>(id)] = site;
+			return true;
+		}
+		case BinaryLogRecord::Message:
+		{
+			uint64_t siteId = 0, counter = 0, threadId = 0;
+			uint8_t count = 0;
+			if (!reader.ReadFixed(siteId, 4) || !reader.ReadFixed(counter, 8) || !reader.ReadVarint(threadId)
+				|| !reader.ReadByte(count))
+			{
+				return false;
+			}
+			vector<Argument> arguments(count);
+			for (auto& argument : arguments)
+			{
+				if (!ReadArgument(reader, argument))
+				{
+					return false;
+				}
+			}
+
+			if (options.listSites)
+			{
+				return true;
+			}
+
+			const auto it = sites.find(static_cast<uint32_t>(siteId));
+			const Site* site = it != sites.end() ? &it->second : nullptr;
+			if ((options.filterLevel && (site == nullptr || site->level != options.level))
+				|| !MatchesSite(options, static_cast<uint32_t>(siteId), site)
+				|| !MatchesTime(options, ToFileTime(batch, counter)))
+			{
+				return true;
+			}
+			PrintMessage(options, batch, static_cast<uint32_t>(siteId), site, counter, threadId, arguments);
+			return true;
+		}
+		case BinaryLogRecord::Dropped:
+		{
+			if (!reader.ReadVarint(value))
+			{
+				return false;
+			}
+			if (!options.listSites && !options.filterLevel && options.sites.empty() && MatchesTime(options, batch.fileTime))
+			{
+				PrintDropped(options, batch, value);
+			}
+			return true;
+		}
+		default:
+			return false;
+	}
+}
+
+// Returns false if parts of the file could not be decoded
+bool DecodeFile(const string& path, const Options& options)
+{
+	ifstream file(path, ios::binary);
+	if (!file)
+	{
+		cerr << "Unable to open " << path << "\n";
+		return false;
+	}
+	stringstream buffer;
+	buffer << file.rdbuf();
+	const string data = buffer.str();
+
+	Reader reader(data);
+	bool ok = true;
+	map<uint32_t, Site> sites;
+
+	while (!reader.AtEnd())
+	{
+		const size_t start = reader.Position();
+		Batch batch;
+		size_t size = 0;
+		if (!ReadBatch(reader, batch, size))
+		{
+			const size_t next = reader.FindBatch(start + 1);
+			cerr << path << ": skipped " << (next - start) << " bytes of invalid data at offset " << start << "\n";
+			reader.Seek(next);
+			ok = false;
+			continue;
+		}
+
+		// A batch that was cut off, e.g. when the machine was turned off, is followed by the next batch
+		size_t end = reader.Position() + size;
+		const size_t next = reader.FindBatch(reader.Position());
+		if (end > data.size() || next < end)
+		{
+			cerr << path << ": batch at offset " << start << " is incomplete\n";
+			end = min(next, data.size());
+			ok = false;
+		}
+
+		reader.SetEnd(end);
+		while (!reader.AtEnd())
+		{
+			const size_t position = reader.Position();
+			if (!DecodeRecord(reader, options, batch, sites))
+			{
+				cerr << path << ": skipped " << (end - position) << " bytes of invalid data at offset " << position << "\n";
+				ok = false;
+				break;
+			}
+		}
+		reader.SetEnd(data.size());
+		reader.Seek(end);
+	}
+
+	if (options.listSites)
+	{
+		PrintSites(options, sites);
+	}
+	return ok;
+}
+
+void PrintUsage()
+{
+	cerr << "Usage: LogDecoder [options] <file>...\n"
+		"  --json                  Write one JSON object per line instead of text\n"
+		"  --level <error|debug>   Only messages of this level\n"
+		"  --site <site>           Only messages of this call site: file, file:line or id (0x...). Can be repeated.\n"
+		"  --from <time>           Only messages at or after this time\n"
+		"  --to <time>             Only messages before this time\n"
+		"  --sites                 List the call sites that are defined in the file instead of the messages\n"
+		"Times are UTC, written as YYYY-MM-DD HH:MM:SS[.ffffff] or YYYY-MM-DDTHH:MM:SS[.ffffff].\n";
+}
+
+bool ParseOptions(int argc, char* argv[], Options& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--json")
+		{
+			options.json = true;
+		}
+		else if (arg == "--sites")
+		{
+			options.listSites = true;
+		}
+		else if (arg == "--level" && hasValue)
+		{
+			const string level = argv[++i];
+			if (level != "error" && level != "debug")
+			{
+				cerr << "Invalid level: " << level << "\n";
+				return false;
+			}
+			options.filterLevel = true;
+			options.level = level == "debug" ? BinaryLogLevel::Debug : BinaryLogLevel::Error;
+		}
+		else if (arg == "--site" && hasValue)
+		{
+			SiteFilter filter;
+			if (!ParseSiteFilter(argv[++i], filter))
+			{
+				cerr << "Invalid site: " << argv[i] << "\n";
+				return false;
+			}
+			options.sites.push_back(filter);
+		}
+		else if ((arg == "--from" || arg == "--to") && hasValue)
+		{
+			int64_t& time = arg == "--from" ? options.from : options.to;
+			if (!ParseTime(argv[++i], time))
+			{
+				cerr << "Invalid time: " << argv[i] << "\n";
+				return false;
+			}
+			(arg == "--from" ? options.hasFrom : options.hasTo) = true;
+		}
+		else if (arg.size() > 1 && arg[0] == '-')
+		{
+			cerr << "Unknown option or missing value: " << arg << "\n";
+			return false;
+		}
+		else
+		{
+			options.files.push_back(arg);
+		}
+	}
+	return !options.files.empty();
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseOptions(argc, argv, options))
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	bool ok = true;
+	for (const auto& path : options.files)
+	{
+		ok = DecodeFile(path, options) && ok;
+	}
+	return ok ? 0 : 2;
+}
@@ -0,0 +1,46 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Counts the heap allocations of the test and benchmark executables, see AllocationCounter.cpp
+#pragma once
+
+#include <cstddef>
+
+namespace AllocationStats
+{
+	// Allocations and allocated bytes of the calling thread since it started
+	size_t Allocations() noexcept;
+	size_t Bytes() noexcept;
+}
+
+// The allocations of the calling thread while the counter exists, to check that a path does not allocate or does not
+// copy a buffer. Counters can be nested.
+class AllocationCounter
+{
+public:
+	AllocationCounter() noexcept : _allocations(AllocationStats::Allocations()), _bytes(AllocationStats::Bytes()) {}
+
+	size_t Allocations() const noexcept { return AllocationStats::Allocations() - _allocations; }
+
+	size_t Bytes() const noexcept { return AllocationStats::Bytes() - _bytes; }
+
+private:
+	size_t _allocations;
+	size_t _bytes;
+};
@@ -0,0 +1,294 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "Convert.h"
+#include <benchmark/benchmark.h>
+#include <openssl/evp.h>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	vector<unsigned char> RandomBytes(size_t size)
+	{
+		mt19937 random(1);
+		vector<unsigned char> bytes(size);
+		for (auto& b : bytes) b = static_cast<unsigned char>(random());
+		return bytes;
+	}
+
+	// The stream based helpers that Convert used before, as references
+	string BytesToHexStream(const vector<unsigned char>& bytes)
+	{
+		stringstream ss;
+		for (unsigned char c : bytes)
+		{
+			ss << hex << setw(2) << setfill('0') << static_cast<int>(c);
+		}
+		return ss.str();
+	}
+
+	vector<unsigned char> HexToBytesStoi(const string& hexString)
+	{
+		vector<unsigned char> bytes;
+		for (size_t i = 0; i < hexString.length(); i += 2)
+		{
+			bytes.push_back(static_cast<unsigned char>(stoi(hexString.substr(i, 2), nullptr, 16)));
+		}
+		return bytes;
+	}
+
+	string LongToHexStringStream(long in)
+	{
+		stringstream ss;
+		ss << hex << in;
+		return "0x" + ss.str();
+	}
+
+	wstring JoinWStream(const vector<wstring>& elements, const wchar_t* separator)
+	{
+		wstringstream os;
+		for (auto iter = elements.begin(); iter != elements.end(); ++iter)
+		{
+			os << *iter;
+			if (iter + 1 != elements.end()) os << separator;
+		}
+		return os.str();
+	}
+
+	string ReplaceAllInPlace(const string& input, const string& target, const string& replacement)
+	{
+		string result = input;
+		size_t pos = 0;
+		while ((pos = result.find(target, pos)) != string::npos)
+		{
+			result.replace(pos, target.length(), replacement);
+			pos += replacement.length();
+		}
+		return result;
+	}
+}
+
+// Sizes of a salt, a WebAuthn public key and a QR code image
+static void Sizes(benchmark::internal::Benchmark* benchmark)
+{
+	benchmark->Arg(16)->Arg(1024)->Arg(64 * 1024);
+}
+
+static void BM_Base64Encode(benchmark::State& state)
+{
+	const auto bytes = RandomBytes(static_cast<size_t>(state.range(0)));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::Base64Encode(bytes, true));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+BENCHMARK(BM_Base64Encode)->Apply(Sizes);
+
+static void BM_Base64Decode(benchmark::State& state)
+{
+	const string base64 = Convert::Base64Encode(RandomBytes(static_cast<size_t>(state.range(0))), true);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::Base64Decode(base64));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * base64.size()));
+}
+BENCHMARK(BM_Base64Decode)->Apply(Sizes);
+
+static void BM_Base64URLDecode(benchmark::State& state)
+{
+	const string base64 = Convert::Base64URLEncode(RandomBytes(static_cast<size_t>(state.range(0))));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::Base64URLDecode(base64));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * base64.size()));
+}
+BENCHMARK(BM_Base64URLDecode)->Apply(Sizes);
+
+// Reference: the codec of OpenSSL, into a buffer that is allocated like the result of Convert
+static void BM_Base64EncodeOpenSSL(benchmark::State& state)
+{
+	const auto bytes = RandomBytes(static_cast<size_t>(state.range(0)));
+	for (auto _ : state)
+	{
+		string base64((bytes.size() + 2) / 3 * 4 + 1, '\0');
+		EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&base64[0]), bytes.data(), static_cast<int>(bytes.size()));
+		benchmark::DoNotOptimize(base64);
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+BENCHMARK(BM_Base64EncodeOpenSSL)->Apply(Sizes);
+
+static void BM_Base64DecodeOpenSSL(benchmark::State& state)
+{
+	const string base64 = Convert::Base64Encode(RandomBytes(static_cast<size_t>(state.range(0))), true);
+	for (auto _ : state)
+	{
+		vector<unsigned char> bytes(base64.size() / 4 * 3);
+		EVP_DecodeBlock(bytes.data(), reinterpret_cast<const unsigned char*>(base64.data()), static_cast<int>(base64.size()));
+		benchmark::DoNotOptimize(bytes);
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * base64.size()));
+}
+BENCHMARK(BM_Base64DecodeOpenSSL)->Apply(Sizes);
+
+static void BM_BytesToHex(benchmark::State& state)
+{
+	const auto bytes = RandomBytes(static_cast<size_t>(state.range(0)));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::BytesToHex(bytes));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+BENCHMARK(BM_BytesToHex)->Apply(Sizes);
+
+// Into a buffer of the caller, like the public key of a WebAuthn credential in the log
+static void BM_BytesToHexBuffer(benchmark::State& state)
+{
+	const auto bytes = RandomBytes(static_cast<size_t>(state.range(0)));
+	string hex(bytes.size() * 2, '\0');
+	for (auto _ : state)
+	{
+		Convert::BytesToHex(bytes.data(), bytes.size(), &hex[0]);
+		benchmark::DoNotOptimize(hex.data());
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+BENCHMARK(BM_BytesToHexBuffer)->Apply(Sizes);
+
+static void BM_BytesToHexStream(benchmark::State& state)
+{
+	const auto bytes = RandomBytes(static_cast<size_t>(state.range(0)));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(BytesToHexStream(bytes));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+BENCHMARK(BM_BytesToHexStream)->Apply(Sizes);
+
+static void BM_HexToBytes(benchmark::State& state)
+{
+	const string hex = Convert::BytesToHex(RandomBytes(static_cast<size_t>(state.range(0))));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::HexToBytes(hex));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * hex.size()));
+}
+BENCHMARK(BM_HexToBytes)->Apply(Sizes);
+
+static void BM_HexToBytesBuffer(benchmark::State& state)
+{
+	const string hex = Convert::BytesToHex(RandomBytes(static_cast<size_t>(state.range(0))));
+	vector<unsigned char> bytes(hex.size() / 2);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::HexToBytes(hex.data(), hex.size(), bytes.data()));
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * hex.size()));
+}
+BENCHMARK(BM_HexToBytesBuffer)->Apply(Sizes);
+
+static void BM_HexToBytesStoi(benchmark::State& state)
+{
+	const string hex = Convert::BytesToHex(RandomBytes(static_cast<size_t>(state.range(0))));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(HexToBytesStoi(hex));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * hex.size()));
+}
+BENCHMARK(BM_HexToBytesStoi)->Apply(Sizes);
+
+static void BM_LongToHexString(benchmark::State& state)
+{
+	long value = static_cast<int32_t>(0x80070005);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(value);
+		benchmark::DoNotOptimize(Convert::LongToHexString(value));
+	}
+}
+BENCHMARK(BM_LongToHexString);
+
+static void BM_LongToHexStringStream(benchmark::State& state)
+{
+	long value = static_cast<int32_t>(0x80070005);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(value);
+		benchmark::DoNotOptimize(LongToHexStringStream(value));
+	}
+}
+BENCHMARK(BM_LongToHexStringStream);
+
+// The fields of a log line or a list of excluded accounts
+static const vector<wstring> JOIN_ELEMENTS = { L"CPUS_LOGON", L"user@example.com", L"DOMAIN\\Administrator", L"\u00C4rger", L"" };
+
+static void BM_JoinW(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::JoinW(JOIN_ELEMENTS, L", "));
+	}
+}
+BENCHMARK(BM_JoinW);
+
+static void BM_JoinWStream(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(JoinWStream(JOIN_ELEMENTS, L", "));
+	}
+}
+BENCHMARK(BM_JoinWStream);
+
+static void BM_ReplaceAll(benchmark::State& state)
+{
+	const string input = "{\"user\":\"a\",\"realm\":\"b\",\"pass\":\"c\",\"transaction_id\":\"d\"}";
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::ReplaceAll(input, "\"", "\\\""));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ReplaceAll);
+
+static void BM_ReplaceAllInPlace(benchmark::State& state)
+{
+	const string input = "{\"user\":\"a\",\"realm\":\"b\",\"pass\":\"c\",\"transaction_id\":\"d\"}";
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(ReplaceAllInPlace(input, "\"", "\\\""));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK(BM_ReplaceAllInPlace);
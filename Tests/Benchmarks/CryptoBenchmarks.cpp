@@ -0,0 +1,58 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "CryptoProvider.h"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+using namespace std;
+
+// PBKDF2 with the iterations of range(0). privacyIDEA uses 10000 for the offline OTPs.
+static void BM_PBKDF2SHA512(benchmark::State& state)
+{
+	const unsigned char password[] = "123456";
+	const unsigned char salt[16] = { 0 };
+	unsigned char out[64];
+	const auto iterations = static_cast<unsigned long long>(state.range(0));
+
+	for (auto _ : state)
+	{
+		CryptoProvider::Get().PBKDF2SHA512(password, sizeof(password) - 1, salt, sizeof(salt), iterations, out, sizeof(out));
+		benchmark::DoNotOptimize(out);
+	}
+
+	state.counters["Iterations/s"] = benchmark::Counter(static_cast<double>(state.iterations() * iterations), benchmark::Counter::kIsRate);
+	state.SetLabel(CryptoProvider::Get().GetName());
+}
+BENCHMARK(BM_PBKDF2SHA512)->Arg(1)->Arg(10)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+static void BM_GenerateRandom(benchmark::State& state)
+{
+	vector<unsigned char> buffer(static_cast<size_t>(state.range(0)));
+
+	for (auto _ : state)
+	{
+		CryptoProvider::Get().GenerateRandom(buffer.data(), buffer.size());
+		benchmark::DoNotOptimize(buffer.data());
+	}
+
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * buffer.size()));
+	state.SetLabel(CryptoProvider::Get().GetName());
+}
+BENCHMARK(BM_GenerateRandom)->Arg(32)->Arg(4096);
@@ -0,0 +1,166 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "Convert.h"
+#include "IdentityKey.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// User names as they are typed at the logon screen, compared with the names of the offline data and the realm map.
+// Argument 0 is ASCII only, 1 has umlauts, accents and Cyrillic names mixed in.
+namespace
+{
+	vector<wstring> UserNames(int kind)
+	{
+		const vector<wstring> ascii = { L"administrator", L"j.doe", L"DOMAIN\\svc-backup", L"alice@example.com",
+			L"Bob.Smith", L"helpdesk01", L"CORP\\Carol", L"dave" };
+		const vector<wstring> unicode = { L"J\u00FCrgen.M\u00FCller", L"fran\u00E7ois@example.fr", L"\u00C5sa.Str\u00F6m",
+			L"\u0414\u043C\u0438\u0442\u0440\u0438\u0439", L"CORP\\Zo\u00EB", L"\u00C9milie.Dubois" };
+		vector<wstring> names = ascii;
+		if (kind == 1) names.insert(names.end(), unicode.begin(), unicode.end());
+		return names;
+	}
+
+	// The same names as typed in another case
+	wstring OtherCase(const wstring& name)
+	{
+		wstring ret = Convert::ToUpperCase(name);
+		return ret == name ? wstring(name.rbegin(), name.rend()) : ret;
+	}
+
+	void Label(benchmark::State& state)
+	{
+		state.SetLabel(state.range(0) == 0 ? "ascii" : "mixed");
+	}
+
+	// The comparison that IdentityKey replaces: both names copied and uppercased with std::toupper on each compare
+	wstring ToUpperCaseCopy(wstring s)
+	{
+		transform(s.begin(), s.end(), s.begin(), [](wchar_t c) { return static_cast<wchar_t>(toupper(c)); });
+		return s;
+	}
+}
+
+static void BM_IdentityKeyCreate(benchmark::State& state)
+{
+	const auto names = UserNames(static_cast<int>(state.range(0)));
+	for (auto _ : state)
+	{
+		for (const auto& name : names)
+		{
+			benchmark::DoNotOptimize(IdentityKey(name));
+		}
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * names.size()));
+	Label(state);
+}
+BENCHMARK(BM_IdentityKeyCreate)->DenseRange(0, 1);
+
+static void BM_IdentityKeyMatches(benchmark::State& state)
+{
+	const auto names = UserNames(static_cast<int>(state.range(0)));
+	vector<IdentityKey> keys;
+	vector<wstring> typed;
+	for (const auto& name : names)
+	{
+		keys.emplace_back(name);
+		typed.push_back(OtherCase(name));
+	}
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			benchmark::DoNotOptimize(keys[i].Matches(typed[i]));
+		}
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * keys.size()));
+	Label(state);
+}
+BENCHMARK(BM_IdentityKeyMatches)->DenseRange(0, 1);
+
+static void BM_IdentityKeyMatchesUtf8(benchmark::State& state)
+{
+	const auto names = UserNames(static_cast<int>(state.range(0)));
+	vector<IdentityKey> keys;
+	vector<string> typed;
+	for (const auto& name : names)
+	{
+		keys.emplace_back(name);
+		typed.push_back(Convert::ToString(OtherCase(name)));
+	}
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < keys.size(); i++)
+		{
+			benchmark::DoNotOptimize(keys[i].Matches(typed[i]));
+		}
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * keys.size()));
+	Label(state);
+}
+BENCHMARK(BM_IdentityKeyMatchesUtf8)->DenseRange(0, 1);
+
+static void BM_UpperCaseCopyCompare(benchmark::State& state)
+{
+	const auto names = UserNames(static_cast<int>(state.range(0)));
+	vector<wstring> typed;
+	for (const auto& name : names)
+	{
+		typed.push_back(OtherCase(name));
+	}
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < names.size(); i++)
+		{
+			benchmark::DoNotOptimize(ToUpperCaseCopy(names[i]) == ToUpperCaseCopy(typed[i]));
+		}
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * names.size()));
+	Label(state);
+}
+BENCHMARK(BM_UpperCaseCopyCompare)->DenseRange(0, 1);
+
+// Lookup in a map keyed by identity, like the realm map of PrivacyIDEA
+static void BM_IdentityKeyLookup(benchmark::State& state)
+{
+	const auto names = UserNames(static_cast<int>(state.range(0)));
+	unordered_map<IdentityKey, size_t, IdentityKey::Hash> map;
+	vector<IdentityKey> typed;
+	for (size_t i = 0; i < names.size(); i++)
+	{
+		map.emplace(IdentityKey(names[i]), i);
+		typed.emplace_back(OtherCase(names[i]));
+	}
+	for (auto _ : state)
+	{
+		for (const auto& key : typed)
+		{
+			benchmark::DoNotOptimize(map.find(key));
+		}
+	}
+	state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * typed.size()));
+	Label(state);
+}
+BENCHMARK(BM_IdentityKeyLookup)->DenseRange(0, 1);
@@ -0,0 +1,138 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "JsonBackend.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// Compare the JSON backends on the inputs of the client. The backends that are not part of the build are skipped,
+// configure with -DPI_JSON_SIMDJSON=ON to compare both.
+namespace
+{
+	string ReadCorpusFile(const string& name)
+	{
+		ifstream in(string(PI_TEST_CORPUS_DIR) + "/" + name, ios::binary);
+		stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+
+	// A response of /validate/check with the given number of offline OTPs, like a refill of a large window
+	string OfflineResponse(int otps)
+	{
+		string json = R"({"auth_items": {"offline": [{"refilltoken": "a6a2b4cb3e2c29b7b8e2e6fbd4e8", "response": {)";
+		for (int i = 0; i < otps; i++)
+		{
+			if (i > 0) json += ", ";
+			json += "\"" + to_string(i) + "\": \"$pbkdf2-sha512$10000$wkSB8B7CmZcTog$YFQZzH76BCUGDHRcyj6UQ0q/CQ1TtNzZl"
+				"/8hmqHI.kPCKdyHzuL9bfN7UqTyWtnPubfMzNq.BB6xDLohRcLzpQ\"";
+		}
+		json += R"(}, "user": "alice", "username": "alice"}]}, )"
+			R"("detail": {"message": "matching 1 tokens", "otplen": 6, "serial": "OATH00012345", "type": "hotp"}, )"
+			R"("id": 1, "jsonrpc": "2.0", "result": {"authentication": "ACCEPT", "status": true, "value": true}, )"
+			R"("time": 1712820100.7340815, "version": "privacyIDEA 3.9.2"})";
+		return json;
+	}
+
+	// An offline file with the given number of users, each with one token of 50 OTPs
+	string OfflineFile(int users)
+	{
+		string json = R"({"offline": [)";
+		for (int u = 0; u < users; u++)
+		{
+			if (u > 0) json += ", ";
+			json += R"({"count": "1", "last_used": 1712820100, "refilltoken": "f8e7d6c5b4a39281", "response": {)";
+			for (int i = 0; i < 50; i++)
+			{
+				if (i > 0) json += ", ";
+				json += "\"" + to_string(i) + "\": \"$pbkdf2-sha512$10000$iBEiJERoTQmhFA$UDYGS19lK5GJ9UJxTWyOKWeDlY6kFTiqy"
+					"XCrUFWTDqcX6VdF4fWvK3lB2k5XM6UL/eZ7cKvKhbHIn0N.UbLsdw\"";
+			}
+			json += R"(}, "serial": "OATH)" + to_string(u) + R"(", "username": "user)" + to_string(u) + "\"}";
+		}
+		json += "]}";
+		return json;
+	}
+
+	void ParseResponse(benchmark::State& state, const string& backendName, const string& input)
+	{
+		JsonBackend* backend = JsonBackend::Get(backendName);
+		if (backend == nullptr)
+		{
+			state.SkipWithError("backend is not part of this build");
+			return;
+		}
+
+		for (auto _ : state)
+		{
+			PIResponse response;
+			vector<OfflineData> offlineData;
+			benchmark::DoNotOptimize(backend->ParseResponse(input, response, offlineData));
+			benchmark::DoNotOptimize(offlineData.data());
+		}
+
+		state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+	}
+}
+
+// The responses of the corpus, small inputs where the setup of the parser counts
+static void BM_ParseResponseCorpus(benchmark::State& state, const string& backendName, const string& file)
+{
+	ParseResponse(state, backendName, ReadCorpusFile(file));
+}
+BENCHMARK_CAPTURE(BM_ParseResponseCorpus, nlohmann_accept, string("nlohmann"), string("response-accept.json"));
+BENCHMARK_CAPTURE(BM_ParseResponseCorpus, simdjson_accept, string("simdjson"), string("response-accept.json"));
+BENCHMARK_CAPTURE(BM_ParseResponseCorpus, nlohmann_webauthn, string("nlohmann"), string("response-webauthn.json"));
+BENCHMARK_CAPTURE(BM_ParseResponseCorpus, simdjson_webauthn, string("simdjson"), string("response-webauthn.json"));
+BENCHMARK_CAPTURE(BM_ParseResponseCorpus, nlohmann_offline, string("nlohmann"), string("response-offline-hotp.json"));
+BENCHMARK_CAPTURE(BM_ParseResponseCorpus, simdjson_offline, string("simdjson"), string("response-offline-hotp.json"));
+
+// A response with range(0) offline OTPs
+static void BM_ParseOfflineResponse(benchmark::State& state, const string& backendName)
+{
+	ParseResponse(state, backendName, OfflineResponse(static_cast<int>(state.range(0))));
+}
+BENCHMARK_CAPTURE(BM_ParseOfflineResponse, nlohmann, string("nlohmann"))->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_ParseOfflineResponse, simdjson, string("simdjson"))->Arg(100)->Arg(1000)->Unit(benchmark::kMicrosecond);
+
+// An offline file with range(0) users
+static void BM_ParseOfflineFile(benchmark::State& state, const string& backendName)
+{
+	JsonBackend* backend = JsonBackend::Get(backendName);
+	if (backend == nullptr)
+	{
+		state.SkipWithError("backend is not part of this build");
+		return;
+	}
+
+	const string input = OfflineFile(static_cast<int>(state.range(0)));
+	for (auto _ : state)
+	{
+		auto offlineData = backend->ParseOfflineFile(input);
+		benchmark::DoNotOptimize(offlineData.data());
+	}
+
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK_CAPTURE(BM_ParseOfflineFile, nlohmann, string("nlohmann"))->Arg(10)->Arg(1000)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_ParseOfflineFile, simdjson, string("simdjson"))->Arg(10)->Arg(1000)->Unit(benchmark::kMicrosecond);
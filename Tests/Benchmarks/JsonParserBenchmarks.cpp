@@ -0,0 +1,82 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "JsonParser.h"
+#include "Logger.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// ProcessResponse gets the PIResponse and the offline data of a response of /validate/check from one parse. Before, the
+// response was parsed once for the PIResponse and a second time for the offline data.
+namespace
+{
+	string ReadCorpusFile(const string& name)
+	{
+		ifstream in(string(PI_TEST_CORPUS_DIR) + "/" + name, ios::binary);
+		stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+}
+
+static void BM_ProcessResponseTwoParses(benchmark::State& state, const string& file)
+{
+	Logger::Get().logDebug = false;
+	const string input = ReadCorpusFile(file);
+	JsonParser parser;
+	int64_t parses = 0;
+	for (auto _ : state)
+	{
+		PIResponse response;
+		benchmark::DoNotOptimize(parser.ParseResponse(input, response));
+		auto offlineData = parser.ParseResponseForOfflineData(input);
+		benchmark::DoNotOptimize(offlineData.data());
+		parses += 2;
+	}
+
+	state.counters["ParsesPerResponse"] = benchmark::Counter(static_cast<double>(parses), benchmark::Counter::kAvgIterations);
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK_CAPTURE(BM_ProcessResponseTwoParses, hotp, string("response-offline-hotp.json"));
+BENCHMARK_CAPTURE(BM_ProcessResponseTwoParses, webauthn, string("response-offline-webauthn.json"));
+
+static void BM_ProcessResponseSingleParse(benchmark::State& state, const string& file)
+{
+	Logger::Get().logDebug = false;
+	const string input = ReadCorpusFile(file);
+	JsonParser parser;
+	int64_t parses = 0;
+	for (auto _ : state)
+	{
+		PIResponse response;
+		vector<OfflineData> offlineData;
+		benchmark::DoNotOptimize(parser.ParseResponse(input, response, offlineData));
+		benchmark::DoNotOptimize(offlineData.data());
+		parses += 1;
+	}
+
+	state.counters["ParsesPerResponse"] = benchmark::Counter(static_cast<double>(parses), benchmark::Counter::kAvgIterations);
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK_CAPTURE(BM_ProcessResponseSingleParse, hotp, string("response-offline-hotp.json"));
+BENCHMARK_CAPTURE(BM_ProcessResponseSingleParse, webauthn, string("response-offline-webauthn.json"));
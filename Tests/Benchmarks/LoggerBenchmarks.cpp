@@ -0,0 +1,128 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "JsonParser.h"
+#include "Logger.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+// The cost of log statements when debug logging is disabled, which is the default at the logon. The Eager benchmarks
+// build the message first, like the macros did before the level was checked.
+namespace
+{
+	string ReadCorpusFile(const string& name)
+	{
+		ifstream in(string(PI_TEST_CORPUS_DIR) + "/" + name, ios::binary);
+		stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+
+	const string SERIAL = "HOTP0001A2B3";
+}
+
+static void BM_DisabledDebug(benchmark::State& state)
+{
+	Logger::Get().logDebug = false;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(SERIAL);
+		PIDebug("Trying token " + SERIAL);
+	}
+}
+BENCHMARK(BM_DisabledDebug);
+
+static void BM_EagerDebug(benchmark::State& state)
+{
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(SERIAL);
+		const string message = "Trying token " + SERIAL;
+		benchmark::DoNotOptimize(message);
+	}
+}
+BENCHMARK(BM_EagerDebug);
+
+static void BM_DisabledDebugF(benchmark::State& state)
+{
+	Logger::Get().logDebug = false;
+	int count = 10;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(count);
+		PIDebugF("Offline authentication success with token {}, removing {} offline OTPs.", SERIAL, count);
+	}
+}
+BENCHMARK(BM_DisabledDebugF);
+
+static void BM_EagerDebugF(benchmark::State& state)
+{
+	int count = 10;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(count);
+		const string message = "Offline authentication success with token " + SERIAL + ", removing " + to_string(count)
+			+ " offline OTPs.";
+		benchmark::DoNotOptimize(message);
+	}
+}
+BENCHMARK(BM_EagerDebugF);
+
+// The response of every request is pretty printed for the debug log in Endpoint::SendRequest
+static void BM_DisabledDebugPrettyJson(benchmark::State& state)
+{
+	Logger::Get().logDebug = false;
+	const string response = ReadCorpusFile("response-offline-hotp.json");
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(response);
+		PIDebug(JsonParser::PrettyFormatJson(response));
+	}
+}
+BENCHMARK(BM_DisabledDebugPrettyJson);
+
+static void BM_EagerPrettyJson(benchmark::State& state)
+{
+	const string response = ReadCorpusFile("response-offline-hotp.json");
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(JsonParser::PrettyFormatJson(response));
+	}
+}
+BENCHMARK(BM_EagerPrettyJson);
+
+// For comparison, the cost on the calling thread when debug logging is enabled: formatting and queueing for the writer.
+// The number of iterations stays below the capacity of the queue, so that no message is dropped.
+static void BM_EnabledDebugF(benchmark::State& state)
+{
+	Logger::Get().logDebug = true;
+	int count = 10;
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(count);
+		PIDebugF("Offline authentication success with token {}, removing {} offline OTPs.", SERIAL, count);
+	}
+	Logger::Get().logDebug = false;
+	Logger::Get().Flush();
+}
+BENCHMARK(BM_EnabledDebugF)->Iterations(LOGGER_QUEUE_CAPACITY / 2);
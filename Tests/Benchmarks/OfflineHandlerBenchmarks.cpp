@@ -0,0 +1,386 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Offline store operations on synthetic stores of users x tokens x OTPs
+
+#include "JsonParser.h"
+#include "OfflineHandler.h"
+#include "TestUtils.h"
+#include <benchmark/benchmark.h>
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <malloc.h>
+#include <memory>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+	constexpr int TRY_WINDOW = 10;
+
+	int Users(const benchmark::State& state) { return static_cast<int>(state.range(0)); }
+	int Tokens(const benchmark::State& state) { return static_cast<int>(state.range(1)); }
+	int OTPs(const benchmark::State& state) { return static_cast<int>(state.range(2)); }
+
+	string UserName(int user)
+	{
+		return "user" + to_string(user);
+	}
+
+	// Stored values by OTP index, the same for all tokens to keep the setup fast
+	const string& StoredValue(int index)
+	{
+		static vector<string> values;
+		while (values.size() <= static_cast<size_t>(index))
+		{
+			values.push_back(HashOTP(TestOTP(static_cast<int>(values.size()))));
+		}
+		return values[index];
+	}
+
+	OfflineData MakeTokenData(int user, int token, int otps)
+	{
+		OfflineData data;
+		data.username = UserName(user);
+		data.serial = "HOTP" + to_string(user) + "-" + to_string(token);
+		data.refilltoken = "refill-" + data.serial;
+		data.count = otps;
+		data.rounds = TEST_PBKDF2_ROUNDS;
+		data.lastUsed = 1 + user;
+		for (int i = 0; i < otps; i++)
+		{
+			data.offlineOTPs[to_string(i)] = StoredValue(i);
+		}
+		return data;
+	}
+
+	// The store of the benchmark arguments
+	vector<OfflineData> MakeStore(const benchmark::State& state)
+	{
+		vector<OfflineData> data;
+		for (int user = 0; user < Users(state); user++)
+		{
+			for (int token = 0; token < Tokens(state); token++)
+			{
+				data.push_back(MakeTokenData(user, token, OTPs(state)));
+			}
+		}
+		return data;
+	}
+
+	// Offline file with the store of the benchmark arguments
+	void WriteStore(const TempFile& file, const benchmark::State& state)
+	{
+		ofstream out(file.Path(), ios::binary | ios::trunc);
+		JsonParser().WriteOfflineData(out, MakeStore(state));
+	}
+
+	// Verify OTPs of the first token of the last user, which is compared with all datasets.
+	// The OTP at lowest key + offset is used and the token is restored when it runs out.
+	void VerifyOTPs(benchmark::State& state, int offset, bool hit)
+	{
+		TempFile file("verify.json");
+		WriteStore(file, state);
+		OfflineHandler handler(file.WPath(), TRY_WINDOW);
+		const int user = Users(state) - 1;
+		const string username = UserName(user);
+		string serialUsed;
+		int next = 0;
+
+		for (auto _ : state)
+		{
+			if (hit && next + offset >= OTPs(state))
+			{
+				state.PauseTiming();
+				handler.AddOfflineData(MakeTokenData(user, 0, OTPs(state)));
+				next = 0;
+				state.ResumeTiming();
+			}
+
+			const SecureWString otp(hit ? Convert::ToWString(TestOTP(next + offset)).c_str() : L"999999");
+			if ((handler.VerifyOfflineOTP(otp, username, serialUsed) == S_OK) != hit)
+			{
+				state.SkipWithError("Unexpected verification result");
+				break;
+			}
+			next += offset + 1;
+		}
+	}
+
+	// The offline file like it was written before WriteOfflineData: the whole document is built with nlohmann::json and
+	// dumped to a string, which is then written
+	void WriteOfflineDataDom(ostream& out, const vector<OfflineData>& data, bool compact)
+	{
+		nlohmann::json::array_t jArray;
+		for (const auto& item : data)
+		{
+			nlohmann::json jElement;
+			jElement["consumption_rate"] = item.consumptionRate;
+			jElement["last_consumption"] = item.lastConsumption;
+			jElement["last_used"] = item.lastUsed;
+			jElement["refilltoken"] = item.refilltoken;
+			jElement["serial"] = item.serial;
+			jElement["username"] = item.username;
+
+			nlohmann::json jResponse = nlohmann::json::object();
+			if (item.isWebAuthn())
+			{
+				jResponse["credentialId"] = item.credId;
+				jResponse["pubKey"] = item.pubKey;
+				jResponse["rpId"] = item.rpId;
+			}
+			else
+			{
+				jElement["count"] = to_string(item.offlineOTPs.size());
+				for (const auto& otpEntry : item.offlineOTPs)
+				{
+					jResponse[otpEntry.first] = otpEntry.second;
+				}
+			}
+			jElement["response"] = std::move(jResponse);
+			jArray.push_back(std::move(jElement));
+		}
+
+		nlohmann::json jRoot;
+		jRoot["offline"] = std::move(jArray);
+		out << jRoot.dump(compact ? -1 : 4);
+	}
+
+	// Resident set of this process in KB
+	long CurrentRSSKB()
+	{
+		long pages = 0, resident = 0;
+		FILE* statm = fopen("/proc/self/statm", "r");
+		if (statm == nullptr) return 0;
+		if (fscanf(statm, "%ld %ld", &pages, &resident) != 2) resident = 0;
+		fclose(statm);
+		return resident * (sysconf(_SC_PAGESIZE) / 1024);
+	}
+
+	// ru_maxrss of the benchmark process only grows from one benchmark to the next, so the write is done once more in a
+	// child process. Reports the peak RSS of the child (ru_maxrss) and how far the write raised it, in KB.
+	void ReportPeakRSS(benchmark::State& state, const function<void()>& write)
+	{
+		int fds[2];
+		if (pipe(fds) != 0) return;
+		const pid_t pid = fork();
+		if (pid < 0)
+		{
+			close(fds[0]);
+			close(fds[1]);
+			return;
+		}
+		if (pid == 0)
+		{
+			close(fds[0]);
+			// Free memory of earlier benchmarks that the heap still holds would hide the growth
+			malloc_trim(0);
+			// The child starts with the peak of the parent, reset it to the current RSS (Linux 4.0 and later)
+			FILE* clearRefs = fopen("/proc/self/clear_refs", "w");
+			if (clearRefs == nullptr || fputs("5", clearRefs) < 0 || fclose(clearRefs) != 0)
+			{
+				_exit(1);
+			}
+			long kb[2] = { CurrentRSSKB(), 0 };
+			write();
+			struct rusage usage = {};
+			getrusage(RUSAGE_SELF, &usage);
+			kb[1] = usage.ru_maxrss;
+			const bool sent = ::write(fds[1], kb, sizeof(kb)) == static_cast<ssize_t>(sizeof(kb));
+			_exit(sent ? 0 : 1);
+		}
+
+		close(fds[1]);
+		long kb[2] = {};
+		const bool received = read(fds[0], kb, sizeof(kb)) == static_cast<ssize_t>(sizeof(kb));
+		close(fds[0]);
+		int status = 0;
+		if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0 || !received) return;
+		state.counters["PeakRSSKB"] = static_cast<double>(kb[1]);
+		state.counters["PeakRSSGrowthKB"] = static_cast<double>(kb[1] > kb[0] ? kb[1] - kb[0] : 0);
+	}
+}
+
+// Users, tokens per user and OTPs per token of the store. PI_BENCHMARK_STORE=users,tokens,otps replaces the defaults.
+static void StoreSizes(benchmark::internal::Benchmark* benchmark)
+{
+	benchmark->ArgNames({ "users", "tokens", "otps" })->Unit(benchmark::kMicrosecond);
+	int users = 0, tokens = 0, otps = 0;
+	const char* custom = getenv("PI_BENCHMARK_STORE");
+	if (custom != nullptr && sscanf(custom, "%d,%d,%d", &users, &tokens, &otps) == 3 && users > 0 && tokens > 0
+		&& otps >= TRY_WINDOW)
+	{
+		benchmark->Args({ users, tokens, otps });
+		return;
+	}
+
+	benchmark->Args({ 1, 1, 100 });
+	benchmark->Args({ 100, 2, 100 });
+	benchmark->Args({ 1000, 2, 50 });
+}
+
+static void BM_OfflineLoadFromFile(benchmark::State& state)
+{
+	TempFile file("load.json");
+	WriteStore(file, state);
+	const size_t fileSize = file.Read().size();
+
+	for (auto _ : state)
+	{
+		// The shared store does not write the file again at the end
+		OfflineHandler handler(file.WPath(), TRY_WINDOW, true);
+	}
+
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fileSize));
+	state.counters["FileBytes"] = static_cast<double>(fileSize);
+}
+BENCHMARK(BM_OfflineLoadFromFile)->Apply(StoreSizes);
+
+static void BM_OfflineSaveToFile(benchmark::State& state)
+{
+	TempFile file("save.json");
+	WriteStore(file, state);
+	const size_t fileSize = file.Read().size();
+
+	for (auto _ : state)
+	{
+		state.PauseTiming();
+		auto handler = make_unique<OfflineHandler>(file.WPath(), TRY_WINDOW);
+		state.ResumeTiming();
+		// The handler writes the store when it is destroyed
+		handler.reset();
+	}
+
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fileSize));
+	state.counters["FileBytes"] = static_cast<double>(fileSize);
+}
+BENCHMARK(BM_OfflineSaveToFile)->Apply(StoreSizes);
+
+// Large stores, indented (compact 0) and compact (compact 1)
+static void WriteSizes(benchmark::internal::Benchmark* benchmark)
+{
+	benchmark->ArgNames({ "users", "tokens", "otps", "compact" })->Unit(benchmark::kMillisecond);
+	for (int compact = 0; compact < 2; compact++)
+	{
+		benchmark->Args({ 1000, 2, 50, compact });
+		benchmark->Args({ 2000, 2, 100, compact });
+	}
+}
+
+// Write the store with a stream writer, like SaveToFile does
+static void BM_OfflineWriteStream(benchmark::State& state)
+{
+	const vector<OfflineData> data = MakeStore(state);
+	const bool compact = state.range(3) != 0;
+	TempFile file("write-stream.json");
+	JsonParser parser;
+
+	for (auto _ : state)
+	{
+		ofstream out(file.Path(), ios::binary | ios::trunc);
+		parser.WriteOfflineData(out, data, compact);
+	}
+
+	const size_t fileSize = file.Read().size();
+	ReportPeakRSS(state, [&]()
+		{
+			ofstream out(file.Path(), ios::binary | ios::trunc);
+			parser.WriteOfflineData(out, data, compact);
+		});
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fileSize));
+	state.counters["FileBytes"] = static_cast<double>(fileSize);
+}
+BENCHMARK(BM_OfflineWriteStream)->Apply(WriteSizes);
+
+// Write the same file by building the nlohmann::json document and dumping it
+static void BM_OfflineWriteDom(benchmark::State& state)
+{
+	const vector<OfflineData> data = MakeStore(state);
+	const bool compact = state.range(3) != 0;
+	TempFile file("write-dom.json");
+
+	for (auto _ : state)
+	{
+		ofstream out(file.Path(), ios::binary | ios::trunc);
+		WriteOfflineDataDom(out, data, compact);
+	}
+
+	const size_t fileSize = file.Read().size();
+	ReportPeakRSS(state, [&]()
+		{
+			ofstream out(file.Path(), ios::binary | ios::trunc);
+			WriteOfflineDataDom(out, data, compact);
+		});
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * fileSize));
+	state.counters["FileBytes"] = static_cast<double>(fileSize);
+}
+BENCHMARK(BM_OfflineWriteDom)->Apply(WriteSizes);
+
+static void BM_OfflineVerifyHitFirst(benchmark::State& state)
+{
+	VerifyOTPs(state, 0, true);
+}
+BENCHMARK(BM_OfflineVerifyHitFirst)->Apply(StoreSizes);
+
+static void BM_OfflineVerifyHitWindowEnd(benchmark::State& state)
+{
+	VerifyOTPs(state, TRY_WINDOW - 1, true);
+}
+BENCHMARK(BM_OfflineVerifyHitWindowEnd)->Apply(StoreSizes);
+
+static void BM_OfflineVerifyMiss(benchmark::State& state)
+{
+	VerifyOTPs(state, 0, false);
+}
+BENCHMARK(BM_OfflineVerifyMiss)->Apply(StoreSizes);
+
+// Refill of the last user with values that are already in the store, so that the store does not grow
+static void BM_OfflineAddOfflineDataMerge(benchmark::State& state)
+{
+	TempFile file("merge.json");
+	WriteStore(file, state);
+	OfflineHandler handler(file.WPath(), TRY_WINDOW);
+	const OfflineData refill = MakeTokenData(Users(state) - 1, 0, OTPs(state));
+
+	for (auto _ : state)
+	{
+		handler.AddOfflineData(refill);
+	}
+}
+BENCHMARK(BM_OfflineAddOfflineDataMerge)->Apply(StoreSizes);
+
+static void BM_OfflineGetTokenInfo(benchmark::State& state)
+{
+	TempFile file("info.json");
+	WriteStore(file, state);
+	OfflineHandler handler(file.WPath(), TRY_WINDOW);
+	const string username = UserName(Users(state) - 1);
+
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(handler.GetTokenInfo(username));
+	}
+}
+BENCHMARK(BM_OfflineGetTokenInfo)->Apply(StoreSizes);
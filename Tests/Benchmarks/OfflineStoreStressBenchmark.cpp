@@ -0,0 +1,150 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Many distinct users logging on to one machine, to see how the offline store behaves over time with and without a limit
+
+#include "OfflineHandler.h"
+#include "TestUtils.h"
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+namespace
+{
+	// Distinct users that use the machine
+	constexpr int POPULATION = 5000;
+	constexpr int OTPS_PER_USER = 10;
+
+	// Stored values of the OTPs, the same for all users to keep the setup fast
+	const map<string, string>& OfflineOTPs()
+	{
+		static const map<string, string> otps = []
+		{
+			return MakeOfflineData("", "", OTPS_PER_USER).offlineOTPs;
+		}();
+		return otps;
+	}
+
+	// A few users log on every day, most only now and then.
+	// lastUsed has a resolution of one second, so in a run the users evicted among those of the same second follow the names.
+	class SharedMachine
+	{
+	public:
+		SharedMachine(const TempFile& file, size_t maxUsers)
+			: _handler(file.WPath(), 10, false, maxUsers), _nextOTP(POPULATION, -1)
+		{
+		}
+
+		// Offline logon if the data of the user is still in the store, otherwise an online logon which adds new data
+		void Logon()
+		{
+			const double skew = _distribution(_random);
+			const int user = static_cast<int>(POPULATION * skew * skew * skew * skew);
+			const string username = "user" + to_string(user);
+			const string serial = "HOTP" + to_string(user);
+			int& next = _nextOTP[user];
+
+			if (next >= 0 && next < OTPS_PER_USER && _handler.GetOfflineOTPCount(username, serial) > 0)
+			{
+				const SecureWString otp(Convert::ToWString(TestOTP(next)).c_str());
+				string serialUsed;
+				const auto start = chrono::steady_clock::now();
+				const HRESULT hr = _handler.VerifyOfflineOTP(otp, username, serialUsed);
+				_lookupTime += chrono::steady_clock::now() - start;
+				_lookups++;
+				if (hr == S_OK)
+				{
+					next++;
+					_hits++;
+					return;
+				}
+			}
+
+			OfflineData data;
+			data.username = username;
+			data.serial = serial;
+			data.refilltoken = "refill-" + serial;
+			data.count = OTPS_PER_USER;
+			data.rounds = TEST_PBKDF2_ROUNDS;
+			data.offlineOTPs = OfflineOTPs();
+			_handler.AddOfflineData(data);
+			next = 0;
+			_misses++;
+		}
+
+		void ResetStatistics()
+		{
+			_lookupTime = chrono::nanoseconds::zero();
+			_lookups = _hits = _misses = 0;
+		}
+
+		void Report(benchmark::State& state)
+		{
+			int users = 0;
+			for (int user = 0; user < POPULATION; user++)
+			{
+				if (!_handler.GetTokenInfo("user" + to_string(user)).empty())
+				{
+					users++;
+				}
+			}
+
+			state.counters["StoreBytes"] = static_cast<double>(_handler.GetStoreSize());
+			state.counters["StoreUsers"] = users;
+			state.counters["HitRate"] = _hits + _misses > 0 ? static_cast<double>(_hits) / (_hits + _misses) : 0.0;
+			state.counters["LookupUs"] = _lookups > 0 ? chrono::duration<double, micro>(_lookupTime).count() / _lookups : 0.0;
+		}
+
+	private:
+		OfflineHandler _handler;
+		vector<int> _nextOTP;
+		mt19937 _random{ 42 };
+		uniform_real_distribution<double> _distribution{ 0.0, 1.0 };
+		chrono::nanoseconds _lookupTime = chrono::nanoseconds::zero();
+		int64_t _lookups = 0;
+		int64_t _hits = 0;
+		int64_t _misses = 0;
+	};
+}
+
+// Logons after the machine has seen range(0) logons, with the store limited to range(1) users (0 is unlimited)
+static void BM_OfflineStoreUserCycling(benchmark::State& state)
+{
+	TempFile file("stress.json");
+	SharedMachine machine(file, static_cast<size_t>(state.range(1)));
+	for (int64_t i = 0; i < state.range(0); i++)
+	{
+		machine.Logon();
+	}
+	machine.ResetStatistics();
+
+	for (auto _ : state)
+	{
+		machine.Logon();
+	}
+
+	machine.Report(state);
+}
+BENCHMARK(BM_OfflineStoreUserCycling)
+	->ArgNames({ "logons", "maxUsers" })
+	->ArgsProduct({ { 0, 1000, 4000 }, { 0, 100 } })
+	->Unit(benchmark::kMicrosecond);
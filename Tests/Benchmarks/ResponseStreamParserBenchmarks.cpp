@@ -0,0 +1,78 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "AllocationCounter.h"
+#include "Logger.h"
+#include "ResponseStreamParser.h"
+#include <benchmark/benchmark.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Heap allocations and time of parsing the responses of /validate/check in the corpus, with the temporary memory taken
+// from the per response arena and from the heap. The allocations include those of the results.
+namespace
+{
+	string ReadCorpusFile(const string& name)
+	{
+		ifstream in(string(PI_TEST_CORPUS_DIR) + "/" + name, ios::binary);
+		stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+}
+
+static void BM_ResponseStreamParser(benchmark::State& state, bool useArena, const string& file)
+{
+	Logger::Get().logDebug = false;
+	const string input = ReadCorpusFile(file);
+	ResponseStreamParser parser(useArena);
+	size_t allocations = 0;
+	size_t bytes = 0;
+
+	for (auto _ : state)
+	{
+		PIResponse response;
+		vector<OfflineData> offlineData;
+		const AllocationCounter counter;
+		parser.Feed(input);
+		benchmark::DoNotOptimize(parser.Finish(response, offlineData));
+		allocations += counter.Allocations();
+		bytes += counter.Bytes();
+	}
+
+	state.counters["HeapAllocsPerParse"] = benchmark::Counter(static_cast<double>(allocations), benchmark::Counter::kAvgIterations);
+	state.counters["HeapBytesPerParse"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * input.size()));
+}
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, arena_accept, true, string("response-accept.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, heap_accept, false, string("response-accept.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, arena_challenges, true, string("response-challenges.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, heap_challenges, false, string("response-challenges.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, arena_webauthn, true, string("response-webauthn.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, heap_webauthn, false, string("response-webauthn.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, arena_image, true, string("response-image.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, heap_image, false, string("response-image.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, arena_offline_hotp, true, string("response-offline-hotp.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, heap_offline_hotp, false, string("response-offline-hotp.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, arena_offline_webauthn, true, string("response-offline-webauthn.json"));
+BENCHMARK_CAPTURE(BM_ResponseStreamParser, heap_offline_webauthn, false, string("response-offline-webauthn.json"));
@@ -0,0 +1,99 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Readers of the shared offline store in several threads, with and without another process writing
+
+#include "OfflineHandler.h"
+#include "TestUtils.h"
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <fcntl.h>
+#include <memory>
+#include <sys/stat.h>
+#include <thread>
+
+using namespace std;
+
+namespace
+{
+	constexpr int USERS = 100;
+
+	unique_ptr<TempFile> storeFile;
+	unique_ptr<OfflineHandler> reader;
+	unique_ptr<thread> writer;
+	atomic<bool> stopWriter{ false };
+
+	// Another handler changes the file every 10ms, like the credential provider of another session
+	void WriteContinuously(const wstring& path)
+	{
+		OfflineHandler handler(path, 10, true);
+		while (!stopWriter.load())
+		{
+			handler.MarkUsed("user0", "HOTP");
+			this_thread::sleep_for(chrono::milliseconds(10));
+		}
+	}
+}
+
+// Lookups of a handler used by all threads, range(0) is 1 if the file is changed meanwhile
+static void BM_SharedStoreRead(benchmark::State& state)
+{
+	if (state.thread_index() == 0)
+	{
+		storeFile.reset(new TempFile("contention.json"));
+		{
+			OfflineHandler setup(storeFile->WPath(), 10, true);
+			for (int user = 0; user < USERS; user++)
+			{
+				setup.AddOfflineData(MakeOfflineData("user" + to_string(user), "HOTP", 10));
+			}
+		}
+		// Written a while ago. A file written in the last seconds is read again on every access.
+		const time_t written = time(nullptr) - 60;
+		const struct timespec times[2] = { { written, 0 }, { written, 0 } };
+		utimensat(AT_FDCWD, storeFile->Path().c_str(), times, 0);
+		reader.reset(new OfflineHandler(storeFile->WPath(), 10, true));
+		if (state.range(0) != 0)
+		{
+			stopWriter = false;
+			writer.reset(new thread(WriteContinuously, storeFile->WPath()));
+		}
+	}
+
+	const string username = "user" + to_string(USERS - 1 - state.thread_index() % USERS);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(reader->GetOfflineOTPCount(username, "HOTP"));
+	}
+
+	if (state.thread_index() == 0)
+	{
+		if (writer)
+		{
+			stopWriter = true;
+			writer->join();
+			writer.reset();
+		}
+		reader.reset();
+		storeFile.reset();
+	}
+}
+BENCHMARK(BM_SharedStoreRead)->ArgName("writer")->Arg(0)->Arg(1)->ThreadRange(1, 8)->UseRealTime();
@@ -0,0 +1,142 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "Convert.h"
+#include "Utf.h"
+#include <benchmark/benchmark.h>
+#include <codecvt>
+#include <locale>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+// Utf compared with wstring_convert, which it replaces. Each is run on a user name, on ASCII text and on text with
+// umlauts and emoji.
+namespace
+{
+	using StdCodecvt = conditional<sizeof(wchar_t) == 2, codecvt_utf8_utf16<wchar_t>, codecvt_utf8<wchar_t>>::type;
+
+	string Text(int kind)
+	{
+		switch (kind)
+		{
+			case 0:
+				return "administrator@example.com";
+			case 1:
+			{
+				string s;
+				while (s.size() < 4096) s += "The quick brown fox jumps over the lazy dog. ";
+				return s;
+			}
+			default:
+			{
+				string s;
+				while (s.size() < 4096) s += "Gr\xC3\xBC\xC3\x9F" "e aus M\xC3\xBCnchen \xF0\x9F\x98\x80, Stra\xC3\x9F" "e ";
+				return s;
+			}
+		}
+	}
+
+	void Label(benchmark::State& state)
+	{
+		const char* labels[] = { "name", "ascii", "mixed" };
+		state.SetLabel(labels[state.range(0)]);
+	}
+}
+
+static void BM_Utf8ToUtf16(benchmark::State& state)
+{
+	const string text = Text(static_cast<int>(state.range(0)));
+	vector<wchar_t> buffer(text.size());
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Utf::Utf8ToUtf16(text.data(), text.size(), buffer.data(), buffer.size()));
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+	Label(state);
+}
+BENCHMARK(BM_Utf8ToUtf16)->DenseRange(0, 2);
+
+// With the allocation of the result, like wstring_convert
+static void BM_ConvertToWString(benchmark::State& state)
+{
+	const string text = Text(static_cast<int>(state.range(0)));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::ToWString(text));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+	Label(state);
+}
+BENCHMARK(BM_ConvertToWString)->DenseRange(0, 2);
+
+static void BM_WStringConvertFromBytes(benchmark::State& state)
+{
+	const string text = Text(static_cast<int>(state.range(0)));
+	for (auto _ : state)
+	{
+		wstring_convert<StdCodecvt> converter;
+		benchmark::DoNotOptimize(converter.from_bytes(text));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+	Label(state);
+}
+BENCHMARK(BM_WStringConvertFromBytes)->DenseRange(0, 2);
+
+static void BM_Utf16ToUtf8(benchmark::State& state)
+{
+	const wstring text = Convert::ToWString(Text(static_cast<int>(state.range(0))));
+	vector<char> buffer(text.size() * 4);
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Utf::Utf16ToUtf8(text.data(), text.size(), buffer.data(), buffer.size()));
+		benchmark::ClobberMemory();
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size() * sizeof(wchar_t)));
+	Label(state);
+}
+BENCHMARK(BM_Utf16ToUtf8)->DenseRange(0, 2);
+
+static void BM_ConvertToString(benchmark::State& state)
+{
+	const wstring text = Convert::ToWString(Text(static_cast<int>(state.range(0))));
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize(Convert::ToString(text));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size() * sizeof(wchar_t)));
+	Label(state);
+}
+BENCHMARK(BM_ConvertToString)->DenseRange(0, 2);
+
+static void BM_WStringConvertToBytes(benchmark::State& state)
+{
+	const wstring text = Convert::ToWString(Text(static_cast<int>(state.range(0))));
+	for (auto _ : state)
+	{
+		wstring_convert<StdCodecvt> converter;
+		benchmark::DoNotOptimize(converter.to_bytes(text));
+	}
+	state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size() * sizeof(wchar_t)));
+	Label(state);
+}
+BENCHMARK(BM_WStringConvertToBytes)->DenseRange(0, 2);
@@ -0,0 +1,157 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "BinaryLogFormat.h"
+#include "Logger.h"
+#include "TestUtils.h"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <limits>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+	string Varint(uint64_t value)
+	{
+		string out;
+		BinaryLogAppendVarint(out, value);
+		return out;
+	}
+
+	uint64_t ReadFixed(const string& data, size_t& pos, size_t bytes)
+	{
+		uint64_t value = 0;
+		for (size_t i = 0; i < bytes; i++)
+		{
+			value |= static_cast<uint64_t>(static_cast<uint8_t>(data.at(pos++))) << (i * 8);
+		}
+		return value;
+	}
+
+	// Output of the LogDecoder tool for the file
+	string Decode(const string& options, const string& path)
+	{
+		string output;
+		FILE* pipe = popen((string("\"") + PI_LOG_DECODER + "\" " + options + " \"" + path + "\"").c_str(), "r");
+		if (pipe == nullptr) return output;
+		char buffer[4096];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), pipe)) > 0)
+		{
+			output.append(buffer, read);
+		}
+		pclose(pipe);
+		return output;
+	}
+
+	// The ids of the log macros are compile time constants
+	static_assert(BinaryLogHash("") == 2166136261u, "FNV-1a offset basis");
+	static_assert(BinaryLogSiteId("Logger.cpp", 1) != BinaryLogSiteId("Logger.cpp", 2), "The line is part of the site id");
+}
+
+TEST(BinaryLogFormat, Varints)
+{
+	EXPECT_EQ(Varint(0), string("\x00", 1));
+	EXPECT_EQ(Varint(0x7F), "\x7F");
+	EXPECT_EQ(Varint(0x80), "\x80\x01");
+	EXPECT_EQ(Varint(300), "\xAC\x02");
+	EXPECT_EQ(Varint((numeric_limits<uint64_t>::max)()), "\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\x01");
+}
+
+TEST(BinaryLogFormat, ZigZag)
+{
+	EXPECT_EQ(BinaryLogZigZag(0), 0u);
+	EXPECT_EQ(BinaryLogZigZag(-1), 1u);
+	EXPECT_EQ(BinaryLogZigZag(1), 2u);
+	EXPECT_EQ(BinaryLogZigZag(-2), 3u);
+	for (const int64_t value : { (numeric_limits<int64_t>::min)(), (numeric_limits<int64_t>::max)(), int64_t(-1000000), int64_t(0) })
+	{
+		EXPECT_EQ(BinaryLogUnZigZag(BinaryLogZigZag(value)), value);
+	}
+}
+
+TEST(BinaryLogFormat, FixedIntegersAreLittleEndian)
+{
+	string out;
+	BinaryLogAppendFixed(out, 0x0102030405060708ULL, 8);
+	BinaryLogAppendFixed(out, 0xAABBCCDD, 4);
+	EXPECT_EQ(out, "\x08\x07\x06\x05\x04\x03\x02\x01\xDD\xCC\xBB\xAA");
+}
+
+TEST(BinaryLogFormat, MessageIds)
+{
+	// Test vectors of FNV-1a 32 bit
+	EXPECT_EQ(BinaryLogHash("a"), 0xE40C292Cu);
+	EXPECT_EQ(BinaryLogHash("foobar"), 0xBF9CF968u);
+}
+
+// Log through the logger in binary mode, check the records and decode them with the LogDecoder tool
+TEST(BinaryLogFormat, LoggerOutputIsDecoded)
+{
+	TempFile file("binary.bin");
+	Logger& logger = Logger::Get();
+	logger.Flush();
+	const string previousPath = logger.binaryLogfilePath;
+	logger.binaryLogfilePath = file.Path();
+	logger.logBinary = true;
+
+	PIErrorF("binary {} {} {} {}", 42, -7, "text", true);
+	PIError("plain message");
+	PIDebugF("not logged {}", 1);
+	logger.logDebug = true;
+	PIDebugF("debug {}", 1.5);
+	logger.logDebug = false;
+	logger.Flush();
+
+	logger.logBinary = false;
+	logger.binaryLogfilePath = previousPath;
+
+	// Batches as the writer thread wrote them, their sizes have to cover the file exactly
+	const string data = file.Read();
+	ASSERT_FALSE(data.empty());
+	size_t pos = 0;
+	while (pos < data.size())
+	{
+		ASSERT_EQ(static_cast<BinaryLogRecord>(data[pos++]), BinaryLogRecord::Batch) << pos;
+		ASSERT_EQ(data.substr(pos, BINARY_LOG_MAGIC_SIZE), BINARY_LOG_MAGIC);
+		pos += BINARY_LOG_MAGIC_SIZE;
+		EXPECT_EQ(ReadFixed(data, pos, 4), BINARY_LOG_VERSION);
+		ReadFixed(data, pos, 4);
+		const size_t size = static_cast<size_t>(ReadFixed(data, pos, 4));
+		pos += 24 + size;
+	}
+	EXPECT_EQ(pos, data.size());
+	// The formats are written once with the site, not with each message
+	EXPECT_NE(data.find("binary {} {} {} {}"), string::npos);
+	EXPECT_EQ(data.find("not logged"), string::npos);
+
+	const string text = Decode("", file.Path());
+	EXPECT_NE(text.find("binary 42 -7 text true"), string::npos) << text;
+	EXPECT_NE(text.find("plain message"), string::npos) << text;
+	EXPECT_NE(text.find("debug 1.5"), string::npos) << text;
+
+	const string debugOnly = Decode("--level debug", file.Path());
+	EXPECT_NE(debugOnly.find("debug 1.5"), string::npos) << debugOnly;
+	EXPECT_EQ(debugOnly.find("plain message"), string::npos) << debugOnly;
+
+	const string json = Decode("--json", file.Path());
+	EXPECT_NE(json.find("\"binary 42 -7 text true\""), string::npos) << json;
+}
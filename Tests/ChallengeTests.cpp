@@ -0,0 +1,113 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "AllocationCounter.h"
+#include "Challenge.h"
+#include "Convert.h"
+#include "PIResponse.h"
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+	// The 8 byte signature of PNG, base64 encoded
+	const string PNG_BASE64 = "iVBORw0KGgo=";
+
+	Challenge WithImage(const string& image)
+	{
+		Challenge c;
+		c.image = make_shared<const string>(image);
+		return c;
+	}
+
+	string ImageBase64(const Challenge& c)
+	{
+		size_t size = 0;
+		const char* base64 = c.GetImageBase64(size);
+		return base64 == nullptr ? "<null>" : string(base64, size);
+	}
+}
+
+TEST(Challenge, ImageBase64SkipsTheDataPrefix)
+{
+	EXPECT_EQ(ImageBase64(WithImage("data:image/png;base64," + PNG_BASE64)), PNG_BASE64);
+	// The prefix does not always have 22 characters
+	EXPECT_EQ(ImageBase64(WithImage("data:image/jpeg;base64,/9j/4AAQ")), "/9j/4AAQ");
+	EXPECT_EQ(ImageBase64(WithImage("data:image/svg+xml;base64,PHN2Zz4=")), "PHN2Zz4=");
+	// Without a prefix, the whole value is the payload
+	EXPECT_EQ(ImageBase64(WithImage(PNG_BASE64)), PNG_BASE64);
+	// A prefix without payload
+	EXPECT_EQ(ImageBase64(WithImage("data:image/png;base64,")), "");
+	EXPECT_EQ(ImageBase64(WithImage("data:image/png")), "");
+}
+
+TEST(Challenge, NoImage)
+{
+	Challenge c;
+	EXPECT_FALSE(c.HasImage());
+	EXPECT_EQ(ImageBase64(c), "<null>");
+
+	c.image = make_shared<const string>();
+	EXPECT_FALSE(c.HasImage());
+	EXPECT_EQ(ImageBase64(c), "<null>");
+}
+
+TEST(Challenge, ImageBase64PointsIntoTheImage)
+{
+	const Challenge c = WithImage("data:image/png;base64," + PNG_BASE64);
+	size_t size = 0;
+	AllocationCounter counter;
+	const char* base64 = c.GetImageBase64(size);
+	EXPECT_EQ(counter.Allocations(), 0u);
+	EXPECT_EQ(base64, c.image->data() + 22);
+	EXPECT_EQ(size, PNG_BASE64.size());
+}
+
+TEST(Challenge, CopiesShareTheImage)
+{
+	// A QR code of an enrollment is a few 10 KB
+	PIResponse response;
+	response.challenges.push_back(WithImage("data:image/png;base64," + string(64 * 1024, 'A')));
+	response.challenges.push_back(WithImage("data:image/png;base64," + string(64 * 1024, 'B')));
+
+	AllocationCounter counter;
+	const PIResponse copy = response;
+	EXPECT_LT(counter.Bytes(), 64 * 1024u);
+	ASSERT_EQ(copy.challenges.size(), 2u);
+	EXPECT_EQ(copy.challenges[0].image, response.challenges[0].image);
+	EXPECT_EQ(copy.challenges[1].image, response.challenges[1].image);
+}
+
+TEST(Challenge, ImageIsDecodedWithoutCopies)
+{
+	const Challenge c = WithImage("data:image/png;base64," + PNG_BASE64);
+	size_t size = 0;
+	const char* base64 = c.GetImageBase64(size);
+	// The decode tables are initialized on first use
+	Convert::Base64Decode(base64, size);
+
+	AllocationCounter counter;
+	const auto png = Convert::Base64Decode(base64, size);
+	// Only the decoded bytes are allocated
+	EXPECT_EQ(counter.Allocations(), 1u);
+	EXPECT_EQ(png, (vector<unsigned char>{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' }));
+}
@@ -0,0 +1,239 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "AllocationCounter.h"
+#include "Convert.h"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	vector<unsigned char> Bytes(const string& s)
+	{
+		return vector<unsigned char>(s.begin(), s.end());
+	}
+
+	vector<unsigned char> RandomBytes(size_t size, mt19937& random)
+	{
+		vector<unsigned char> bytes(size);
+		for (auto& b : bytes) b = static_cast<unsigned char>(random());
+		return bytes;
+	}
+}
+
+// RFC 4648, section 10
+TEST(Convert, Base64TestVectors)
+{
+	const pair<string, string> vectors[] = { { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+		{ "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" } };
+	for (const auto& v : vectors)
+	{
+		EXPECT_EQ(Convert::Base64Encode(Bytes(v.first), true), v.second);
+		const string unpadded = v.second.substr(0, v.second.find('='));
+		EXPECT_EQ(Convert::Base64Encode(Bytes(v.first)), unpadded);
+		EXPECT_EQ(Convert::Base64Decode(v.second), Bytes(v.first)) << v.second;
+		EXPECT_EQ(Convert::Base64Decode(unpadded), Bytes(v.first)) << unpadded;
+	}
+}
+
+TEST(Convert, Base64Alphabets)
+{
+	const vector<unsigned char> bytes = { 0xFB, 0xEF, 0xFF };
+	EXPECT_EQ(Convert::Base64Encode(bytes), "++//");
+	EXPECT_EQ(Convert::Base64URLEncode(bytes), "--__");
+	EXPECT_EQ(Convert::Base64Decode("++//"), bytes);
+	EXPECT_EQ(Convert::Base64URLDecode("--__"), bytes);
+	// passlib's ab64 uses '.' instead of '+'
+	EXPECT_EQ(Convert::ABase64Decode("..//"), bytes);
+
+	// The characters of the other alphabets are not part of the input
+	EXPECT_TRUE(Convert::Base64Decode("--__").empty());
+	EXPECT_TRUE(Convert::Base64URLDecode("++//").empty());
+	EXPECT_TRUE(Convert::ABase64Decode("++//").empty());
+
+	string base64 = "a+b/c";
+	Convert::Base64ToBase64URL(base64);
+	EXPECT_EQ(base64, "a-b_c");
+	Convert::Base64URLToBase64(base64);
+	EXPECT_EQ(base64, "a+b/c");
+}
+
+TEST(Convert, Base64RoundTrip)
+{
+	mt19937 random(42);
+	for (size_t size = 0; size < 200; size++)
+	{
+		const auto bytes = RandomBytes(size, random);
+		for (const bool padded : { false, true })
+		{
+			EXPECT_EQ(Convert::Base64Decode(Convert::Base64Encode(bytes, padded)), bytes) << size;
+			EXPECT_EQ(Convert::Base64URLDecode(Convert::Base64URLEncode(bytes, padded)), bytes) << size;
+
+			string ab64 = Convert::Base64Encode(bytes, padded);
+			replace(ab64.begin(), ab64.end(), '+', '.');
+			EXPECT_EQ(Convert::ABase64Decode(ab64), bytes) << size;
+		}
+	}
+}
+
+TEST(Convert, Base64DecodeStopsAtTheFirstInvalidCharacter)
+{
+	EXPECT_EQ(Convert::Base64Decode("Zm9v!YmFy"), Bytes("foo"));
+	EXPECT_EQ(Convert::Base64Decode("Zm9vYmFy\n"), Bytes("foobar"));
+	// In every position of a group
+	EXPECT_EQ(Convert::Base64Decode("Zm9vY mFy"), Bytes("foo"));
+	EXPECT_EQ(Convert::Base64Decode("Zm9vYm Fy"), Bytes("foob"));
+	EXPECT_EQ(Convert::Base64Decode("Zm9vYmF y"), Bytes("fooba"));
+	EXPECT_TRUE(Convert::Base64Decode("\xC3\xA4Zm9v").empty());
+	// Padding ends the input
+	EXPECT_EQ(Convert::Base64Decode("Zg==Zm9v"), Bytes("f"));
+}
+
+TEST(Convert, Base64DecodeAcceptsAnyInput)
+{
+	mt19937 random(7);
+	for (int i = 0; i < 1000; i++)
+	{
+		const auto bytes = RandomBytes(random() % 64, random);
+		const string input(bytes.begin(), bytes.end());
+		// Never more than 3 bytes for 4 characters
+		EXPECT_LE(Convert::Base64Decode(input).size(), input.size() * 3 / 4);
+	}
+}
+
+TEST(Convert, Base64AllocatesOnlyTheResult)
+{
+	const vector<unsigned char> bytes(1000, 0x5A);
+	// The decode tables are initialized on first use
+	Convert::Base64Decode(Convert::Base64Encode(bytes));
+
+	AllocationCounter encode;
+	const string base64 = Convert::Base64Encode(bytes, true);
+	EXPECT_EQ(encode.Allocations(), 1u);
+
+	AllocationCounter decode;
+	const auto decoded = Convert::Base64Decode(base64);
+	EXPECT_EQ(decode.Allocations(), 1u);
+	EXPECT_EQ(decoded, bytes);
+}
+
+TEST(Convert, HexTestVectors)
+{
+	EXPECT_EQ(Convert::BytesToHex(vector<unsigned char>()), "");
+	EXPECT_EQ(Convert::BytesToHex(vector<unsigned char>{ 0x00, 0x01, 0x7F, 0x80, 0xA5, 0xFF }), "00017f80a5ff");
+	EXPECT_EQ(Convert::HexToBytes("00017f80a5ff"), (vector<unsigned char>{ 0x00, 0x01, 0x7F, 0x80, 0xA5, 0xFF }));
+	// Both cases are accepted
+	EXPECT_EQ(Convert::HexToBytes("DEADbeef"), (vector<unsigned char>{ 0xDE, 0xAD, 0xBE, 0xEF }));
+	EXPECT_TRUE(Convert::HexToBytes("").empty());
+}
+
+TEST(Convert, HexRoundTrip)
+{
+	mt19937 random(3);
+	for (size_t size = 0; size < 100; size++)
+	{
+		const auto bytes = RandomBytes(size, random);
+		string hex = Convert::BytesToHex(bytes);
+		ASSERT_EQ(hex.size(), size * 2);
+		EXPECT_EQ(Convert::HexToBytes(hex), bytes) << hex;
+		transform(hex.begin(), hex.end(), hex.begin(), [](char c) { return static_cast<char>(toupper(c)); });
+		EXPECT_EQ(Convert::HexToBytes(hex), bytes) << hex;
+	}
+}
+
+TEST(Convert, HexToBytesRejectsInvalidInput)
+{
+	unsigned char out[4] = {};
+	EXPECT_FALSE(Convert::HexToBytes("abc", 3, out));
+	EXPECT_TRUE(Convert::HexToBytes("abc").empty());
+
+	// std::stoi accepted a sign, a prefix or a single digit followed by anything
+	for (const string& hex : { "0x12", "+1", "-1", " 1", "1 ", "1g", "g1", "zz", "\xC3\xA4" })
+	{
+		EXPECT_FALSE(Convert::HexToBytes(hex.data(), hex.size(), out)) << hex;
+		EXPECT_TRUE(Convert::HexToBytes(hex).empty()) << hex;
+	}
+
+	// Every byte value that is not a hex digit, in both positions
+	for (int c = 0; c < 256; c++)
+	{
+		if (isxdigit(c)) continue;
+		const char invalid = static_cast<char>(c);
+		const string high = string(1, invalid) + "0";
+		const string low = "0" + string(1, invalid);
+		EXPECT_FALSE(Convert::HexToBytes(high.data(), 2, out)) << c;
+		EXPECT_FALSE(Convert::HexToBytes(low.data(), 2, out)) << c;
+	}
+}
+
+TEST(Convert, HexBufferOverloadsDoNotAllocate)
+{
+	const unsigned char bytes[] = { 0x12, 0x34, 0xAB, 0xCD };
+	char hex[8];
+	unsigned char decoded[4];
+	// The decode table is initialized on first use
+	Convert::HexToBytes("00", 2, decoded);
+
+	AllocationCounter counter;
+	Convert::BytesToHex(bytes, sizeof(bytes), hex);
+	EXPECT_TRUE(Convert::HexToBytes(hex, sizeof(hex), decoded));
+	EXPECT_EQ(counter.Allocations(), 0u);
+	EXPECT_EQ(string(hex, sizeof(hex)), "1234abcd");
+	EXPECT_TRUE(equal(begin(bytes), end(bytes), begin(decoded)));
+}
+
+TEST(Convert, LongToHexString)
+{
+	EXPECT_EQ(Convert::LongToHexString(0), "0x0");
+	EXPECT_EQ(Convert::LongToHexString(0xABC), "0xabc");
+	EXPECT_EQ(Convert::LongToHexString((numeric_limits<long>::max)()), sizeof(long) == 4 ? "0x7fffffff" : "0x7fffffffffffffff");
+	// Negative values are shown as their two's complement, like E_ACCESSDENIED
+	const long accessDenied = static_cast<int32_t>(0x80070005);
+	EXPECT_EQ(Convert::LongToHexString(accessDenied), sizeof(long) == 4 ? "0x80070005" : "0xffffffff80070005");
+	EXPECT_EQ(Convert::LongToHexString(-1), sizeof(long) == 4 ? "0xffffffff" : "0xffffffffffffffff");
+}
+
+TEST(Convert, JoinW)
+{
+	EXPECT_EQ(Convert::JoinW({}, L", "), L"");
+	EXPECT_EQ(Convert::JoinW({ L"a" }, L", "), L"a");
+	EXPECT_EQ(Convert::JoinW({ L"a", L"", L"c" }, L", "), L"a, , c");
+	EXPECT_EQ(Convert::JoinW({ L"a", L"b" }, L""), L"ab");
+	EXPECT_EQ(Convert::JoinW({ L"a", L"b" }, nullptr), L"ab");
+}
+
+TEST(Convert, ReplaceAll)
+{
+	EXPECT_EQ(Convert::ReplaceAll("a.b.c", ".", "::"), "a::b::c");
+	EXPECT_EQ(Convert::ReplaceAll("aaa", "aa", "b"), "ba");
+	// The replacement is not searched again
+	EXPECT_EQ(Convert::ReplaceAll("ab", "a", "aa"), "aab");
+	EXPECT_EQ(Convert::ReplaceAll("abc", "x", "y"), "abc");
+	EXPECT_EQ(Convert::ReplaceAll("abc", "abc", ""), "");
+	// An empty target leaves the input unchanged instead of looping forever
+	EXPECT_EQ(Convert::ReplaceAll("abc", "", "x"), "abc");
+}
@@ -0,0 +1,105 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "Convert.h"
+#include "CryptoProvider.h"
+#include <gtest/gtest.h>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	string PBKDF2(const string& password, const string& salt, unsigned long long iterations, size_t size = 64)
+	{
+		vector<unsigned char> out(size);
+		const bool ok = CryptoProvider::Get().PBKDF2SHA512(reinterpret_cast<const unsigned char*>(password.data()), password.size(),
+			reinterpret_cast<const unsigned char*>(salt.data()), salt.size(), iterations, out.data(), out.size());
+		return ok ? Convert::BytesToHex(out) : "failed";
+	}
+}
+
+// The vectors of RFC 6070 with HMAC-SHA512 instead of HMAC-SHA1
+TEST(CryptoProvider, PBKDF2SHA512KnownAnswers)
+{
+	EXPECT_EQ(PBKDF2("password", "salt", 1),
+		"867f70cf1ade02cff3752599a3a53dc4af34c7a669815ae5d513554e1c8cf252c02d470a285a0501bad999bfe943c08f050235d7d68b1da55e63f73b60a57fce");
+	EXPECT_EQ(PBKDF2("password", "salt", 2),
+		"e1d9c16aa681708a45f5c7c4e215ceb66e011a2e9f0040713f18aefdb866d53cf76cab2868a39b9f7840edce4fef5a82be67335c77a6068e04112754f27ccf4e");
+	EXPECT_EQ(PBKDF2("password", "salt", 4096),
+		"d197b1b33db0143e018b12f3d1d1479e6cdebdcc97c5c0f87f6902e072f457b5143f30602641b3d55cd335988cb36b84376060ecd532e039b742a239434af2d5");
+	EXPECT_EQ(PBKDF2("passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096),
+		"8c0511f4c6e597c6ac6315d8f0362e225f3c501495ba23b868c005174dc4ee71115b59f9e60cd9532fa33e0f75aefe30225c583a186cd82bd4daea9724a3d3b8");
+	EXPECT_EQ(PBKDF2(string("pass\0word", 9), string("sa\0lt", 5), 4096),
+		"9d9e9c4cd21fe4be24d5b8244c759665f39d98fc12a9ca759bb021db3cfadf345844aebe70dd8b2f6966f25f3613e1187bbd24ed2ca43ed13b246e4675be7ab9");
+}
+
+TEST(CryptoProvider, PBKDF2SHA512OutputSizes)
+{
+	// Shorter output is a prefix, longer output continues with the next block
+	EXPECT_EQ(PBKDF2("password", "salt", 1, 16), "867f70cf1ade02cff3752599a3a53dc4");
+	EXPECT_EQ(PBKDF2("password", "salt", 3, 128),
+		"b6b07cb2cebf4ad84468391a543824fccffe0e0769dbe6bddf10a65673c4b648e612d44918f9ce9a19a1294cf5140628084ba994c3b21a4ef4741220b811c633"
+		"cfc0641fccbcc4164f1bbfcb1f33f595ae9aa4a33ddcce570157775980362c0ee28aa340c842a3ae84710167aea2f9ba34833cbf66a8922e5f165d886868fd3f");
+}
+
+TEST(CryptoProvider, RandomBytesAreFilledAndDiffer)
+{
+	vector<unsigned char> first(64, 0);
+	vector<unsigned char> second(64, 0);
+	ASSERT_TRUE(CryptoProvider::Get().GenerateRandom(first.data(), first.size()));
+	ASSERT_TRUE(CryptoProvider::Get().GenerateRandom(second.data(), second.size()));
+	EXPECT_NE(first, second);
+	EXPECT_NE(first, vector<unsigned char>(64, 0));
+
+	// A zero size request is valid and does not touch the buffer
+	unsigned char untouched = 0xAA;
+	EXPECT_TRUE(CryptoProvider::Get().GenerateRandom(&untouched, 0));
+	EXPECT_EQ(untouched, 0xAA);
+}
+
+TEST(CryptoProvider, RandomBytesAreUniform)
+{
+	// 256 expected per value. The bounds are more than 7 standard deviations away, a failure is not bad luck.
+	vector<unsigned char> buffer(256 * 256);
+	ASSERT_TRUE(CryptoProvider::Get().GenerateRandom(buffer.data(), buffer.size()));
+	size_t counts[256] = {};
+	for (const auto b : buffer)
+	{
+		counts[b]++;
+	}
+	for (size_t value = 0; value < 256; value++)
+	{
+		EXPECT_GT(counts[value], 140u) << "value " << value;
+		EXPECT_LT(counts[value], 372u) << "value " << value;
+	}
+}
+
+TEST(CryptoProvider, SelectKeepsTheProviderForUnknownNames)
+{
+	const string before = CryptoProvider::Get().GetName();
+	EXPECT_FALSE(CryptoProvider::Select("unknown"));
+	EXPECT_EQ(CryptoProvider::Get().GetName(), before);
+
+	ASSERT_TRUE(CryptoProvider::Select(CRYPTO_PROVIDER_OPENSSL));
+	EXPECT_EQ(CryptoProvider::Get().GetName(), CRYPTO_PROVIDER_OPENSSL);
+	EXPECT_EQ(PBKDF2("password", "salt", 1, 16), "867f70cf1ade02cff3752599a3a53dc4");
+	CryptoProvider::Select(before);
+}
@@ -0,0 +1,229 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Runs the fuzz target without libFuzzer: every input of the given files and directories, and with --mutations=N also
+// N random mutations of each. Prints the allocations and the time of each input and fails if an input exceeds the limits,
+// which are per KB of input (at least 1 KB), so that only a growth faster than the input is caught:
+//   JsonParserFuzzer [--mutations=N] [--max-allocations-per-kb=N] [--max-us-per-kb=N] [--verbose] <file or directory>...
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <csignal>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace
+{
+	struct Input
+	{
+		string name;
+		string data;
+	};
+
+	struct Result
+	{
+		string name;
+		size_t bytes = 0;
+		size_t allocations = 0;
+		size_t allocatedBytes = 0;
+		long long microseconds = 0;
+	};
+
+	string ReadFile(const string& path)
+	{
+		ifstream in(path, ios::binary);
+		stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+
+	void AddInputs(const string& path, vector<Input>& inputs)
+	{
+		DIR* dir = opendir(path.c_str());
+		if (dir == nullptr)
+		{
+			inputs.push_back({ path, ReadFile(path) });
+			return;
+		}
+
+		vector<string> names;
+		while (const dirent* entry = readdir(dir))
+		{
+			if (entry->d_name[0] != '.') names.push_back(entry->d_name);
+		}
+		closedir(dir);
+		sort(names.begin(), names.end());
+		for (const auto& name : names)
+		{
+			inputs.push_back({ path + "/" + name, ReadFile(path + "/" + name) });
+		}
+	}
+
+	// Byte flips, insertions and removals, biased to the characters of json
+	string Mutate(const string& seed, mt19937& random)
+	{
+		static const char JSON_BYTES[] = "{}[]\":,\\0123456789-+.eEtrufalsn \xC3\xA4\xF0\x9F";
+		string data = seed;
+		const int count = 1 + static_cast<int>(random() % 4);
+		for (int i = 0; i < count; i++)
+		{
+			const size_t position = data.empty() ? 0 : random() % (data.size() + 1);
+			const char c = random() % 4 == 0 ? static_cast<char>(random()) : JSON_BYTES[random() % (sizeof(JSON_BYTES) - 1)];
+			switch (random() % 4)
+			{
+				case 0:
+					if (position < data.size()) data[position] = c;
+					break;
+				case 1:
+					data.insert(position, 1, c);
+					break;
+				case 2:
+					if (position < data.size()) data.erase(position, 1 + random() % 8);
+					break;
+				default:
+					// Repeat a part, for deep nesting and long values
+					if (position < data.size())
+					{
+						const string part = data.substr(position, 1 + random() % 16);
+						for (int j = static_cast<int>(random() % 64); j > 0; j--) data.insert(position, part);
+					}
+			}
+		}
+		return data;
+	}
+
+	const Input* currentInput = nullptr;
+
+	// Like libFuzzer, keep the input that crashed as crash-input in the working directory
+	void OnCrash(int signal)
+	{
+		if (currentInput != nullptr)
+		{
+			const int fd = open("crash-input", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (fd >= 0)
+			{
+				(void)!write(fd, currentInput->data.data(), currentInput->data.size());
+				close(fd);
+			}
+			const char message[] = "Crashed, the input is saved as crash-input\n";
+			(void)!write(STDERR_FILENO, message, sizeof(message) - 1);
+		}
+		std::signal(signal, SIG_DFL);
+		raise(signal);
+	}
+
+	Result Run(const Input& input)
+	{
+		currentInput = &input;
+		Result result;
+		result.name = input.name;
+		result.bytes = input.data.size();
+		const AllocationCounter counter;
+		const auto start = chrono::steady_clock::now();
+		LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(input.data.data()), input.data.size());
+		result.microseconds = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+		result.allocations = counter.Allocations();
+		result.allocatedBytes = counter.Bytes();
+		currentInput = nullptr;
+		return result;
+	}
+
+	void Print(const Result& result)
+	{
+		printf("%-60s %8zu %8zu %10zu %8lld\n", result.name.c_str(), result.bytes, result.allocations, result.allocatedBytes,
+			result.microseconds);
+	}
+
+	bool Option(const char* arg, const char* name, long long& value)
+	{
+		const size_t length = strlen(name);
+		if (strncmp(arg, name, length) != 0) return false;
+		value = atoll(arg + length);
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	LLVMFuzzerInitialize(&argc, &argv);
+	for (const int signal : { SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL })
+	{
+		std::signal(signal, OnCrash);
+	}
+
+	long long mutations = 0, maxAllocationsPerKB = 0, maxMicrosecondsPerKB = 0;
+	bool verbose = false;
+	vector<Input> seeds;
+	for (int i = 1; i < argc; i++)
+	{
+		if (Option(argv[i], "--mutations=", mutations) || Option(argv[i], "--max-allocations-per-kb=", maxAllocationsPerKB)
+			|| Option(argv[i], "--max-us-per-kb=", maxMicrosecondsPerKB)) continue;
+		if (strcmp(argv[i], "--verbose") == 0) verbose = true;
+		else AddInputs(argv[i], seeds);
+	}
+
+	printf("%-60s %8s %8s %10s %8s\n", "input", "bytes", "allocs", "alloc-bytes", "us");
+	mt19937 random(1);
+	Result worstAllocations, worstTime;
+	size_t runs = 0, failures = 0;
+	for (const auto& seed : seeds)
+	{
+		for (long long m = 0; m <= mutations; m++)
+		{
+			const Input input = m == 0 ? seed : Input{ seed.name + "~" + to_string(m), Mutate(seed.data, random) };
+			const Result result = Run(input);
+			runs++;
+
+			const long long kilobytes = max<long long>(1, static_cast<long long>(result.bytes / 1024));
+			const bool failed = (maxAllocationsPerKB > 0 && static_cast<long long>(result.allocations) > maxAllocationsPerKB * kilobytes)
+				|| (maxMicrosecondsPerKB > 0 && result.microseconds > maxMicrosecondsPerKB * kilobytes);
+			if (failed)
+			{
+				failures++;
+				printf("LIMIT EXCEEDED ");
+				// Keep the input to reproduce it
+				ofstream(input.name.substr(input.name.find_last_of('/') + 1) + ".fail", ios::binary) << input.data;
+			}
+			if (m == 0 || failed || verbose) Print(result);
+
+			if (result.allocations > worstAllocations.allocations) worstAllocations = result;
+			if (result.microseconds > worstTime.microseconds) worstTime = result;
+		}
+	}
+
+	printf("\n%zu inputs, %zu over the limits. Most allocations and slowest:\n", runs, failures);
+	Print(worstAllocations);
+	Print(worstTime);
+	return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Fuzz target for the parsers of the server responses and the offline file. Built as a libFuzzer target with
+// -DPI_FUZZ_LIBFUZZER=ON (clang), otherwise FuzzMain.cpp replays and mutates the corpus and reports the allocations
+// and the time per input.
+#include "JsonParser.h"
+#include "Logger.h"
+#include "ResponseStreamParser.h"
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	// Like DescribeResponse of the tests, only what the parsers must agree on
+	string Describe(HRESULT res, const PIResponse& response, const vector<OfflineData>& offlineData)
+	{
+		string description = to_string(res) + (response.status ? " s" : " -") + (response.value ? "v " : "- ")
+			+ to_string(response.errorCode) + response.errorMessage + response.message + response.transactionId
+			+ response.preferredMode + " " + to_string(response.challenges.size());
+		for (const auto& data : offlineData)
+		{
+			description += " " + data.username + data.serial + data.refilltoken + to_string(data.offlineOTPs.size());
+		}
+		return description;
+	}
+
+	void Check(bool condition)
+	{
+		// Let the fuzzer save the input
+		if (!condition) abort();
+	}
+}
+
+extern "C" int LLVMFuzzerInitialize(int*, char***)
+{
+	Logger::Get().logfilePath = "JsonParserFuzzer.log";
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+	const string input(reinterpret_cast<const char*>(data), size);
+	JsonParser parser;
+
+	// The response as received by the client, with the backend of the build
+	PIResponse response;
+	vector<OfflineData> offlineData;
+	const HRESULT res = parser.ParseResponse(input, response, offlineData);
+
+	// The streaming parser gives the same result wherever the input is split. The first byte selects the split.
+	ResponseStreamParser streamParser;
+	const size_t split = size > 0 ? data[0] % (size + 1) : 0;
+	streamParser.Feed(input.data(), split);
+	streamParser.Feed(input.data() + split, size - split);
+	PIResponse streamResponse;
+	vector<OfflineData> streamOfflineData;
+	const HRESULT streamRes = streamParser.Finish(streamResponse, streamOfflineData);
+
+	ResponseStreamParser wholeParser;
+	wholeParser.Feed(input);
+	PIResponse wholeResponse;
+	vector<OfflineData> wholeOfflineData;
+	const HRESULT wholeRes = wholeParser.Finish(wholeResponse, wholeOfflineData);
+	Check(Describe(streamRes, streamResponse, streamOfflineData) == Describe(wholeRes, wholeResponse, wholeOfflineData));
+
+	// The offline file, which is written by the client but can be damaged
+	const auto fileData = parser.ParseFileContentsForOfflineData(input);
+
+	// The other inputs from the server
+	parser.GetErrorCode(input);
+	parser.IsStillActiveOfflineToken(input);
+	parser.ParsePollTransaction(input);
+	parser.GetRefilltoken(input);
+	OfflineData refill;
+	parser.ParseRefillResponse(input, "alice", refill);
+	vector<string> protectedOTPs;
+	parser.ParseOfflineRefillJobs(input, protectedOTPs);
+
+	(void)res;
+	(void)fileData;
+	return 0;
+}
@@ -0,0 +1,143 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "AllocationCounter.h"
+#include "Convert.h"
+#include "IdentityKey.h"
+#include <gtest/gtest.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+using namespace std;
+
+namespace
+{
+	// The mapping outside of ASCII comes from the system, the C.UTF-8 locale outside of Windows
+	bool HasUnicodeCaseMapping()
+	{
+		return Convert::ToUpperCase(wstring(L"\u00E4")) == L"\u00C4";
+	}
+}
+
+TEST(IdentityKey, AsciiIsCaseInsensitive)
+{
+	const IdentityKey key(wstring(L"Administrator"));
+	EXPECT_EQ(key, IdentityKey(wstring(L"ADMINISTRATOR")));
+	EXPECT_EQ(key, IdentityKey(string("administrator")));
+	EXPECT_EQ(key.GetHash(), IdentityKey(wstring(L"aDmInIsTrAtOr")).GetHash());
+	EXPECT_EQ(key.GetFolded(), L"ADMINISTRATOR");
+
+	EXPECT_NE(key, IdentityKey(wstring(L"Administrators")));
+	EXPECT_NE(key, IdentityKey(wstring(L"Administrat0r")));
+	EXPECT_NE(IdentityKey(wstring(L"DOMAIN\\user")), IdentityKey(wstring(L"DOMAIN/user")));
+}
+
+TEST(IdentityKey, EmptyName)
+{
+	EXPECT_EQ(IdentityKey(), IdentityKey(wstring()));
+	EXPECT_EQ(IdentityKey().GetHash(), IdentityKey(string()).GetHash());
+	EXPECT_TRUE(IdentityKey().Matches(wstring()));
+	EXPECT_TRUE(IdentityKey().Matches(string()));
+	EXPECT_FALSE(IdentityKey().Matches(wstring(L"a")));
+}
+
+TEST(IdentityKey, UnicodeIsCaseInsensitive)
+{
+	if (!HasUnicodeCaseMapping()) GTEST_SKIP() << "No Unicode case mapping on this system";
+
+	const IdentityKey key(wstring(L"J\u00FCrgen.M\u00FCller"));
+	EXPECT_EQ(key, IdentityKey(wstring(L"J\u00DCRGEN.M\u00DCLLER")));
+	// The same name in UTF-8
+	EXPECT_EQ(key, IdentityKey(string("j\xC3\xBCrgen.m\xC3\xBCller")));
+	EXPECT_TRUE(key.Matches(string("J\xC3\x9CRGEN.m\xC3\xBCller")));
+	EXPECT_TRUE(IdentityKey(wstring(L"\u0434\u043C\u0438\u0442\u0440\u0438\u0439")).Matches(wstring(L"\u0414\u041C\u0418\u0422\u0420\u0418\u0419")));
+	// Simple mapping: both forms of the small sigma are the capital sigma
+	EXPECT_EQ(IdentityKey(wstring(L"\u03C3")), IdentityKey(wstring(L"\u03C2")));
+
+	// The mapping keeps the length, so sharp s is not expanded to SS
+	EXPECT_NE(IdentityKey(wstring(L"Stra\u00DFe")), IdentityKey(wstring(L"STRASSE")));
+	EXPECT_NE(key, IdentityKey(wstring(L"Jurgen.Muller")));
+}
+
+TEST(IdentityKey, MatchesAgreesWithEquality)
+{
+	const wstring names[] = { L"user", L"USER", L"User1", L"us", L"DOMAIN\\user", L"user@example.com", L"\u00C4rger",
+		L"\u00E4rger", L"\U0001F600", L"" };
+	for (const auto& a : names)
+	{
+		const IdentityKey key(a);
+		for (const auto& b : names)
+		{
+			const bool equal = key == IdentityKey(b);
+			EXPECT_EQ(key.Matches(b), equal);
+			EXPECT_EQ(key.Matches(Convert::ToString(b)), equal);
+			if (equal) EXPECT_EQ(key.GetHash(), IdentityKey(b).GetHash());
+		}
+	}
+}
+
+TEST(IdentityKey, LongNames)
+{
+	// Longer than the buffer that Matches uses on the stack
+	const wstring lower(2000, L'a');
+	const wstring upper(2000, L'A');
+	const IdentityKey key(lower);
+	EXPECT_TRUE(key.Matches(upper));
+	EXPECT_TRUE(key.Matches(string(2000, 'A')));
+	EXPECT_FALSE(key.Matches(upper + L"A"));
+	EXPECT_FALSE(key.Matches(string(2001, 'A')));
+	EXPECT_FALSE(IdentityKey(wstring(L"a")).Matches(string(2000, 'a')));
+}
+
+TEST(IdentityKey, MatchesDoesNotAllocate)
+{
+	const IdentityKey key(wstring(L"J\u00FCrgen.M\u00FCller@example.com"));
+	const wstring wide = L"J\u00DCRGEN.M\u00DCLLER@EXAMPLE.COM";
+	const string utf8 = "j\xC3\xBCrgen.m\xC3\xBCller@example.com";
+	const wstring other = L"someone.else@example.com";
+	// The locale is created on first use
+	key.Matches(wide);
+
+	AllocationCounter counter;
+	const bool matches = key.Matches(wide) && key.Matches(utf8) && !key.Matches(other);
+	EXPECT_EQ(counter.Allocations(), 0u);
+	if (HasUnicodeCaseMapping()) EXPECT_TRUE(matches);
+}
+
+TEST(IdentityKey, Containers)
+{
+	unordered_map<IdentityKey, int, IdentityKey::Hash> hashed;
+	map<IdentityKey, int> ordered;
+	const wstring names[] = { L"alice", L"Bob", L"CAROL", L"DOMAIN\\dave" };
+	for (int i = 0; i < 4; i++)
+	{
+		hashed.emplace(IdentityKey(names[i]), i);
+		ordered.emplace(IdentityKey(names[i]), i);
+	}
+
+	EXPECT_EQ(hashed.at(IdentityKey(wstring(L"ALICE"))), 0);
+	EXPECT_EQ(hashed.at(IdentityKey(string("bob"))), 1);
+	EXPECT_EQ(ordered.at(IdentityKey(wstring(L"Carol"))), 2);
+	EXPECT_EQ(ordered.at(IdentityKey(wstring(L"domain\\DAVE"))), 3);
+	EXPECT_EQ(hashed.count(IdentityKey(wstring(L"eve"))), 0u);
+	// A name in another case is the same entry
+	EXPECT_FALSE(hashed.emplace(IdentityKey(wstring(L"ALICE")), 4).second);
+	EXPECT_FALSE(ordered.emplace(IdentityKey(wstring(L"ALICE")), 4).second);
+}
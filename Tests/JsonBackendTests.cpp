@@ -0,0 +1,122 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "JsonBackend.h"
+#include "JsonParser.h"
+#include "TestUtils.h"
+#include <gtest/gtest.h>
+#include <dirent.h>
+
+using namespace std;
+
+namespace
+{
+	// Files of Tests/Corpus starting with prefix: response-* are valid responses, invalid-* must be rejected and
+	// offline-* are offline files
+	vector<string> CorpusFiles(const string& prefix)
+	{
+		vector<string> files;
+		DIR* dir = opendir(PI_TEST_CORPUS_DIR);
+		if (dir == nullptr) return files;
+		while (const dirent* entry = readdir(dir))
+		{
+			const string name = entry->d_name;
+			if (name.compare(0, prefix.size(), prefix) == 0)
+			{
+				files.push_back(name);
+			}
+		}
+		closedir(dir);
+		sort(files.begin(), files.end());
+		return files;
+	}
+
+	string ReadCorpusFile(const string& name)
+	{
+		ifstream in(string(PI_TEST_CORPUS_DIR) + "/" + name, ios::binary);
+		stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+
+	HRESULT ParseResponse(JsonBackend& backend, const string& input, string& description)
+	{
+		PIResponse response;
+		vector<OfflineData> offlineData;
+		const HRESULT res = backend.ParseResponse(input, response, offlineData);
+		description = DescribeResponse(response, offlineData);
+		return res;
+	}
+}
+
+TEST(JsonBackend, CorpusIsParsed)
+{
+	auto& backend = JsonBackend::Get();
+	ASSERT_FALSE(CorpusFiles("response-").empty());
+	for (const auto& name : CorpusFiles("response-"))
+	{
+		string description;
+		EXPECT_EQ(ParseResponse(backend, ReadCorpusFile(name), description), S_OK) << name;
+	}
+
+	for (const auto& name : CorpusFiles("invalid-"))
+	{
+		string description;
+		EXPECT_EQ(ParseResponse(backend, ReadCorpusFile(name), description), PI_JSON_PARSE_ERROR) << name;
+	}
+
+	for (const auto& name : CorpusFiles("offline-"))
+	{
+		EXPECT_FALSE(backend.ParseOfflineFile(ReadCorpusFile(name)).empty()) << name;
+	}
+}
+
+// Both backends must give the same values for the same input
+TEST(JsonBackend, BackendsAgreeOnTheCorpus)
+{
+	JsonBackend* nlohmann = JsonBackend::Get("nlohmann");
+	JsonBackend* simdjson = JsonBackend::Get("simdjson");
+	ASSERT_NE(nlohmann, nullptr);
+	if (simdjson == nullptr)
+	{
+		GTEST_SKIP() << "Built without PI_JSON_SIMDJSON";
+	}
+
+	for (const auto& prefix : { "response-", "invalid-" })
+	{
+		for (const auto& name : CorpusFiles(prefix))
+		{
+			const string input = ReadCorpusFile(name);
+			string expected, actual;
+			const HRESULT expectedResult = ParseResponse(*nlohmann, input, expected);
+			EXPECT_EQ(ParseResponse(*simdjson, input, actual), expectedResult) << name;
+			if (expectedResult == S_OK)
+			{
+				EXPECT_EQ(actual, expected) << name;
+			}
+		}
+	}
+
+	for (const auto& name : CorpusFiles("offline-"))
+	{
+		const string input = ReadCorpusFile(name);
+		EXPECT_EQ(DescribeResponse(PIResponse(), simdjson->ParseOfflineFile(input)),
+			DescribeResponse(PIResponse(), nlohmann->ParseOfflineFile(input))) << name;
+	}
+}
@@ -0,0 +1,36 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "JsonParser.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+TEST(JsonParser, GetErrorCode)
+{
+	JsonParser parser;
+	EXPECT_EQ(parser.GetErrorCode(R"({"result":{"status":false,"error":{"code":905,"message":"not offline"}}})"), 905);
+	EXPECT_EQ(parser.GetErrorCode(R"({"result":{"status":false,"error":{"message":"no code"}}})"), -1);
+	EXPECT_EQ(parser.GetErrorCode(R"({"result":{"status":true,"value":true}})"), 0);
+	// Not an answer of the server, e.g. the page of a proxy
+	EXPECT_EQ(parser.GetErrorCode("<html>Bad Gateway</html>"), 0);
+
+	EXPECT_FALSE(parser.IsStillActiveOfflineToken(R"({"result":{"error":{"code":905}}})"));
+	EXPECT_TRUE(parser.IsStillActiveOfflineToken(R"({"result":{"error":{"code":10}}})"));
+}
@@ -0,0 +1,145 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "Logger.h"
+#include "TestUtils.h"
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	// Logs into a file of its own while it exists
+	class LogFile : public TempFile
+	{
+	public:
+		explicit LogFile(const string& name) : TempFile(name)
+		{
+			// The writer keeps the current file open
+			Logger::Get().Flush();
+			_previousPath = Logger::Get().logfilePath;
+			Logger::Get().logfilePath = Path();
+		}
+
+		~LogFile()
+		{
+			Logger::Get().Flush();
+			Logger::Get().logfilePath = _previousPath;
+		}
+
+		// Wait until the writer thread has written the text
+		bool WaitFor(const string& text, chrono::milliseconds timeout) const
+		{
+			const auto deadline = chrono::steady_clock::now() + timeout;
+			while (Read().find(text) == string::npos)
+			{
+				if (chrono::steady_clock::now() > deadline) return false;
+				this_thread::sleep_for(chrono::milliseconds(10));
+			}
+			return true;
+		}
+
+	private:
+		string _previousPath;
+	};
+
+	bool WaitForWriterExit(chrono::milliseconds timeout)
+	{
+		const auto deadline = chrono::steady_clock::now() + timeout;
+		while (Logger::Get().IsWriterRunning())
+		{
+			if (chrono::steady_clock::now() > deadline) return false;
+			this_thread::sleep_for(chrono::milliseconds(10));
+		}
+		return true;
+	}
+}
+
+TEST(Logger, WritesWithoutFlush)
+{
+	LogFile file("writes.log");
+	PIError("first message");
+	PIErrorF("second message {}", 2);
+	EXPECT_TRUE(file.WaitFor("second message 2", chrono::seconds(5)));
+	EXPECT_NE(file.Read().find("first message"), string::npos);
+}
+
+TEST(Logger, FlushWritesAndStopsTheWriter)
+{
+	LogFile file("flush.log");
+	PIError("flushed message");
+	Logger::Get().Flush();
+	EXPECT_FALSE(Logger::Get().IsWriterRunning());
+	EXPECT_NE(file.Read().find("flushed message"), string::npos);
+}
+
+// The writer thread must not outlive the last message by much, the module can be unloaded after that
+TEST(Logger, WriterExitsWhenIdle)
+{
+	LogFile file("idle.log");
+	PIError("before idle");
+	EXPECT_TRUE(Logger::Get().IsWriterRunning());
+	ASSERT_TRUE(file.WaitFor("before idle", chrono::seconds(5)));
+	EXPECT_TRUE(WaitForWriterExit(chrono::milliseconds(LOGGER_IDLE_EXIT_MS + 2000)));
+
+	// The next message starts it again
+	PIError("after idle");
+	EXPECT_TRUE(Logger::Get().IsWriterRunning());
+	EXPECT_TRUE(file.WaitFor("after idle", chrono::seconds(5)));
+}
+
+TEST(Logger, NoMessageIsLostWhileTheWriterExits)
+{
+	LogFile file("exiting.log");
+	PIError("warm up");
+	ASSERT_TRUE(file.WaitFor("warm up", chrono::seconds(5)));
+
+	// Messages from several threads around the time the idle writer decides to exit
+	vector<thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.emplace_back([t]()
+			{
+				this_thread::sleep_for(chrono::milliseconds(LOGGER_IDLE_EXIT_MS - 50 + 25 * t));
+				for (int i = 0; i < 50; i++)
+				{
+					PIErrorF("thread {} message {}", t, i);
+					this_thread::sleep_for(chrono::milliseconds(1));
+				}
+			});
+	}
+	for (auto& thread : threads) thread.join();
+
+	for (int t = 0; t < 4; t++)
+	{
+		EXPECT_TRUE(file.WaitFor("thread " + to_string(t) + " message 49", chrono::seconds(5))) << t;
+	}
+	const string content = file.Read();
+	for (int t = 0; t < 4; t++)
+	{
+		for (int i = 0; i < 50; i++)
+		{
+			EXPECT_NE(content.find("thread " + to_string(t) + " message " + to_string(i) + "\n"), string::npos) << t << " " << i;
+		}
+	}
+}
@@ -0,0 +1,153 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "JsonParser.h"
+#include "OfflineData.h"
+#include "OfflineHandler.h"
+#include "TestUtils.h"
+#include <gtest/gtest.h>
+#include <cmath>
+#include <sstream>
+
+using namespace std;
+
+namespace
+{
+	constexpr time_t DAY = 86400;
+	constexpr time_t START = 1700000000;
+}
+
+TEST(OfflineData, FirstConsumptionOnlyRecordsTheTime)
+{
+	OfflineData data;
+	data.RecordConsumption(3, START);
+	EXPECT_EQ(data.consumptionRate, 0.0);
+	EXPECT_EQ(data.lastConsumption, START);
+}
+
+TEST(OfflineData, ConsumptionRateIsAMovingAverage)
+{
+	OfflineData data;
+	data.RecordConsumption(1, START);
+	data.RecordConsumption(5, START + DAY);
+	EXPECT_DOUBLE_EQ(data.consumptionRate, 5.0);
+
+	// 12 OTPs in 2 days is a rate of 6, weighted with the 2 days that passed against the time constant of 7 days
+	data.RecordConsumption(12, START + 3 * DAY);
+	const double weight = 1.0 - exp(-2.0 / 7.0);
+	EXPECT_DOUBLE_EQ(data.consumptionRate, weight * 6.0 + (1.0 - weight) * 5.0);
+	EXPECT_EQ(data.lastConsumption, START + 3 * DAY);
+
+	// After a long break, the new rate dominates
+	data.RecordConsumption(60, START + 63 * DAY);
+	EXPECT_NEAR(data.consumptionRate, 1.0, 0.01);
+}
+
+TEST(OfflineData, ShortIntervalsDoNotInflateTheRate)
+{
+	OfflineData data;
+	data.RecordConsumption(1, START);
+	// Two OTPs 10 minutes later count as two in an hour
+	data.RecordConsumption(2, START + 600);
+	EXPECT_DOUBLE_EQ(data.consumptionRate, 48.0);
+}
+
+TEST(OfflineData, ClockGoingBackIsIgnored)
+{
+	OfflineData data;
+	data.RecordConsumption(1, START);
+	data.RecordConsumption(5, START + DAY);
+	data.RecordConsumption(100, START);
+	EXPECT_DOUBLE_EQ(data.consumptionRate, 5.0);
+	EXPECT_EQ(data.lastConsumption, START + DAY);
+}
+
+TEST(OfflineData, ConsumptionIsPersisted)
+{
+	OfflineData data = MakeOfflineData("alice", "HOTP1", 2);
+	data.consumptionRate = 2.5;
+	data.lastConsumption = START;
+
+	JsonParser parser;
+	ostringstream out;
+	parser.WriteOfflineData(out, { data }, true);
+	const auto parsed = parser.ParseFileContentsForOfflineData(out.str());
+	ASSERT_EQ(parsed.size(), 1u);
+	EXPECT_DOUBLE_EQ(parsed[0].consumptionRate, 2.5);
+	EXPECT_EQ(parsed[0].lastConsumption, START);
+}
+
+TEST(OfflineData, NonFiniteRateIsWrittenAsNull)
+{
+	JsonParser parser;
+	for (const double rate : { NAN, INFINITY, -INFINITY })
+	{
+		OfflineData data = MakeOfflineData("alice", "HOTP1", 2);
+		data.consumptionRate = rate;
+
+		ostringstream out;
+		parser.WriteOfflineData(out, { data }, true);
+		EXPECT_NE(out.str().find(R"("consumption_rate":null)"), string::npos) << out.str();
+
+		// The file stays valid and is read back without the rate
+		const auto parsed = parser.ParseFileContentsForOfflineData(out.str());
+		ASSERT_EQ(parsed.size(), 1u) << out.str();
+		EXPECT_EQ(parsed[0].consumptionRate, 0.0);
+		EXPECT_EQ(parsed[0].offlineOTPs.size(), 2u);
+	}
+}
+
+TEST(OfflineHandler, ShouldRefillUsesTheRateIfKnown)
+{
+	TempFile file("refill.json");
+	OfflineHandler handler(file.WPath(), 10);
+	OfflineData data = MakeOfflineData("alice", "HOTP1", 20);
+	ASSERT_EQ(handler.AddOfflineData(data), S_OK);
+
+	// No rate yet, only the threshold counts
+	EXPECT_FALSE(handler.ShouldRefill("alice", "HOTP1", 10, 3.0));
+	EXPECT_TRUE(handler.ShouldRefill("alice", "HOTP1", 25, 3.0));
+	EXPECT_TRUE(handler.ShouldRefill("alice", "HOTP1", 0, 0.0));
+	EXPECT_FALSE(handler.ShouldRefill("bob", "HOTP1", 0, 0.0));
+
+	// 10 per day for 3 days needs 30
+	data = MakeOfflineData("bob", "HOTP2", 20);
+	data.consumptionRate = 10.0;
+	ASSERT_EQ(handler.AddOfflineData(data), S_OK);
+	EXPECT_TRUE(handler.ShouldRefill("bob", "HOTP2", 5, 3.0));
+	EXPECT_FALSE(handler.ShouldRefill("bob", "HOTP2", 5, 1.5));
+	// Without autonomy days, the threshold is used even if the rate is known
+	EXPECT_FALSE(handler.ShouldRefill("bob", "HOTP2", 5, 0.0));
+}
+
+TEST(OfflineHandler, VerifyRecordsTheConsumption)
+{
+	TempFile file("consumption.json");
+	{
+		OfflineHandler handler(file.WPath(), 10);
+		ASSERT_EQ(handler.AddOfflineData(MakeOfflineData("alice", "HOTP1", 5)), S_OK);
+		string serial;
+		ASSERT_EQ(handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(1)).c_str()), "alice", serial), S_OK);
+	}
+
+	const auto parsed = JsonParser().ParseFileContentsForOfflineData(file.Read());
+	ASSERT_EQ(parsed.size(), 1u);
+	EXPECT_GT(parsed[0].lastConsumption, 0);
+	EXPECT_EQ(parsed[0].lastConsumption, parsed[0].lastUsed);
+}
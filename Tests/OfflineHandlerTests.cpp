@@ -0,0 +1,463 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "OfflineHandler.h"
+#include "OfflineFileLock.h"
+#include "JsonParser.h"
+#include "TestUtils.h"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <csignal>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+TEST(OfflineHandler, VerifyConsumesOTPsUpToTheMatch)
+{
+	TempFile file("verify.json");
+	OfflineHandler handler(file.WPath(), 10);
+	ASSERT_EQ(handler.AddOfflineData(MakeOfflineData("alice", "HOTP1", 20)), S_OK);
+
+	string serial;
+	EXPECT_EQ(handler.VerifyOfflineOTP(SecureWString(L"999999"), "alice", serial), E_FAIL);
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 20u);
+
+	ASSERT_EQ(handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(3)).c_str()), "ALICE", serial), S_OK);
+	EXPECT_EQ(serial, "HOTP1");
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 16u);
+
+	// A used OTP can not be used again
+	EXPECT_NE(handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(3)).c_str()), "alice", serial), S_OK);
+}
+
+TEST(OfflineHandler, VerifyCopiesTheOTPOnce)
+{
+	TempFile file("verifycopies.json");
+	OfflineHandler handler(file.WPath(), 10);
+	ASSERT_EQ(handler.AddOfflineData(MakeOfflineData("alice", "HOTP1", 20)), S_OK);
+
+	// The UTF-8 form for the verifier is the only copy, however many stored values are tried
+	string serial;
+	const SecureWString otp(L"999999");
+	const size_t before = SecurePool::Get().GetAllocationCount();
+	EXPECT_EQ(handler.VerifyOfflineOTP(otp, "alice", serial), E_FAIL);
+	EXPECT_EQ(SecurePool::Get().GetAllocationCount() - before, 1u);
+}
+
+TEST(OfflineHandler, VerifiesValuesOfPasslib)
+{
+	TempFile file("passlib.json");
+	OfflineHandler handler(file.WPath(), 10);
+	OfflineData data = MakeOfflineData("alice", "HOTP1", 0);
+	// passlib.hash.pbkdf2_sha512.using(rounds=10000, salt=bytes(range(16))).hash("123456")
+	data.offlineOTPs["0"] = "$pbkdf2-sha512$10000$AAECAwQFBgcICQoLDA0ODw$"
+		"vU/OCANO0HKKuaLrqcQii5nkc6jl5jFWz5tvwiZiTgoeI5.14uCZNBjBcy2PGdIeUqeUIl30COZi4TED.yX6DA";
+	data.rounds = 10000;
+	ASSERT_EQ(handler.AddOfflineData(data), S_OK);
+
+	string serial;
+	EXPECT_EQ(handler.VerifyOfflineOTP(SecureWString(L"123457"), "alice", serial), E_FAIL);
+	EXPECT_EQ(handler.VerifyOfflineOTP(SecureWString(L"123456"), "alice", serial), S_OK);
+	EXPECT_EQ(serial, "HOTP1");
+}
+
+TEST(OfflineHandler, SharedStoreSeesChangesOfOtherHandlers)
+{
+	TempFile file("shared.json");
+	OfflineHandler first(file.WPath(), 10, true);
+	OfflineHandler second(file.WPath(), 10, true);
+
+	ASSERT_EQ(first.AddOfflineData(MakeOfflineData("alice", "HOTP1", 10)), S_OK);
+	ASSERT_EQ(second.AddOfflineData(MakeOfflineData("bob", "HOTP2", 10)), S_OK);
+	EXPECT_EQ(first.GetOfflineOTPCount("bob", "HOTP2"), 10u);
+
+	string serial;
+	ASSERT_EQ(second.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(0)).c_str()), "alice", serial), S_OK);
+	EXPECT_EQ(first.GetOfflineOTPCount("alice", "HOTP1"), 9u);
+
+	// The OTP was consumed by the other handler
+	EXPECT_NE(first.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(0)).c_str()), "alice", serial), S_OK);
+}
+
+namespace
+{
+	// Offline file content of a token with count OTPs, padded to size if given
+	string OfflineFileContent(int count, size_t size = 0)
+	{
+		ostringstream out;
+		JsonParser().WriteOfflineData(out, { MakeOfflineData("alice", "HOTP1", count) }, true);
+		string content = out.str();
+		if (content.size() < size)
+		{
+			content.append(size - content.size(), ' ');
+		}
+		return content;
+	}
+
+	void SetWriteTime(const TempFile& file, time_t time)
+	{
+		struct timespec times[2] = { { time, 0 }, { time, 0 } };
+		ASSERT_EQ(utimensat(AT_FDCWD, file.Path().c_str(), times, 0), 0);
+	}
+}
+
+TEST(OfflineHandler, SharedStoreReloadsOnlyIfTheFileChanged)
+{
+	TempFile file("reload.json");
+	const time_t now = time(nullptr);
+	const string five = OfflineFileContent(5);
+	file.Write(five);
+	SetWriteTime(file, now - 100);
+
+	OfflineHandler handler(file.WPath(), 10, true);
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 5u);
+
+	// Same size and time, the file is not read again
+	const string four = OfflineFileContent(4, five.size());
+	ASSERT_EQ(four.size(), five.size());
+	file.Write(four);
+	SetWriteTime(file, now - 100);
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 5u);
+
+	SetWriteTime(file, now - 50);
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 4u);
+
+	// A recent write can not be told apart from the next one by time, so the file is read again until it is older
+	file.Write(five);
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 5u);
+	file.Write(four);
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 4u);
+}
+
+TEST(OfflineHandler, SharedStoreReadersSeeEveryChangeInOrder)
+{
+	TempFile file("readers.json");
+	constexpr int OTPS = 30;
+	constexpr int READERS = 4;
+	OfflineHandler writer(file.WPath(), 10, true);
+	ASSERT_EQ(writer.AddOfflineData(MakeOfflineData("alice", "HOTP1", OTPS)), S_OK);
+
+	// One handler used by several threads and one handler per thread
+	OfflineHandler sharedReader(file.WPath(), 10, true);
+	atomic<bool> done{ false };
+	atomic<int> errors{ 0 };
+	vector<thread> readers;
+	for (int r = 0; r < READERS; r++)
+	{
+		readers.emplace_back([&, r]()
+			{
+				unique_ptr<OfflineHandler> own;
+				if (r % 2 == 1)
+				{
+					own.reset(new OfflineHandler(file.WPath(), 10, true));
+				}
+				OfflineHandler& reader = own ? *own : sharedReader;
+				size_t last = OTPS;
+				while (!done.load())
+				{
+					const size_t count = reader.GetOfflineOTPCount("alice", "HOTP1");
+					// Consumed OTPs never come back
+					if (count > last)
+					{
+						errors++;
+					}
+					last = count;
+				}
+				if (reader.GetOfflineOTPCount("alice", "HOTP1") != 0)
+				{
+					errors++;
+				}
+			});
+	}
+
+	string serial;
+	for (int i = 0; i < OTPS; i++)
+	{
+		EXPECT_EQ(writer.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(i)).c_str()), "alice", serial), S_OK);
+	}
+	done = true;
+	for (auto& t : readers)
+	{
+		t.join();
+	}
+
+	EXPECT_EQ(errors.load(), 0);
+}
+
+TEST(OfflineHandler, SharedStoreChangesFailWithoutTheLock)
+{
+	TempFile file("locked.json");
+	OfflineHandler handler(file.WPath(), 10, true);
+	ASSERT_EQ(handler.AddOfflineData(MakeOfflineData("alice", "HOTP1", 10)), S_OK);
+	const string before = file.Read();
+
+	// Another handle holds the lock, like a hanging process. The lock of a handle also excludes other handles of the
+	// same process.
+	OfflineFileLock other(file.WPath(), true, true);
+	ASSERT_TRUE(other.IsLocked());
+
+	EXPECT_EQ(handler.AddOfflineData(MakeOfflineData("bob", "HOTP2", 10)), PI_OFFLINE_FILE_LOCKED);
+	string serial;
+	EXPECT_EQ(handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(0)).c_str()), "alice", serial), PI_OFFLINE_FILE_LOCKED);
+	EXPECT_EQ(file.Read(), before);
+}
+
+TEST(OfflineHandler, SharedStoreThreadsWithOwnHandlersDoNotLoseUpdates)
+{
+	TempFile file("threads.json");
+	constexpr int THREADS = 4;
+	constexpr int USERS_PER_THREAD = 10;
+
+	vector<thread> threads;
+	for (int t = 0; t < THREADS; t++)
+	{
+		threads.emplace_back([&file, t]()
+			{
+				OfflineHandler handler(file.WPath(), 10, true);
+				for (int u = 0; u < USERS_PER_THREAD; u++)
+				{
+					handler.AddOfflineData(MakeOfflineData("user" + to_string(t) + "_" + to_string(u), "HOTP", 2));
+				}
+			});
+	}
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+
+	OfflineHandler reader(file.WPath(), 10, true);
+	for (int t = 0; t < THREADS; t++)
+	{
+		for (int u = 0; u < USERS_PER_THREAD; u++)
+		{
+			EXPECT_EQ(reader.GetOfflineOTPCount("user" + to_string(t) + "_" + to_string(u), "HOTP"), 2u);
+		}
+	}
+}
+
+TEST(OfflineHandler, SharedStoreRejectsOTPsThatCouldNotBeSaved)
+{
+	TempFile file("writefails.json");
+	{
+		OfflineHandler setup(file.WPath(), 10, true);
+		ASSERT_EQ(setup.AddOfflineData(MakeOfflineData("alice", "HOTP1", 20)), S_OK);
+	}
+
+	// In a child process, because the file size limit applies to the whole process
+	const pid_t pid = fork();
+	ASSERT_GE(pid, 0);
+	if (pid == 0)
+	{
+		OfflineHandler handler(file.WPath(), 10, true);
+		// Writes beyond the limit fail with EFBIG instead of raising SIGXFSZ
+		signal(SIGXFSZ, SIG_IGN);
+		const rlimit limit = { 64, 64 };
+		setrlimit(RLIMIT_FSIZE, &limit);
+
+		string serial;
+		const HRESULT verified = handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(0)).c_str()), "alice", serial);
+		// The file is truncated by the failed write, all further changes must fail as well
+		const bool refilltoken = handler.UpdateRefilltoken("HOTP1", "new-refilltoken");
+		const HRESULT marked = handler.MarkUsed("alice", "HOTP1");
+		const bool removed = handler.RemoveOfflineData("alice", "HOTP1");
+		const bool ok = verified == PI_OFFLINE_FILE_WRITE_FAILED && serial.empty() && !refilltoken && marked != S_OK && !removed;
+		_exit(ok ? 0 : 1);
+	}
+
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	ASSERT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 0);
+}
+
+TEST(OfflineHandler, SharedStoreProcessesDoNotLoseUpdates)
+{
+	TempFile file("processes.json");
+	constexpr int PROCESSES = 4;
+	constexpr int OTPS = 40;
+
+	// All processes consume OTPs of the same token, every OTP must be accepted exactly once
+	{
+		OfflineHandler setup(file.WPath(), OTPS, true);
+		ASSERT_EQ(setup.AddOfflineData(MakeOfflineData("alice", "HOTP1", OTPS)), S_OK);
+	}
+
+	vector<pid_t> children;
+	for (int p = 0; p < PROCESSES; p++)
+	{
+		const pid_t pid = fork();
+		ASSERT_GE(pid, 0);
+		if (pid == 0)
+		{
+			OfflineHandler handler(file.WPath(), OTPS, true);
+			int accepted = 0;
+			string serial;
+			for (int i = p; i < OTPS; i += PROCESSES)
+			{
+				if (handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(i)).c_str()), "alice", serial) == S_OK)
+				{
+					accepted++;
+				}
+			}
+			// No destructors, the parent owns the file
+			_exit(accepted);
+		}
+		children.push_back(pid);
+	}
+
+	int accepted = 0;
+	for (pid_t pid : children)
+	{
+		int status = 0;
+		ASSERT_EQ(waitpid(pid, &status, 0), pid);
+		ASSERT_TRUE(WIFEXITED(status));
+		accepted += WEXITSTATUS(status);
+	}
+
+	// An OTP is rejected if a later one was used first, but none may be accepted twice
+	OfflineHandler reader(file.WPath(), OTPS, true);
+	const size_t remaining = reader.GetOfflineOTPCount("alice", "HOTP1");
+	EXPECT_GT(accepted, 0);
+	EXPECT_LE(static_cast<size_t>(accepted) + remaining, static_cast<size_t>(OTPS));
+	string serial;
+	for (int i = 0; i < OTPS; i++)
+	{
+		if (reader.GetOfflineOTPCount("alice", "HOTP1") == 0) break;
+		reader.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(i)).c_str()), "alice", serial);
+	}
+	EXPECT_EQ(reader.GetOfflineOTPCount("alice", "HOTP1"), 0u);
+}
+
+TEST(OfflineHandler, EvictsLeastRecentlyUsedUser)
+{
+	TempFile file("evict.json");
+	OfflineHandler handler(file.WPath(), 10, false, 2);
+	OfflineData first = MakeOfflineData("alice", "HOTP1", 2);
+	first.lastUsed = 100;
+	OfflineData second = MakeOfflineData("bob", "HOTP2", 2);
+	second.lastUsed = 200;
+	ASSERT_EQ(handler.AddOfflineData(first), S_OK);
+	ASSERT_EQ(handler.AddOfflineData(second), S_OK);
+	ASSERT_EQ(handler.AddOfflineData(MakeOfflineData("carol", "HOTP3", 2)), S_OK);
+
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 0u);
+	EXPECT_EQ(handler.GetOfflineOTPCount("bob", "HOTP2"), 2u);
+	EXPECT_EQ(handler.GetOfflineOTPCount("carol", "HOTP3"), 2u);
+
+	// The eviction is in the file right away
+	OfflineHandler reloaded(file.WPath(), 10);
+	EXPECT_EQ(reloaded.GetOfflineOTPCount("alice", "HOTP1"), 0u);
+	EXPECT_EQ(reloaded.GetOfflineOTPCount("bob", "HOTP2"), 2u);
+}
+
+TEST(OfflineHandler, LoweredLimitEvictsSeveralUsersAtOnce)
+{
+	TempFile file("evict-many.json");
+	const vector<pair<string, time_t>> users = { { "alice", 500 }, { "bob", 100 }, { "carol", 400 }, { "dave", 200 }, { "erin", 300 } };
+	{
+		OfflineHandler handler(file.WPath(), 10);
+		for (size_t i = 0; i < users.size(); i++)
+		{
+			OfflineData data = MakeOfflineData(users[i].first, "HOTP" + to_string(i), 2);
+			data.lastUsed = users[i].second;
+			ASSERT_EQ(handler.AddOfflineData(data), S_OK);
+		}
+		// The last use of a user is the last use of any of its token
+		OfflineData recent = MakeOfflineData("BOB", "HOTP9", 2);
+		recent.lastUsed = 450;
+		ASSERT_EQ(handler.AddOfflineData(recent), S_OK);
+	}
+
+	OfflineHandler limited(file.WPath(), 10, false, 2);
+	EXPECT_EQ(limited.GetOfflineOTPCount("alice", "HOTP0"), 2u);
+	EXPECT_EQ(limited.GetOfflineOTPCount("bob", "HOTP1"), 2u);
+	EXPECT_EQ(limited.GetOfflineOTPCount("bob", "HOTP9"), 2u);
+	EXPECT_EQ(limited.GetOfflineOTPCount("carol", "HOTP2"), 0u);
+	EXPECT_EQ(limited.GetOfflineOTPCount("dave", "HOTP3"), 0u);
+	EXPECT_EQ(limited.GetOfflineOTPCount("erin", "HOTP4"), 0u);
+}
+
+TEST(OfflineHandler, UseProtectsFromEviction)
+{
+	TempFile file("evict-use.json");
+	OfflineHandler handler(file.WPath(), 10, false, 2);
+	OfflineData first = MakeOfflineData("alice", "HOTP1", 4);
+	first.lastUsed = 100;
+	OfflineData second = MakeOfflineData("bob", "HOTP2", 4);
+	second.lastUsed = 200;
+	ASSERT_EQ(handler.AddOfflineData(first), S_OK);
+	ASSERT_EQ(handler.AddOfflineData(second), S_OK);
+
+	// alice logs in offline, so bob is now the least recently used
+	string serial;
+	ASSERT_EQ(handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(0)).c_str()), "alice", serial), S_OK);
+	ASSERT_EQ(handler.AddOfflineData(MakeOfflineData("carol", "HOTP3", 4)), S_OK);
+
+	EXPECT_EQ(handler.GetOfflineOTPCount("alice", "HOTP1"), 3u);
+	EXPECT_EQ(handler.GetOfflineOTPCount("bob", "HOTP2"), 0u);
+	EXPECT_EQ(handler.GetOfflineOTPCount("carol", "HOTP3"), 4u);
+}
+
+TEST(OfflineHandler, SizeLimitEvictsAllTokensOfAUserButNeverTheLastUser)
+{
+	TempFile file("evict-size.json");
+	OfflineData alice1 = MakeOfflineData("alice", "HOTP1", 20);
+	alice1.lastUsed = 100;
+	OfflineData alice2 = MakeOfflineData("Alice", "HOTP2", 20);
+	alice2.lastUsed = 100;
+	const OfflineData bob = MakeOfflineData("bob", "HOTP3", 20);
+	// Room for one and a half datasets
+	const size_t limit = bob.GetSize() + bob.GetSize() / 2;
+
+	OfflineHandler handler(file.WPath(), 10, false, 0, limit);
+	ASSERT_EQ(handler.AddOfflineData(alice1), S_OK);
+	ASSERT_EQ(handler.AddOfflineData(alice2), S_OK);
+	// A single user is kept even above the limit
+	EXPECT_EQ(handler.GetTokenInfo("alice").size(), 2u);
+	EXPECT_GT(handler.GetStoreSize(), limit);
+
+	ASSERT_EQ(handler.AddOfflineData(bob), S_OK);
+	EXPECT_TRUE(handler.GetTokenInfo("alice").empty());
+	EXPECT_EQ(handler.GetOfflineOTPCount("bob", "HOTP3"), 20u);
+	EXPECT_LE(handler.GetStoreSize(), limit);
+}
+
+TEST(OfflineHandler, StoreSizeFollowsTheData)
+{
+	TempFile file("size.json");
+	OfflineHandler handler(file.WPath(), 10);
+	EXPECT_EQ(handler.GetStoreSize(), 0u);
+
+	const OfflineData data = MakeOfflineData("alice", "HOTP1", 10);
+	ASSERT_EQ(handler.AddOfflineData(data), S_OK);
+	const size_t full = handler.GetStoreSize();
+	EXPECT_GE(full, data.offlineOTPs.size() * data.offlineOTPs.begin()->second.size());
+
+	string serial;
+	ASSERT_EQ(handler.VerifyOfflineOTP(SecureWString(Convert::ToWString(TestOTP(4)).c_str()), "alice", serial), S_OK);
+	EXPECT_LT(handler.GetStoreSize(), full);
+
+	ASSERT_TRUE(handler.RemoveOfflineData("alice", "HOTP1"));
+	EXPECT_EQ(handler.GetStoreSize(), 0u);
+}
@@ -0,0 +1,181 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "OfflineRefillQueue.h"
+#include "TestUtils.h"
+#include <gtest/gtest.h>
+#include <limits>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static OfflineRefillJob MakeJob(const string& username, const string& serial, const string& lastOTP)
+{
+	OfflineRefillJob job;
+	job.username = username;
+	job.serial = serial;
+	job.lastOTP.assign(lastOTP.c_str(), lastOTP.size());
+	return job;
+}
+
+TEST(OfflineRefillQueue, NextAttemptTimeIsNowIfAJobIsDue)
+{
+	TempFile file("queue-due.refill");
+	OfflineRefillQueue queue(file.WPath());
+	EXPECT_EQ(queue.GetNextAttemptTime(), (numeric_limits<time_t>::max)());
+
+	// The due job comes first, the one that is scheduled later must not hide it
+	queue.Enqueue(MakeJob("alice", "HOTP1", "111111"));
+	queue.Enqueue(MakeJob("bob", "HOTP2", "222222"));
+	queue.Reschedule(MakeJob("bob", "HOTP2", "222222"));
+
+	EXPECT_LE(queue.GetNextAttemptTime(), time(nullptr));
+	const auto due = queue.GetDueJobs();
+	ASSERT_EQ(due.size(), 1u);
+	EXPECT_EQ(due[0].serial, "HOTP1");
+}
+
+TEST(OfflineRefillQueue, RescheduleBacksOffAndDrops)
+{
+	TempFile file("queue-backoff.refill");
+	OfflineRefillQueue queue(file.WPath());
+	const OfflineRefillJob job = MakeJob("alice", "HOTP1", "111111");
+	queue.Enqueue(job);
+
+	const time_t before = time(nullptr);
+	queue.Reschedule(job);
+	EXPECT_GE(queue.GetNextAttemptTime(), before + OFFLINE_REFILL_BACKOFF_BASE_SECONDS);
+	queue.Reschedule(job);
+	EXPECT_GE(queue.GetNextAttemptTime(), before + 2 * OFFLINE_REFILL_BACKOFF_BASE_SECONDS);
+
+	for (int i = 2; i < OFFLINE_REFILL_MAX_ATTEMPTS; i++)
+	{
+		ASSERT_FALSE(queue.IsEmpty());
+		queue.Reschedule(job);
+	}
+	EXPECT_TRUE(queue.IsEmpty());
+}
+
+TEST(OfflineRefillQueue, CompleteKeepsNewerJob)
+{
+	TempFile file("queue-complete.refill");
+	OfflineRefillQueue queue(file.WPath());
+	const OfflineRefillJob first = MakeJob("alice", "HOTP1", "111111");
+	queue.Enqueue(first);
+	// Queued again with a newer OTP while the first refill was in progress
+	queue.Enqueue(MakeJob("ALICE", "HOTP1", "333333"));
+
+	queue.Complete(first);
+	ASSERT_FALSE(queue.IsEmpty());
+	EXPECT_STREQ(queue.GetDueJobs()[0].lastOTP.c_str(), "333333");
+}
+
+TEST(OfflineRefillQueue, DropRemovesWithoutRetry)
+{
+	TempFile file("queue-drop.refill");
+	OfflineRefillQueue queue(file.WPath());
+	const OfflineRefillJob rejected = MakeJob("alice", "HOTP1", "111111");
+	queue.Enqueue(rejected);
+	queue.Enqueue(MakeJob("bob", "HOTP2", "222222"));
+
+	queue.Drop(rejected);
+	const auto due = queue.GetDueJobs();
+	ASSERT_EQ(due.size(), 1u);
+	EXPECT_EQ(due[0].serial, "HOTP2");
+
+	// A newer job for the same token is not dropped with the old one
+	queue.Enqueue(MakeJob("bob", "HOTP2", "333333"));
+	queue.Drop(due[0]);
+	EXPECT_FALSE(queue.IsEmpty());
+}
+
+TEST(OfflineRefillQueue, JobsArePersisted)
+{
+	TempFile file("queue-persist.refill");
+	{
+		OfflineRefillQueue queue(file.WPath());
+		queue.Enqueue(MakeJob("alice", "HOTP1", "111111"));
+		OfflineRefillJob webAuthn = MakeJob("bob", "WAN1", "");
+		webAuthn.isWebAuthn = true;
+		queue.Enqueue(webAuthn);
+	}
+	// The OTP is not written in clear text
+	EXPECT_EQ(file.Read().find("111111"), string::npos);
+
+	OfflineRefillQueue loaded(file.WPath());
+	const auto jobs = loaded.GetDueJobs();
+	ASSERT_EQ(jobs.size(), 2u);
+	EXPECT_STREQ(jobs[0].lastOTP.c_str(), "111111");
+	EXPECT_TRUE(jobs[1].isWebAuthn);
+
+	loaded.Complete(jobs[0]);
+	loaded.Complete(jobs[1]);
+	// No file is left behind when the queue is empty
+	EXPECT_TRUE(file.Read().empty());
+}
+
+TEST(OfflineRefillQueue, QueuesOnTheSameFileSeeEachOthersJobs)
+{
+	TempFile file("queue-shared.refill");
+	// Like the queues of LogonUI and the CredUI host
+	OfflineRefillQueue first(file.WPath());
+	OfflineRefillQueue second(file.WPath());
+
+	first.Enqueue(MakeJob("alice", "HOTP1", "111111"));
+	second.Enqueue(MakeJob("bob", "HOTP2", "222222"));
+	EXPECT_EQ(first.GetDueJobs().size(), 2u);
+
+	// A job that is done by one queue is not done again by the other one
+	first.Complete(MakeJob("alice", "HOTP1", "111111"));
+	const auto due = second.GetDueJobs();
+	ASSERT_EQ(due.size(), 1u);
+	EXPECT_EQ(due[0].serial, "HOTP2");
+
+	second.Complete(due[0]);
+	EXPECT_TRUE(first.IsEmpty());
+	EXPECT_TRUE(file.Read().empty());
+}
+
+TEST(OfflineRefillQueue, ThreadsWithOwnQueuesDoNotLoseJobs)
+{
+	TempFile file("queue-threads.refill");
+	constexpr int threadCount = 4;
+	constexpr int jobsPerThread = 10;
+
+	vector<thread> threads;
+	for (int t = 0; t < threadCount; t++)
+	{
+		threads.emplace_back([&file, t]()
+			{
+				OfflineRefillQueue queue(file.WPath());
+				for (int i = 0; i < jobsPerThread; i++)
+				{
+					queue.Enqueue(MakeJob("user" + to_string(t), "HOTP" + to_string(i), TestOTP(i)));
+				}
+			});
+	}
+	for (auto& t : threads)
+	{
+		t.join();
+	}
+
+	OfflineRefillQueue loaded(file.WPath());
+	EXPECT_EQ(loaded.GetDueJobs().size(), (size_t)(threadCount * jobsPerThread));
+}
@@ -0,0 +1,159 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "AllocationCounter.h"
+#include "ParseArena.h"
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+using namespace std;
+
+TEST(ParseArena, AllocationsAreAlignedAndDoNotOverlap)
+{
+	ParseArena arena(256);
+	struct Allocation
+	{
+		unsigned char* data;
+		size_t size;
+	};
+	vector<Allocation> allocations;
+	const size_t alignments[] = { 1, 2, 4, 8, 16 };
+	for (size_t i = 0; i < 200; i++)
+	{
+		const size_t size = 1 + i % 37;
+		const size_t alignment = alignments[i % 5];
+		auto data = static_cast<unsigned char*>(arena.Allocate(size, alignment));
+		ASSERT_EQ(reinterpret_cast<uintptr_t>(data) % alignment, 0u) << i;
+		memset(data, static_cast<int>(i), size);
+		allocations.push_back({ data, size });
+	}
+
+	for (size_t i = 0; i < allocations.size(); i++)
+	{
+		for (size_t j = 0; j < allocations[i].size; j++)
+		{
+			ASSERT_EQ(allocations[i].data[j], static_cast<unsigned char>(i)) << i;
+		}
+	}
+	EXPECT_EQ(arena.GetAllocationCount(), allocations.size());
+}
+
+TEST(ParseArena, SmallAllocationsShareABlock)
+{
+	ParseArena arena(4096);
+	AllocationCounter counter;
+	for (int i = 0; i < 100; i++)
+	{
+		arena.Allocate(16, 8);
+	}
+	// One block and the list of blocks
+	EXPECT_LE(counter.Allocations(), 2u);
+	EXPECT_EQ(arena.GetCapacity(), 4096u);
+	EXPECT_EQ(arena.GetAllocationCount(), 100u);
+}
+
+TEST(ParseArena, LargeAllocationsGetTheirOwnBlock)
+{
+	ParseArena arena(1024);
+	arena.Allocate(100, 8);
+	void* large = arena.Allocate(10000, 8);
+	ASSERT_NE(large, nullptr);
+	memset(large, 0xAB, 10000);
+	EXPECT_GE(arena.GetCapacity(), 1024u + 10000u);
+}
+
+TEST(ParseArena, ZeroSizeAllocationsAreDistinct)
+{
+	ParseArena arena;
+	EXPECT_NE(arena.Allocate(0, 1), arena.Allocate(0, 1));
+}
+
+TEST(ParseArena, ReleaseFreesAllBlocks)
+{
+	ParseArena arena(512);
+	for (int i = 0; i < 10; i++)
+	{
+		arena.Allocate(400, 8);
+	}
+	EXPECT_EQ(arena.GetCapacity(), 10 * 512u);
+
+	arena.Release();
+	EXPECT_EQ(arena.GetCapacity(), 0u);
+	EXPECT_EQ(arena.GetAllocationCount(), 0u);
+
+	// Usable again
+	auto data = static_cast<char*>(arena.Allocate(8, 8));
+	memcpy(data, "1234567", 8);
+	EXPECT_STREQ(data, "1234567");
+	EXPECT_EQ(arena.GetCapacity(), 512u);
+}
+
+TEST(ParseArena, ContainersUseTheArena)
+{
+	// The old buffers are not reused, growing to 1000 characters takes about 4 KB
+	ParseArena arena(16384);
+	// Warm up the list of blocks
+	arena.Allocate(1, 1);
+
+	AllocationCounter counter;
+	{
+		ArenaString value{ ArenaAllocator<char>(arena) };
+		// Longer than the small string buffer
+		for (int i = 0; i < 100; i++)
+		{
+			value += "abcdefghij";
+		}
+		EXPECT_EQ(value.size(), 1000u);
+
+		vector<int, ArenaAllocator<int>> numbers{ ArenaAllocator<int>(arena) };
+		for (int i = 0; i < 100; i++)
+		{
+			numbers.push_back(i);
+		}
+		EXPECT_EQ(numbers[99], 99);
+	}
+	// The growth of both fits into the first block, nothing comes from the heap
+	EXPECT_EQ(counter.Allocations(), 0u);
+	EXPECT_GT(arena.GetAllocationCount(), 2u);
+}
+
+TEST(ParseArena, AllocatorWithoutArenaUsesTheHeap)
+{
+	AllocationCounter counter;
+	{
+		vector<int, ArenaAllocator<int>> numbers{ ArenaAllocator<int>(nullptr) };
+		for (int i = 0; i < 100; i++)
+		{
+			numbers.push_back(i);
+		}
+		EXPECT_EQ(numbers[99], 99);
+	}
+	// Every growth of the vector comes from the heap and is given back to it
+	EXPECT_GT(counter.Allocations(), 1u);
+	EXPECT_TRUE(ArenaAllocator<char>(nullptr) == ArenaAllocator<int>(nullptr));
+}
+
+TEST(ParseArena, AllocatorsOfTheSameArenaAreEqual)
+{
+	ParseArena a, b;
+	EXPECT_TRUE(ArenaAllocator<char>(a) == ArenaAllocator<int>(a));
+	EXPECT_TRUE(ArenaAllocator<char>(a) != ArenaAllocator<char>(b));
+}
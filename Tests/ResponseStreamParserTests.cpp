@@ -0,0 +1,204 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "JsonParser.h"
+#include "ResponseStreamParser.h"
+#include "TestUtils.h"
+#include <gtest/gtest.h>
+
+using namespace std;
+
+namespace
+{
+	const string RESPONSE = R"({"id": 1, "jsonrpc": "2.0",
+		"result": {"status": true, "value": false, "authentication": "CHALLENGE"},
+		"detail": {"message": "Bitte ändern 😀 \"jetzt\"\n", "serial": "HOTP0001", "transaction_id": "01234",
+			"preferred_client_mode": "interactive", "threadid": 140000000000000,
+			"multi_challenge": [
+				{"type": "hotp", "message": "OTP", "serial": "HOTP0001", "transaction_id": "01234", "attributes": null,
+					"image": "data:image/png;base64,iVBORw0KGgo="},
+				{"type": "webauthn", "message": "Key", "serial": "WAN0001", "transaction_id": "01234",
+					"attributes": {"webAuthnSignRequest": {"challenge": "abc", "rpId": "example.com", "timeout": 60000,
+						"userVerification": "preferred",
+						"allowCredentials": [{"id": "cred1", "type": "public-key", "transports": ["usb", "nfc"]}]}}}]},
+		"auth_items": {"offline": [{"refilltoken": "r3f1ll", "username": "alice", "count": "2",
+			"response": {"1": "$pbkdf2-sha512$10$a", "2": "$pbkdf2-sha512$10$b"}}]},
+		"version": "privacyIDEA 3.9", "signature": "rsa_sha256_pss:12ab", "time": 1.5e9, "negative": -12, "fraction": -0.25E-2})";
+
+	HRESULT Parse(ResponseStreamParser& parser, string& description)
+	{
+		PIResponse response;
+		vector<OfflineData> offlineData;
+		const HRESULT res = parser.Finish(response, offlineData);
+		description = DescribeResponse(response, offlineData);
+		return res;
+	}
+
+	HRESULT ParseInParts(const string& input, size_t partSize, string& description)
+	{
+		ResponseStreamParser parser;
+		for (size_t i = 0; i < input.size(); i += partSize)
+		{
+			parser.Feed(input.substr(i, partSize));
+		}
+		return Parse(parser, description);
+	}
+}
+
+TEST(ResponseStreamParser, ParsesAllValues)
+{
+	string description;
+	ASSERT_EQ(ParseInParts(RESPONSE, RESPONSE.size(), description), S_OK);
+	EXPECT_EQ(description,
+		"status=1 value=0 error=0: message=Bitte \xC3\xA4ndern \xF0\x9F\x98\x80 \"jetzt\"\n transaction=01234 mode=interactive\n"
+		"challenge type=hotp message=OTP serial=HOTP0001 transaction=01234 image=data:image/png;base64,iVBORw0KGgo=\n"
+		"  webauthn challenge= rpId= timeout=0 uv= type=\n"
+		"challenge type=webauthn message=Key serial=WAN0001 transaction=01234 image=-\n"
+		"  webauthn challenge=abc rpId=example.com timeout=60000 uv=preferred type=public-key\n"
+		"  credential id=cred1 type=public-key transports=usb,nfc,\n"
+		"offline user=alice serial=HOTP0001 refill=r3f1ll count=2 pubKey= credId= rpId= lastUsed=0 rate=0 lastConsumption=0\n"
+		"  1=$pbkdf2-sha512$10$a\n"
+		"  2=$pbkdf2-sha512$10$b\n");
+}
+
+TEST(ResponseStreamParser, AnySplitGivesTheSameResult)
+{
+	string expected;
+	ASSERT_EQ(ParseInParts(RESPONSE, RESPONSE.size(), expected), S_OK);
+
+	// Two parts split at every position, so that every token is cut somewhere once
+	for (size_t split = 1; split < RESPONSE.size(); split++)
+	{
+		ResponseStreamParser parser;
+		parser.Feed(RESPONSE.data(), split);
+		parser.Feed(RESPONSE.data() + split, RESPONSE.size() - split);
+		string description;
+		ASSERT_EQ(Parse(parser, description), S_OK) << "split at " << split;
+		ASSERT_EQ(description, expected) << "split at " << split;
+	}
+
+	for (size_t partSize : { 1, 2, 3, 7, 64 })
+	{
+		string description;
+		ASSERT_EQ(ParseInParts(RESPONSE, partSize, description), S_OK) << "parts of " << partSize;
+		EXPECT_EQ(description, expected) << "parts of " << partSize;
+	}
+}
+
+TEST(ResponseStreamParser, HeapGivesTheSameResultAsTheArena)
+{
+	string expected;
+	ASSERT_EQ(ParseInParts(RESPONSE, RESPONSE.size(), expected), S_OK);
+
+	ResponseStreamParser parser(false);
+	parser.Feed(RESPONSE);
+	string description;
+	ASSERT_EQ(Parse(parser, description), S_OK);
+	EXPECT_EQ(description, expected);
+}
+
+TEST(ResponseStreamParser, LastDuplicateKeyWins)
+{
+	const string input = R"({"result": {"status": false, "status": true, "value": true},
+		"detail": {"message": "first", "message": "second", "serial": "S1"},
+		"auth_items": {"offline": [{"username": "alice", "username": "bob", "response": {"1": "old", "2": "x", "1": "new"}}]}})";
+	ResponseStreamParser parser;
+	parser.Feed(input);
+	PIResponse response;
+	vector<OfflineData> offlineData;
+	ASSERT_EQ(parser.Finish(response, offlineData), S_OK);
+
+	EXPECT_TRUE(response.status);
+	EXPECT_EQ(response.message, "second");
+	ASSERT_EQ(offlineData.size(), 1u);
+	EXPECT_EQ(offlineData[0].username, "bob");
+	EXPECT_EQ(offlineData[0].offlineOTPs.at("1"), "new");
+	EXPECT_EQ(offlineData[0].offlineOTPs.size(), 2u);
+}
+
+TEST(ResponseStreamParser, MalformedInputIsAnError)
+{
+	const string inputs[] = {
+		"",
+		R"({"result": {"status": true})",
+		R"({"result": {"status": true}} x)",
+		R"({"result": {"status": true},})",
+		R"({"result": {"status": tru}})",
+		R"({"result": {"status": true}, "n": 01})",
+		R"({"result": {"status": true}, "n": 1.})",
+		R"({"result": {"status": true}, "n": -})",
+		R"({"result": {"status": true}, "s": "\x"})",
+		R"({"result": {"status": true}, "s": "\ud83d"})",
+		R"({"result": {"status": true}, "s": "\ude00"})",
+		R"({"result": {"status": true}, "s": "\u12G4"})",
+		"{\"result\": {\"status\": true}, \"s\": \"a\tb\"}",
+		R"({"result": {"status": true}, "s": "open)",
+		R"({"result" {"status": true}})",
+		R"({"result": {"status": true}]})",
+		R"([1, 2,])",
+	};
+
+	for (const auto& input : inputs)
+	{
+		// Also each split, an error must not depend on where the input is cut
+		for (size_t split = 0; split <= input.size(); split++)
+		{
+			ResponseStreamParser parser;
+			parser.Feed(input.data(), split);
+			parser.Feed(input.data() + split, input.size() - split);
+			string description;
+			ASSERT_EQ(Parse(parser, description), PI_JSON_PARSE_ERROR) << input << " split at " << split;
+		}
+	}
+}
+
+TEST(ResponseStreamParser, MissingResultIsAnError)
+{
+	ResponseStreamParser parser;
+	parser.Feed(R"({"detail": {"message": "no result"}})");
+	string description;
+	EXPECT_EQ(Parse(parser, description), PI_JSON_PARSE_ERROR);
+}
+
+TEST(ResponseStreamParser, ParserIsReusableAfterAnError)
+{
+	ResponseStreamParser parser;
+	parser.Feed(R"({"result": [)");
+	string description;
+	EXPECT_EQ(Parse(parser, description), PI_JSON_PARSE_ERROR);
+
+	parser.Feed(R"({"result": {"status": true, "value": true}, "detail": {"message": "ok"}})");
+	PIResponse response;
+	vector<OfflineData> offlineData;
+	ASSERT_EQ(parser.Finish(response, offlineData), S_OK);
+	EXPECT_TRUE(response.value);
+	EXPECT_EQ(response.message, "ok");
+}
+
+TEST(ResponseStreamParser, ErrorCodesAndNumbers)
+{
+	ResponseStreamParser parser;
+	parser.Feed(R"({"result": {"status": false, "error": {"code": 904, "message": "ERR904: The user can not be found"}},
+		"big": 18446744073709551615, "bigger": 18446744073709551616, "small": -9223372036854775808})");
+	PIResponse response;
+	vector<OfflineData> offlineData;
+	ASSERT_EQ(parser.Finish(response, offlineData), S_OK);
+	EXPECT_EQ(response.errorCode, 904);
+	EXPECT_EQ(response.errorMessage, "ERR904: The user can not be found");
+}
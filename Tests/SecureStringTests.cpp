@@ -0,0 +1,265 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "AllocationCounter.h"
+#include "Convert.h"
+#include "SecureString.h"
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+static_assert(!is_copy_constructible<SecureWString>::value && !is_copy_assignable<SecureWString>::value,
+	"Copies of secrets have to be made with Copy()");
+static_assert(is_nothrow_move_constructible<SecureWString>::value && is_nothrow_move_assignable<SecureWString>::value,
+	"Moving a secret must not allocate");
+
+namespace
+{
+	// Copies of secrets are counted by the allocations of the pool, every string buffer is one allocation
+	class PoolCounter
+	{
+	public:
+		PoolCounter() : _start(SecurePool::Get().GetAllocationCount()) {}
+		size_t Allocations() const { return SecurePool::Get().GetAllocationCount() - _start; }
+
+	private:
+		size_t _start;
+	};
+
+	// A freed slot starts with the link of the free list, everything after it has to be zero
+	bool IsWiped(const void* p, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(p);
+		for (size_t i = sizeof(void*); i < size; i++)
+		{
+			if (bytes[i] != 0) return false;
+		}
+		return true;
+	}
+}
+
+TEST(SecureString, BasicOperations)
+{
+	SecureWString empty;
+	EXPECT_TRUE(empty.empty());
+	EXPECT_EQ(wstring(empty.c_str()), L"");
+	EXPECT_EQ(empty.data(), nullptr);
+
+	SecureWString s(L"pass");
+	EXPECT_EQ(s.size(), 4u);
+	s.append(L"word", 4);
+	s.push_back(L'!');
+	EXPECT_EQ(wstring(s.c_str()), L"password!");
+
+	s.resize(4);
+	EXPECT_EQ(wstring(s.c_str()), L"pass");
+	s.resize(6);
+	EXPECT_EQ(s.size(), 6u);
+	EXPECT_EQ(s.c_str()[4], L'\0');
+	EXPECT_EQ(s.c_str()[6], L'\0');
+
+	s = L"123456";
+	EXPECT_EQ(s, SecureWString(L"123456"));
+	EXPECT_NE(s, SecureWString(L"123457"));
+	EXPECT_NE(s, SecureWString(L"12345"));
+
+	s.assign(nullptr);
+	EXPECT_TRUE(s.empty());
+	EXPECT_EQ(s, SecureWString());
+}
+
+TEST(SecureString, AppendOfItself)
+{
+	SecureString s("abc");
+	wstring expected = L"abc";
+	// Each append grows the buffer, so the source moves while it is copied
+	for (int i = 0; i < 6; i++)
+	{
+		s.append(s.c_str(), s.size());
+		expected += expected;
+	}
+	EXPECT_EQ(Convert::ToWString(string(s.c_str(), s.size())), expected);
+
+	s.assign("12345", 5);
+	s.append(s.c_str() + 3, 2);
+	EXPECT_STREQ(s.c_str(), "1234545");
+	s.push_back(s.c_str()[0]);
+	EXPECT_STREQ(s.c_str(), "12345451");
+}
+
+TEST(SecureString, AssignOfItself)
+{
+	SecureString s("password");
+	s = s.c_str();
+	EXPECT_STREQ(s.c_str(), "password");
+
+	s.assign(s.c_str() + 2, 4);
+	EXPECT_EQ(s.size(), 4u);
+	EXPECT_STREQ(s.c_str(), "sswo");
+	// The characters behind the new end are wiped
+	for (size_t i = 4; i < 8; i++)
+	{
+		EXPECT_EQ(s.c_str()[i], '\0') << i;
+	}
+
+	s.assign(s.c_str(), 0);
+	EXPECT_TRUE(s.empty());
+	EXPECT_EQ(s.c_str()[0], '\0');
+}
+
+TEST(SecureString, MovesDoNotCopy)
+{
+	SecureWString s(L"secret");
+	const wchar_t* buffer = s.c_str();
+
+	PoolCounter counter;
+	SecureWString moved(std::move(s));
+	EXPECT_EQ(moved.c_str(), buffer);
+	EXPECT_TRUE(s.empty());
+
+	SecureWString assigned;
+	assigned = std::move(moved);
+	EXPECT_EQ(assigned.c_str(), buffer);
+	EXPECT_TRUE(moved.empty());
+	EXPECT_EQ(counter.Allocations(), 0u);
+
+	// Copies are explicit and counted
+	const SecureWString copy = assigned.Copy();
+	EXPECT_EQ(counter.Allocations(), 1u);
+	EXPECT_NE(copy.c_str(), assigned.c_str());
+	EXPECT_EQ(copy, assigned);
+}
+
+TEST(SecureString, DoesNotUseTheHeap)
+{
+	// The pool and its chunks are created on first use
+	{
+		SecureWString warmUp(wstring(100, L'x').c_str());
+		SecureString small("x");
+	}
+
+	AllocationCounter heap;
+	{
+		SecureWString password(L"correct horse battery staple");
+		password.append(L" and more", 9);
+		SecureWString copy = password.Copy();
+		SecureWString moved = std::move(copy);
+		const SecureString utf8 = Convert::ToString(moved);
+		EXPECT_EQ(Convert::ToWString(utf8), password);
+	}
+	EXPECT_EQ(heap.Allocations(), 0u);
+}
+
+TEST(SecureString, ClearAndShrinkWipe)
+{
+	SecureString s("123456");
+	char* data = s.data();
+	s.resize(2);
+	EXPECT_EQ(string(data, 6), string("12\0\0\0\0", 6));
+
+	s.clear();
+	EXPECT_TRUE(s.empty());
+	// The buffer is kept for reuse
+	EXPECT_EQ(s.data(), data);
+	EXPECT_EQ(string(data, 6), string(6, '\0'));
+}
+
+TEST(SecureString, FreedAndOutgrownBuffersAreWiped)
+{
+	const void* freed = nullptr;
+	size_t freedSize = 0;
+	{
+		SecureString s("a password that is freed");
+		freed = s.c_str();
+		freedSize = s.size();
+	}
+	// Chunks are never unmapped, so the freed slot can still be read
+	EXPECT_TRUE(IsWiped(freed, freedSize));
+
+	SecureString s("short");
+	const void* outgrown = s.c_str();
+	s.append(string(100, 'x').c_str(), 100);
+	EXPECT_NE(s.c_str(), outgrown);
+	EXPECT_TRUE(IsWiped(outgrown, 6));
+	EXPECT_EQ(string(s.c_str()), "short" + string(100, 'x'));
+}
+
+TEST(SecureString, ConversionAllocatesOnce)
+{
+	const SecureWString otp(L"123456");
+	PoolCounter counter;
+	const SecureString utf8 = Convert::ToString(otp);
+	// Sized once, without growing
+	EXPECT_EQ(counter.Allocations(), 1u);
+	EXPECT_EQ(string(utf8.c_str()), "123456");
+
+	const SecureWString unicode(L"p\u00E4ss\u20AC\U0001F511");
+	EXPECT_EQ(Convert::ToWString(Convert::ToString(unicode)), unicode);
+}
+
+TEST(SecureString, LargeStrings)
+{
+	// Larger than the biggest size class of the pool, so it gets pages of its own
+	const wstring large(5000, L'k');
+	SecureWString s(large.c_str());
+	s.push_back(L'!');
+	EXPECT_EQ(wstring(s.c_str()), large + L"!");
+	SecureWString copy = s.Copy();
+	EXPECT_EQ(copy, s);
+}
+
+TEST(SecureString, PoolReusesSlots)
+{
+	SecurePool& pool = SecurePool::Get();
+	void* first = pool.Allocate(100);
+	pool.Free(first, 100);
+	void* second = pool.Allocate(100);
+	EXPECT_EQ(first, second);
+	pool.Free(second, 100);
+
+	// Sizes of the same class share the slots
+	void* third = pool.Allocate(65);
+	EXPECT_EQ(third, first);
+	pool.Free(third, 65);
+}
+
+TEST(SecureString, ConcurrentUse)
+{
+	vector<thread> threads;
+	vector<int> failures(8, 0);
+	for (int t = 0; t < 8; t++)
+	{
+		threads.emplace_back([t, &failures]()
+			{
+				for (int i = 0; i < 1000; i++)
+				{
+					const string value = to_string(t) + ":" + string(static_cast<size_t>(i % 300), 'v');
+					SecureString s(value.c_str());
+					SecureString copy = s.Copy();
+					if (string(copy.c_str()) != value) failures[t]++;
+				}
+			});
+	}
+	for (auto& thread : threads) thread.join();
+	for (int t = 0; t < 8; t++) EXPECT_EQ(failures[t], 0) << t;
+}
@@ -0,0 +1,29 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "Logger.h"
+#include <gtest/gtest.h>
+
+int main(int argc, char** argv)
+{
+	// Errors of the code under test go to the build directory instead of C:
+	Logger::Get().logfilePath = "CppClientTests.log";
+	testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,165 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Helpers shared by the tests and the benchmarks of the portable build
+#pragma once
+
+#include "Convert.h"
+#include "CryptoProvider.h"
+#include "OfflineData.h"
+#include "PIResponse.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+// Iterations for the test data, the real value (10000) would make the tests slow
+constexpr int TEST_PBKDF2_ROUNDS = 10;
+
+// The OTP value with index i of a test token
+inline std::string TestOTP(int i)
+{
+	char buffer[16];
+	snprintf(buffer, sizeof(buffer), "%06d", 100000 + i);
+	return buffer;
+}
+
+// Stored value in the format of passlib: $pbkdf2-sha512$iterations$salt$checksum, salt and checksum in ab64
+inline std::string HashOTP(const std::string& otp, int rounds = TEST_PBKDF2_ROUNDS)
+{
+	unsigned char salt[16];
+	for (size_t i = 0; i < sizeof(salt); i++)
+	{
+		salt[i] = static_cast<unsigned char>(otp[i % otp.size()] + i);
+	}
+	unsigned char checksum[64];
+	CryptoProvider::Get().PBKDF2SHA512(reinterpret_cast<const unsigned char*>(otp.data()), otp.size(), salt, sizeof(salt),
+		static_cast<unsigned long long>(rounds), checksum, sizeof(checksum));
+
+	auto ab64 = [](const unsigned char* data, size_t size)
+	{
+		std::string encoded = Convert::Base64Encode(data, size, false);
+		std::replace(encoded.begin(), encoded.end(), '+', '.');
+		return encoded;
+	};
+	return "$pbkdf2-sha512$" + std::to_string(rounds) + "$" + ab64(salt, sizeof(salt)) + "$" + ab64(checksum, sizeof(checksum));
+}
+
+// HOTP offline data with the OTPs first to first + count - 1
+inline OfflineData MakeOfflineData(const std::string& username, const std::string& serial, int count, int first = 0)
+{
+	OfflineData data;
+	data.username = username;
+	data.serial = serial;
+	data.refilltoken = "refill-" + serial;
+	data.count = count;
+	data.rounds = TEST_PBKDF2_ROUNDS;
+	for (int i = first; i < first + count; i++)
+	{
+		data.offlineOTPs[std::to_string(i)] = HashOTP(TestOTP(i));
+	}
+	return data;
+}
+
+// All values of a parsed response in one string, to compare the results of different parsers or inputs
+inline std::string DescribeResponse(const PIResponse& response, const std::vector<OfflineData>& offlineData)
+{
+	std::ostringstream out;
+	out << "status=" << response.status << " value=" << response.value << " error=" << response.errorCode << ":"
+		<< response.errorMessage << " message=" << response.message << " transaction=" << response.transactionId
+		<< " mode=" << response.preferredMode << "\n";
+	for (const auto& c : response.challenges)
+	{
+		out << "challenge type=" << c.type << " message=" << c.message << " serial=" << c.serial << " transaction="
+			<< c.transactionId << " image=" << (c.image ? *c.image : "-") << "\n";
+		const auto& request = c.webAuthnSignRequest;
+		out << "  webauthn challenge=" << request.challenge << " rpId=" << request.rpId << " timeout=" << request.timeout
+			<< " uv=" << request.userVerification << " type=" << request.type << "\n";
+		for (const auto& credential : request.allowCredentials)
+		{
+			out << "  credential id=" << credential.id << " type=" << credential.type << " transports=";
+			for (const auto& transport : credential.transports)
+			{
+				out << transport << ",";
+			}
+			out << "\n";
+		}
+	}
+	for (const auto& data : offlineData)
+	{
+		out << "offline user=" << data.username << " serial=" << data.serial << " refill=" << data.refilltoken << " count="
+			<< data.count << " pubKey=" << data.pubKey << " credId=" << data.credId << " rpId=" << data.rpId << " lastUsed="
+			<< data.lastUsed << " rate=" << data.consumptionRate << " lastConsumption=" << data.lastConsumption << "\n";
+		for (const auto& otp : data.offlineOTPs)
+		{
+			out << "  " << otp.first << "=" << otp.second << "\n";
+		}
+	}
+	return out.str();
+}
+
+// File in the temp directory that is removed at the end of the scope, together with the lock file of the offline store
+class TempFile
+{
+public:
+	explicit TempFile(const std::string& name)
+	{
+		const char* dir = getenv("TMPDIR");
+		_path = std::string(dir != nullptr ? dir : "/tmp") + "/pi-test-" + std::to_string(getpid()) + "-" + name;
+		Remove();
+	}
+
+	~TempFile()
+	{
+		Remove();
+	}
+
+	TempFile(const TempFile&) = delete;
+	TempFile& operator=(const TempFile&) = delete;
+
+	const std::string& Path() const { return _path; }
+
+	std::wstring WPath() const { return Convert::ToWString(_path); }
+
+	std::string Read() const
+	{
+		std::ifstream in(_path, std::ios::binary);
+		std::stringstream buffer;
+		buffer << in.rdbuf();
+		return buffer.str();
+	}
+
+	void Write(const std::string& content) const
+	{
+		std::ofstream out(_path, std::ios::binary | std::ios::trunc);
+		out << content;
+	}
+
+private:
+	void Remove()
+	{
+		std::remove(_path.c_str());
+		std::remove((_path + ".lock").c_str());
+	}
+
+	std::string _path;
+};
@@ -0,0 +1,220 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+#include "AllocationCounter.h"
+#include "Convert.h"
+#include "Utf.h"
+#include <gtest/gtest.h>
+#include <codecvt>
+#include <cstdint>
+#include <locale>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	constexpr bool WCHAR_IS_UTF16 = sizeof(wchar_t) == 2;
+
+	// The converter of the standard library that Utf replaces, for valid input
+	using StdCodecvt = conditional<WCHAR_IS_UTF16, codecvt_utf8_utf16<wchar_t>, codecvt_utf8<wchar_t>>::type;
+
+	wstring ToWide(const string& s)
+	{
+		wstring ws(s.size(), L'\0');
+		ws.resize(Utf::Utf8ToUtf16(s.data(), s.size(), &ws[0], ws.size()));
+		return ws;
+	}
+
+	string ToUtf8(const wstring& ws)
+	{
+		string s(ws.size() * 4, '\0');
+		s.resize(Utf::Utf16ToUtf8(ws.data(), ws.size(), &s[0], s.size()));
+		return s;
+	}
+
+	// Independent encoders of a code point
+	string EncodeUtf8(uint32_t c)
+	{
+		string s;
+		if (c < 0x80) s += static_cast<char>(c);
+		else if (c < 0x800)
+		{
+			s += static_cast<char>(0xC0 | (c >> 6));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			s += static_cast<char>(0xE0 | (c >> 12));
+			s += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			s += static_cast<char>(0xF0 | (c >> 18));
+			s += static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			s += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			s += static_cast<char>(0x80 | (c & 0x3F));
+		}
+		return s;
+	}
+
+	wstring EncodeWide(uint32_t c)
+	{
+		if (WCHAR_IS_UTF16 && c > 0xFFFF)
+		{
+			c -= 0x10000;
+			return { static_cast<wchar_t>(0xD800 + (c >> 10)), static_cast<wchar_t>(0xDC00 + (c & 0x3FF)) };
+		}
+		return wstring(1, static_cast<wchar_t>(c));
+	}
+
+	const wstring FFFD(1, static_cast<wchar_t>(0xFFFD));
+}
+
+TEST(Utf, AllCodePointsRoundTrip)
+{
+	string utf8;
+	wstring wide;
+	for (uint32_t c = 0; c <= 0x10FFFF; c++)
+	{
+		if (c >= 0xD800 && c <= 0xDFFF) continue;
+		utf8 += EncodeUtf8(c);
+		wide += EncodeWide(c);
+	}
+
+	EXPECT_TRUE(ToWide(utf8) == wide);
+	EXPECT_TRUE(ToUtf8(wide) == utf8);
+	EXPECT_TRUE(wstring_convert<StdCodecvt>().from_bytes(utf8) == wide);
+}
+
+// Unicode 15, section 3.9, U+FFFD Substitution of Maximal Subparts
+TEST(Utf, MaximalSubpartsAreReplaced)
+{
+	EXPECT_EQ(ToWide("\x61\xF1\x80\x80\xE1\x80\xC2\x62\x80\x63\x80\xBF\x64"),
+		L"a" + FFFD + FFFD + FFFD + L"b" + FFFD + L"c" + FFFD + FFFD + L"d");
+	// Overlong forms, surrogates and values above U+10FFFF are replaced byte by byte
+	EXPECT_EQ(ToWide("\xC0\xAF"), FFFD + FFFD);
+	EXPECT_EQ(ToWide("\xE0\x80\xAF"), FFFD + FFFD + FFFD);
+	EXPECT_EQ(ToWide("\xED\xA0\x80"), FFFD + FFFD + FFFD);
+	EXPECT_EQ(ToWide("\xF4\x90\x80\x80"), FFFD + FFFD + FFFD + FFFD);
+	EXPECT_EQ(ToWide("\xFE\xFF"), FFFD + FFFD);
+	// Truncated at the end
+	EXPECT_EQ(ToWide("ab\xF0\x9F\x98"), L"ab" + FFFD);
+	EXPECT_EQ(ToWide("\xE2\x82"), FFFD);
+}
+
+TEST(Utf, LoneSurrogatesAreReplaced)
+{
+	const string replacement = "\xEF\xBF\xBD";
+	EXPECT_EQ(ToUtf8(wstring(1, static_cast<wchar_t>(0xD800)) + L"a"), replacement + "a");
+	EXPECT_EQ(ToUtf8(L"a" + wstring(1, static_cast<wchar_t>(0xDC00))), "a" + replacement);
+	// A low surrogate before a high surrogate is not a pair
+	EXPECT_EQ(ToUtf8({ static_cast<wchar_t>(0xDC00), static_cast<wchar_t>(0xD800) }), replacement + replacement);
+	if (!WCHAR_IS_UTF16)
+	{
+		EXPECT_EQ(ToUtf8(wstring(1, static_cast<wchar_t>(0x110000))), replacement);
+	}
+}
+
+TEST(Utf, AsciiRunsOfEveryLength)
+{
+	// Covers the ends of the 16 and 8 unit fast paths, with a non-ASCII character in every position
+	for (size_t length = 0; length < 70; length++)
+	{
+		string ascii;
+		for (size_t i = 0; i < length; i++) ascii += static_cast<char>('!' + i % 90);
+		const wstring wideAscii(ascii.begin(), ascii.end());
+		EXPECT_EQ(ToWide(ascii), wideAscii);
+		EXPECT_EQ(ToUtf8(wideAscii), ascii);
+
+		for (size_t position = 0; position < length; position++)
+		{
+			string mixed = ascii;
+			mixed.replace(position, 1, "\xC3\xA4");
+			wstring wideMixed = wideAscii;
+			wideMixed[position] = L'\xE4';
+			EXPECT_EQ(ToWide(mixed), wideMixed) << length << " " << position;
+			EXPECT_EQ(ToUtf8(wideMixed), mixed) << length << " " << position;
+		}
+	}
+}
+
+TEST(Utf, RandomTextMatchesTheStandardLibrary)
+{
+	mt19937 random(3);
+	const uint32_t ranges[][2] = { { 0x20, 0x7E }, { 0xA0, 0x7FF }, { 0x800, 0xD7FF }, { 0xE000, 0xFFFD }, { 0x10000, 0x10FFFF } };
+	for (int i = 0; i < 200; i++)
+	{
+		string utf8;
+		for (int j = static_cast<int>(random() % 100); j > 0; j--)
+		{
+			// Mostly ASCII like real names and messages
+			const auto& range = ranges[random() % 8 < 4 ? 0 : random() % 5];
+			utf8 += EncodeUtf8(range[0] + random() % (range[1] - range[0] + 1));
+		}
+		wstring_convert<StdCodecvt> converter;
+		EXPECT_TRUE(ToWide(utf8) == converter.from_bytes(utf8)) << i;
+		EXPECT_EQ(ToUtf8(converter.from_bytes(utf8)), utf8) << i;
+	}
+}
+
+TEST(Utf, OutputIsBounded)
+{
+	const string utf8 = "abcdefghijklmnopqrstuvwxyz \xC3\xA4\xF0\x9F\x98\x80 abcdefghijklmnopqrstuvwxyz";
+	const size_t needed = Utf::Utf8ToUtf16(utf8.data(), utf8.size(), nullptr, 0);
+	EXPECT_EQ(needed, ToWide(utf8).size());
+
+	for (size_t outSize = 0; outSize <= needed; outSize++)
+	{
+		// Canaries after the end
+		vector<wchar_t> out(outSize + 4, L'#');
+		EXPECT_EQ(Utf::Utf8ToUtf16(utf8.data(), utf8.size(), out.data(), outSize), needed);
+		for (size_t i = outSize; i < out.size(); i++) ASSERT_EQ(out[i], L'#') << outSize;
+	}
+
+	const wstring wide = ToWide(utf8);
+	for (size_t outSize = 0; outSize <= utf8.size(); outSize++)
+	{
+		vector<char> out(outSize + 4, '#');
+		EXPECT_EQ(Utf::Utf16ToUtf8(wide.data(), wide.size(), out.data(), outSize), utf8.size());
+		for (size_t i = outSize; i < out.size(); i++) ASSERT_EQ(out[i], '#') << outSize;
+	}
+}
+
+TEST(Utf, ConvertKeepsSupplementaryCharacters)
+{
+	const string utf8 = "\xF0\x9F\x98\x80 \xF0\x9F\x94\x91";
+	EXPECT_EQ(Convert::ToString(Convert::ToWString(utf8)), utf8);
+}
+
+TEST(Utf, DoesNotAllocate)
+{
+	const string utf8 = "J\xC3\xBCrgen M\xC3\xBCller \xF0\x9F\x98\x80 and some ASCII to use the fast path";
+	wchar_t wide[128];
+	char back[512];
+	AllocationCounter counter;
+	const size_t wideSize = Utf::Utf8ToUtf16(utf8.data(), utf8.size(), wide, 128);
+	const size_t size = Utf::Utf16ToUtf8(wide, wideSize, back, sizeof(back));
+	EXPECT_EQ(counter.Allocations(), 0u);
+	EXPECT_EQ(string(back, size), utf8);
+}
@@ -0,0 +1,77 @@
+/* * * * * * * * * * * * * * * * * * * * *
+**
+** Copyright 2024 NetKnights GmbH
+** Author: Nils Behlen
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * */
+
+// Subset of Windows.h for the portable build of the tests (Tests/CMakeLists.txt). It only has the types, error codes and
+// helpers that the portable units use. Calls into the system are behind _WIN32 in the units themselves.
+#pragma once
+
+#ifdef _WIN32
+#error "The compat headers are only for builds on other platforms"
+#endif
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+typedef int32_t HRESULT;
+typedef uint32_t DWORD;
+typedef int32_t LONG;
+typedef uint8_t BYTE;
+typedef int BOOL;
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+#define S_OK							((HRESULT)0L)
+#define S_FALSE							((HRESULT)1L)
+#define E_FAIL							((HRESULT)0x80004005L)
+#define E_INVALIDARG					((HRESULT)0x80070057L)
+#define E_OUTOFMEMORY					((HRESULT)0x8007000EL)
+#define E_NOTIMPL						((HRESULT)0x80004001L)
+#define E_UNEXPECTED					((HRESULT)0x8000FFFFL)
+
+#define SUCCEEDED(hr)					(((HRESULT)(hr)) >= 0)
+#define FAILED(hr)						(((HRESULT)(hr)) < 0)
+
+// The values of errno for these are the same as the Windows error codes
+#define ERROR_SUCCESS					0L
+#define ERROR_FILE_NOT_FOUND			2L
+
+#define UNREFERENCED_PARAMETER(P)		(void)(P)
+
+// errno takes the place of the thread's last error value
+inline DWORD GetLastError() noexcept
+{
+	return static_cast<DWORD>(errno);
+}
+
+// Zero memory without the compiler removing it as a dead store
+inline void* SecureZeroMemory(void* ptr, size_t size) noexcept
+{
+	volatile unsigned char* p = static_cast<volatile unsigned char*>(ptr);
+	while (size--)
+	{
+		*p++ = 0;
+	}
+	return ptr;
+}
@@ -0,0 +1,33 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/CppClient/CppClient/Convert.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Convert.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Convert.cpp.o.d"
+  "/root/repo/CppClient/CppClient/CryptoProvider.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/CryptoProvider.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/CryptoProvider.cpp.o.d"
+  "/root/repo/CppClient/CppClient/IdentityKey.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/IdentityKey.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/IdentityKey.cpp.o.d"
+  "/root/repo/CppClient/CppClient/JsonParser.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/JsonParser.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/JsonParser.cpp.o.d"
+  "/root/repo/CppClient/CppClient/Logger.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Logger.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Logger.cpp.o.d"
+  "/root/repo/CppClient/CppClient/OfflineData.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineData.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineData.cpp.o.d"
+  "/root/repo/CppClient/CppClient/OfflineFileLock.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineFileLock.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineFileLock.cpp.o.d"
+  "/root/repo/CppClient/CppClient/OfflineHandler.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineHandler.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineHandler.cpp.o.d"
+  "/root/repo/CppClient/CppClient/OfflineRefillQueue.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineRefillQueue.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineRefillQueue.cpp.o.d"
+  "/root/repo/CppClient/CppClient/PIResponse.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/PIResponse.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/PIResponse.cpp.o.d"
+  "/root/repo/CppClient/CppClient/ParseArena.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ParseArena.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ParseArena.cpp.o.d"
+  "/root/repo/CppClient/CppClient/ResponseStreamParser.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ResponseStreamParser.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ResponseStreamParser.cpp.o.d"
+  "/root/repo/CppClient/CppClient/SecureString.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SecureString.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SecureString.cpp.o.d"
+  "/root/repo/CppClient/CppClient/SimdJsonBackend.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SimdJsonBackend.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SimdJsonBackend.cpp.o.d"
+  "/root/repo/CppClient/CppClient/Utf.cpp" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Utf.cpp.o" "gcc" "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Utf.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,39 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Convert.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Convert.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/CryptoProvider.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/CryptoProvider.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/IdentityKey.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/IdentityKey.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/JsonParser.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/JsonParser.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Logger.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Logger.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineData.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineData.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineFileLock.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineFileLock.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineHandler.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineHandler.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineRefillQueue.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/OfflineRefillQueue.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/PIResponse.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/PIResponse.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ParseArena.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ParseArena.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ResponseStreamParser.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/ResponseStreamParser.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SecureString.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SecureString.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SimdJsonBackend.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/SimdJsonBackend.cpp.o.d"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Utf.cpp.o"
+  "CMakeFiles/CppClientPortable.dir/CppClient/CppClient/Utf.cpp.o.d"
+  "libCppClientPortable.a"
+  "libCppClientPortable.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/CppClientPortable.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,36 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Tests/AllocationCounter.cpp" "Tests/CMakeFiles/CppClientTests.dir/AllocationCounter.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/AllocationCounter.cpp.o.d"
+  "/root/repo/Tests/BinaryLogFormatTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/BinaryLogFormatTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/BinaryLogFormatTests.cpp.o.d"
+  "/root/repo/Tests/ChallengeTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/ChallengeTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/ChallengeTests.cpp.o.d"
+  "/root/repo/Tests/ConvertTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/ConvertTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/ConvertTests.cpp.o.d"
+  "/root/repo/Tests/CryptoProviderTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/CryptoProviderTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/CryptoProviderTests.cpp.o.d"
+  "/root/repo/Tests/IdentityKeyTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/IdentityKeyTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/IdentityKeyTests.cpp.o.d"
+  "/root/repo/Tests/JsonBackendTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/JsonBackendTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/JsonBackendTests.cpp.o.d"
+  "/root/repo/Tests/JsonParserTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/JsonParserTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/JsonParserTests.cpp.o.d"
+  "/root/repo/Tests/LoggerTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/LoggerTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/LoggerTests.cpp.o.d"
+  "/root/repo/Tests/OfflineDataTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/OfflineDataTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/OfflineDataTests.cpp.o.d"
+  "/root/repo/Tests/OfflineHandlerTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/OfflineHandlerTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/OfflineHandlerTests.cpp.o.d"
+  "/root/repo/Tests/OfflineRefillQueueTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/OfflineRefillQueueTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/OfflineRefillQueueTests.cpp.o.d"
+  "/root/repo/Tests/ParseArenaTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/ParseArenaTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/ParseArenaTests.cpp.o.d"
+  "/root/repo/Tests/ResponseStreamParserTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/ResponseStreamParserTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/ResponseStreamParserTests.cpp.o.d"
+  "/root/repo/Tests/SecureStringTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/SecureStringTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/SecureStringTests.cpp.o.d"
+  "/root/repo/Tests/TestMain.cpp" "Tests/CMakeFiles/CppClientTests.dir/TestMain.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/TestMain.cpp.o.d"
+  "/root/repo/Tests/UtfTests.cpp" "Tests/CMakeFiles/CppClientTests.dir/UtfTests.cpp.o" "gcc" "Tests/CMakeFiles/CppClientTests.dir/UtfTests.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build_simd/CMakeFiles/CppClientPortable.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
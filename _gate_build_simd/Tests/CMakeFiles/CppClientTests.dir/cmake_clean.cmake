@@ -0,0 +1,44 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/CppClientTests.dir/AllocationCounter.cpp.o"
+  "CMakeFiles/CppClientTests.dir/AllocationCounter.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/BinaryLogFormatTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/BinaryLogFormatTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/ChallengeTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/ChallengeTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/ConvertTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/ConvertTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/CryptoProviderTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/CryptoProviderTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/IdentityKeyTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/IdentityKeyTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/JsonBackendTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/JsonBackendTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/JsonParserTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/JsonParserTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/LoggerTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/LoggerTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/OfflineDataTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/OfflineDataTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/OfflineHandlerTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/OfflineHandlerTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/OfflineRefillQueueTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/OfflineRefillQueueTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/ParseArenaTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/ParseArenaTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/ResponseStreamParserTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/ResponseStreamParserTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/SecureStringTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/SecureStringTests.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/TestMain.cpp.o"
+  "CMakeFiles/CppClientTests.dir/TestMain.cpp.o.d"
+  "CMakeFiles/CppClientTests.dir/UtfTests.cpp.o"
+  "CMakeFiles/CppClientTests.dir/UtfTests.cpp.o.d"
+  "CppClientTests"
+  "CppClientTests.pdb"
+  "CppClientTests[1]_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/CppClientTests.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
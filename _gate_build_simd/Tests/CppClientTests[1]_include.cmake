@@ -0,0 +1,5 @@
+if(EXISTS "/root/repo/_gate_build_simd/Tests/CppClientTests[1]_tests.cmake")
+  include("/root/repo/_gate_build_simd/Tests/CppClientTests[1]_tests.cmake")
+else()
+  add_test(CppClientTests_NOT_BUILT CppClientTests_NOT_BUILT)
+endif()
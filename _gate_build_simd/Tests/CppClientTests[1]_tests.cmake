@@ -0,0 +1,215 @@
+add_test([=[BinaryLogFormat.Varints]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=BinaryLogFormat.Varints]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[BinaryLogFormat.Varints]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[BinaryLogFormat.ZigZag]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=BinaryLogFormat.ZigZag]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[BinaryLogFormat.ZigZag]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[BinaryLogFormat.FixedIntegersAreLittleEndian]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=BinaryLogFormat.FixedIntegersAreLittleEndian]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[BinaryLogFormat.FixedIntegersAreLittleEndian]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[BinaryLogFormat.MessageIds]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=BinaryLogFormat.MessageIds]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[BinaryLogFormat.MessageIds]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[BinaryLogFormat.LoggerOutputIsDecoded]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=BinaryLogFormat.LoggerOutputIsDecoded]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[BinaryLogFormat.LoggerOutputIsDecoded]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Challenge.ImageBase64SkipsTheDataPrefix]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Challenge.ImageBase64SkipsTheDataPrefix]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Challenge.ImageBase64SkipsTheDataPrefix]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Challenge.NoImage]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Challenge.NoImage]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Challenge.NoImage]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Challenge.ImageBase64PointsIntoTheImage]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Challenge.ImageBase64PointsIntoTheImage]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Challenge.ImageBase64PointsIntoTheImage]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Challenge.CopiesShareTheImage]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Challenge.CopiesShareTheImage]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Challenge.CopiesShareTheImage]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Challenge.ImageIsDecodedWithoutCopies]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Challenge.ImageIsDecodedWithoutCopies]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Challenge.ImageIsDecodedWithoutCopies]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.Base64TestVectors]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.Base64TestVectors]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.Base64TestVectors]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.Base64Alphabets]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.Base64Alphabets]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.Base64Alphabets]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.Base64RoundTrip]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.Base64RoundTrip]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.Base64RoundTrip]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.Base64DecodeStopsAtTheFirstInvalidCharacter]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.Base64DecodeStopsAtTheFirstInvalidCharacter]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.Base64DecodeStopsAtTheFirstInvalidCharacter]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.Base64DecodeAcceptsAnyInput]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.Base64DecodeAcceptsAnyInput]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.Base64DecodeAcceptsAnyInput]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.Base64AllocatesOnlyTheResult]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.Base64AllocatesOnlyTheResult]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.Base64AllocatesOnlyTheResult]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.HexTestVectors]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.HexTestVectors]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.HexTestVectors]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.HexRoundTrip]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.HexRoundTrip]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.HexRoundTrip]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.HexToBytesRejectsInvalidInput]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.HexToBytesRejectsInvalidInput]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.HexToBytesRejectsInvalidInput]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.HexBufferOverloadsDoNotAllocate]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.HexBufferOverloadsDoNotAllocate]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.HexBufferOverloadsDoNotAllocate]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.LongToHexString]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.LongToHexString]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.LongToHexString]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.JoinW]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.JoinW]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.JoinW]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Convert.ReplaceAll]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Convert.ReplaceAll]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Convert.ReplaceAll]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[CryptoProvider.PBKDF2SHA512KnownAnswers]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=CryptoProvider.PBKDF2SHA512KnownAnswers]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[CryptoProvider.PBKDF2SHA512KnownAnswers]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[CryptoProvider.PBKDF2SHA512OutputSizes]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=CryptoProvider.PBKDF2SHA512OutputSizes]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[CryptoProvider.PBKDF2SHA512OutputSizes]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[CryptoProvider.RandomBytesAreFilledAndDiffer]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=CryptoProvider.RandomBytesAreFilledAndDiffer]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[CryptoProvider.RandomBytesAreFilledAndDiffer]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[CryptoProvider.RandomBytesAreUniform]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=CryptoProvider.RandomBytesAreUniform]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[CryptoProvider.RandomBytesAreUniform]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[CryptoProvider.SelectKeepsTheProviderForUnknownNames]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=CryptoProvider.SelectKeepsTheProviderForUnknownNames]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[CryptoProvider.SelectKeepsTheProviderForUnknownNames]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[IdentityKey.AsciiIsCaseInsensitive]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=IdentityKey.AsciiIsCaseInsensitive]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IdentityKey.AsciiIsCaseInsensitive]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[IdentityKey.EmptyName]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=IdentityKey.EmptyName]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IdentityKey.EmptyName]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[IdentityKey.UnicodeIsCaseInsensitive]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=IdentityKey.UnicodeIsCaseInsensitive]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IdentityKey.UnicodeIsCaseInsensitive]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[IdentityKey.MatchesAgreesWithEquality]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=IdentityKey.MatchesAgreesWithEquality]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IdentityKey.MatchesAgreesWithEquality]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[IdentityKey.LongNames]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=IdentityKey.LongNames]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IdentityKey.LongNames]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[IdentityKey.MatchesDoesNotAllocate]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=IdentityKey.MatchesDoesNotAllocate]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IdentityKey.MatchesDoesNotAllocate]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[IdentityKey.Containers]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=IdentityKey.Containers]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IdentityKey.Containers]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[JsonBackend.CorpusIsParsed]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=JsonBackend.CorpusIsParsed]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[JsonBackend.CorpusIsParsed]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[JsonBackend.BackendsAgreeOnTheCorpus]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=JsonBackend.BackendsAgreeOnTheCorpus]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[JsonBackend.BackendsAgreeOnTheCorpus]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[JsonParser.GetErrorCode]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=JsonParser.GetErrorCode]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[JsonParser.GetErrorCode]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Logger.WritesWithoutFlush]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Logger.WritesWithoutFlush]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Logger.WritesWithoutFlush]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Logger.FlushWritesAndStopsTheWriter]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Logger.FlushWritesAndStopsTheWriter]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Logger.FlushWritesAndStopsTheWriter]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Logger.WriterExitsWhenIdle]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Logger.WriterExitsWhenIdle]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Logger.WriterExitsWhenIdle]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Logger.NoMessageIsLostWhileTheWriterExits]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Logger.NoMessageIsLostWhileTheWriterExits]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Logger.NoMessageIsLostWhileTheWriterExits]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineData.FirstConsumptionOnlyRecordsTheTime]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineData.FirstConsumptionOnlyRecordsTheTime]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineData.FirstConsumptionOnlyRecordsTheTime]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineData.ConsumptionRateIsAMovingAverage]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineData.ConsumptionRateIsAMovingAverage]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineData.ConsumptionRateIsAMovingAverage]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineData.ShortIntervalsDoNotInflateTheRate]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineData.ShortIntervalsDoNotInflateTheRate]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineData.ShortIntervalsDoNotInflateTheRate]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineData.ClockGoingBackIsIgnored]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineData.ClockGoingBackIsIgnored]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineData.ClockGoingBackIsIgnored]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineData.ConsumptionIsPersisted]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineData.ConsumptionIsPersisted]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineData.ConsumptionIsPersisted]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineData.NonFiniteRateIsWrittenAsNull]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineData.NonFiniteRateIsWrittenAsNull]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineData.NonFiniteRateIsWrittenAsNull]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.ShouldRefillUsesTheRateIfKnown]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.ShouldRefillUsesTheRateIfKnown]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.ShouldRefillUsesTheRateIfKnown]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.VerifyRecordsTheConsumption]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.VerifyRecordsTheConsumption]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.VerifyRecordsTheConsumption]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.VerifyConsumesOTPsUpToTheMatch]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.VerifyConsumesOTPsUpToTheMatch]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.VerifyConsumesOTPsUpToTheMatch]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.VerifyCopiesTheOTPOnce]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.VerifyCopiesTheOTPOnce]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.VerifyCopiesTheOTPOnce]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.VerifiesValuesOfPasslib]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.VerifiesValuesOfPasslib]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.VerifiesValuesOfPasslib]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SharedStoreSeesChangesOfOtherHandlers]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SharedStoreSeesChangesOfOtherHandlers]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SharedStoreSeesChangesOfOtherHandlers]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SharedStoreReloadsOnlyIfTheFileChanged]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SharedStoreReloadsOnlyIfTheFileChanged]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SharedStoreReloadsOnlyIfTheFileChanged]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SharedStoreReadersSeeEveryChangeInOrder]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SharedStoreReadersSeeEveryChangeInOrder]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SharedStoreReadersSeeEveryChangeInOrder]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SharedStoreChangesFailWithoutTheLock]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SharedStoreChangesFailWithoutTheLock]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SharedStoreChangesFailWithoutTheLock]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SharedStoreThreadsWithOwnHandlersDoNotLoseUpdates]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SharedStoreThreadsWithOwnHandlersDoNotLoseUpdates]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SharedStoreThreadsWithOwnHandlersDoNotLoseUpdates]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SharedStoreRejectsOTPsThatCouldNotBeSaved]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SharedStoreRejectsOTPsThatCouldNotBeSaved]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SharedStoreRejectsOTPsThatCouldNotBeSaved]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SharedStoreProcessesDoNotLoseUpdates]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SharedStoreProcessesDoNotLoseUpdates]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SharedStoreProcessesDoNotLoseUpdates]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.EvictsLeastRecentlyUsedUser]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.EvictsLeastRecentlyUsedUser]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.EvictsLeastRecentlyUsedUser]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.LoweredLimitEvictsSeveralUsersAtOnce]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.LoweredLimitEvictsSeveralUsersAtOnce]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.LoweredLimitEvictsSeveralUsersAtOnce]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.UseProtectsFromEviction]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.UseProtectsFromEviction]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.UseProtectsFromEviction]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.SizeLimitEvictsAllTokensOfAUserButNeverTheLastUser]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.SizeLimitEvictsAllTokensOfAUserButNeverTheLastUser]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.SizeLimitEvictsAllTokensOfAUserButNeverTheLastUser]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineHandler.StoreSizeFollowsTheData]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineHandler.StoreSizeFollowsTheData]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineHandler.StoreSizeFollowsTheData]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineRefillQueue.NextAttemptTimeIsNowIfAJobIsDue]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineRefillQueue.NextAttemptTimeIsNowIfAJobIsDue]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineRefillQueue.NextAttemptTimeIsNowIfAJobIsDue]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineRefillQueue.RescheduleBacksOffAndDrops]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineRefillQueue.RescheduleBacksOffAndDrops]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineRefillQueue.RescheduleBacksOffAndDrops]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineRefillQueue.CompleteKeepsNewerJob]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineRefillQueue.CompleteKeepsNewerJob]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineRefillQueue.CompleteKeepsNewerJob]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineRefillQueue.DropRemovesWithoutRetry]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineRefillQueue.DropRemovesWithoutRetry]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineRefillQueue.DropRemovesWithoutRetry]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineRefillQueue.JobsArePersisted]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineRefillQueue.JobsArePersisted]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineRefillQueue.JobsArePersisted]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineRefillQueue.QueuesOnTheSameFileSeeEachOthersJobs]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineRefillQueue.QueuesOnTheSameFileSeeEachOthersJobs]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineRefillQueue.QueuesOnTheSameFileSeeEachOthersJobs]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[OfflineRefillQueue.ThreadsWithOwnQueuesDoNotLoseJobs]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=OfflineRefillQueue.ThreadsWithOwnQueuesDoNotLoseJobs]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[OfflineRefillQueue.ThreadsWithOwnQueuesDoNotLoseJobs]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.AllocationsAreAlignedAndDoNotOverlap]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.AllocationsAreAlignedAndDoNotOverlap]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.AllocationsAreAlignedAndDoNotOverlap]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.SmallAllocationsShareABlock]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.SmallAllocationsShareABlock]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.SmallAllocationsShareABlock]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.LargeAllocationsGetTheirOwnBlock]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.LargeAllocationsGetTheirOwnBlock]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.LargeAllocationsGetTheirOwnBlock]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.ZeroSizeAllocationsAreDistinct]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.ZeroSizeAllocationsAreDistinct]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.ZeroSizeAllocationsAreDistinct]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.ReleaseFreesAllBlocks]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.ReleaseFreesAllBlocks]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.ReleaseFreesAllBlocks]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.ContainersUseTheArena]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.ContainersUseTheArena]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.ContainersUseTheArena]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.AllocatorWithoutArenaUsesTheHeap]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.AllocatorWithoutArenaUsesTheHeap]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.AllocatorWithoutArenaUsesTheHeap]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ParseArena.AllocatorsOfTheSameArenaAreEqual]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ParseArena.AllocatorsOfTheSameArenaAreEqual]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ParseArena.AllocatorsOfTheSameArenaAreEqual]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.ParsesAllValues]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.ParsesAllValues]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.ParsesAllValues]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.AnySplitGivesTheSameResult]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.AnySplitGivesTheSameResult]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.AnySplitGivesTheSameResult]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.HeapGivesTheSameResultAsTheArena]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.HeapGivesTheSameResultAsTheArena]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.HeapGivesTheSameResultAsTheArena]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.LastDuplicateKeyWins]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.LastDuplicateKeyWins]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.LastDuplicateKeyWins]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.MalformedInputIsAnError]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.MalformedInputIsAnError]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.MalformedInputIsAnError]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.MissingResultIsAnError]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.MissingResultIsAnError]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.MissingResultIsAnError]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.ParserIsReusableAfterAnError]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.ParserIsReusableAfterAnError]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.ParserIsReusableAfterAnError]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[ResponseStreamParser.ErrorCodesAndNumbers]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=ResponseStreamParser.ErrorCodesAndNumbers]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ResponseStreamParser.ErrorCodesAndNumbers]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.BasicOperations]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.BasicOperations]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.BasicOperations]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.AppendOfItself]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.AppendOfItself]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.AppendOfItself]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.AssignOfItself]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.AssignOfItself]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.AssignOfItself]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.MovesDoNotCopy]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.MovesDoNotCopy]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.MovesDoNotCopy]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.DoesNotUseTheHeap]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.DoesNotUseTheHeap]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.DoesNotUseTheHeap]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.ClearAndShrinkWipe]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.ClearAndShrinkWipe]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.ClearAndShrinkWipe]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.FreedAndOutgrownBuffersAreWiped]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.FreedAndOutgrownBuffersAreWiped]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.FreedAndOutgrownBuffersAreWiped]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.ConversionAllocatesOnce]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.ConversionAllocatesOnce]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.ConversionAllocatesOnce]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.LargeStrings]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.LargeStrings]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.LargeStrings]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.PoolReusesSlots]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.PoolReusesSlots]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.PoolReusesSlots]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[SecureString.ConcurrentUse]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=SecureString.ConcurrentUse]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[SecureString.ConcurrentUse]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.AllCodePointsRoundTrip]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.AllCodePointsRoundTrip]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.AllCodePointsRoundTrip]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.MaximalSubpartsAreReplaced]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.MaximalSubpartsAreReplaced]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.MaximalSubpartsAreReplaced]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.LoneSurrogatesAreReplaced]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.LoneSurrogatesAreReplaced]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.LoneSurrogatesAreReplaced]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.AsciiRunsOfEveryLength]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.AsciiRunsOfEveryLength]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.AsciiRunsOfEveryLength]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.RandomTextMatchesTheStandardLibrary]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.RandomTextMatchesTheStandardLibrary]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.RandomTextMatchesTheStandardLibrary]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.OutputIsBounded]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.OutputIsBounded]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.OutputIsBounded]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.ConvertKeepsSupplementaryCharacters]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.ConvertKeepsSupplementaryCharacters]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.ConvertKeepsSupplementaryCharacters]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+add_test([=[Utf.DoesNotAllocate]=]  /root/repo/_gate_build_simd/Tests/CppClientTests [==[--gtest_filter=Utf.DoesNotAllocate]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[Utf.DoesNotAllocate]=]  PROPERTIES WORKING_DIRECTORY /root/repo/_gate_build_simd/Tests SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==])
+set(  CppClientTests_TESTS BinaryLogFormat.Varints BinaryLogFormat.ZigZag BinaryLogFormat.FixedIntegersAreLittleEndian BinaryLogFormat.MessageIds BinaryLogFormat.LoggerOutputIsDecoded Challenge.ImageBase64SkipsTheDataPrefix Challenge.NoImage Challenge.ImageBase64PointsIntoTheImage Challenge.CopiesShareTheImage Challenge.ImageIsDecodedWithoutCopies Convert.Base64TestVectors Convert.Base64Alphabets Convert.Base64RoundTrip Convert.Base64DecodeStopsAtTheFirstInvalidCharacter Convert.Base64DecodeAcceptsAnyInput Convert.Base64AllocatesOnlyTheResult Convert.HexTestVectors Convert.HexRoundTrip Convert.HexToBytesRejectsInvalidInput Convert.HexBufferOverloadsDoNotAllocate Convert.LongToHexString Convert.JoinW Convert.ReplaceAll CryptoProvider.PBKDF2SHA512KnownAnswers CryptoProvider.PBKDF2SHA512OutputSizes CryptoProvider.RandomBytesAreFilledAndDiffer CryptoProvider.RandomBytesAreUniform CryptoProvider.SelectKeepsTheProviderForUnknownNames IdentityKey.AsciiIsCaseInsensitive IdentityKey.EmptyName IdentityKey.UnicodeIsCaseInsensitive IdentityKey.MatchesAgreesWithEquality IdentityKey.LongNames IdentityKey.MatchesDoesNotAllocate IdentityKey.Containers JsonBackend.CorpusIsParsed JsonBackend.BackendsAgreeOnTheCorpus JsonParser.GetErrorCode Logger.WritesWithoutFlush Logger.FlushWritesAndStopsTheWriter Logger.WriterExitsWhenIdle Logger.NoMessageIsLostWhileTheWriterExits OfflineData.FirstConsumptionOnlyRecordsTheTime OfflineData.ConsumptionRateIsAMovingAverage OfflineData.ShortIntervalsDoNotInflateTheRate OfflineData.ClockGoingBackIsIgnored OfflineData.ConsumptionIsPersisted OfflineData.NonFiniteRateIsWrittenAsNull OfflineHandler.ShouldRefillUsesTheRateIfKnown OfflineHandler.VerifyRecordsTheConsumption OfflineHandler.VerifyConsumesOTPsUpToTheMatch OfflineHandler.VerifyCopiesTheOTPOnce OfflineHandler.VerifiesValuesOfPasslib OfflineHandler.SharedStoreSeesChangesOfOtherHandlers OfflineHandler.SharedStoreReloadsOnlyIfTheFileChanged OfflineHandler.SharedStoreReadersSeeEveryChangeInOrder OfflineHandler.SharedStoreChangesFailWithoutTheLock OfflineHandler.SharedStoreThreadsWithOwnHandlersDoNotLoseUpdates OfflineHandler.SharedStoreRejectsOTPsThatCouldNotBeSaved OfflineHandler.SharedStoreProcessesDoNotLoseUpdates OfflineHandler.EvictsLeastRecentlyUsedUser OfflineHandler.LoweredLimitEvictsSeveralUsersAtOnce OfflineHandler.UseProtectsFromEviction OfflineHandler.SizeLimitEvictsAllTokensOfAUserButNeverTheLastUser OfflineHandler.StoreSizeFollowsTheData OfflineRefillQueue.NextAttemptTimeIsNowIfAJobIsDue OfflineRefillQueue.RescheduleBacksOffAndDrops OfflineRefillQueue.CompleteKeepsNewerJob OfflineRefillQueue.DropRemovesWithoutRetry OfflineRefillQueue.JobsArePersisted OfflineRefillQueue.QueuesOnTheSameFileSeeEachOthersJobs OfflineRefillQueue.ThreadsWithOwnQueuesDoNotLoseJobs ParseArena.AllocationsAreAlignedAndDoNotOverlap ParseArena.SmallAllocationsShareABlock ParseArena.LargeAllocationsGetTheirOwnBlock ParseArena.ZeroSizeAllocationsAreDistinct ParseArena.ReleaseFreesAllBlocks ParseArena.ContainersUseTheArena ParseArena.AllocatorWithoutArenaUsesTheHeap ParseArena.AllocatorsOfTheSameArenaAreEqual ResponseStreamParser.ParsesAllValues ResponseStreamParser.AnySplitGivesTheSameResult ResponseStreamParser.HeapGivesTheSameResultAsTheArena ResponseStreamParser.LastDuplicateKeyWins ResponseStreamParser.MalformedInputIsAnError ResponseStreamParser.MissingResultIsAnError ResponseStreamParser.ParserIsReusableAfterAnError ResponseStreamParser.ErrorCodesAndNumbers SecureString.BasicOperations SecureString.AppendOfItself SecureString.AssignOfItself SecureString.MovesDoNotCopy SecureString.DoesNotUseTheHeap SecureString.ClearAndShrinkWipe SecureString.FreedAndOutgrownBuffersAreWiped SecureString.ConversionAllocatesOnce SecureString.LargeStrings SecureString.PoolReusesSlots SecureString.ConcurrentUse Utf.AllCodePointsRoundTrip Utf.MaximalSubpartsAreReplaced Utf.LoneSurrogatesAreReplaced Utf.AsciiRunsOfEveryLength Utf.RandomTextMatchesTheStandardLibrary Utf.OutputIsBounded Utf.ConvertKeepsSupplementaryCharacters Utf.DoesNotAllocate)
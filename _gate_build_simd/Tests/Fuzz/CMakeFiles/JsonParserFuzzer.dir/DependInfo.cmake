@@ -0,0 +1,22 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/Tests/Fuzz/FuzzMain.cpp" "Tests/Fuzz/CMakeFiles/JsonParserFuzzer.dir/FuzzMain.cpp.o" "gcc" "Tests/Fuzz/CMakeFiles/JsonParserFuzzer.dir/FuzzMain.cpp.o.d"
+  "/root/repo/Tests/Fuzz/JsonParserFuzzer.cpp" "Tests/Fuzz/CMakeFiles/JsonParserFuzzer.dir/JsonParserFuzzer.cpp.o" "gcc" "Tests/Fuzz/CMakeFiles/JsonParserFuzzer.dir/JsonParserFuzzer.cpp.o.d"
+  "/root/repo/Tests/AllocationCounter.cpp" "Tests/Fuzz/CMakeFiles/JsonParserFuzzer.dir/__/AllocationCounter.cpp.o" "gcc" "Tests/Fuzz/CMakeFiles/JsonParserFuzzer.dir/__/AllocationCounter.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build_simd/CMakeFiles/CppClientPortable.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/JsonParserFuzzer.dir/FuzzMain.cpp.o"
+  "CMakeFiles/JsonParserFuzzer.dir/FuzzMain.cpp.o.d"
+  "CMakeFiles/JsonParserFuzzer.dir/JsonParserFuzzer.cpp.o"
+  "CMakeFiles/JsonParserFuzzer.dir/JsonParserFuzzer.cpp.o.d"
+  "CMakeFiles/JsonParserFuzzer.dir/__/AllocationCounter.cpp.o"
+  "CMakeFiles/JsonParserFuzzer.dir/__/AllocationCounter.cpp.o.d"
+  "JsonParserFuzzer"
+  "JsonParserFuzzer.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/JsonParserFuzzer.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
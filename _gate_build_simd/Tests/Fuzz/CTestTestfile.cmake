@@ -0,0 +1,8 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/Tests/Fuzz
+# Build directory: /root/repo/_gate_build_simd/Tests/Fuzz
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+add_test(JsonParserFuzzer.Corpus "/root/repo/_gate_build_simd/Tests/Fuzz/JsonParserFuzzer" "--mutations=50" "--max-allocations-per-kb=10000" "--max-us-per-kb=50000" "/root/repo/Tests/Fuzz/../Corpus" "/root/repo/Tests/Fuzz/Corpus")
+set_tests_properties(JsonParserFuzzer.Corpus PROPERTIES  WORKING_DIRECTORY "/root/repo/_gate_build_simd/Tests/Fuzz" _BACKTRACE_TRIPLES "/root/repo/Tests/Fuzz/CMakeLists.txt;12;add_test;/root/repo/Tests/Fuzz/CMakeLists.txt;0;")